@@ -24,6 +24,7 @@ int __cdecl _getch(void);	// from conio.h
 #include "emu/EmuStructs.h"
 #include "emu/SoundEmu.h"
 #include "emu/Resampler.h"
+#include "emu/RegQueue.h"
 #include "emu/SoundDevs.h"
 #include "emu/EmuCores.h"
 #include "emu/cores/sn764intf.h"	// for SN76496_CFG
@@ -44,14 +45,17 @@ static DEV_INFO opllDefInf;
 static RESMPL_STATE snResmpl;
 static RESMPL_STATE okiResmpl;
 static RESMPL_STATE opllResmpl;
+static REG_QUEUE* snQueue;
+static REG_QUEUE* okiQueue;
+static REG_QUEUE* opllQueue;
 static UINT32 smplAlloc;
 static DEV_SMPL* smplData[2];
 static volatile bool canRender;
 
-static void OPLL_Write(DEVFUNC_WRITE_A8D8 write, void* info, UINT8 addr, UINT8 data)
+static void OPLL_Write(REG_QUEUE* queue, UINT32 smplTime, UINT8 addr, UINT8 data)
 {
-	write(info, 0, addr);
-	write(info, 1, data);
+	RegQueue_Write(queue, smplTime, DEVRW_A8D8, 0, addr);
+	RegQueue_Write(queue, smplTime, DEVRW_A8D8, 1, data);
 	return;
 }
 
@@ -66,9 +70,8 @@ int main(int argc, char* argv[])
 	
 	DEV_GEN_CFG devCfg;
 	SN76496_CFG snCfg;
-	DEVFUNC_WRITE_A8D8 snWrite;
-	DEVFUNC_WRITE_A8D8 okiWrite;
-	DEVFUNC_WRITE_A8D8 opllWrite;
+	UINT32 smplTime;
+	UINT32 smplRate;
 	
 	Audio_Init();
 	drvCount = Audio_GetDriverCount();
@@ -112,6 +115,7 @@ int main(int argc, char* argv[])
 	devCfg.srMode = DEVRI_SRMODE_NATIVE;
 	devCfg.flags = 0x00;
 	devCfg.clock = 3579545;
+	devCfg.memArena = NULL;
 	devCfg.smplRate = 48000;
 	snCfg._genCfg = devCfg;
 	snCfg.shiftRegWidth = 0x10;	snCfg.noiseTaps = 0x09;
@@ -204,33 +208,42 @@ int main(int argc, char* argv[])
 	Resmpl_SetVals(&opllResmpl, 0xFF, 0x100, opts->sampleRate);
 	Resmpl_DevConnect(&opllResmpl, &opllDefInf);
 	Resmpl_Init(&opllResmpl);
-	canRender = true;
 	
-	// get functions for executing sound chip register writes
-	SndEmu_GetDeviceFunc(snDefInf.devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, (void**)&snWrite);
-	SndEmu_GetDeviceFunc(okiDefInf.devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, (void**)&okiWrite);
-	SndEmu_GetDeviceFunc(opllDefInf.devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, (void**)&opllWrite);
+	// The register writes are sent from this thread, so queue them for the audio thread.
+	RegQueue_Init(&snQueue, 0x40);
+	RegQueue_DevConnect(snQueue, &snDefInf);
+	RegQueue_Init(&okiQueue, 0x40);
+	RegQueue_DevConnect(okiQueue, &okiDefInf);
+	RegQueue_Init(&opllQueue, 0x40);
+	RegQueue_DevConnect(opllQueue, &opllDefInf);
+	canRender = true;
 	
 	// write data to the sound chip registers, so that they make sound
-	snWrite(snDefInf.dataPtr, 0, 0x8B);	// PSG channel 1 frequency 0x06B (lower 4 bits)
-	snWrite(snDefInf.dataPtr, 0, 0x06);	// frequency 0x06B (upper 6 bits)
-	snWrite(snDefInf.dataPtr, 0, 0x93);	// PSG channel 1 volume 0x3
-	OPLL_Write(opllWrite, opllDefInf.dataPtr, 0x30, 0x70);	// OPLL channel 0 instrument 7, volume 0
-	OPLL_Write(opllWrite, opllDefInf.dataPtr, 0x10, 0x80);	// channel 0 frequency 0x180 (lower 8 bits)
-	OPLL_Write(opllWrite, opllDefInf.dataPtr, 0x20, 0x17);	// channel 0 frequency 0x180 (upper 1 bit), octave 3, key on
-	Sleep(250);
-	okiWrite(okiDefInf.dataPtr, 0, 0x80 | 0x0D);	// OKI6295 sample 0D
-	okiWrite(okiDefInf.dataPtr, 0, 0x10);	// channel 0 (mask 0x1), volume 0x0
-	Sleep(400);
-	okiWrite(okiDefInf.dataPtr, 0x0C, 1);	// set pin 7 = high
-	okiWrite(okiDefInf.dataPtr, 0, 0x80 | 0x0D);	// sample 0D
-	okiWrite(okiDefInf.dataPtr, 0, 0x20);	// channel 1 (mask 0x2), volume 0x0
-	Sleep(1000);
-	snWrite(snDefInf.dataPtr, 0, 0x99);
+	// The writes are scheduled with sample accuracy, starting 50 ms from now.
+	smplRate = opts->sampleRate;
+	smplTime = RegQueue_GetTime(snQueue) + smplRate / 20;
+	RegQueue_Write(snQueue, smplTime, DEVRW_A8D8, 0, 0x8B);	// PSG channel 1 frequency 0x06B (lower 4 bits)
+	RegQueue_Write(snQueue, smplTime, DEVRW_A8D8, 0, 0x06);	// frequency 0x06B (upper 6 bits)
+	RegQueue_Write(snQueue, smplTime, DEVRW_A8D8, 0, 0x93);	// PSG channel 1 volume 0x3
+	OPLL_Write(opllQueue, smplTime, 0x30, 0x70);	// OPLL channel 0 instrument 7, volume 0
+	OPLL_Write(opllQueue, smplTime, 0x10, 0x80);	// channel 0 frequency 0x180 (lower 8 bits)
+	OPLL_Write(opllQueue, smplTime, 0x20, 0x17);	// channel 0 frequency 0x180 (upper 1 bit), octave 3, key on
+	smplTime += smplRate * 250 / 1000;
+	RegQueue_Write(okiQueue, smplTime, DEVRW_A8D8, 0, 0x80 | 0x0D);	// OKI6295 sample 0D
+	RegQueue_Write(okiQueue, smplTime, DEVRW_A8D8, 0, 0x10);	// channel 0 (mask 0x1), volume 0x0
+	smplTime += smplRate * 400 / 1000;
+	RegQueue_Write(okiQueue, smplTime, DEVRW_A8D8, 0x0C, 1);	// set pin 7 = high
+	RegQueue_Write(okiQueue, smplTime, DEVRW_A8D8, 0, 0x80 | 0x0D);	// sample 0D
+	RegQueue_Write(okiQueue, smplTime, DEVRW_A8D8, 0, 0x20);	// channel 1 (mask 0x2), volume 0x0
+	smplTime += smplRate;
+	RegQueue_Write(snQueue, smplTime, DEVRW_A8D8, 0, 0x99);
 	
 	getchar();
 	
 	retVal = AudioDrv_Stop(audDrv);
+	RegQueue_Deinit(snQueue);
+	RegQueue_Deinit(okiQueue);
+	RegQueue_Deinit(opllQueue);
 	Resmpl_Deinit(&snResmpl);
 	Resmpl_Deinit(&okiResmpl);
 	Resmpl_Deinit(&opllResmpl);
@@ -273,9 +286,10 @@ static UINT32 FillBuffer(void* drvStruct, void* userParam, UINT32 bufSize, void*
 	memset(smplData[1], 0, bufSize);
 	// emulate the sound chips
 	// The resampler requests samples when needed and mixes everything into the smplDataW buffer.
-	Resmpl_Execute(&snResmpl, smplCount, smplDataW);
-	Resmpl_Execute(&okiResmpl, smplCount, smplDataW);
-	Resmpl_Execute(&opllResmpl, smplCount, smplDataW);
+	// Queued register writes are executed at their sample position within the buffer.
+	RegQueue_Render(snQueue, &snResmpl, smplCount, smplDataW);
+	RegQueue_Render(okiQueue, &okiResmpl, smplCount, smplDataW);
+	RegQueue_Render(opllQueue, &opllResmpl, smplCount, smplDataW);
 	switch(smplSize)
 	{
 	case 4:
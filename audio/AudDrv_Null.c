@@ -0,0 +1,612 @@
+// Audio Stream - Null Driver
+// Consumes the audio data on a simulated hardware clock without outputting it.
+// Useful for measuring render performance and testing buffer/latency settings without a sound device.
+#define _CRTDBG_MAP_ALLOC
+#include <stdlib.h>
+#include <string.h>	// for memset()
+
+#ifdef _WIN32
+#include <windows.h>	// for Sleep()
+#else
+#include <unistd.h>		// for usleep()
+#define	Sleep(msec)	usleep(msec * 1000)
+#endif
+
+#include "../stdtype.h"
+
+#include "AudioStream.h"
+#include "AudioStream_SpcDrvFuns.h"
+#include "../utils/OSThread.h"
+#include "../utils/OSSignal.h"
+#include "../utils/OSMutex.h"
+#include "../utils/OSTimer.h"
+
+
+typedef struct _null_driver
+{
+	void* audDrvPtr;
+	volatile UINT8 devState;	// 0 - not running, 1 - running, 2 - terminating
+	
+	UINT32 smplRate;
+	UINT32 smplSize;	// bytes per sample (all channels)
+	UINT32 bufSmpls;
+	UINT32 bufSize;
+	UINT32 bufCount;
+	UINT8* bufSpace;
+	
+	OS_THREAD* hThread;
+	OS_SIGNAL* hSignal;
+	OS_MUTEX* hMutex;
+	volatile UINT8 pauseThread;
+	
+	void* userParam;
+	AUDFUNC_FILLBUF FillBuffer;
+	
+	// simulated hardware clock
+	double speed;		// 1.0 = realtime, 0.0 = as fast as possible
+	UINT64 tmrFreq;
+	double tmrSmplMul;	// samples per timer tick
+	UINT8 clkRunning;	// the clock starts with the first buffer
+	UINT64 clkStart;	// timer value at sample 0
+	UINT64 pauseStart;
+	UINT64 wrtSmpls;	// number of samples sent to the "device"
+	
+	// statistics [protected by hMutex]
+	UINT32 statBufs;
+	UINT32 statUnderruns;
+	UINT32 statRenderCnt;	// number of buffers rendered by the callback (WriteData buffers have no render time)
+	UINT64 statRenderMin;	// all times in timer ticks
+	UINT64 statRenderMax;
+	UINT64 statRenderSum;
+	UINT64 statJitterMax;
+	UINT64 statJitterSum;
+	UINT32 statJitterCnt;
+} DRV_NULL;
+
+
+UINT8 NullDrv_IsAvailable(void);
+UINT8 NullDrv_Init(void);
+UINT8 NullDrv_Deinit(void);
+const AUDIO_DEV_LIST* NullDrv_GetDeviceList(void);
+AUDIO_OPTS* NullDrv_GetDefaultOpts(void);
+
+UINT8 NullDrv_Create(void** retDrvObj);
+UINT8 NullDrv_Destroy(void* drvObj);
+UINT8 NullDrv_SetSpeed(void* drvObj, double speed);
+double NullDrv_GetSpeed(void* drvObj);
+UINT8 NullDrv_GetStats(void* drvObj, NULLDRV_STATS* retStats);
+UINT8 NullDrv_ResetStats(void* drvObj);
+
+UINT8 NullDrv_Start(void* drvObj, UINT32 deviceID, AUDIO_OPTS* options, void* audDrvParam);
+UINT8 NullDrv_Stop(void* drvObj);
+UINT8 NullDrv_Pause(void* drvObj);
+UINT8 NullDrv_Resume(void* drvObj);
+
+UINT8 NullDrv_SetCallback(void* drvObj, AUDFUNC_FILLBUF FillBufCallback, void* userParam);
+UINT32 NullDrv_GetBufferSize(void* drvObj);
+UINT8 NullDrv_IsBusy(void* drvObj);
+UINT8 NullDrv_WriteData(void* drvObj, UINT32 dataSize, void* data);
+UINT32 NullDrv_GetLatency(void* drvObj);
+
+static UINT64 GetPlayPos(DRV_NULL* drv, UINT64 time);
+static UINT64 GetQueueFreeTime(DRV_NULL* drv);
+static void WaitForTime(UINT64 time, UINT64 tmrFreq);
+static void QueueSamples(DRV_NULL* drv, UINT32 smplCnt);
+static UINT32 Ticks2USec(const DRV_NULL* drv, UINT64 ticks);
+static void NullThread(void* Arg);
+
+
+AUDIO_DRV audDrv_Null =
+{
+	{ADRVTYPE_NULL, ADRVSIG_NULL, "Null"},
+	
+	NullDrv_IsAvailable,
+	NullDrv_Init, NullDrv_Deinit,
+	NullDrv_GetDeviceList, NullDrv_GetDefaultOpts,
+	
+	NullDrv_Create, NullDrv_Destroy,
+	NullDrv_Start, NullDrv_Stop,
+	NullDrv_Pause, NullDrv_Resume,
+	
+	NullDrv_SetCallback, NullDrv_GetBufferSize,
+	NullDrv_IsBusy, NullDrv_WriteData,
+	
+	NullDrv_GetLatency,
+};
+
+
+static char* nullDevNames[1] = {"Null Device"};
+static AUDIO_OPTS defOptions;
+static AUDIO_DEV_LIST deviceList;
+
+static UINT8 isInit = 0;
+static UINT32 activeDrivers;
+
+UINT8 NullDrv_IsAvailable(void)
+{
+	return 1;
+}
+
+UINT8 NullDrv_Init(void)
+{
+	if (isInit)
+		return AERR_WASDONE;
+	
+	deviceList.devCount = 1;
+	deviceList.devNames = nullDevNames;
+	
+	
+	memset(&defOptions, 0x00, sizeof(AUDIO_OPTS));
+	defOptions.sampleRate = 44100;
+	defOptions.numChannels = 2;
+	defOptions.numBitsPerSmpl = 16;
+	defOptions.usecPerBuf = 10000;	// 10 ms per buffer
+	defOptions.numBuffers = 10;	// 100 ms latency
+	
+	
+	activeDrivers = 0;
+	isInit = 1;
+	
+	return AERR_OK;
+}
+
+UINT8 NullDrv_Deinit(void)
+{
+	if (! isInit)
+		return AERR_WASDONE;
+	
+	deviceList.devCount = 0;
+	deviceList.devNames = NULL;
+	
+	isInit = 0;
+	
+	return AERR_OK;
+}
+
+const AUDIO_DEV_LIST* NullDrv_GetDeviceList(void)
+{
+	return &deviceList;
+}
+
+AUDIO_OPTS* NullDrv_GetDefaultOpts(void)
+{
+	return &defOptions;
+}
+
+
+UINT8 NullDrv_Create(void** retDrvObj)
+{
+	DRV_NULL* drv;
+	UINT8 retVal8;
+	
+	drv = (DRV_NULL*)malloc(sizeof(DRV_NULL));
+	drv->devState = 0;
+	drv->bufSmpls = 0;
+	drv->bufSpace = NULL;
+	drv->hThread = NULL;
+	drv->hSignal = NULL;
+	drv->hMutex = NULL;
+	drv->userParam = NULL;
+	drv->FillBuffer = NULL;
+	drv->speed = 1.0;
+	drv->tmrFreq = OSTimer_GetFreq();
+	NullDrv_ResetStats(drv);
+	
+	activeDrivers ++;
+	retVal8  = OSSignal_Init(&drv->hSignal, 0);
+	retVal8 |= OSMutex_Init(&drv->hMutex, 0);
+	if (retVal8)
+	{
+		NullDrv_Destroy(drv);
+		*retDrvObj = NULL;
+		return AERR_API_ERR;
+	}
+	*retDrvObj = drv;
+	
+	return AERR_OK;
+}
+
+UINT8 NullDrv_Destroy(void* drvObj)
+{
+	DRV_NULL* drv = (DRV_NULL*)drvObj;
+	
+	if (drv->devState != 0)
+		NullDrv_Stop(drvObj);
+	if (drv->hThread != NULL)
+	{
+		OSThread_Cancel(drv->hThread);
+		OSThread_Deinit(drv->hThread);
+	}
+	if (drv->hSignal != NULL)
+		OSSignal_Deinit(drv->hSignal);
+	if (drv->hMutex != NULL)
+		OSMutex_Deinit(drv->hMutex);
+	
+	free(drv);
+	activeDrivers --;
+	
+	return AERR_OK;
+}
+
+// speed: speed of the simulated clock, 1.0 = realtime, 2.0 = twice as fast, 0.0 = as fast as possible
+UINT8 NullDrv_SetSpeed(void* drvObj, double speed)
+{
+	DRV_NULL* drv = (DRV_NULL*)drvObj;
+	
+	if (drv->devState != 0)
+		return AERR_BAD_MODE;
+	if (speed < 0.0)
+		return AERR_NO_SUPPORT;
+	
+	drv->speed = speed;
+	return AERR_OK;
+}
+
+double NullDrv_GetSpeed(void* drvObj)
+{
+	DRV_NULL* drv = (DRV_NULL*)drvObj;
+	
+	return drv->speed;
+}
+
+UINT8 NullDrv_GetStats(void* drvObj, NULLDRV_STATS* retStats)
+{
+	DRV_NULL* drv = (DRV_NULL*)drvObj;
+	
+	OSMutex_Lock(drv->hMutex);
+	retStats->buffers = drv->statBufs;
+	retStats->underruns = drv->statUnderruns;
+	if (drv->statRenderCnt)
+	{
+		retStats->renderMin = Ticks2USec(drv, drv->statRenderMin);
+		retStats->renderMax = Ticks2USec(drv, drv->statRenderMax);
+		retStats->renderAvg = Ticks2USec(drv, drv->statRenderSum / drv->statRenderCnt);
+	}
+	else
+	{
+		retStats->renderMin = retStats->renderMax = retStats->renderAvg = 0;
+	}
+	retStats->jitterMax = Ticks2USec(drv, drv->statJitterMax);
+	retStats->jitterAvg = drv->statJitterCnt ? Ticks2USec(drv, drv->statJitterSum / drv->statJitterCnt) : 0;
+	if (drv->bufSmpls && drv->speed > 0.0)
+		retStats->bufPeriod = (UINT32)(drv->bufSmpls * 1000000.0 / (drv->smplRate * drv->speed) + 0.5);
+	else
+		retStats->bufPeriod = 0;
+	OSMutex_Unlock(drv->hMutex);
+	
+	return AERR_OK;
+}
+
+UINT8 NullDrv_ResetStats(void* drvObj)
+{
+	DRV_NULL* drv = (DRV_NULL*)drvObj;
+	
+	if (drv->hMutex != NULL)
+		OSMutex_Lock(drv->hMutex);
+	drv->statBufs = 0;
+	drv->statUnderruns = 0;
+	drv->statRenderCnt = 0;
+	drv->statRenderMin = (UINT64)-1;
+	drv->statRenderMax = 0;
+	drv->statRenderSum = 0;
+	drv->statJitterMax = 0;
+	drv->statJitterSum = 0;
+	drv->statJitterCnt = 0;
+	if (drv->hMutex != NULL)
+		OSMutex_Unlock(drv->hMutex);
+	
+	return AERR_OK;
+}
+
+UINT8 NullDrv_Start(void* drvObj, UINT32 deviceID, AUDIO_OPTS* options, void* audDrvParam)
+{
+	DRV_NULL* drv = (DRV_NULL*)drvObj;
+	UINT64 tempInt64;
+	UINT8 retVal8;
+	
+	if (drv->devState != 0)
+		return 0xD0;	// already running
+	
+	drv->audDrvPtr = audDrvParam;
+	if (options == NULL)
+		options = &defOptions;
+	if (! options->sampleRate || ! options->numChannels || ! options->numBitsPerSmpl)
+		return 0xCF;	// invalid sample format
+	drv->smplRate = options->sampleRate;
+	drv->smplSize = options->numBitsPerSmpl * options->numChannels / 8;
+	
+	tempInt64 = (UINT64)options->sampleRate * options->usecPerBuf;
+	drv->bufSmpls = (UINT32)((tempInt64 + 500000) / 1000000);
+	if (! drv->bufSmpls)
+		drv->bufSmpls = 1;
+	drv->bufSize = drv->smplSize * drv->bufSmpls;
+	drv->bufCount = options->numBuffers ? options->numBuffers : 10;
+	
+	drv->tmrSmplMul = drv->smplRate * drv->speed / (double)drv->tmrFreq;
+	drv->clkRunning = 0;
+	drv->wrtSmpls = 0;
+	
+	drv->bufSpace = (UINT8*)malloc(drv->bufSize);
+	if (drv->bufSpace == NULL)
+		return 0xFF;
+	
+	OSSignal_Reset(drv->hSignal);
+	retVal8 = OSThread_Init(&drv->hThread, &NullThread, drv);
+	if (retVal8)
+	{
+		free(drv->bufSpace);	drv->bufSpace = NULL;
+		return 0xC8;	// CreateThread failed
+	}
+	
+	drv->devState = 1;
+	drv->pauseThread = 0x00;
+	OSSignal_Signal(drv->hSignal);
+	
+	return AERR_OK;
+}
+
+UINT8 NullDrv_Stop(void* drvObj)
+{
+	DRV_NULL* drv = (DRV_NULL*)drvObj;
+	
+	if (drv->devState != 1)
+		return 0xD8;	// is already stopped (or stopping)
+	
+	drv->devState = 2;
+	
+	OSThread_Join(drv->hThread);
+	OSThread_Deinit(drv->hThread);	drv->hThread = NULL;
+	
+	free(drv->bufSpace);	drv->bufSpace = NULL;
+	drv->devState = 0;
+	
+	return AERR_OK;
+}
+
+UINT8 NullDrv_Pause(void* drvObj)
+{
+	DRV_NULL* drv = (DRV_NULL*)drvObj;
+	
+	if (drv->devState != 1)
+		return 0xFF;
+	
+	OSMutex_Lock(drv->hMutex);
+	if (! (drv->pauseThread & 0x01))
+	{
+		drv->pauseStart = OSTimer_GetTime();
+		drv->pauseThread |= 0x01;
+	}
+	OSMutex_Unlock(drv->hMutex);
+	return AERR_OK;
+}
+
+UINT8 NullDrv_Resume(void* drvObj)
+{
+	DRV_NULL* drv = (DRV_NULL*)drvObj;
+	
+	if (drv->devState != 1)
+		return 0xFF;
+	
+	OSMutex_Lock(drv->hMutex);
+	if (drv->pauseThread & 0x01)
+	{
+		// the simulated clock stops while paused
+		drv->clkStart += OSTimer_GetTime() - drv->pauseStart;
+		drv->pauseThread &= ~0x01;
+	}
+	OSMutex_Unlock(drv->hMutex);
+	return AERR_OK;
+}
+
+
+UINT8 NullDrv_SetCallback(void* drvObj, AUDFUNC_FILLBUF FillBufCallback, void* userParam)
+{
+	DRV_NULL* drv = (DRV_NULL*)drvObj;
+	
+	drv->pauseThread |= 0x02;
+	OSMutex_Lock(drv->hMutex);
+	drv->userParam = userParam;
+	drv->FillBuffer = FillBufCallback;
+	drv->pauseThread &= ~0x02;
+	OSMutex_Unlock(drv->hMutex);
+	
+	return AERR_OK;
+}
+
+UINT32 NullDrv_GetBufferSize(void* drvObj)
+{
+	DRV_NULL* drv = (DRV_NULL*)drvObj;
+	
+	return drv->bufSize;
+}
+
+UINT8 NullDrv_IsBusy(void* drvObj)
+{
+	DRV_NULL* drv = (DRV_NULL*)drvObj;
+	UINT64 freeTime;
+	
+	if (drv->FillBuffer != NULL)
+		return AERR_BAD_MODE;
+	if (drv->devState != 1)
+		return AERR_OK;
+	
+	OSMutex_Lock(drv->hMutex);
+	freeTime = GetQueueFreeTime(drv);
+	OSMutex_Unlock(drv->hMutex);
+	return (freeTime > OSTimer_GetTime()) ? AERR_BUSY : AERR_OK;
+}
+
+UINT8 NullDrv_WriteData(void* drvObj, UINT32 dataSize, void* data)
+{
+	DRV_NULL* drv = (DRV_NULL*)drvObj;
+	UINT64 freeTime;
+	
+	if (drv->devState != 1)
+		return AERR_NOT_OPEN;
+	if (dataSize > drv->bufSize)
+		return AERR_TOO_MUCH_DATA;
+	
+	// block until there is space in the queue, like a sound device would
+	OSMutex_Lock(drv->hMutex);
+	freeTime = GetQueueFreeTime(drv);
+	OSMutex_Unlock(drv->hMutex);
+	WaitForTime(freeTime, drv->tmrFreq);
+	
+	OSMutex_Lock(drv->hMutex);
+	QueueSamples(drv, dataSize / drv->smplSize);
+	OSMutex_Unlock(drv->hMutex);
+	
+	return AERR_OK;
+}
+
+// returns the latency in msec of the simulated clock
+UINT32 NullDrv_GetLatency(void* drvObj)
+{
+	DRV_NULL* drv = (DRV_NULL*)drvObj;
+	UINT64 playPos;
+	UINT64 smplsBehind;
+	
+	if (drv->devState != 1)
+		return 0;
+	
+	OSMutex_Lock(drv->hMutex);
+	if (drv->speed > 0.0)
+	{
+		playPos = GetPlayPos(drv, (drv->pauseThread & 0x01) ? drv->pauseStart : OSTimer_GetTime());
+		smplsBehind = (drv->wrtSmpls > playPos) ? (drv->wrtSmpls - playPos) : 0;
+	}
+	else
+	{
+		smplsBehind = (UINT64)drv->bufSmpls * drv->bufCount;
+	}
+	OSMutex_Unlock(drv->hMutex);
+	
+	return (UINT32)(smplsBehind * 1000 / drv->smplRate);
+}
+
+// returns the number of samples the simulated device has played at the specified time
+static UINT64 GetPlayPos(DRV_NULL* drv, UINT64 time)
+{
+	if (! drv->clkRunning || time <= drv->clkStart)
+		return 0;
+	return (UINT64)((time - drv->clkStart) * drv->tmrSmplMul);
+}
+
+// returns the time when the queue can take the next buffer
+static UINT64 GetQueueFreeTime(DRV_NULL* drv)
+{
+	UINT64 queueEnd;
+	
+	if (! drv->clkRunning || drv->speed <= 0.0)
+		return 0;	// no clock - the queue is always free
+	
+	// the queue has space as soon as fewer than (bufCount - 1) buffers are left to play
+	queueEnd = (UINT64)drv->bufSmpls * (drv->bufCount - 1);
+	if (drv->wrtSmpls <= queueEnd)
+		return 0;
+	return drv->clkStart + (UINT64)((drv->wrtSmpls - queueEnd) / drv->tmrSmplMul + 0.5);
+}
+
+static void WaitForTime(UINT64 time, UINT64 tmrFreq)
+{
+	UINT64 curTime;
+	UINT64 sleepThresh;
+	
+	// sleep as long as there is enough time left, then poll for more accuracy
+	sleepThresh = tmrFreq / 500;	// 2 ms
+	curTime = OSTimer_GetTime();
+	while(curTime < time)
+	{
+		if (time - curTime > sleepThresh)
+			Sleep(1);
+		curTime = OSTimer_GetTime();
+	}
+	
+	return;
+}
+
+// hands samples to the simulated device and checks whether it ran out of data [requires hMutex]
+static void QueueSamples(DRV_NULL* drv, UINT32 smplCnt)
+{
+	UINT64 playPos;
+	
+	if (drv->speed > 0.0)
+	{
+		if (! drv->clkRunning)
+		{
+			// playback starts with the first buffer
+			drv->clkStart = OSTimer_GetTime();
+			drv->clkRunning = 1;
+		}
+		playPos = GetPlayPos(drv, OSTimer_GetTime());
+		if (playPos > drv->wrtSmpls)
+		{
+			// The device played everything and had to output silence.
+			drv->statUnderruns ++;
+			drv->wrtSmpls = playPos;
+		}
+	}
+	drv->wrtSmpls += smplCnt;
+	drv->statBufs ++;
+	
+	return;
+}
+
+static UINT32 Ticks2USec(const DRV_NULL* drv, UINT64 ticks)
+{
+	return (UINT32)(ticks * 1000000 / drv->tmrFreq);
+}
+
+static void NullThread(void* Arg)
+{
+	DRV_NULL* drv = (DRV_NULL*)Arg;
+	UINT64 freeTime;
+	UINT64 startTime;
+	UINT64 endTime;
+	UINT32 bufBytes;
+	UINT8 didBuffers;	// number of processed buffers
+	
+	OSSignal_Wait(drv->hSignal);	// wait until the initialization is done
+	
+	while(drv->devState == 1)
+	{
+		didBuffers = 0;
+		OSMutex_Lock(drv->hMutex);
+		freeTime = GetQueueFreeTime(drv);
+		OSMutex_Unlock(drv->hMutex);
+		if (! drv->pauseThread && drv->FillBuffer != NULL)
+		{
+			WaitForTime(freeTime, drv->tmrFreq);
+			OSMutex_Lock(drv->hMutex);
+			if (! drv->pauseThread && drv->FillBuffer != NULL)
+			{
+				startTime = OSTimer_GetTime();
+				bufBytes = drv->FillBuffer(drv->audDrvPtr, drv->userParam, drv->bufSize, drv->bufSpace);
+				endTime = OSTimer_GetTime();
+				
+				if (freeTime)
+				{
+					// jitter: delay between the time the device requested data and the callback
+					UINT64 jitter = (startTime > freeTime) ? (startTime - freeTime) : 0;
+					if (drv->statJitterMax < jitter)
+						drv->statJitterMax = jitter;
+					drv->statJitterSum += jitter;
+					drv->statJitterCnt ++;
+				}
+				if (drv->statRenderMin > endTime - startTime)
+					drv->statRenderMin = endTime - startTime;
+				if (drv->statRenderMax < endTime - startTime)
+					drv->statRenderMax = endTime - startTime;
+				drv->statRenderSum += endTime - startTime;
+				drv->statRenderCnt ++;
+				QueueSamples(drv, bufBytes / drv->smplSize);
+				didBuffers ++;
+			}
+			OSMutex_Unlock(drv->hMutex);
+		}
+		if (! didBuffers)
+			Sleep(1);
+	}
+	
+	return;
+}
@@ -7,6 +7,9 @@
 #include "../common_def.h"	// stdtype.h, INLINE
 
 #include "AudioStream.h"
+#include "../utils/OSThread.h"
+#include "../utils/OSSignal.h"
+#include "../utils/OSMutex.h"
 
 
 #ifdef _MSC_VER
@@ -28,6 +31,11 @@ typedef struct
 
 #define WAVE_FORMAT_PCM	0x0001
 
+// default settings for the background writer
+#define DEF_BUF_SIZE	0x40000	// 256 KB
+#define DEF_BUF_COUNT	4
+#define BUF_ALIGN		0x1000	// buffer sizes are multiples of this, so that each fwrite() covers whole pages
+
 
 typedef struct _wave_writer_driver
 {
@@ -40,6 +48,20 @@ typedef struct _wave_writer_driver
 	
 	UINT32 hdrSize;
 	UINT32 wrtDataBytes;
+	
+	// background writer (bufCount == 0: write synchronously)
+	UINT32 bufSize;
+	UINT32 bufCount;
+	UINT8* bufSpace;
+	UINT32* bufFill;	// number of bytes in each buffer
+	UINT32 fillIdx;		// buffer being filled by the producer
+	UINT32 readIdx;		// next buffer to be written by the thread
+	UINT32 pendCnt;		// number of full buffers waiting to be written [protected by hMutex]
+	volatile UINT8 wrtError;
+	OS_THREAD* hThread;
+	OS_SIGNAL* hSigData;	// set when a buffer was queued or the thread has to quit
+	OS_SIGNAL* hSigFree;	// set when a buffer was written
+	OS_MUTEX* hMutex;
 } DRV_WAV_WRT;
 
 
@@ -53,6 +75,8 @@ UINT8 WavWrt_Create(void** retDrvObj);
 UINT8 WavWrt_Destroy(void* drvObj);
 UINT8 WavWrt_SetFileName(void* drvObj, const char* fileName);
 const char* WavWrt_GetFileName(void* drvObj);
+UINT8 WavWrt_SetBufferSize(void* drvObj, UINT32 bufSize, UINT32 bufCount);
+UINT8 WavWrt_Flush(void* drvObj);
 
 UINT8 WavWrt_Start(void* drvObj, UINT32 deviceID, AUDIO_OPTS* options, void* audDrvParam);
 UINT8 WavWrt_Stop(void* drvObj);
@@ -64,6 +88,9 @@ UINT8 WavWrt_IsBusy(void* drvObj);
 UINT8 WavWrt_WriteData(void* drvObj, UINT32 dataSize, void* data);
 UINT32 WavWrt_GetLatency(void* drvObj);
 
+static void QueueBuffer(DRV_WAV_WRT* drv);
+static void WaitForQueue(DRV_WAV_WRT* drv, UINT32 maxPending);
+static void WavWrtThread(void* Arg);
 INLINE size_t fputLE16(UINT16 Value, FILE* hFile);
 INLINE size_t fputLE32(UINT32 Value, FILE* hFile);
 INLINE size_t fputBE32(UINT32 Value, FILE* hFile);
@@ -151,12 +178,31 @@ UINT8 WavWrt_Create(void** retDrvObj)
 {
 	DRV_WAV_WRT* drv;
 	
+	UINT8 retVal8;
+	
 	drv = (DRV_WAV_WRT*)malloc(sizeof(DRV_WAV_WRT));
 	drv->devState = 0;
 	drv->fileName = NULL;
 	drv->hFile = NULL;
+	drv->bufSize = DEF_BUF_SIZE;
+	drv->bufCount = DEF_BUF_COUNT;
+	drv->bufSpace = NULL;
+	drv->bufFill = NULL;
+	drv->hThread = NULL;
+	drv->hSigData = NULL;
+	drv->hSigFree = NULL;
+	drv->hMutex = NULL;
 	
 	activeDrivers ++;
+	retVal8  = OSSignal_Init(&drv->hSigData, 0);
+	retVal8 |= OSSignal_Init(&drv->hSigFree, 0);
+	retVal8 |= OSMutex_Init(&drv->hMutex, 0);
+	if (retVal8)
+	{
+		WavWrt_Destroy(drv);
+		*retDrvObj = NULL;
+		return AERR_API_ERR;
+	}
 	*retDrvObj = drv;
 	
 	return AERR_OK;
@@ -171,6 +217,12 @@ UINT8 WavWrt_Destroy(void* drvObj)
 	
 	if (drv->fileName != NULL)
 		free(drv->fileName);
+	if (drv->hSigData != NULL)
+		OSSignal_Deinit(drv->hSigData);
+	if (drv->hSigFree != NULL)
+		OSSignal_Deinit(drv->hSigFree);
+	if (drv->hMutex != NULL)
+		OSMutex_Deinit(drv->hMutex);
 	
 	free(drv);
 	activeDrivers --;
@@ -196,6 +248,44 @@ const char* WavWrt_GetFileName(void* drvObj)
 	return drv->fileName;
 }
 
+// bufSize: size of each buffer in bytes (rounded up to 4 KB)
+// bufCount: number of buffers, 0 = write synchronously from the calling thread
+UINT8 WavWrt_SetBufferSize(void* drvObj, UINT32 bufSize, UINT32 bufCount)
+{
+	DRV_WAV_WRT* drv = (DRV_WAV_WRT*)drvObj;
+	
+	if (drv->devState != 0)
+		return AERR_BAD_MODE;
+	
+	if (! bufSize)
+		bufCount = 0;
+	else if (bufCount == 1)
+		bufCount = 2;	// need at least one buffer for filling and one for writing
+	drv->bufSize = (bufSize + BUF_ALIGN - 1) & ~(BUF_ALIGN - 1);
+	drv->bufCount = bufCount;
+	
+	return AERR_OK;
+}
+
+// writes all data that was sent so far and waits for it to complete
+UINT8 WavWrt_Flush(void* drvObj)
+{
+	DRV_WAV_WRT* drv = (DRV_WAV_WRT*)drvObj;
+	
+	if (drv->devState != 1)
+		return AERR_NOT_OPEN;
+	
+	if (drv->bufCount)
+	{
+		if (drv->bufFill[drv->fillIdx])
+			QueueBuffer(drv);
+		WaitForQueue(drv, 0);
+	}
+	fflush(drv->hFile);
+	
+	return drv->wrtError ? AERR_FILE_ERR : AERR_OK;
+}
+
 UINT8 WavWrt_Start(void* drvObj, UINT32 deviceID, AUDIO_OPTS* options, void* audDrvParam)
 {
 	DRV_WAV_WRT* drv = (DRV_WAV_WRT*)drvObj;
@@ -249,8 +339,33 @@ UINT8 WavWrt_Start(void* drvObj, UINT32 deviceID, AUDIO_OPTS* options, void* aud
 	drv->hdrSize += 0x08;
 	
 	drv->wrtDataBytes = 0x00;
+	drv->wrtError = 0;
 	drv->devState = 1;
 	
+	if (drv->bufCount)
+	{
+		UINT8 retVal8;
+		
+		drv->bufSpace = (UINT8*)malloc(drv->bufSize * drv->bufCount);
+		drv->bufFill = (UINT32*)calloc(drv->bufCount, sizeof(UINT32));
+		drv->fillIdx = 0;
+		drv->readIdx = 0;
+		drv->pendCnt = 0;
+		OSSignal_Reset(drv->hSigData);
+		OSSignal_Reset(drv->hSigFree);
+		retVal8 = 0xFF;
+		if (drv->bufSpace != NULL && drv->bufFill != NULL)
+			retVal8 = OSThread_Init(&drv->hThread, &WavWrtThread, drv);
+		if (retVal8)
+		{
+			drv->devState = 0;
+			free(drv->bufSpace);	drv->bufSpace = NULL;
+			free(drv->bufFill);	drv->bufFill = NULL;
+			fclose(drv->hFile);	drv->hFile = NULL;
+			return 0xC8;	// CreateThread failed
+		}
+	}
+	
 	return AERR_OK;
 }
 
@@ -262,6 +377,20 @@ UINT8 WavWrt_Stop(void* drvObj)
 	if (drv->devState != 1)
 		return AERR_NOT_OPEN;
 	
+	if (drv->bufCount)
+	{
+		// write remaining data and wait for the thread to finish
+		if (drv->bufFill[drv->fillIdx])
+			QueueBuffer(drv);
+		OSMutex_Lock(drv->hMutex);
+		drv->devState = 2;
+		OSMutex_Unlock(drv->hMutex);
+		OSSignal_Signal(drv->hSigData);
+		OSThread_Join(drv->hThread);
+		OSThread_Deinit(drv->hThread);	drv->hThread = NULL;
+		free(drv->bufSpace);	drv->bufSpace = NULL;
+		free(drv->bufFill);	drv->bufFill = NULL;
+	}
 	drv->devState = 2;
 	
 	fseek(drv->hFile, drv->hdrSize - 0x04, SEEK_SET);
@@ -295,7 +424,17 @@ UINT32 WavWrt_GetBufferSize(void* drvObj)
 
 UINT8 WavWrt_IsBusy(void* drvObj)
 {
-	return AERR_OK;
+	DRV_WAV_WRT* drv = (DRV_WAV_WRT*)drvObj;
+	UINT32 pendCnt;
+	
+	if (! drv->bufCount || drv->devState != 1)
+		return AERR_OK;
+	
+	// busy when the next full buffer would have to wait for the disk
+	OSMutex_Lock(drv->hMutex);
+	pendCnt = drv->pendCnt;
+	OSMutex_Unlock(drv->hMutex);
+	return (pendCnt >= drv->bufCount - 1) ? AERR_BUSY : AERR_OK;
 }
 
 UINT8 WavWrt_WriteData(void* drvObj, UINT32 dataSize, void* data)
@@ -306,10 +445,31 @@ UINT8 WavWrt_WriteData(void* drvObj, UINT32 dataSize, void* data)
 	if (drv->hFile == NULL)
 		return AERR_NOT_OPEN;
 	
-	wrtBytes = (UINT32)fwrite(data, 0x01, dataSize, drv->hFile);
-	if (! wrtBytes)
+	if (! drv->bufCount)
+	{
+		wrtBytes = (UINT32)fwrite(data, 0x01, dataSize, drv->hFile);
+		if (! wrtBytes)
+			return AERR_FILE_ERR;
+		drv->wrtDataBytes += wrtBytes;
+		return AERR_OK;
+	}
+	
+	if (drv->wrtError)
 		return AERR_FILE_ERR;
-	drv->wrtDataBytes += wrtBytes;
+	while(dataSize > 0)
+	{
+		UINT32* fill = &drv->bufFill[drv->fillIdx];
+		
+		wrtBytes = drv->bufSize - *fill;
+		if (wrtBytes > dataSize)
+			wrtBytes = dataSize;
+		memcpy(&drv->bufSpace[drv->fillIdx * drv->bufSize + *fill], data, wrtBytes);
+		*fill += wrtBytes;
+		data = (UINT8*)data + wrtBytes;
+		dataSize -= wrtBytes;
+		if (*fill == drv->bufSize)
+			QueueBuffer(drv);
+	}
 	
 	return AERR_OK;
 }
@@ -319,6 +479,78 @@ UINT32 WavWrt_GetLatency(void* drvObj)
 	return 0;
 }
 
+// hands the current buffer over to the writer thread and continues with the next one
+// Waits only when all buffers are still waiting to be written.
+static void QueueBuffer(DRV_WAV_WRT* drv)
+{
+	OSMutex_Lock(drv->hMutex);
+	drv->pendCnt ++;
+	OSMutex_Unlock(drv->hMutex);
+	OSSignal_Signal(drv->hSigData);
+	
+	drv->fillIdx ++;
+	if (drv->fillIdx >= drv->bufCount)
+		drv->fillIdx = 0;
+	WaitForQueue(drv, drv->bufCount - 1);
+	drv->bufFill[drv->fillIdx] = 0;
+	
+	return;
+}
+
+static void WaitForQueue(DRV_WAV_WRT* drv, UINT32 maxPending)
+{
+	OSMutex_Lock(drv->hMutex);
+	while(drv->pendCnt > maxPending)
+	{
+		OSMutex_Unlock(drv->hMutex);
+		OSSignal_Wait(drv->hSigFree);
+		OSMutex_Lock(drv->hMutex);
+	}
+	OSMutex_Unlock(drv->hMutex);
+	
+	return;
+}
+
+static void WavWrtThread(void* Arg)
+{
+	DRV_WAV_WRT* drv = (DRV_WAV_WRT*)Arg;
+	UINT32 pendCnt;
+	UINT32 wrtBytes;
+	
+	while(1)
+	{
+		OSMutex_Lock(drv->hMutex);
+		pendCnt = drv->pendCnt;
+		if (! pendCnt && drv->devState != 1)
+		{
+			OSMutex_Unlock(drv->hMutex);
+			break;	// everything was written, quit
+		}
+		OSMutex_Unlock(drv->hMutex);
+		if (! pendCnt)
+		{
+			OSSignal_Wait(drv->hSigData);
+			continue;
+		}
+		
+		wrtBytes = (UINT32)fwrite(&drv->bufSpace[drv->readIdx * drv->bufSize], 0x01,
+									drv->bufFill[drv->readIdx], drv->hFile);
+		if (wrtBytes < drv->bufFill[drv->readIdx])
+			drv->wrtError = 1;
+		drv->wrtDataBytes += wrtBytes;
+		drv->readIdx ++;
+		if (drv->readIdx >= drv->bufCount)
+			drv->readIdx = 0;
+		
+		OSMutex_Lock(drv->hMutex);
+		drv->pendCnt --;
+		OSMutex_Unlock(drv->hMutex);
+		OSSignal_Signal(drv->hSigFree);
+	}
+	
+	return;
+}
+
 
 INLINE size_t fputLE16(UINT16 Value, FILE* hFile)
 {
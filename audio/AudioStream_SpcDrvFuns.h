@@ -14,6 +14,27 @@ extern "C"
 #ifdef AUDDRV_WAVEWRITE
 UINT8 WavWrt_SetFileName(void* drvObj, const char* fileName);
 const char* WavWrt_GetFileName(void* drvObj);
+UINT8 WavWrt_SetBufferSize(void* drvObj, UINT32 bufSize, UINT32 bufCount);	// bufCount = 0: write synchronously
+UINT8 WavWrt_Flush(void* drvObj);	// write all buffered data and wait for completion
+#endif
+
+#ifdef AUDDRV_NULL
+typedef struct _null_driver_stats
+{
+	UINT32 buffers;		// number of buffers sent to the device
+	UINT32 underruns;	// number of buffers that arrived after the device ran out of data
+	UINT32 renderMin;	// time spent in the callback per buffer (usec), 0 when no callback is used
+	UINT32 renderMax;
+	UINT32 renderAvg;
+	UINT32 jitterMax;	// delay of the callback relative to the device's request (usec)
+	UINT32 jitterAvg;
+	UINT32 bufPeriod;	// real time the device needs to play one buffer (usec), 0 = not running at a fixed speed
+} NULLDRV_STATS;
+
+UINT8 NullDrv_SetSpeed(void* drvObj, double speed);	// 1.0 = realtime, 0.0 = as fast as possible
+double NullDrv_GetSpeed(void* drvObj);
+UINT8 NullDrv_GetStats(void* drvObj, NULLDRV_STATS* retStats);
+UINT8 NullDrv_ResetStats(void* drvObj);
 #endif
 
 #ifdef AUDDRV_DSOUND
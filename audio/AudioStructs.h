@@ -76,6 +76,7 @@ typedef struct _audio_driver
 #define ADRVTYPE_OUT	0x01	// stream to speakers
 #define ADRVTYPE_DISK	0x02	// write to disk
 
+#define ADRVSIG_NULL	0x00	// Null Driver (no output)
 #define ADRVSIG_WAVEWRT	0x01	// WAV Writer
 #define ADRVSIG_WINMM	0x10	// [Windows] WinMM
 #define ADRVSIG_DSOUND	0x11	// [Windows] DirectSound
@@ -0,0 +1,226 @@
+#include <stdlib.h>
+#include <string.h>	// for memset(), memmove()
+#include <math.h>
+
+#include "../stdtype.h"
+#include "snddef.h"
+#include "EmuHelper.h"	// for M_PI
+#include "BlipBuf.h"
+
+// The buffer stores the band-limited derivative of the signal, i.e. each level change adds
+// a windowed-sinc impulse. Reading integrates it back into a signal made of band-limited steps.
+
+#define BLIP_TAPS		16	// length of the impulse kernel (in samples)
+#define BLIP_PHASE_BITS	8	// sub-sample resolution of the step position
+#define BLIP_PHASES		(1 << BLIP_PHASE_BITS)
+#define BLIP_KERNEL_BITS	14	// fixed point precision of the kernel, each phase sums up to (1 << BLIP_KERNEL_BITS)
+#define BLIP_CUTOFF		0.875	// cutoff frequency, relative to the Nyquist frequency
+#define BLIP_FRAC_BITS	32	// fractional bits of sample positions
+#define BLIP_EXTRA		(BLIP_TAPS + BLIP_MAX_RATIO)	// buffer space required beyond the frame end
+
+struct _blip_buffer
+{
+	UINT64 factor;	// output samples per clock (32.32 fixed point)
+	UINT64 offset;	// position of the current frame's beginning, relative to the first unread sample (32.32 fixed point)
+	INT32 integrator;
+	UINT32 size;	// maximum frame size (in samples)
+	INT32* buf;		// size + BLIP_EXTRA entries
+	INT16 kernel[BLIP_PHASES][BLIP_TAPS];
+};
+
+static void Blip_GenerateKernel(BLIP_BUF* blip)
+{
+	const double halfWidth = BLIP_TAPS / 2;
+	double kern[BLIP_TAPS];
+	double sum;
+	double t;
+	double x;
+	INT32 intSum;
+	UINT32 phase;
+	UINT32 curTap;
+	UINT32 maxTap;
+
+	for (phase = 0; phase < BLIP_PHASES; phase ++)
+	{
+		// the step happens (phase / BLIP_PHASES) samples after the first tap,
+		// the kernel delays it by (BLIP_TAPS / 2 - 1) samples
+		sum = 0.0;
+		for (curTap = 0; curTap < BLIP_TAPS; curTap ++)
+		{
+			t = (double)curTap - (halfWidth - 1) - (double)phase / BLIP_PHASES;
+			x = M_PI * BLIP_CUTOFF * t;
+			kern[curTap] = (x == 0.0) ? 1.0 : sin(x) / x;
+			// Blackman window
+			kern[curTap] *= 0.42 + 0.5 * cos(M_PI * t / halfWidth) + 0.08 * cos(2 * M_PI * t / halfWidth);
+			sum += kern[curTap];
+		}
+
+		// normalize, so that the sum of all taps is exact and the integrated signal doesn't drift
+		intSum = 0;
+		maxTap = 0;
+		for (curTap = 0; curTap < BLIP_TAPS; curTap ++)
+		{
+			blip->kernel[phase][curTap] = (INT16)floor(kern[curTap] / sum * (1 << BLIP_KERNEL_BITS) + 0.5);
+			intSum += blip->kernel[phase][curTap];
+			if (blip->kernel[phase][curTap] > blip->kernel[phase][maxTap])
+				maxTap = curTap;
+		}
+		blip->kernel[phase][maxTap] += (INT16)((1 << BLIP_KERNEL_BITS) - intSum);
+	}
+
+	return;
+}
+
+UINT8 Blip_Init(BLIP_BUF** retBlip, UINT32 maxSamples)
+{
+	BLIP_BUF* blip;
+
+	blip = (BLIP_BUF*)calloc(1, sizeof(BLIP_BUF));
+	if (blip == NULL)
+		return 0xFF;
+	blip->size = maxSamples;
+	blip->buf = (INT32*)calloc(maxSamples + BLIP_EXTRA, sizeof(INT32));
+	if (blip->buf == NULL)
+	{
+		free(blip);
+		return 0xFF;
+	}
+	Blip_GenerateKernel(blip);
+	blip->factor = (UINT64)1 << BLIP_FRAC_BITS;
+	Blip_Clear(blip);
+
+	*retBlip = blip;
+	return 0x00;
+}
+
+void Blip_Deinit(BLIP_BUF* blip)
+{
+	free(blip->buf);
+	free(blip);
+
+	return;
+}
+
+UINT8 Blip_SetRates(BLIP_BUF* blip, double clockRate, double smplRate)
+{
+	double factor;
+
+	if (clockRate <= 0.0 || smplRate > clockRate * BLIP_MAX_RATIO)
+		return 0x80;
+	factor = smplRate / clockRate * (double)((UINT64)1 << BLIP_FRAC_BITS);
+	blip->factor = (UINT64)ceil(factor);
+
+	return 0x00;
+}
+
+void Blip_Clear(BLIP_BUF* blip)
+{
+	blip->offset = 0;
+	blip->integrator = 0;
+	memset(blip->buf, 0x00, (blip->size + BLIP_EXTRA) * sizeof(INT32));
+
+	return;
+}
+
+UINT32 Blip_ClocksNeeded(const BLIP_BUF* blip, UINT32 samples)
+{
+	UINT64 needed;
+
+	needed = (UINT64)samples << BLIP_FRAC_BITS;
+	if (blip->offset >= needed)
+		return 0;
+	return (UINT32)((needed - blip->offset + blip->factor - 1) / blip->factor);
+}
+
+void Blip_AddDelta(BLIP_BUF* blip, UINT32 clockTime, INT32 delta)
+{
+	UINT64 pos;
+	UINT32 idx;
+	const INT16* kern;
+	INT32* out;
+	UINT32 curTap;
+
+	pos = blip->offset + clockTime * blip->factor;
+	idx = (UINT32)(pos >> BLIP_FRAC_BITS);
+	if (idx >= blip->size + BLIP_MAX_RATIO)
+		return;	// outside of the frame - ignore
+	kern = blip->kernel[(UINT32)pos >> (BLIP_FRAC_BITS - BLIP_PHASE_BITS)];
+	out = &blip->buf[idx];
+	for (curTap = 0; curTap < BLIP_TAPS; curTap ++)
+		out[curTap] += delta * kern[curTap];
+
+	return;
+}
+
+void Blip_EndFrame(BLIP_BUF* blip, UINT32 clockDuration)
+{
+	blip->offset += clockDuration * blip->factor;
+
+	return;
+}
+
+UINT32 Blip_SamplesAvail(const BLIP_BUF* blip)
+{
+	return (UINT32)(blip->offset >> BLIP_FRAC_BITS);
+}
+
+static void Blip_RemoveSamples(BLIP_BUF* blip, UINT32 count, UINT32 avail)
+{
+	UINT32 remain;
+
+	// move the unread samples and the kernel tails to the front
+	remain = avail - count + BLIP_TAPS;
+	memmove(&blip->buf[0], &blip->buf[count], remain * sizeof(INT32));
+	memset(&blip->buf[remain], 0x00, count * sizeof(INT32));
+	blip->offset -= (UINT64)count << BLIP_FRAC_BITS;
+
+	return;
+}
+
+UINT32 Blip_ReadSamples(BLIP_BUF* blip, DEV_SMPL* buffer, UINT32 count)
+{
+	UINT32 avail;
+	UINT32 curSmpl;
+	INT32 sum;
+
+	avail = Blip_SamplesAvail(blip);
+	if (count > avail)
+		count = avail;
+	if (! count)
+		return 0;
+
+	sum = blip->integrator;
+	for (curSmpl = 0; curSmpl < count; curSmpl ++)
+	{
+		sum += blip->buf[curSmpl];
+		buffer[curSmpl] = sum >> BLIP_KERNEL_BITS;
+	}
+	blip->integrator = sum;
+	Blip_RemoveSamples(blip, count, avail);
+
+	return count;
+}
+
+UINT32 Blip_MixSamples(BLIP_BUF* blip, DEV_SMPL* buffer, UINT32 count, UINT32 stride, INT32 gain)
+{
+	UINT32 avail;
+	UINT32 curSmpl;
+	INT32 sum;
+
+	avail = Blip_SamplesAvail(blip);
+	if (count > avail)
+		count = avail;
+	if (! count)
+		return 0;
+
+	sum = blip->integrator;
+	for (curSmpl = 0; curSmpl < count; curSmpl ++, buffer += stride)
+	{
+		sum += blip->buf[curSmpl];
+		*buffer += (sum >> BLIP_KERNEL_BITS) * gain;
+	}
+	blip->integrator = sum;
+	Blip_RemoveSamples(blip, count, avail);
+
+	return count;
+}
@@ -0,0 +1,114 @@
+#ifndef __BLIPBUF_H__
+#define __BLIPBUF_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "../stdtype.h"
+#include "snddef.h"
+
+// Band-limited step buffer.
+// Sound cores that generate square waves can use this to synthesize their output directly
+// at the output sample rate: Instead of rendering every internal clock cycle, they only
+// report the level changes (with their clock timestamp) and the buffer turns them into
+// band-limited steps. This avoids both the aliasing of naive point sampling and the cost
+// of running and resampling the core at its native rate.
+//
+// Usage per frame:
+//   clocks = Blip_ClocksNeeded(blip, samples);
+//   [call Blip_AddDelta() for all level changes with 0 <= time < clocks]
+//   Blip_EndFrame(blip, clocks);
+//   Blip_ReadSamples(blip, buffer, samples);
+typedef struct _blip_buffer BLIP_BUF;
+
+#define BLIP_MAX_RATIO	16	// maximum ratio of sample rate / clock rate
+
+/**
+ * @brief Creates a new band-limited step buffer.
+ *
+ * @param retBlip buffer for the pointer to the new instance
+ * @param maxSamples maximum number of samples that can be rendered in one frame
+ * @return 0x00 on success, 0xFF if out of memory
+ */
+UINT8 Blip_Init(BLIP_BUF** retBlip, UINT32 maxSamples);
+/**
+ * @brief Frees a band-limited step buffer.
+ *
+ * @param blip instance to be freed
+ */
+void Blip_Deinit(BLIP_BUF* blip);
+/**
+ * @brief Sets the clock rate of the input timestamps and the output sample rate.
+ *        The current buffer contents are kept.
+ *
+ * @param blip buffer instance
+ * @param clockRate rate of the timestamps passed to Blip_AddDelta(), in Hz
+ * @param smplRate output sample rate, in Hz
+ * @return 0x00 on success, 0x80 if the sample rate exceeds the clock rate by more than BLIP_MAX_RATIO
+ */
+UINT8 Blip_SetRates(BLIP_BUF* blip, double clockRate, double smplRate);
+/**
+ * @brief Clears all pending samples and resets the output level to 0.
+ *
+ * @param blip buffer instance
+ */
+void Blip_Clear(BLIP_BUF* blip);
+/**
+ * @brief Returns the number of clocks that must be rendered to make the specified number of samples available.
+ *
+ * @param blip buffer instance
+ * @param samples number of samples, must not exceed the maxSamples value passed to Blip_Init()
+ * @return number of clocks
+ */
+UINT32 Blip_ClocksNeeded(const BLIP_BUF* blip, UINT32 samples);
+/**
+ * @brief Adds a level change to the current frame.
+ *
+ * @param blip buffer instance
+ * @param clockTime time of the level change, in clocks relative to the beginning of the frame
+ * @param delta difference between the new and the old level, should stay within the 16-bit range
+ */
+void Blip_AddDelta(BLIP_BUF* blip, UINT32 clockTime, INT32 delta);
+/**
+ * @brief Ends the current frame and makes its samples available for reading.
+ *
+ * @param blip buffer instance
+ * @param clockDuration length of the frame in clocks, usually the value returned by Blip_ClocksNeeded()
+ */
+void Blip_EndFrame(BLIP_BUF* blip, UINT32 clockDuration);
+/**
+ * @brief Returns the number of samples that can be read.
+ *
+ * @param blip buffer instance
+ * @return number of available samples
+ */
+UINT32 Blip_SamplesAvail(const BLIP_BUF* blip);
+/**
+ * @brief Reads samples from the buffer and removes them.
+ *
+ * @param blip buffer instance
+ * @param buffer buffer for the samples
+ * @param count maximum number of samples to be read
+ * @return number of samples read
+ */
+UINT32 Blip_ReadSamples(BLIP_BUF* blip, DEV_SMPL* buffer, UINT32 count);
+/**
+ * @brief Reads samples from the buffer, removes them and adds them to a mixing buffer.
+ *        The result is the same as Blip_ReadSamples() followed by (buffer[i * stride] += smpl[i] * gain).
+ *
+ * @param blip buffer instance
+ * @param buffer mixing buffer the samples are added to
+ * @param count maximum number of samples to be read
+ * @param stride distance between two samples in the mixing buffer (e.g. 2 for interleaved stereo)
+ * @param gain factor the samples are multiplied with
+ * @return number of samples read
+ */
+UINT32 Blip_MixSamples(BLIP_BUF* blip, DEV_SMPL* buffer, UINT32 count, UINT32 stride, INT32 gain);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __BLIPBUF_H__
@@ -5,6 +5,7 @@
 #include "../stdtype.h"
 #include "../common_def.h"	// for INLINE
 #include "EmuStructs.h"
+#include "MemArena.h"
 
 #ifdef _DEBUG
 #include <stdio.h>
@@ -46,6 +47,23 @@ INLINE void INIT_DEVINF(DEV_INFO* devInf, DEV_DATA* devData, UINT32 sampleRate,
 // get parent struct from chip data pointer
 #define CHP_GET_INF_PTR(info)	(((DEV_DATA*)info)->chipInf)
 
+// allocates a zero-initialized chip structure (starting with DEV_DATA), arena = NULL: use the heap
+INLINE void* DevData_Alloc(MEM_ARENA* arena, size_t size)
+{
+	DEV_DATA* devData = (DEV_DATA*)MemArena_Alloc(arena, size);
+	if (devData != NULL)
+		devData->memArena = arena;
+	return devData;
+}
+
+// frees a chip structure that was allocated using DevData_Alloc()
+INLINE void DevData_Free(void* info)
+{
+	if (info != NULL)
+		MemArena_Free(((DEV_DATA*)info)->memArena, info);
+	return;
+}
+
 
 #define SRATE_CUSTOM_HIGHEST(srmode, rate, customrate)	\
 	if (srmode == DEVRI_SRMODE_CUSTOM ||	\
@@ -81,4 +99,27 @@ INLINE UINT32 pow2_mask(UINT32 v)
 	return v;
 }
 
+// per-instance replacement for rand(), so that noise generators don't depend on global state
+// (LCG from the C standard, returns 0..0xFFFF)
+INLINE UINT16 emu_rand(UINT32* seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return (UINT16)(*seed >> 16);
+}
+
+// FNV-1a hash, used for device state hashes (RWF_STATE)
+#define EMU_HASH_INIT	(((UINT64)0xCBF29CE4 << 32) | 0x84222325)
+INLINE UINT64 EmuHash_Data(UINT64 hash, const void* data, size_t size)
+{
+	const UINT8* bytes = (const UINT8*)data;
+	size_t curByte;
+	
+	for (curByte = 0; curByte < size; curByte ++)
+	{
+		hash ^= bytes[curByte];
+		hash *= ((UINT64)0x00000100 << 32) | 0x000001B3;
+	}
+	return hash;
+}
+
 #endif	// __EMUHELPER_H__
@@ -0,0 +1,48 @@
+// Thread-safe one-time initialization
+// The flag goes 0 (not run) -> 1 (running) -> 2 (done).
+// The thread that moves it from 0 to 1 calls the function, all others wait for state 2.
+#include "../stdtype.h"
+#include "EmuOnce.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <windows.h>
+#define ATOMIC_LOAD(ptr)		(INT32)_InterlockedCompareExchange((volatile long*)(ptr), 0, 0)
+#define ATOMIC_STORE(ptr, val)	_InterlockedExchange((volatile long*)(ptr), (long)(val))
+#define ATOMIC_CAS(ptr, oldv, newv)	((INT32)_InterlockedCompareExchange((volatile long*)(ptr), (long)(newv), (long)(oldv)) == (oldv))
+#define THREAD_YIELD()			Sleep(0)
+#elif defined(__GNUC__)
+#include <sched.h>
+#define ATOMIC_LOAD(ptr)		__atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE(ptr, val)	__atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#define ATOMIC_CAS(ptr, oldv, newv)	__sync_bool_compare_and_swap(ptr, oldv, newv)
+#define THREAD_YIELD()			sched_yield()
+#else
+// no atomics available - not thread-safe
+#define ATOMIC_LOAD(ptr)		(*(ptr))
+#define ATOMIC_STORE(ptr, val)	*(ptr) = (val)
+#define ATOMIC_CAS(ptr, oldv, newv)	((*(ptr) == (oldv)) ? (*(ptr) = (newv), 1) : 0)
+#define THREAD_YIELD()
+#endif
+
+#define ONCE_NONE	0
+#define ONCE_BUSY	1
+#define ONCE_DONE	2
+
+void Emu_CallOnce(EMU_ONCE* once, void (*initFunc)(void))
+{
+	if (ATOMIC_LOAD(once) == ONCE_DONE)
+		return;	// fast path: already initialized
+
+	if (ATOMIC_CAS(once, ONCE_NONE, ONCE_BUSY))
+	{
+		initFunc();
+		ATOMIC_STORE(once, ONCE_DONE);
+		return;
+	}
+
+	// another thread is building the tables right now
+	while (ATOMIC_LOAD(once) != ONCE_DONE)
+		THREAD_YIELD();
+	return;
+}
@@ -0,0 +1,30 @@
+#ifndef __EMUONCE_H__
+#define __EMUONCE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "../stdtype.h"
+
+// Thread-safe one-time initialization for the static tables of sound cores.
+// Sound cores must not keep any other mutable global state, so that independent
+// devices can be used from multiple threads at the same time.
+typedef volatile INT32 EMU_ONCE;
+#define EMU_ONCE_INIT	0
+
+/**
+ * @brief Calls a function exactly once, even when called from multiple threads at the same time.
+ *        Other threads wait until the function has finished.
+ *
+ * @param once pointer to a static flag that was initialized using EMU_ONCE_INIT
+ * @param initFunc function to be called
+ */
+void Emu_CallOnce(EMU_ONCE* once, void (*initFunc)(void));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __EMUONCE_H__
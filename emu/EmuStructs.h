@@ -20,6 +20,11 @@ typedef void (*DEVCB_SRATE_CHG)(void* info, UINT32 newSRate);
 typedef UINT8 (*DEVFUNC_START)(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 typedef void (*DEVFUNC_CTRL)(void* info);
 typedef void (*DEVFUNC_UPDATE)(void* info, UINT32 samples, DEV_SMPL** outputs);
+// renders and adds (sample * vol) to an interleaved L/R buffer (mixBuf[i*2+0] = left, mixBuf[i*2+1] = right)
+// Note: The result must be identical to calling DEVFUNC_UPDATE and mixing the output separately.
+//       Only the copy resampler (device rate == output rate) uses it. The interpolating resamplers
+//       need the raw samples and always call DEVFUNC_UPDATE, applying the volume in their interpolation loop.
+typedef void (*DEVFUNC_UPDATE_MIX)(void* info, UINT32 samples, DEV_SMPL* mixBuf, INT32 volL, INT32 volR);
 typedef void (*DEVFUNC_OPTMASK)(void* info, UINT32 optionBits);
 typedef void (*DEVFUNC_PANALL)(void* info, const INT16* channelPanVal);
 typedef void (*DEVFUNC_SRCCB)(void* info, DEVCB_SRATE_CHG SmpRateChgCallback, void* paramPtr);
@@ -32,6 +37,7 @@ typedef UINT16 (*DEVFUNC_READ_A16D16)(void* info, UINT16 addr);
 typedef UINT32 (*DEVFUNC_READ_CLOCK)(void* info);
 typedef UINT32 (*DEVFUNC_READ_SRATE)(void* info);
 typedef UINT32 (*DEVFUNC_READ_VOLUME)(void* info);
+typedef UINT8 (*DEVFUNC_READ_STATEHASH)(void* info, UINT64* hash);	// returns 0x00 on success, 0x80 if the state can't be hashed
 
 typedef void (*DEVFUNC_WRITE_A8D8)(void* info, UINT8 addr, UINT8 data);
 typedef void (*DEVFUNC_WRITE_A8D16)(void* info, UINT8 addr, UINT16 data);
@@ -56,6 +62,8 @@ typedef void (*DEVFUNC_WRITE_VOL_LR)(void* info, INT32 volL, INT32 volR);
 #define RWF_VOLUME_LR	0x86	// volume (left/right separately)
 #define RWF_CHN_MUTE	0x90	// set channel muting (DEVRW_VALUE = single channel, DEVRW_ALL = mask)
 #define RWF_CHN_PAN		0x92	// set channel panning (DEVRW_VALUE = single channel, DEVRW_ALL = array)
+#define RWF_STATE		0xA0	// internal state (read DEVRW_ALL = add state to hash, see EmuHash_Data)
+#define RWF_UPDATE_MIX	0xB0	// mixing update (DEVRW_ALL = DEVFUNC_UPDATE_MIX, optional, replaces DEV_DEF::Update in copy mode only)
 
 // register/memory DEVRW constants
 #define DEVRW_A8D8		0x11	//  8-bit address,  8-bit data
@@ -126,6 +134,8 @@ struct _device_generic_config
 	UINT32 clock;		// chip clock
 	UINT32 smplRate;	// sample rate for SRMODE_CUSTOM/DEVRI_SRMODE_HIGHEST
 						// Note: Some cores ignore the srMode setting and always use smplRate.
+	struct _mem_arena* memArena;	// arena for the chip state (MEM_ARENA), NULL = heap
+						// Note: The device must be stopped before the arena is reset.
 };	// DEV_GEN_CFG
 
 #ifdef __cplusplus
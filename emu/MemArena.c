@@ -0,0 +1,151 @@
+#include <stdlib.h>
+#include <string.h>	// for memset()
+
+#include "../stdtype.h"
+#include "MemArena.h"
+
+#define ARENA_DEF_BLKSIZE	0x40000	// 256 KB
+#define ARENA_ALIGN			0x10	// alignment of all allocations
+
+typedef struct _mem_block MEM_BLOCK;
+struct _mem_block
+{
+	MEM_BLOCK* next;
+	size_t size;	// usable size
+	size_t used;
+	// data follows after the (aligned) header
+};
+
+struct _mem_arena
+{
+	size_t blockSize;
+	MEM_BLOCK* blocks;	// list of all blocks, the first one is the current one
+	MEM_ARENA_STATS stats;
+};
+
+#define ALIGN_SIZE(x)	(((x) + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1))
+#define BLOCK_HDR_SIZE	ALIGN_SIZE(sizeof(MEM_BLOCK))
+#define BLOCK_DATA(blk)	((UINT8*)(blk) + BLOCK_HDR_SIZE)
+
+static MEM_BLOCK* MemArena_NewBlock(MEM_ARENA* arena, size_t minSize)
+{
+	MEM_BLOCK* blk;
+	size_t size;
+	
+	size = (minSize > arena->blockSize) ? minSize : arena->blockSize;
+	blk = (MEM_BLOCK*)malloc(BLOCK_HDR_SIZE + size);
+	if (blk == NULL)
+		return NULL;
+	blk->size = size;
+	blk->used = 0;
+	blk->next = arena->blocks;
+	arena->blocks = blk;
+	
+	arena->stats.blockCount ++;
+	arena->stats.bytesReserved += size;
+	return blk;
+}
+
+UINT8 MemArena_Init(MEM_ARENA** retArena, size_t blockSize)
+{
+	MEM_ARENA* arena;
+	
+	arena = (MEM_ARENA*)calloc(1, sizeof(MEM_ARENA));
+	if (arena == NULL)
+		return 0xFF;
+	arena->blockSize = blockSize ? ALIGN_SIZE(blockSize) : ARENA_DEF_BLKSIZE;
+	arena->blocks = NULL;
+	
+	*retArena = arena;
+	return 0x00;
+}
+
+void MemArena_Deinit(MEM_ARENA* arena)
+{
+	MEM_BLOCK* blk;
+	MEM_BLOCK* nextBlk;
+	
+	for (blk = arena->blocks; blk != NULL; blk = nextBlk)
+	{
+		nextBlk = blk->next;
+		free(blk);
+	}
+	free(arena);
+	
+	return;
+}
+
+void* MemArena_Alloc(MEM_ARENA* arena, size_t size)
+{
+	MEM_BLOCK* blk;
+	void* ptr;
+	
+	if (arena == NULL)
+		return calloc(1, size);
+	
+	size = ALIGN_SIZE(size);
+	blk = arena->blocks;
+	if (blk == NULL || blk->size - blk->used < size)
+	{
+		blk = MemArena_NewBlock(arena, size);
+		if (blk == NULL)
+			return NULL;
+	}
+	
+	ptr = BLOCK_DATA(blk) + blk->used;
+	blk->used += size;
+	memset(ptr, 0x00, size);
+	
+	arena->stats.allocCount ++;
+	arena->stats.bytesUsed += size;
+	if (arena->stats.bytesPeak < arena->stats.bytesUsed)
+		arena->stats.bytesPeak = arena->stats.bytesUsed;
+	return ptr;
+}
+
+void MemArena_Free(MEM_ARENA* arena, void* ptr)
+{
+	if (arena == NULL)
+		free(ptr);
+	return;
+}
+
+void MemArena_Reset(MEM_ARENA* arena)
+{
+	MEM_BLOCK* blk;
+	MEM_BLOCK* nextBlk;
+	size_t totalSize;
+	
+	arena->stats.resetCount ++;
+	arena->stats.allocCount = 0;
+	arena->stats.bytesUsed = 0;
+	if (arena->blocks == NULL)
+		return;
+	
+	if (arena->blocks->next == NULL)
+	{
+		arena->blocks->used = 0;
+		return;
+	}
+	
+	// The last session needed multiple blocks. Replace them with a single block
+	// that is large enough, so that the next session of the same kind fits into it.
+	totalSize = 0;
+	for (blk = arena->blocks; blk != NULL; blk = nextBlk)
+	{
+		nextBlk = blk->next;
+		totalSize += blk->size;
+		free(blk);
+	}
+	arena->blocks = NULL;
+	arena->stats.bytesReserved = 0;
+	MemArena_NewBlock(arena, totalSize);
+	
+	return;
+}
+
+void MemArena_GetStats(const MEM_ARENA* arena, MEM_ARENA_STATS* retStats)
+{
+	*retStats = arena->stats;
+	return;
+}
@@ -0,0 +1,75 @@
+#ifndef __MEMARENA_H__
+#define __MEMARENA_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>	// for size_t
+#include "../stdtype.h"
+
+// Simple arena allocator for per-session allocations.
+// Allocations are never freed individually. Instead, MemArena_Reset() releases everything at once
+// and keeps the memory blocks for reuse by the next session.
+typedef struct _mem_arena MEM_ARENA;
+
+typedef struct _mem_arena_stats
+{
+	UINT32 allocCount;	// number of allocations since the last reset
+	UINT32 resetCount;	// number of resets
+	UINT32 blockCount;	// number of memory blocks requested from the system (lifetime)
+	size_t bytesUsed;	// bytes currently allocated
+	size_t bytesPeak;	// highest value of bytesUsed (lifetime)
+	size_t bytesReserved;	// size of all memory blocks currently owned by the arena
+} MEM_ARENA_STATS;
+
+/**
+ * @brief Creates a new memory arena.
+ *
+ * @param retArena buffer for the pointer to the arena
+ * @param blockSize minimum size of the memory blocks requested from the system, 0 = default
+ * @return 0x00 on success, 0xFF if out of memory
+ */
+UINT8 MemArena_Init(MEM_ARENA** retArena, size_t blockSize);
+/**
+ * @brief Frees the arena and all memory allocated from it.
+ *
+ * @param arena arena to be freed
+ */
+void MemArena_Deinit(MEM_ARENA* arena);
+/**
+ * @brief Allocates zero-initialized memory from an arena.
+ *
+ * @param arena arena to allocate from, NULL = use calloc()
+ * @param size number of bytes to allocate
+ * @return pointer to the allocated memory, NULL if out of memory
+ */
+void* MemArena_Alloc(MEM_ARENA* arena, size_t size);
+/**
+ * @brief Frees memory allocated with MemArena_Alloc().
+ *        Does nothing for arena memory, as it is only released by MemArena_Reset().
+ *
+ * @param arena arena the memory was allocated from, NULL = use free()
+ * @param ptr memory to be freed
+ */
+void MemArena_Free(MEM_ARENA* arena, void* ptr);
+/**
+ * @brief Releases all allocations at once. The memory is kept for reuse.
+ *
+ * @param arena arena to be reset
+ */
+void MemArena_Reset(MEM_ARENA* arena);
+/**
+ * @brief Retrieves allocation statistics.
+ *
+ * @param arena arena to be queried
+ * @param retStats buffer for the statistics
+ */
+void MemArena_GetStats(const MEM_ARENA* arena, MEM_ARENA_STATS* retStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __MEMARENA_H__
@@ -0,0 +1,142 @@
+#include <stdlib.h>
+#include <string.h>	// for memcmp()
+
+#include "../stdtype.h"
+#include "PcmCache.h"
+
+#define PCMCACHE_DEF_MAXSIZE	0x2000000	// 32 MB
+#define PCMCACHE_HASH_BITS	8
+#define PCMCACHE_HASH_SIZE	(1 << PCMCACHE_HASH_BITS)
+#define PCMCACHE_MIN_ALLOC	0x100	// minimum number of samples per allocation
+#define PCMCACHE_SMPL_BYTES	(sizeof(INT16) * 2)	// sample + state
+
+struct _pcm_cache
+{
+	size_t maxBytes;
+	size_t usedBytes;
+	PCM_CACHE_ENTRY* hash[PCMCACHE_HASH_SIZE];
+};
+
+static UINT32 PcmCache_Hash(const UINT32* key)
+{
+	UINT32 hash;
+	UINT32 curKey;
+
+	hash = 0;
+	for (curKey = 0; curKey < PCMCACHE_KEY_LEN; curKey ++)
+		hash = (hash ^ key[curKey]) * 0x9E3779B1;
+	return hash >> (32 - PCMCACHE_HASH_BITS);
+}
+
+UINT8 PcmCache_Init(PCM_CACHE** retCache, size_t maxBytes)
+{
+	PCM_CACHE* cache;
+
+	cache = (PCM_CACHE*)calloc(1, sizeof(PCM_CACHE));
+	if (cache == NULL)
+		return 0xFF;
+	cache->maxBytes = maxBytes ? maxBytes : PCMCACHE_DEF_MAXSIZE;
+	cache->usedBytes = 0;
+
+	*retCache = cache;
+	return 0x00;
+}
+
+void PcmCache_Deinit(PCM_CACHE* cache)
+{
+	PcmCache_Clear(cache);
+	free(cache);
+
+	return;
+}
+
+void PcmCache_Clear(PCM_CACHE* cache)
+{
+	UINT32 curBucket;
+	PCM_CACHE_ENTRY* entry;
+	PCM_CACHE_ENTRY* nextEntry;
+
+	for (curBucket = 0; curBucket < PCMCACHE_HASH_SIZE; curBucket ++)
+	{
+		for (entry = cache->hash[curBucket]; entry != NULL; entry = nextEntry)
+		{
+			nextEntry = entry->next;
+			free(entry->smpl);
+			free(entry->state);
+			free(entry);
+		}
+		cache->hash[curBucket] = NULL;
+	}
+	cache->usedBytes = 0;
+
+	return;
+}
+
+PCM_CACHE_ENTRY* PcmCache_Get(PCM_CACHE* cache, const UINT32* key, UINT32 sizeHint)
+{
+	UINT32 bucket;
+	PCM_CACHE_ENTRY* entry;
+
+	bucket = PcmCache_Hash(key);
+	for (entry = cache->hash[bucket]; entry != NULL; entry = entry->next)
+	{
+		if (! memcmp(entry->key, key, sizeof(entry->key)))
+			return entry;
+	}
+
+	if (cache->usedBytes + sizeof(PCM_CACHE_ENTRY) > cache->maxBytes)
+		return NULL;
+	entry = (PCM_CACHE_ENTRY*)calloc(1, sizeof(PCM_CACHE_ENTRY));
+	if (entry == NULL)
+		return NULL;
+	memcpy(entry->key, key, sizeof(entry->key));
+	entry->length = 0;
+	entry->alloc = 0;
+	entry->smpl = NULL;
+	entry->state = NULL;
+	cache->usedBytes += sizeof(PCM_CACHE_ENTRY);
+	if (sizeHint)
+		PcmCache_Grow(cache, entry, sizeHint);	// a failure is no problem here
+
+	entry->next = cache->hash[bucket];
+	cache->hash[bucket] = entry;
+	return entry;
+}
+
+UINT8 PcmCache_Grow(PCM_CACHE* cache, PCM_CACHE_ENTRY* entry, UINT32 minSize)
+{
+	UINT32 newSize;
+	size_t addBytes;
+	INT16* newSmpl;
+	INT16* newState;
+
+	if (minSize <= entry->alloc)
+		return 0x00;
+	newSize = entry->alloc * 2;
+	if (newSize < minSize)
+		newSize = minSize;
+	if (newSize < PCMCACHE_MIN_ALLOC)
+		newSize = PCMCACHE_MIN_ALLOC;
+	addBytes = (newSize - entry->alloc) * PCMCACHE_SMPL_BYTES;
+	if (cache->usedBytes + addBytes > cache->maxBytes)
+	{
+		// try with the minimum size
+		newSize = minSize;
+		addBytes = (newSize - entry->alloc) * PCMCACHE_SMPL_BYTES;
+		if (cache->usedBytes + addBytes > cache->maxBytes)
+			return 0xFF;
+	}
+
+	newSmpl = (INT16*)realloc(entry->smpl, newSize * sizeof(INT16));
+	if (newSmpl == NULL)
+		return 0xFF;
+	entry->smpl = newSmpl;
+	newState = (INT16*)realloc(entry->state, newSize * sizeof(INT16));
+	if (newState == NULL)
+		return 0xFF;	// entry->alloc stays, so the larger smpl buffer is just not used
+	entry->state = newState;
+	entry->alloc = newSize;
+	cache->usedBytes += addBytes;
+
+	return 0x00;
+}
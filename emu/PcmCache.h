@@ -0,0 +1,105 @@
+#ifndef __PCMCACHE_H__
+#define __PCMCACHE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>	// for size_t
+#include "../stdtype.h"
+#include "../common_def.h"	// for INLINE
+
+// Cache for decoded ADPCM samples.
+// A sample that is started from the same address with the same decoder state always decodes
+// to the same PCM data. Sound cores can store the decoded data in this cache while playing
+// a sample for the first time and use it for all further playbacks of the sample.
+//
+// Entries are filled incrementally: The first voice that plays a sample appends each decoded
+// sample together with the decoder state after it. A later playback reads the cached part and
+// continues decoding live (restoring the decoder state from the cache) where the cache ends.
+//
+// The cache doesn't know anything about the sample memory. The core has to use all parameters
+// that affect decoding (start address, end condition, bank configuration) as the key and must
+// call PcmCache_Clear() when the sample memory is written to.
+typedef struct _pcm_cache PCM_CACHE;
+
+#define PCMCACHE_KEY_LEN	4	// number of UINT32 values per key
+
+typedef struct _pcm_cache_entry PCM_CACHE_ENTRY;
+struct _pcm_cache_entry
+{
+	UINT32 key[PCMCACHE_KEY_LEN];
+	UINT32 length;	// number of decoded samples
+	UINT32 alloc;	// number of allocated samples
+	INT16* smpl;	// decoded samples
+	INT16* state;	// decoder state after each sample (core-specific, e.g. the ADPCM step size)
+	PCM_CACHE_ENTRY* next;
+};
+
+/**
+ * @brief Creates a new ADPCM cache.
+ *
+ * @param retCache buffer for the pointer to the cache
+ * @param maxBytes memory limit for all cached data, 0 = default (32 MB)
+ * @return 0x00 on success, 0xFF if out of memory
+ */
+UINT8 PcmCache_Init(PCM_CACHE** retCache, size_t maxBytes);
+/**
+ * @brief Frees a cache and all of its entries.
+ *
+ * @param cache cache to be freed
+ */
+void PcmCache_Deinit(PCM_CACHE* cache);
+/**
+ * @brief Removes all entries. All entry pointers become invalid.
+ *
+ * @param cache cache to be cleared
+ */
+void PcmCache_Clear(PCM_CACHE* cache);
+/**
+ * @brief Looks up a cache entry and creates a new (empty) one if there is none yet.
+ *
+ * @param cache cache to be searched
+ * @param key key of the sample (PCMCACHE_KEY_LEN values, unused values should be 0)
+ * @param sizeHint expected number of samples, used for the initial allocation
+ * @return pointer to the cache entry, NULL if the memory limit is reached
+ */
+PCM_CACHE_ENTRY* PcmCache_Get(PCM_CACHE* cache, const UINT32* key, UINT32 sizeHint);
+/**
+ * @brief Enlarges the sample buffers of a cache entry.
+ *
+ * @param cache cache the entry belongs to
+ * @param entry entry to be enlarged
+ * @param minSize minimum number of samples
+ * @return 0x00 on success, 0xFF if the memory limit is reached or out of memory
+ */
+UINT8 PcmCache_Grow(PCM_CACHE* cache, PCM_CACHE_ENTRY* entry, UINT32 minSize);
+
+/**
+ * @brief Appends a decoded sample to a cache entry.
+ *        The sample is only stored if it directly follows the cached data.
+ *
+ * @param cache cache the entry belongs to
+ * @param entry entry to be extended
+ * @param pos position of the sample, relative to the beginning of the entry
+ * @param smpl decoded sample
+ * @param state decoder state after the sample
+ */
+INLINE void PcmCache_Append(PCM_CACHE* cache, PCM_CACHE_ENTRY* entry, UINT32 pos, INT16 smpl, INT16 state)
+{
+	if (pos != entry->length)
+		return;
+	if (entry->length >= entry->alloc && PcmCache_Grow(cache, entry, entry->length + 1))
+		return;
+	entry->smpl[pos] = smpl;
+	entry->state[pos] = state;
+	entry->length ++;
+	return;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __PCMCACHE_H__
@@ -0,0 +1,220 @@
+// Lock-free SPSC register write queue
+// The producer owns writePos, the consumer owns readPos and curTime.
+// Each side only reads the other side's counters, so no locks are needed.
+#include <stdlib.h>
+#include <stddef.h>	// for NULL
+
+#include "../stdtype.h"
+#include "EmuStructs.h"
+#include "SoundEmu.h"
+#include "Resampler.h"
+#include "RegQueue.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define ATOMIC_LOAD(ptr)		(UINT32)_InterlockedCompareExchange((volatile long*)(ptr), 0, 0)
+#define ATOMIC_STORE(ptr, val)	_InterlockedExchange((volatile long*)(ptr), (long)(val))
+#elif defined(__GNUC__)
+#define ATOMIC_LOAD(ptr)		__atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE(ptr, val)	__atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#else
+#define ATOMIC_LOAD(ptr)		(*(ptr))
+#define ATOMIC_STORE(ptr, val)	*(ptr) = (val)
+#endif
+
+typedef struct _register_queue_entry
+{
+	UINT32 smplTime;
+	UINT8 rwType;
+	UINT16 addr;
+	UINT16 data;
+} RQ_ENTRY;
+
+struct _register_queue
+{
+	UINT32 sizeMask;
+	RQ_ENTRY* entries;
+	volatile UINT32 writePos;	// written by producer
+	volatile UINT32 readPos;	// written by consumer
+	volatile UINT32 curTime;	// written by consumer
+	
+	void* dataPtr;
+	DEVFUNC_WRITE_A8D8 writeA8D8;
+	DEVFUNC_WRITE_A8D16 writeA8D16;
+	DEVFUNC_WRITE_A16D8 writeA16D8;
+	DEVFUNC_WRITE_A16D16 writeA16D16;
+};
+
+UINT8 RegQueue_Init(REG_QUEUE** retQueue, UINT32 size)
+{
+	REG_QUEUE* queue;
+	UINT32 bufSize;
+	
+	bufSize = 1;
+	while (bufSize < size)
+		bufSize <<= 1;
+	
+	queue = (REG_QUEUE*)calloc(1, sizeof(REG_QUEUE));
+	if (queue == NULL)
+		return 0xFF;
+	queue->entries = (RQ_ENTRY*)malloc(bufSize * sizeof(RQ_ENTRY));
+	if (queue->entries == NULL)
+	{
+		free(queue);
+		return 0xFF;
+	}
+	queue->sizeMask = bufSize - 1;
+	queue->writePos = 0;
+	queue->readPos = 0;
+	queue->curTime = 0;
+	queue->dataPtr = NULL;
+	
+	*retQueue = queue;
+	return 0x00;
+}
+
+void RegQueue_Deinit(REG_QUEUE* queue)
+{
+	free(queue->entries);
+	free(queue);
+	
+	return;
+}
+
+UINT8 RegQueue_DevConnect(REG_QUEUE* queue, const DEV_INFO* devInf)
+{
+	const DEV_DEF* devDef = devInf->devDef;
+	
+	queue->writeA8D8 = NULL;
+	queue->writeA8D16 = NULL;
+	queue->writeA16D8 = NULL;
+	queue->writeA16D16 = NULL;
+	SndEmu_GetDeviceFunc(devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, (void**)&queue->writeA8D8);
+	SndEmu_GetDeviceFunc(devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D16, 0, (void**)&queue->writeA8D16);
+	SndEmu_GetDeviceFunc(devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A16D8, 0, (void**)&queue->writeA16D8);
+	SndEmu_GetDeviceFunc(devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A16D16, 0, (void**)&queue->writeA16D16);
+	queue->dataPtr = devInf->dataPtr;
+	
+	if (queue->writeA8D8 == NULL && queue->writeA8D16 == NULL &&
+		queue->writeA16D8 == NULL && queue->writeA16D16 == NULL)
+		return 0xFF;
+	return 0x00;
+}
+
+UINT8 RegQueue_Write(REG_QUEUE* queue, UINT32 smplTime, UINT8 rwType, UINT16 addr, UINT16 data)
+{
+	UINT32 wPos;
+	RQ_ENTRY* entry;
+	
+	switch(rwType)
+	{
+	case DEVRW_A8D8:
+		if (queue->writeA8D8 == NULL)
+			return 0x80;
+		break;
+	case DEVRW_A8D16:
+		if (queue->writeA8D16 == NULL)
+			return 0x80;
+		break;
+	case DEVRW_A16D8:
+		if (queue->writeA16D8 == NULL)
+			return 0x80;
+		break;
+	case DEVRW_A16D16:
+		if (queue->writeA16D16 == NULL)
+			return 0x80;
+		break;
+	default:
+		return 0x80;
+	}
+	
+	wPos = queue->writePos;	// only modified by this thread
+	if (wPos - ATOMIC_LOAD(&queue->readPos) > queue->sizeMask)
+		return 0xFF;	// queue full
+	
+	entry = &queue->entries[wPos & queue->sizeMask];
+	entry->smplTime = smplTime;
+	entry->rwType = rwType;
+	entry->addr = addr;
+	entry->data = data;
+	ATOMIC_STORE(&queue->writePos, wPos + 1);	// publish the entry
+	
+	return 0x00;
+}
+
+UINT32 RegQueue_GetTime(const REG_QUEUE* queue)
+{
+	return ATOMIC_LOAD(&queue->curTime);
+}
+
+void RegQueue_SetTime(REG_QUEUE* queue, UINT32 smplTime)
+{
+	ATOMIC_STORE(&queue->curTime, smplTime);
+	
+	return;
+}
+
+static void ExecuteWrite(REG_QUEUE* queue, const RQ_ENTRY* entry)
+{
+	switch(entry->rwType)
+	{
+	case DEVRW_A8D8:
+		queue->writeA8D8(queue->dataPtr, (UINT8)entry->addr, (UINT8)entry->data);
+		break;
+	case DEVRW_A8D16:
+		queue->writeA8D16(queue->dataPtr, (UINT8)entry->addr, entry->data);
+		break;
+	case DEVRW_A16D8:
+		queue->writeA16D8(queue->dataPtr, entry->addr, (UINT8)entry->data);
+		break;
+	case DEVRW_A16D16:
+		queue->writeA16D16(queue->dataPtr, entry->addr, entry->data);
+		break;
+	}
+	
+	return;
+}
+
+void RegQueue_Render(REG_QUEUE* queue, RESMPL_STATE* CAA, UINT32 samples, WAVE_32BS* smplBuffer)
+{
+	UINT32 curTime;
+	UINT32 rPos;
+	UINT32 wPos;
+	UINT32 smplPos;
+	
+	curTime = queue->curTime;	// only modified by this thread
+	rPos = queue->readPos;
+	wPos = ATOMIC_LOAD(&queue->writePos);
+	smplPos = 0;
+	while (smplPos < samples)
+	{
+		UINT32 renderSmpls;
+		
+		// execute all writes that are due at the current sample
+		while (rPos != wPos)
+		{
+			const RQ_ENTRY* entry = &queue->entries[rPos & queue->sizeMask];
+			INT32 timeDiff = (INT32)(entry->smplTime - curTime);
+			if (timeDiff > 0)
+				break;
+			ExecuteWrite(queue, entry);
+			rPos ++;
+		}
+		ATOMIC_STORE(&queue->readPos, rPos);	// free the slots for the producer
+		
+		// render until the next write (or the end of the block)
+		renderSmpls = samples - smplPos;
+		if (rPos != wPos)
+		{
+			UINT32 timeDiff = queue->entries[rPos & queue->sizeMask].smplTime - curTime;
+			if (renderSmpls > timeDiff)
+				renderSmpls = timeDiff;
+		}
+		Resmpl_Execute(CAA, renderSmpls, &smplBuffer[smplPos]);
+		smplPos += renderSmpls;
+		curTime += renderSmpls;
+	}
+	ATOMIC_STORE(&queue->curTime, curTime);
+	
+	return;
+}
@@ -0,0 +1,88 @@
+#ifndef __REGQUEUE_H__
+#define __REGQUEUE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "../stdtype.h"
+#include "EmuStructs.h"
+#include "Resampler.h"
+
+// Lock-free single-producer/single-consumer queue of timestamped register writes for one device.
+// One thread (e.g. MIDI/tracker input) queues writes, the audio thread renders the device using
+// RegQueue_Render(), which executes each write at its exact sample position within the block.
+// Timestamps are in samples of the output stream and wrap around at 2^32.
+typedef struct _register_queue REG_QUEUE;
+
+/**
+ * @brief Creates a register write queue.
+ *
+ * @param retQueue buffer for the pointer to the queue
+ * @param size maximum number of pending writes, rounded up to a power of 2
+ * @return 0x00 on success, 0xFF if out of memory
+ */
+UINT8 RegQueue_Init(REG_QUEUE** retQueue, UINT32 size);
+/**
+ * @brief Frees a register write queue.
+ *
+ * @param queue queue to be freed
+ */
+void RegQueue_Deinit(REG_QUEUE* queue);
+/**
+ * @brief Connects the queue to a sound device. Must be called before rendering.
+ *
+ * @param queue queue to be connected
+ * @param devInf device that receives the register writes
+ * @return 0x00 on success, 0xFF if the device has no register write function
+ */
+UINT8 RegQueue_DevConnect(REG_QUEUE* queue, const DEV_INFO* devInf);
+
+// ---- producer functions ----
+/**
+ * @brief Queues a register write. Never blocks.
+ *        Writes are executed in queue order, so timestamps should not decrease.
+ *        Writes whose time has already passed are executed at the start of the next block.
+ *
+ * @param queue queue to write to
+ * @param smplTime sample position at which the write takes effect
+ * @param rwType register write type (DEVRW_A8D8, DEVRW_A8D16, DEVRW_A16D8 or DEVRW_A16D16)
+ * @param addr register address
+ * @param data register data
+ * @return 0x00 on success, 0xFF if the queue is full, 0x80 if the device has no function of that type
+ */
+UINT8 RegQueue_Write(REG_QUEUE* queue, UINT32 smplTime, UINT8 rwType, UINT16 addr, UINT16 data);
+/**
+ * @brief Returns the current render position, i.e. the timestamp of the next sample to be rendered.
+ *        Safe to call from the producer thread.
+ *
+ * @param queue queue to be queried
+ * @return current sample position
+ */
+UINT32 RegQueue_GetTime(const REG_QUEUE* queue);
+
+// ---- consumer functions ----
+/**
+ * @brief Sets the render position. Call before rendering starts.
+ *
+ * @param queue queue to be modified
+ * @param smplTime new sample position
+ */
+void RegQueue_SetTime(REG_QUEUE* queue, UINT32 smplTime);
+/**
+ * @brief Renders a block of samples while executing all writes that are due within the block.
+ *        Advances the render position by the number of samples.
+ *
+ * @param queue queue of the device
+ * @param CAA resampler of the device
+ * @param samples number of output samples to be rendered
+ * @param smplBuffer buffer for output data (mixed into, like Resmpl_Execute)
+ */
+void RegQueue_Render(REG_QUEUE* queue, RESMPL_STATE* CAA, UINT32 samples, WAVE_32BS* smplBuffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __REGQUEUE_H__
@@ -6,6 +6,8 @@
 
 #include "../stdtype.h"
 #include "EmuStructs.h"
+#include "EmuHelper.h"	// for EmuHash_Data
+#include "SoundEmu.h"	// for SndEmu_GetDeviceFunc
 #include "Resampler.h"
 
 #define RESALGO_OLD			0x00
@@ -22,6 +24,9 @@ void Resmpl_DevConnect(RESMPL_STATE* CAA, const DEV_INFO* devInf)
 {
 	CAA->smpRateSrc = devInf->sampleRate;
 	CAA->StreamUpdate = devInf->devDef->Update;
+	CAA->StreamUpdateMix = NULL;
+	if (devInf->devDef->rwFuncs != NULL)
+		SndEmu_GetDeviceFunc(devInf->devDef, RWF_UPDATE_MIX, DEVRW_ALL, 0, (void**)&CAA->StreamUpdateMix);
 	CAA->su_DataPtr = devInf->dataPtr;
 	if (devInf->devDef->SetSRateChgCB != NULL)
 		devInf->devDef->SetSRateChgCB(CAA->su_DataPtr, Resmpl_ChangeRate, CAA);
@@ -34,6 +39,7 @@ void Resmpl_SetVals(RESMPL_STATE* CAA, UINT8 resampleMode, UINT16 volume, UINT32
 	CAA->resampleMode = resampleMode;
 	CAA->smpRateDst = destSampleRate;
 	CAA->volumeL = volume;	CAA->volumeR = volume;
+	CAA->memArena = NULL;
 	
 	return;
 }
@@ -62,7 +68,7 @@ void Resmpl_Init(RESMPL_STATE* CAA)
 	}*/
 	
 	CAA->smplBufSize = CAA->smpRateSrc / 1;	// reserve buffer for 1 second of samples
-	CAA->smplBufs[0] = (DEV_SMPL*)malloc(CAA->smplBufSize * 2 * sizeof(DEV_SMPL));
+	CAA->smplBufs[0] = (DEV_SMPL*)MemArena_Alloc(CAA->memArena, CAA->smplBufSize * 2 * sizeof(DEV_SMPL));
 	CAA->smplBufs[1] = &CAA->smplBufs[0][CAA->smplBufSize];
 	
 	CAA->smpP = 0x00;
@@ -88,7 +94,7 @@ void Resmpl_Init(RESMPL_STATE* CAA)
 
 void Resmpl_Deinit(RESMPL_STATE* CAA)
 {
-	free(CAA->smplBufs[0]);
+	MemArena_Free(CAA->memArena, CAA->smplBufs[0]);
 	CAA->smplBufs[0] = NULL;
 	CAA->smplBufs[1] = NULL;
 	
@@ -290,12 +296,20 @@ static void Resmpl_Exec_Copy(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSam
 	UINT32 OutPos;
 	
 	CAA->smpNext = CAA->smpP * CAA->smpRateSrc / CAA->smpRateDst;
-	CAA->StreamUpdate(CAA->su_DataPtr, length, CAA->smplBufs);
-	
-	for (OutPos = 0; OutPos < length; OutPos ++)
+	if (CAA->StreamUpdateMix != NULL)
 	{
-		retSample[OutPos].L += CAA->smplBufs[0][OutPos] * CAA->volumeL;
-		retSample[OutPos].R += CAA->smplBufs[1][OutPos] * CAA->volumeR;
+		// let the device add its output directly, saving the pass over the sample buffers
+		// (The other resamplers need the raw samples and apply the volume while interpolating.)
+		CAA->StreamUpdateMix(CAA->su_DataPtr, length, &retSample[0].L, CAA->volumeL, CAA->volumeR);
+	}
+	else
+	{
+		CAA->StreamUpdate(CAA->su_DataPtr, length, CAA->smplBufs);
+		for (OutPos = 0; OutPos < length; OutPos ++)
+		{
+			retSample[OutPos].L += CAA->smplBufs[0][OutPos] * CAA->volumeL;
+			retSample[OutPos].R += CAA->smplBufs[1][OutPos] * CAA->volumeR;
+		}
 	}
 	CAA->smpP += length;
 	CAA->smpLast = CAA->smpNext;
@@ -436,3 +450,34 @@ void Resmpl_Execute(RESMPL_STATE* CAA, UINT32 smplCount, WAVE_32BS* smplBuffer)
 	
 	return;
 }
+
+void Resmpl_HashState(const RESMPL_STATE* CAA, UINT64* hash)
+{
+	UINT64 h = *hash;
+	UINT64 srcPos;
+	UINT32 srcBase;
+	UINT32 srcFrac;
+	INT32 relLast;
+	INT32 relNext;
+	
+	// The input positions are hashed relative to the current output sample.
+	// This way the state matches whenever the fractional position is the same.
+	srcPos = (UINT64)CAA->smpP * CAA->smpRateSrc;
+	srcBase = (UINT32)(srcPos / CAA->smpRateDst);
+	srcFrac = (UINT32)(srcPos % CAA->smpRateDst);
+	relLast = (INT32)(CAA->smpLast - srcBase);
+	relNext = (INT32)(CAA->smpNext - srcBase);
+	h = EmuHash_Data(h, &CAA->smpRateSrc, sizeof(CAA->smpRateSrc));
+	h = EmuHash_Data(h, &CAA->smpRateDst, sizeof(CAA->smpRateDst));
+	h = EmuHash_Data(h, &CAA->volumeL, sizeof(CAA->volumeL));
+	h = EmuHash_Data(h, &CAA->volumeR, sizeof(CAA->volumeR));
+	h = EmuHash_Data(h, &CAA->resampler, sizeof(CAA->resampler));
+	h = EmuHash_Data(h, &srcFrac, sizeof(srcFrac));
+	h = EmuHash_Data(h, &relLast, sizeof(relLast));
+	h = EmuHash_Data(h, &relNext, sizeof(relNext));
+	h = EmuHash_Data(h, &CAA->lSmpl, sizeof(CAA->lSmpl));
+	h = EmuHash_Data(h, &CAA->nSmpl, sizeof(CAA->nSmpl));
+	*hash = h;
+	
+	return;
+}
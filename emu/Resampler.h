@@ -9,6 +9,7 @@ extern "C"
 #include "../stdtype.h"
 #include "snddef.h"	// for DEV_SMPL
 #include "EmuStructs.h"
+#include "MemArena.h"
 
 typedef struct _waveform_32bit_stereo
 {
@@ -29,6 +30,7 @@ typedef struct _resampling_state
 	UINT8 resampleMode;	// can be FF [auto] or Resampler Type
 	UINT8 resampler;
 	DEVFUNC_UPDATE StreamUpdate;
+	DEVFUNC_UPDATE_MIX StreamUpdateMix;	// optional, used only by the copy resampler (NULL = not supported)
 	void* su_DataPtr;
 	UINT32 smpP;		// Current Sample (Playback Rate)
 	UINT32 smpLast;		// Sample Number Last
@@ -37,6 +39,7 @@ typedef struct _resampling_state
 	WAVE_32BS nSmpl;	// Next Sample
 	UINT32 smplBufSize;
 	DEV_SMPL* smplBufs[2];
+	MEM_ARENA* memArena;	// arena for the sample buffers, NULL = heap (set by Resmpl_SetVals)
 } RESMPL_STATE;
 
 // ---- resampler helper functions (for quick/comfortable initialization) ----
@@ -54,6 +57,7 @@ void Resmpl_DevConnect(RESMPL_STATE* CAA, const DEV_INFO* devInf);
  * @param resampleMode resampling mode, 0xFF = auto
  * @param volume volume gain applied during resampling process, 8.8 fixed point, 0x100 equals 100%
  * @param destSampleRate sample rate of the output stream
+ * @note This resets memArena to NULL. Set it afterwards to allocate the buffers from an arena.
  */
 void Resmpl_SetVals(RESMPL_STATE* CAA, UINT8 resampleMode, UINT16 volume, UINT32 destSampleRate);
 
@@ -84,6 +88,13 @@ void Resmpl_ChangeRate(void* DataPtr, UINT32 newSmplRate);
  * @param smplBuffer buffer for output data
  */
 void Resmpl_Execute(RESMPL_STATE* CAA, UINT32 samples, WAVE_32BS* smplBuffer);
+/**
+ * @brief Adds the resampling state to a state hash. (see EmuHash_Data)
+ *
+ * @param CAA resampler whose state is hashed
+ * @param hash hash value to be updated
+ */
+void Resmpl_HashState(const RESMPL_STATE* CAA, UINT64* hash);
 
 #ifdef __cplusplus
 }
@@ -645,7 +645,7 @@ const char* SndEmu_GetDevName(UINT8 deviceID, UINT8 opts, const DEV_GEN_CFG* dev
 #endif
 #ifdef SNDDEV_ES5506
 	case DEVID_ES5506:
-		if (devCfg != NULL && ! devCfg->flags)
+		if (devCfg != NULL && ! (devCfg->flags & 0x01))
 			return "ES5505";
 		return "ES5506";
 #endif
@@ -0,0 +1,109 @@
+#include <stddef.h>	// for NULL
+
+#include "../stdtype.h"
+#include "snddef.h"
+#include "VoiceMix.h"
+
+void VoiceMix_Init(VMIX_VOICE* voice, UINT8 fracBits, UINT32 idxMask)
+{
+	voice->pos = 0;
+	voice->step = 0;
+	voice->fracBits = fracBits;
+	voice->idxMask = idxMask;
+	voice->idxBase = 0;
+	voice->endMarker = VMIX_NO_MARKER;
+	voice->lvlFunc = NULL;
+	voice->volL = 0;
+	voice->volR = 0;
+
+	return;
+}
+
+void VoiceMix_SetVolume(VMIX_VOICE* voice, UINT32 volL, UINT32 volR, VMIX_LEVEL_FUNC lvlFunc)
+{
+	UINT32 curVal;
+
+	if (voice->lvlFunc == lvlFunc && voice->volL == volL && voice->volR == volR)
+		return;
+
+	voice->lvlFunc = lvlFunc;
+	voice->volL = volL;
+	voice->volR = volR;
+	for (curVal = 0x00; curVal < 0x100; curVal ++)
+	{
+		voice->level[0][curVal] = lvlFunc((UINT8)curVal, volL);
+		voice->level[1][curVal] = lvlFunc((UINT8)curVal, volR);
+	}
+
+	return;
+}
+
+UINT32 VoiceMix_Render(VMIX_VOICE* voice, const UINT8* data, DEV_SMPL* outL, DEV_SMPL* outR, UINT32 samples)
+{
+	const INT32* lvlL = voice->level[0];
+	const INT32* lvlR = voice->level[1];
+	const UINT8 fracBits = voice->fracBits;
+	const UINT32 idxMask = voice->idxMask;
+	const UINT32 idxBase = voice->idxBase;
+	const UINT32 step = voice->step;
+	UINT32 pos = voice->pos;
+	UINT32 curSmpl;
+	UINT8 val;
+
+	if (voice->endMarker == VMIX_NO_MARKER)
+	{
+		if (! step)
+		{
+			// the position doesn't change - the whole span uses the same sample
+			INT32 smplL;
+			INT32 smplR;
+
+			val = data[idxBase | ((pos >> fracBits) & idxMask)];
+			smplL = lvlL[val];
+			smplR = lvlR[val];
+			for (curSmpl = 0; curSmpl < samples; curSmpl ++)
+			{
+				outL[curSmpl] += smplL;
+				outR[curSmpl] += smplR;
+			}
+			return samples;
+		}
+
+		for (curSmpl = 0; curSmpl < samples; curSmpl ++)
+		{
+			val = data[idxBase | ((pos >> fracBits) & idxMask)];
+			outL[curSmpl] += lvlL[val];
+			outR[curSmpl] += lvlR[val];
+			pos += step;
+		}
+	}
+	else
+	{
+		const UINT8 marker = (UINT8)voice->endMarker;
+
+		for (curSmpl = 0; curSmpl < samples; curSmpl ++)
+		{
+			val = data[idxBase | ((pos >> fracBits) & idxMask)];
+			if (val == marker)
+				break;
+			outL[curSmpl] += lvlL[val];
+			outR[curSmpl] += lvlR[val];
+			pos += step;
+		}
+	}
+	voice->pos = pos;
+
+	return curSmpl;
+}
+
+UINT32 VoiceMix_StepsTo(UINT64 pos, UINT32 step, UINT64 limit)
+{
+	UINT64 steps;
+
+	if (pos >= limit)
+		return 0;
+	if (! step)
+		return (UINT32)-1;
+	steps = (limit - pos + step - 1) / step;
+	return (steps > (UINT32)-1) ? (UINT32)-1 : (UINT32)steps;
+}
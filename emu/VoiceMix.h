@@ -0,0 +1,85 @@
+#ifndef __VOICEMIX_H__
+#define __VOICEMIX_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "../stdtype.h"
+#include "snddef.h"
+
+// Block-based mixer for 8-bit sample playback voices.
+// PCM cores that play samples from ROM/RAM can use this instead of a per-sample loop over all voices.
+// Each voice is rendered over a span of output samples (voice-major) and the core only handles
+// events like sample end and looping between spans.
+//
+// Volume and panning are applied using a table that holds the output value of every possible
+// sample byte for the left and right channel. This table is rebuilt only when the volume changes
+// and reproduces the core's own sample decoding and volume arithmetic exactly.
+typedef struct _vmix_voice VMIX_VOICE;
+
+// returns the output value of one sample byte at the specified volume
+typedef INT32 (*VMIX_LEVEL_FUNC)(UINT8 data, UINT32 volume);
+
+#define VMIX_NO_MARKER	0x100	// value for endMarker: don't stop at any sample value
+
+struct _vmix_voice
+{
+	UINT32 pos;			// current position (fixed point), advanced by Render
+	UINT32 step;		// position increment per output sample
+	UINT8 fracBits;		// number of fractional bits of pos/step
+	UINT32 idxMask;		// mask applied to the integer part of the position
+	UINT32 idxBase;		// value OR'ed to the masked sample index (e.g. bank offset)
+	UINT16 endMarker;	// sample byte that stops rendering (0x00..0xFF), VMIX_NO_MARKER = none
+
+	VMIX_LEVEL_FUNC lvlFunc;
+	UINT32 volL;
+	UINT32 volR;
+	INT32 level[2][0x100];	// output value for each sample byte, left/right
+};
+
+/**
+ * @brief Initializes a voice. The level table is built on the first call to VoiceMix_SetVolume().
+ *
+ * @param voice voice to be initialized
+ * @param fracBits number of fractional bits of the position
+ * @param idxMask mask for the integer part of the position
+ */
+void VoiceMix_Init(VMIX_VOICE* voice, UINT8 fracBits, UINT32 idxMask);
+/**
+ * @brief Sets the volume of a voice and rebuilds its level table if required.
+ *
+ * @param voice voice to be changed
+ * @param volL volume of the left channel, passed to lvlFunc
+ * @param volR volume of the right channel, passed to lvlFunc
+ * @param lvlFunc function that calculates the output value of a sample byte
+ */
+void VoiceMix_SetVolume(VMIX_VOICE* voice, UINT32 volL, UINT32 volR, VMIX_LEVEL_FUNC lvlFunc);
+/**
+ * @brief Renders a voice and adds its output to a stereo buffer.
+ *        Rendering stops before a sample byte that equals the voice's end marker.
+ *
+ * @param voice voice to be rendered
+ * @param data sample memory
+ * @param outL buffer for the left channel
+ * @param outR buffer for the right channel
+ * @param samples maximum number of samples to render
+ * @return number of samples rendered, less than samples if the end marker was reached
+ */
+UINT32 VoiceMix_Render(VMIX_VOICE* voice, const UINT8* data, DEV_SMPL* outL, DEV_SMPL* outR, UINT32 samples);
+/**
+ * @brief Returns the number of steps until a position reaches a limit.
+ *
+ * @param pos current position
+ * @param step position increment per output sample
+ * @param limit target position
+ * @return number of steps until pos >= limit, 0xFFFFFFFF if it is never reached
+ */
+UINT32 VoiceMix_StepsTo(UINT64 pos, UINT32 step, UINT64 limit);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __VOICEMIX_H__
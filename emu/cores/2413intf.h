@@ -12,6 +12,8 @@
 
 // cfg.flags: 0 = YM2413 mode, 1 = VRC7 mode
 
+#define OPT_YM2413_LEGACY_RATECONV	0x01	// [EMU2413 core] use the original sinc rate converter (slower, default: disabled)
+
 extern const DEV_DEF* devDefList_YM2413[];
 
 #endif	// __2413INTF_H__
@@ -57,6 +57,7 @@ Copyright(C)2006-2017 Kitao Nakamura.
 #include "../EmuStructs.h"
 #include "../EmuCores.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "Ootake_PSG.h"
 #include "Ootake_PSG_private.h"
 
@@ -284,7 +285,7 @@ typedef struct
 	BOOL		bHoneyInTheSky; //はにいいんざすかいパッチ用。v2.60
 } huc6280_state;
 
-static BOOL			_bTblInit = FALSE;
+static EMU_ONCE		_bTblInit = EMU_ONCE_INIT;
 static Sint32		_VolumeTable[92];
 static Sint32		_NoiseTable[32768];
 
@@ -374,6 +375,13 @@ create_noise_table()
 	}
 }
 
+static void
+create_tables(void)
+{
+	create_volume_table();
+	create_noise_table();
+}
+
 
 /*-----------------------------------------------------------------------------
 	[write_reg]
@@ -767,7 +775,7 @@ static UINT8 device_start_c6280_ootake(const DEV_GEN_CFG* cfg, DEV_INFO* retDevI
 	rate = cfg->clock / 16;
 	SRATE_CUSTOM_HIGHEST(cfg->srMode, rate, cfg->smplRate);
 	
-	chip = OPSG_Init(cfg->clock, rate);
+	chip = OPSG_Init(cfg->clock, rate, cfg->memArena);
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -787,18 +795,14 @@ static UINT8 device_start_c6280_ootake(const DEV_GEN_CFG* cfg, DEV_INFO* retDevI
 static void*
 OPSG_Init(
 	UINT32		clock,
-	UINT32		sampleRate)
+	UINT32		sampleRate,
+	MEM_ARENA*	arena)
 {
 	huc6280_state* info;
 	
-	if (! _bTblInit)
-	{
-		create_volume_table();
-		create_noise_table();
-		_bTblInit = TRUE;
-	}
+	Emu_CallOnce(&_bTblInit, create_tables);
 
-	info = (huc6280_state*)calloc(1, sizeof(huc6280_state));
+	info = (huc6280_state*)DevData_Alloc(arena, sizeof(huc6280_state));
 	if (info == NULL)
 		return NULL;
 	
@@ -831,7 +835,7 @@ OPSG_Deinit(void* chip)
 {
 	huc6280_state* info = (huc6280_state*)chip;
 	
-	free(info);
+	DevData_Free(info);
 }
 
 
@@ -32,7 +32,8 @@ static UINT8 device_start_c6280_ootake(const DEV_GEN_CFG* cfg, DEV_INFO* retDevI
 static void*
 OPSG_Init(
 	UINT32		clock,
-	UINT32		sampleRate);
+	UINT32		sampleRate,
+	MEM_ARENA*	arena);
 
 static void
 OPSG_Deinit(void* chip);
@@ -32,11 +32,13 @@
 #endif
 
 #include <math.h>
-#include <stdlib.h> // rand
+#include <stdlib.h> // for calloc
 #include <string.h> // for memset
 
 #include "../../stdtype.h"
 #include "../snddef.h"
+#include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "adlibemu_opl_inc.h"
 
 
@@ -50,11 +52,10 @@ static Bit32s trem_table[TREMTAB_SIZE*2];
 static Bit32s vibval_const[BLOCKBUF_SIZE];
 static Bit32s tremval_const[BLOCKBUF_SIZE];
 
+static EMU_ONCE tablesOnce = EMU_ONCE_INIT;
+
 // vibrato value tables (used per-operator)
-static Bit32s vibval_var1[BLOCKBUF_SIZE];
-static Bit32s vibval_var2[BLOCKBUF_SIZE];
-//static Bit32s vibval_var3[BLOCKBUF_SIZE];
-//static Bit32s vibval_var4[BLOCKBUF_SIZE];
+// moved to adlib_getsample
 
 // vibrato/trmolo value table pointers
 //static Bit32s *vibval1, *vibval2, *vibval3, *vibval4;
@@ -171,7 +172,7 @@ INLINE void operator_advance_drums(OPL_DATA* chip, op_type* op_pt1, Bit32s vib1,
 	Bit32u c3 = op_pt3->tcount/FIXEDPT;
 	Bit32u phasebit = (((c1 & 0x88) ^ ((c1<<5) & 0x80)) | ((c3 ^ (c3<<2)) & 0x20)) ? 0x02 : 0x00;
 
-	Bit32u noisebit = rand()&1;
+	Bit32u noisebit = emu_rand(&chip->noise_seed)&1;
 
 	Bit32u snare_phase_bit = (((Bitu)((op_pt1->tcount/FIXEDPT) / 0x100))&1);
 
@@ -583,15 +584,9 @@ static void disable_operator(op_type* op_pt, Bit32u act_type)
 
 static void init_tables(void)
 {
-	static Bitu initfirstime = 0;
 	Bits i, j, oct;
 	Bit32s trem_table_int[TREMTAB_SIZE];
 
-
-	if (initfirstime)
-		return;
-	initfirstime = 1;
-
 	// create vibrato table
 	vib_table[0] = 8;
 	vib_table[1] = 4;
@@ -682,7 +677,7 @@ void* ADLIBEMU(init)(UINT32 clock, UINT32 samplerate)
 		OPL->frqmul[i] = (fltype)(frqmul_tab[i]*INTFREQU/(fltype)WAVEPREC*(fltype)FIXEDPT*OPL->recipsamp);
 	}
 
-	init_tables();
+	Emu_CallOnce(&tablesOnce, init_tables);
 
 	// vibrato at ~6.1 ?? (opl3 docs say 6.1, opl4 docs say 6.0, y8950 docs say 6.4)
 	OPL->vibtab_add = (Bit32u)(VIBTAB_SIZE*FIXEDPT_LFO/8192*INTFREQU/OPL->int_samplerate);
@@ -753,6 +748,7 @@ void ADLIBEMU(reset)(void *chip)
 	OPL->status = 0;
 	OPL->opl_addr = 0;
 	OPL->isDisabled = 0x01;	// OPL4 speed hack
+	OPL->noise_seed = 1;
 	
 	return;
 }
@@ -1195,6 +1191,9 @@ void ADLIBEMU(getsample)(void *chip, UINT32 numsamples, DEV_SMPL** sndptr)
 	// vibrato/tremolo lookup tables (global, to possibly be used by all operators)
 	Bit32s vib_lut[BLOCKBUF_SIZE];
 	Bit32s trem_lut[BLOCKBUF_SIZE];
+	// vibrato value tables (used per-operator)
+	Bit32s vibval_var1[BLOCKBUF_SIZE];
+	Bit32s vibval_var2[BLOCKBUF_SIZE];
 
 	Bit32u cursmp;
 	Bit32s vib_tshift;
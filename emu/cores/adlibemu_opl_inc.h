@@ -184,6 +184,7 @@ typedef struct opl_chip
 	Bit32u tremtab_add;
 	
 	Bit32u generator_add;	// should be a chip parameter
+	Bit32u noise_seed;		// random number generator state for the rhythm noise
 	
 	fltype recipsamp;	// inverse of sampling rate
 	fltype frqmul[16];
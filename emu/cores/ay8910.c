@@ -541,10 +541,13 @@ YM2203 Japanese datasheet contents, translated: http://www.larwe.com/technical/c
 #include "../EmuStructs.h"
 #include "../EmuCores.h"
 #include "../EmuHelper.h"
+#include "../BlipBuf.h"
 #include "ayintf.h"
 #include "ay8910.h"
 
 
+static void ay8910_update_mix(void *param, UINT32 samples, DEV_SMPL *mixBuf, INT32 volL, INT32 volR);
+
 static DEVDEF_RWFUNC devFunc[] =
 {
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, ay8910_write},
@@ -553,6 +556,7 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_CLOCK | RWF_WRITE, DEVRW_VALUE, 0, ay8910_set_clock},
 	{RWF_SRATE | RWF_READ, DEVRW_VALUE, 0, ay8910_get_sample_rate},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, ay8910_set_mute_mask},
+	{RWF_UPDATE_MIX, DEVRW_ALL, 0, ay8910_update_mix},
 	{0x00, 0x00, 0, NULL}
 };
 DEV_DEF devDef_AY8910_MAME =
@@ -586,6 +590,7 @@ DEV_DEF devDef_AY8910_MAME =
 
 #define MAX_OUTPUT 0x4000
 #define NUM_CHANNELS 3
+#define AY_BLIP_FRAME 0x800     /* maximum number of samples per frame in output rate mode */
 
 /* register id's */
 #define AY_AFINE    (0)
@@ -694,6 +699,10 @@ struct _ay8910_context
 	
 	DEVCB_SRATE_CHG SmpRateFunc;
 	void* SmpRateData;
+	
+	BLIP_BUF* blip[2];	// output rate mode: band-limited steps at blipRate (NULL = native rate)
+	DEV_SMPL blipLast[2];
+	UINT32 blipRate;
 };
 
 
@@ -1108,137 +1117,329 @@ void ay8910_write_reg(ay8910_context *psg, UINT8 r, UINT8 v)
 	}
 }
 
-void ay8910_update_one(void *param, UINT32 samples, DEV_SMPL **outputs)
+INLINE void ay8910_calc_output(ay8910_context *psg, DEV_SMPL *outL, DEV_SMPL *outR)
 {
-	ay8910_context *psg = (ay8910_context *)param;
 	int chan;
-	UINT32 cur_smpl;
-	DEV_SMPL *bufL = outputs[0];
-	DEV_SMPL *bufR = outputs[1];
 	DEV_SMPL chnout;
 	
-	memset(outputs[0], 0x00, samples * sizeof(DEV_SMPL));
-	memset(outputs[1], 0x00, samples * sizeof(DEV_SMPL));
-	
-	/* The 8910 has three outputs, each output is the mix of one of the three */
-	/* tone generators and of the (single) noise generator. The two are mixed */
-	/* BEFORE going into the DAC. The formula to mix each channel is: */
-	/* (ToneOn | ToneDisable) & (NoiseOn | NoiseDisable). */
-	/* Note that this means that if both tone and noise are disabled, the output */
-	/* is 1, not 0, and can be modulated changing the volume. */
+	for (chan = 0; chan < NUM_CHANNELS; chan++)
+	{
+		psg->vol_enabled[chan] = (psg->output[chan] | TONE_ENABLEQ(psg, chan)) & (NOISE_OUTPUT(psg) | NOISE_ENABLEQ(psg, chan));
+	}
+	psg->env_volume = (psg->env_step ^ psg->attack);
 
-	/* buffering loop */
-	for (cur_smpl = 0; cur_smpl < samples; cur_smpl++)
+	*outL = 0;
+	*outR = 0;
+#if ENABLE_CUSTOM_OUTPUTS
+	if (psg->streams == 3)
+#endif
 	{
 		for (chan = 0; chan < NUM_CHANNELS; chan++)
 		{
-			psg->count[chan]++;
-			if (psg->count[chan] >= TONE_PERIOD(psg, chan))
+			if (! psg->MuteMsk[chan])
+				continue;
+			if (TONE_ENVELOPE(psg, chan) != 0)
+			{
+				if (psg->chip_type == AYTYPE_AY8914) // AY8914 Has a two bit tone_envelope field
+				{
+					chnout = psg->env_table[chan][psg->vol_enabled[chan] ? psg->env_volume >> (3-TONE_ENVELOPE(psg,chan)) : 0];
+				}
+				else
+				{
+					chnout = psg->env_table[chan][psg->vol_enabled[chan] ? psg->env_volume : 0];
+				}
+			}
+			else
 			{
-				psg->output[chan] ^= 1;
-				psg->count[chan] = 0;
+				chnout = psg->vol_table[chan][psg->vol_enabled[chan] ? TONE_VOLUME(psg, chan) : 0];
 			}
+			if (psg->StereoMask[chan] & 0x01)
+				*outL += chnout;
+			if (psg->StereoMask[chan] & 0x02)
+				*outR += chnout;
 		}
+	}
+#if ENABLE_CUSTOM_OUTPUTS
+	else
+	{
+		chnout = mix_3D(psg);
+		*outL += chnout;
+		*outR += chnout;
+	}
+#endif
+}
 
-		psg->count_noise++;
-		if (psg->count_noise >= NOISE_PERIOD(psg))
-		{
-			/* toggle the prescaler output. Noise is no different to
-			 * channels.
-			 */
-			psg->count_noise = 0;
-			psg->prescale_noise ^= 1;
+// returns the number of samples until a counter expires (the expiring sample included)
+INLINE UINT32 ay8910_steps_to_event(const ay8910_context *psg, UINT32 maxSteps)
+{
+	int chan;
+	INT32 period;
+	UINT32 steps = maxSteps;
+	
+	for (chan = 0; chan < NUM_CHANNELS; chan++)
+	{
+		period = TONE_PERIOD(psg, chan);
+		if (psg->count[chan] + 1 >= period)
+			return 1;
+		if (steps > (UINT32)(period - psg->count[chan]))
+			steps = (UINT32)(period - psg->count[chan]);
+	}
+	
+	period = NOISE_PERIOD(psg);
+	if (psg->count_noise + 1 >= period)
+		return 1;
+	if (steps > (UINT32)(period - psg->count_noise))
+		steps = (UINT32)(period - psg->count_noise);
+	
+	if (psg->holding == 0)
+	{
+		period = ENVELOPE_PERIOD(psg) * psg->step;
+		if (psg->count_env + 1 >= period)
+			return 1;
+		if (steps > (UINT32)(period - psg->count_env))
+			steps = (UINT32)(period - psg->count_env);
+	}
+	
+	return steps;
+}
 
-			if ( psg->prescale_noise)
-			{
-				/* The Random Number Generator of the 8910 is a 17-bit shift */
-				/* register. The input to the shift register is bit0 XOR bit3 */
-				/* (bit0 is the output). This was verified on AY-3-8910 and YM2149 chips. */
+// advances the counters by the specified number of steps - there must be no counter event in between
+INLINE void ay8910_skip(ay8910_context *psg, UINT32 steps)
+{
+	int chan;
+	
+	for (chan = 0; chan < NUM_CHANNELS; chan++)
+		psg->count[chan] += steps;
+	psg->count_noise += steps;
+	if (psg->holding == 0)
+		psg->count_env += steps;
+}
 
-				psg->rng ^= (((psg->rng & 1) ^ ((psg->rng >> 3) & 1)) << 17);
-				psg->rng >>= 1;
-			}
+// runs the tone, noise and envelope generators for a single step
+INLINE void ay8910_step(ay8910_context *psg)
+{
+	int chan;
+	
+	for (chan = 0; chan < NUM_CHANNELS; chan++)
+	{
+		psg->count[chan]++;
+		if (psg->count[chan] >= TONE_PERIOD(psg, chan))
+		{
+			psg->output[chan] ^= 1;
+			psg->count[chan] = 0;
 		}
+	}
 
-		for (chan = 0; chan < NUM_CHANNELS; chan++)
+	psg->count_noise++;
+	if (psg->count_noise >= NOISE_PERIOD(psg))
+	{
+		/* toggle the prescaler output. Noise is no different to
+		 * channels.
+		 */
+		psg->count_noise = 0;
+		psg->prescale_noise ^= 1;
+
+		if ( psg->prescale_noise)
 		{
-			psg->vol_enabled[chan] = (psg->output[chan] | TONE_ENABLEQ(psg, chan)) & (NOISE_OUTPUT(psg) | NOISE_ENABLEQ(psg, chan));
+			/* The Random Number Generator of the 8910 is a 17-bit shift */
+			/* register. The input to the shift register is bit0 XOR bit3 */
+			/* (bit0 is the output). This was verified on AY-3-8910 and YM2149 chips. */
+
+			psg->rng ^= (((psg->rng & 1) ^ ((psg->rng >> 3) & 1)) << 17);
+			psg->rng >>= 1;
 		}
+	}
 
-		/* update envelope */
-		if (psg->holding == 0)
+	/* update envelope */
+	if (psg->holding == 0)
+	{
+		psg->count_env++;
+		if (psg->count_env >= ENVELOPE_PERIOD(psg) * psg->step )
 		{
-			psg->count_env++;
-			if (psg->count_env >= ENVELOPE_PERIOD(psg) * psg->step )
-			{
-				psg->count_env = 0;
-				psg->env_step--;
+			psg->count_env = 0;
+			psg->env_step--;
 
-				/* check envelope current position */
-				if (psg->env_step < 0)
+			/* check envelope current position */
+			if (psg->env_step < 0)
+			{
+				if (psg->hold)
 				{
-					if (psg->hold)
-					{
-						if (psg->alternate)
-							psg->attack ^= psg->env_step_mask;
-						psg->holding = 1;
-						psg->env_step = 0;
-					}
-					else
-					{
-						/* if CountEnv has looped an odd number of times (usually 1), */
-						/* invert the output. */
-						if (psg->alternate && (psg->env_step & (psg->env_step_mask + 1)))
- 							psg->attack ^= psg->env_step_mask;
+					if (psg->alternate)
+						psg->attack ^= psg->env_step_mask;
+					psg->holding = 1;
+					psg->env_step = 0;
+				}
+				else
+				{
+					/* if CountEnv has looped an odd number of times (usually 1), */
+					/* invert the output. */
+					if (psg->alternate && (psg->env_step & (psg->env_step_mask + 1)))
+						psg->attack ^= psg->env_step_mask;
 
-						psg->env_step &= psg->env_step_mask;
-					}
+					psg->env_step &= psg->env_step_mask;
 				}
+			}
+
+		}
+	}
+}
+
+INLINE void ay8910_blip_output(ay8910_context *psg, UINT32 time)
+{
+	DEV_SMPL outL;
+	DEV_SMPL outR;
+	
+	ay8910_calc_output(psg, &outL, &outR);
+	if (outL != psg->blipLast[0])
+	{
+		Blip_AddDelta(psg->blip[0], time, outL - psg->blipLast[0]);
+		psg->blipLast[0] = outL;
+	}
+	if (outR != psg->blipLast[1])
+	{
+		Blip_AddDelta(psg->blip[1], time, outR - psg->blipLast[1]);
+		psg->blipLast[1] = outR;
+	}
+}
 
+// output rate mode: run the generators at the native rate, but only report the level changes
+// The samples are written to outputs or, when mixBuf is set, added to the interleaved buffer mixBuf.
+static void ay8910_update_blip(ay8910_context *psg, UINT32 samples, DEV_SMPL **outputs,
+							   DEV_SMPL *mixBuf, INT32 volL, INT32 volR)
+{
+	UINT32 smpl_pos;
+	UINT32 frm_smpls;
+	UINT32 frm_steps;
+	UINT32 cur_step;
+	UINT32 span;
+	
+	for (smpl_pos = 0; smpl_pos < samples; smpl_pos += frm_smpls)
+	{
+		frm_smpls = samples - smpl_pos;
+		if (frm_smpls > AY_BLIP_FRAME)
+			frm_smpls = AY_BLIP_FRAME;
+		frm_steps = Blip_ClocksNeeded(psg->blip[0], frm_smpls);
+		
+		ay8910_blip_output(psg, 0);	// register writes may have changed the output
+		for (cur_step = 0; cur_step < frm_steps; cur_step++)
+		{
+			span = ay8910_steps_to_event(psg, frm_steps - cur_step);
+			if (span > 1)
+			{
+				span --;
+				ay8910_skip(psg, span);
+				cur_step += span;
 			}
+			ay8910_step(psg);
+			ay8910_blip_output(psg, cur_step);
+		}
+		
+		Blip_EndFrame(psg->blip[0], frm_steps);
+		Blip_EndFrame(psg->blip[1], frm_steps);
+		if (mixBuf == NULL)
+		{
+			Blip_ReadSamples(psg->blip[0], &outputs[0][smpl_pos], frm_smpls);
+			Blip_ReadSamples(psg->blip[1], &outputs[1][smpl_pos], frm_smpls);
+		}
+		else
+		{
+			Blip_MixSamples(psg->blip[0], &mixBuf[smpl_pos * 2 + 0], frm_smpls, 2, volL);
+			Blip_MixSamples(psg->blip[1], &mixBuf[smpl_pos * 2 + 1], frm_smpls, 2, volR);
 		}
-		psg->env_volume = (psg->env_step ^ psg->attack);
+	}
+}
 
-#if ENABLE_CUSTOM_OUTPUTS
-		if (psg->streams == 3)
-#endif
+/* native rate mode: render to bufL/bufR, the samples are 'stride' entries apart */
+/* mix = 0: store the samples, mix = 1: add (sample * volL/volR) */
+INLINE void ay8910_render(ay8910_context *psg, UINT32 samples,
+						  DEV_SMPL *bufL, DEV_SMPL *bufR, UINT32 stride, INT32 volL, INT32 volR, UINT8 mix)
+{
+	UINT32 cur_smpl;
+	UINT32 span;
+	UINT32 i;
+	DEV_SMPL outL;
+	DEV_SMPL outR;
+	
+	/* buffering loop */
+	for (cur_smpl = 0; cur_smpl < samples; cur_smpl++)
+	{
+		/* Between two counter events, the output is constant.
+		 * Advance the counters over the whole span and fill it in one go. */
+		span = ay8910_steps_to_event(psg, samples - cur_smpl);
+		if (span > 1)
 		{
-			for (chan = 0; chan < NUM_CHANNELS; chan++)
+			span --;
+			ay8910_skip(psg, span);
+			
+			ay8910_calc_output(psg, &outL, &outR);
+			if (mix)
 			{
-				if (! psg->MuteMsk[chan])
-					continue;
-				if (TONE_ENVELOPE(psg, chan) != 0)
+				outL *= volL;
+				outR *= volR;
+				for (i = 0; i < span; i++)
 				{
-					if (psg->chip_type == AYTYPE_AY8914) // AY8914 Has a two bit tone_envelope field
-					{
-						chnout = psg->env_table[chan][psg->vol_enabled[chan] ? psg->env_volume >> (3-TONE_ENVELOPE(psg,chan)) : 0];
-					}
-					else
-					{
-						chnout = psg->env_table[chan][psg->vol_enabled[chan] ? psg->env_volume : 0];
-					}
+					bufL[(cur_smpl + i) * stride] += outL;
+					bufR[(cur_smpl + i) * stride] += outR;
 				}
-				else
+			}
+			else
+			{
+				for (i = 0; i < span; i++)
 				{
-					chnout = psg->vol_table[chan][psg->vol_enabled[chan] ? TONE_VOLUME(psg, chan) : 0];
+					bufL[(cur_smpl + i) * stride] = outL;
+					bufR[(cur_smpl + i) * stride] = outR;
 				}
-				if (psg->StereoMask[chan] & 0x01)
-					bufL[cur_smpl] += chnout;
-				if (psg->StereoMask[chan] & 0x02)
-					bufR[cur_smpl] += chnout;
 			}
+			cur_smpl += span;
+		}
+		
+		ay8910_step(psg);
+
+		ay8910_calc_output(psg, &outL, &outR);
+		if (mix)
+		{
+			bufL[cur_smpl * stride] += outL * volL;
+			bufR[cur_smpl * stride] += outR * volR;
 		}
-#if ENABLE_CUSTOM_OUTPUTS
 		else
 		{
-			chnout = mix_3D(psg);
-			bufL[cur_smpl] += chnout;
-			bufR[cur_smpl] += chnout;
+			bufL[cur_smpl * stride] = outL;
+			bufR[cur_smpl * stride] = outR;
 		}
-#endif
 	}
 }
 
+void ay8910_update_one(void *param, UINT32 samples, DEV_SMPL **outputs)
+{
+	ay8910_context *psg = (ay8910_context *)param;
+	
+	/* The 8910 has three outputs, each output is the mix of one of the three */
+	/* tone generators and of the (single) noise generator. The two are mixed */
+	/* BEFORE going into the DAC. The formula to mix each channel is: */
+	/* (ToneOn | ToneDisable) & (NoiseOn | NoiseDisable). */
+	/* Note that this means that if both tone and noise are disabled, the output */
+	/* is 1, not 0, and can be modulated changing the volume. */
+
+	if (psg->blip[0] != NULL)
+	{
+		ay8910_update_blip(psg, samples, outputs, NULL, 0, 0);
+		return;
+	}
+	ay8910_render(psg, samples, outputs[0], outputs[1], 1, 0, 0, 0);
+}
+
+static void ay8910_update_mix(void *param, UINT32 samples, DEV_SMPL *mixBuf, INT32 volL, INT32 volR)
+{
+	ay8910_context *psg = (ay8910_context *)param;
+	
+	if (psg->blip[0] != NULL)
+	{
+		ay8910_update_blip(psg, samples, NULL, mixBuf, volL, volR);
+		return;
+	}
+	ay8910_render(psg, samples, &mixBuf[0], &mixBuf[1], 2, volL, volR, 1);
+}
+
 static void build_mixer_table(ay8910_context *psg)
 {
 #if ENABLE_CUSTOM_OUTPUTS
@@ -1363,6 +1564,45 @@ static void ay8910_set_type(ay8910_context *info, UINT8 chip_type)
 	return;
 }
 
+static UINT32 ay8910_get_master_clock(const ay8910_context *psg)
+{
+	UINT32 master_clock = psg->clock;
+	
+	if (psg->type == PSG_TYPE_YM)
+	{
+		// YM2149 master clock divider
+		if (psg->chip_flags & YM2149_PIN26_LOW)
+			master_clock /= 2;
+	}
+	return master_clock;
+}
+
+static UINT8 ay8910_set_output_rate(ay8910_context *psg, UINT32 sample_rate)
+{
+	UINT8 retVal;
+	
+	if (! sample_rate)
+		return 0x80;
+	retVal = Blip_Init(&psg->blip[0], AY_BLIP_FRAME);
+	if (! retVal)
+		retVal = Blip_Init(&psg->blip[1], AY_BLIP_FRAME);
+	if (! retVal)
+		retVal = Blip_SetRates(psg->blip[0], ay8910_get_master_clock(psg) / 8.0, sample_rate);
+	if (retVal)
+	{
+		if (psg->blip[0] != NULL)
+			Blip_Deinit(psg->blip[0]);
+		if (psg->blip[1] != NULL)
+			Blip_Deinit(psg->blip[1]);
+		psg->blip[0] = psg->blip[1] = NULL;
+		return retVal;
+	}
+	Blip_SetRates(psg->blip[1], ay8910_get_master_clock(psg) / 8.0, sample_rate);
+	psg->blipRate = sample_rate;
+	
+	return 0x00;
+}
+
 UINT8 device_start_ay8910_mame(const AY8910_CFG* cfg, DEV_INFO* retDevInf)
 {
 	void* chip;
@@ -1372,6 +1612,13 @@ UINT8 device_start_ay8910_mame(const AY8910_CFG* cfg, DEV_INFO* retDevInf)
 	rate = ay8910_start(&chip, cfg->_genCfg.clock, cfg->chipType, cfg->chipFlags);
 	if (chip == NULL)
 		return 0xFF;
+	if (cfg->_genCfg.srMode == DEVRI_SRMODE_CUSTOM ||
+		(cfg->_genCfg.srMode == DEVRI_SRMODE_HIGHEST && rate < cfg->_genCfg.smplRate))
+	{
+		// render directly at the output sample rate using band-limited steps
+		if (! ay8910_set_output_rate((ay8910_context *)chip, cfg->_genCfg.smplRate))
+			rate = cfg->_genCfg.smplRate;
+	}
 	
 	devData = (DEV_DATA*)chip;
 	devData->chipInf = chip;
@@ -1419,6 +1666,12 @@ UINT32 ay8910_start(void **chip, UINT32 clock, UINT8 ay_type, UINT8 ay_flags)
 
 void ay8910_stop(void *chip)
 {
+	ay8910_context *psg = (ay8910_context *)chip;
+	
+	if (psg->blip[0] != NULL)
+		Blip_Deinit(psg->blip[0]);
+	if (psg->blip[1] != NULL)
+		Blip_Deinit(psg->blip[1]);
 	free(chip);
 }
 
@@ -1440,6 +1693,12 @@ void ay8910_reset(void *chip)
 	psg->count_env = 0;
 	psg->prescale_noise = 0;
 	psg->last_enable = 0xFF;    /* force a write */
+	if (psg->blip[0] != NULL)
+	{
+		Blip_Clear(psg->blip[0]);
+		Blip_Clear(psg->blip[1]);
+		psg->blipLast[0] = psg->blipLast[1] = 0;
+	}
 	for (i = 0;i < AY_PORTA;i++)
 		ay8910_write_reg(psg,i,0);
 	//psg->ready = 1;
@@ -1466,6 +1725,13 @@ void ay8910_set_clock(void *chip, UINT32 clock)
 	ay8910_context *psg = (ay8910_context *)chip;
 	
 	psg->clock = clock;
+	if (psg->blip[0] != NULL)
+	{
+		// output rate mode: the sample rate stays, only the step timing changes
+		Blip_SetRates(psg->blip[0], ay8910_get_master_clock(psg) / 8.0, psg->blipRate);
+		Blip_SetRates(psg->blip[1], ay8910_get_master_clock(psg) / 8.0, psg->blipRate);
+		return;
+	}
 	if (psg->SmpRateFunc != NULL)
 		psg->SmpRateFunc(psg->SmpRateData, ay8910_get_sample_rate(psg));
 	
@@ -1475,17 +1741,12 @@ void ay8910_set_clock(void *chip, UINT32 clock)
 UINT32 ay8910_get_sample_rate(void *chip)
 {
 	ay8910_context *psg = (ay8910_context *)chip;
-	UINT32 master_clock = psg->clock;
 	
-	if (psg->type == PSG_TYPE_YM)
-	{
-		// YM2149 master clock divider
-		if (psg->chip_flags & YM2149_PIN26_LOW)
-			master_clock /= 2;
-	}
+	if (psg->blip[0] != NULL)
+		return psg->blipRate;
 	/* The envelope is pacing twice as fast for the YM2149 as for the AY-3-8910,    */
 	/* This handled by the step parameter. Consequently we use a divider of 8 here. */
-	return master_clock / 8;
+	return ay8910_get_master_clock(psg) / 8;
 }
 
 void ay8910_write(void *chip, UINT8 addr, UINT8 data)
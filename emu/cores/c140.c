@@ -378,7 +378,7 @@ static UINT8 device_start_c140(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	c140_state *info;
 	int i;
 
-	info = (c140_state *)calloc(1, sizeof(c140_state));
+	info = (c140_state *)DevData_Alloc(cfg->memArena, sizeof(c140_state));
 	if (info == NULL)
 		return 0xFF;
 	
@@ -414,7 +414,7 @@ static void device_stop_c140(void *chip)
 	c140_state *info = (c140_state *)chip;
 	
 	free(info->pRom);
-	free(info);
+	DevData_Free(info);
 	
 	return;
 }
@@ -323,7 +323,7 @@ static UINT8 device_start_c219(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	int i;
 	INT16 j;
 	
-	info = (c219_state *)calloc(1, sizeof(c219_state));
+	info = (c219_state *)DevData_Alloc(cfg->memArena, sizeof(c219_state));
 	if (info == NULL)
 		return 0xFF;
 	
@@ -364,7 +364,7 @@ static void device_stop_c219(void *chip)
 	c219_state *info = (c219_state *)chip;
 	
 	free(info->pRom);
-	free(info);
+	DevData_Free(info);
 	
 	return;
 }
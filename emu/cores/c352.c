@@ -289,7 +289,7 @@ static UINT8 device_start_c352(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	int i;
 	INT16 j;
 
-	c = (C352 *)calloc(1, sizeof(C352));
+	c = (C352 *)DevData_Alloc(cfg->memArena, sizeof(C352));
 	if (c == NULL)
 		return 0xFF;
 
@@ -332,7 +332,7 @@ static void device_stop_c352(void *chip)
 	C352 *c = (C352 *)chip;
 	
 	free(c->wave);
-	free(c);
+	DevData_Free(c);
 	
 	return;
 }
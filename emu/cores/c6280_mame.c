@@ -38,7 +38,7 @@
 
 */
 
-#include <stdlib.h>	// for rand()
+#include <stdlib.h>	// for calloc()
 #include <string.h>	// for memset()
 #include <math.h>	// for pow()
 
@@ -55,7 +55,7 @@ static UINT8 c6280mame_r(void* chip, UINT8 offset);
 
 static void c6280mame_update(void* param, UINT32 samples, DEV_SMPL **outputs);
 static UINT8 device_start_c6280_mame(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
-static void* device_start_c6280mame(UINT32 clock, UINT32 rate);
+static void* device_start_c6280mame(UINT32 clock, UINT32 rate, MEM_ARENA* arena);
 static void device_stop_c6280mame(void* chip);
 static void device_reset_c6280mame(void* chip);
 
@@ -97,6 +97,7 @@ typedef struct {
 	INT16 dda;
 	UINT8 noise_control;
 	UINT32 noise_counter;
+	int noise_data;
 	UINT32 counter;
 	UINT8 Muted;
 } t_channel;
@@ -112,6 +113,7 @@ typedef struct {
 	INT16 volume_table[32];
 	UINT32 noise_freq_tab[32];
 	UINT32 wave_freq_tab[4096];
+	UINT32 noise_seed;
 } c6280_t;
 
 
@@ -271,15 +273,14 @@ static void c6280mame_update(void* param, UINT32 samples, DEV_SMPL **outputs)
 				UINT32 step = p->noise_freq_tab[(p->channel[ch].noise_control & 0x1F) ^ 0x1F];
 				for(i = 0; i < samples; i += 1)
 				{
-					static int data = 0;
 					p->channel[ch].noise_counter += step;
 					if(p->channel[ch].noise_counter >= 0x800)
 					{
-						data = (rand() & 1) ? 0x1F : 0;
+						p->channel[ch].noise_data = (emu_rand(&p->noise_seed) & 1) ? 0x1F : 0;
 					}
 					p->channel[ch].noise_counter &= 0x7FF;
-					outputs[0][i] += (vll * (data - 16));
-					outputs[1][i] += (vlr * (data - 16));
+					outputs[0][i] += (vll * (p->channel[ch].noise_data - 16));
+					outputs[1][i] += (vlr * (p->channel[ch].noise_data - 16));
 				}
 			}
 			else
@@ -356,7 +357,7 @@ static UINT8 device_start_c6280_mame(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf
 	rate = cfg->clock / 16;
 	SRATE_CUSTOM_HIGHEST(cfg->srMode, rate, cfg->smplRate);
 	
-	chip = device_start_c6280mame(cfg->clock, rate);
+	chip = device_start_c6280mame(cfg->clock, rate, cfg->memArena);
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -366,7 +367,7 @@ static UINT8 device_start_c6280_mame(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf
 	return 0x00;
 }
 
-static void* device_start_c6280mame(UINT32 clock, UINT32 rate)
+static void* device_start_c6280mame(UINT32 clock, UINT32 rate, MEM_ARENA* arena)
 {
 	c6280_t *info;
 	int i;
@@ -374,7 +375,7 @@ static void* device_start_c6280mame(UINT32 clock, UINT32 rate)
 	/* Loudest volume level for table */
 	double level = 65536.0 / 6.0 / 32.0;
 
-	info = (c6280_t*)calloc(1, sizeof(c6280_t));
+	info = (c6280_t*)DevData_Alloc(arena, sizeof(c6280_t));
 	if (info == NULL)
 		return NULL;
 
@@ -399,7 +400,7 @@ static void device_stop_c6280mame(void* chip)
 {
 	c6280_t *info = (c6280_t *)chip;
 	
-	free(info);
+	DevData_Free(info);
 	
 	return;
 }
@@ -414,6 +415,7 @@ static void device_reset_c6280mame(void* chip)
 	info->balance = 0x00;
 	info->lfo_frequency = 0x00;
 	info->lfo_control = 0x00;
+	info->noise_seed = 1;
 	
 	for (CurChn = 0; CurChn < 6; CurChn ++)
 	{
@@ -427,6 +429,7 @@ static void device_reset_c6280mame(void* chip)
 		TempChn->dda = 0x00;
 		TempChn->noise_control = 0x00;
 		TempChn->noise_counter = 0x00;
+		TempChn->noise_data = 0;
 		TempChn->counter = 0x00;
 	}
 	
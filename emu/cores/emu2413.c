@@ -20,7 +20,9 @@
 #include "../EmuStructs.h"
 #include "../EmuCores.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "emu2413.h"
+#include "2413intf.h"
 #include "emu2413_private.h"
 #include "../panning.h" // Maxim
 #undef INLINE	// emu2413 uses its own INLINE definition
@@ -29,6 +31,7 @@
 static UINT8 device_start_ym2413_emu(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 static void ym2413_update_emu(void *chip, UINT32 samples, DEV_SMPL **out);
 static void ym2413_set_mute_mask_emu(void *chip, UINT32 MuteMask);
+static void ym2413_set_options_emu(void *chip, UINT32 Flags);
 static void ym2413_pan_emu(void* chip, const INT16* PanVals);
 
 
@@ -49,7 +52,7 @@ DEV_DEF devDef_YM2413_Emu =
 	(DEVFUNC_CTRL)EOPLL_reset,
 	ym2413_update_emu,
 	
-	NULL,	// SetOptionBits
+	ym2413_set_options_emu,	// SetOptionBits
 	ym2413_set_mute_mask_emu,
 	ym2413_pan_emu,
 	NULL,	// SetSampleRateChangeCallback
@@ -271,6 +274,10 @@ static EOPLL_PATCH default_patch[EOPLL_TONE_NUM][(16 + 3) * 2];
 #define SINC_RESO 256
 #define SINC_AMP_BITS 12
 
+/* [libvgm] number of phases of the polyphase filter table */
+#define POLY_RESO_BITS 10
+#define POLY_RESO (1 << POLY_RESO_BITS)
+
 // double hamming(double x) { return 0.54 - 0.46 * cos(2 * PI * x); }
 static double blackman(double x) { return 0.42 - 0.5 * cos(2 * _PI_ * x) + 0.08 * cos(4 * _PI_ * x); }
 static double sinc(double x) { return (x == 0.0 ? 1.0 : sin(_PI_ * x) / (_PI_ * x)); }
@@ -285,8 +292,11 @@ EOPLL_RateConv *EOPLL_RateConv_new(double f_inp, double f_out, int ch) {
   conv->f_ratio = f_inp / f_out;
   conv->buf = malloc(sizeof(void *) * ch);
   for (i = 0; i < ch; i++) {
-    conv->buf[i] = malloc(sizeof(conv->buf[0][0]) * LW);
+    /* twice the length, so that the ring buffer history can always be read linearly */
+    conv->buf[i] = malloc(sizeof(conv->buf[0][0]) * LW * 2);
   }
+  conv->pos = malloc(sizeof(conv->pos[0]) * ch);
+  conv->legacy = 0;
 
   /* create sinc_table for positive 0 <= x < LW/2 */
   conv->sinc_table = malloc(sizeof(conv->sinc_table[0]) * SINC_RESO * LW / 2);
@@ -301,6 +311,23 @@ EOPLL_RateConv *EOPLL_RateConv_new(double f_inp, double f_out, int ch) {
     }
   }
 
+  /* [libvgm] create polyphase table: the coefficients of all taps for fractional positions 0/POLY_RESO ... POLY_RESO/POLY_RESO */
+  conv->poly_table = malloc(sizeof(conv->poly_table[0]) * (POLY_RESO + 1) * LW);
+  for (i = 0; i <= POLY_RESO; i++) {
+    int k;
+    for (k = 0; k < LW; k++) {
+      const double x = fabs((k - (LW / 2 - 1)) - (double)i / POLY_RESO);
+      double v;
+      if (x >= LW / 2)
+        v = 0.0;
+      else if (f_out < f_inp)
+        v = windowed_sinc(x / conv->f_ratio) / conv->f_ratio;
+      else
+        v = windowed_sinc(x);
+      conv->poly_table[i * LW + k] = (int16_t)((1 << SINC_AMP_BITS) * v);
+    }
+  }
+
   return conv;
 }
 
@@ -315,7 +342,8 @@ void EOPLL_RateConv_reset(EOPLL_RateConv *conv) {
   int i;
   conv->timer = 0;
   for (i = 0; i < conv->ch; i++) {
-    memset(conv->buf[i], 0, sizeof(conv->buf[i][0]) * LW);
+    memset(conv->buf[i], 0, sizeof(conv->buf[i][0]) * LW * 2);
+    conv->pos[i] = 0;
   }
 }
 
@@ -323,6 +351,13 @@ void EOPLL_RateConv_reset(EOPLL_RateConv *conv) {
 void EOPLL_RateConv_putData(EOPLL_RateConv *conv, int ch, int32_t data) {
   int32_t *buf = conv->buf[ch];
   int i;
+  if (!conv->legacy) {
+    /* ring buffer: write the sample twice, so that buf[pos ... pos+LW-1] is always the whole history */
+    uint32_t pos = conv->pos[ch];
+    buf[pos] = buf[pos + LW] = data;
+    conv->pos[ch] = (pos + 1 < LW) ? pos + 1 : 0;
+    return;
+  }
   for (i = 0; i < LW - 1; i++) {
     buf[i] = buf[i + 1];
   }
@@ -347,13 +382,42 @@ int32_t EOPLL_RateConv_getData(EOPLL_RateConv *conv, int ch) {
   return sum >> SINC_AMP_BITS;
 }
 
+/* [libvgm] get resampled data of the first ch channels at f_out. */
+/* dist is the distance between the newest input sample and the output sample, period the length of one input sample. */
+/* Using the caller's timing keeps the filter phase in sync with the putData calls. */
+void EOPLL_RateConv_getFrame(EOPLL_RateConv *conv, int32_t *out, int ch, uint32_t dist, uint32_t period) {
+  const int16_t *coef;
+  uint32_t phase;
+  int i;
+
+  if (conv->legacy) {
+    for (i = 0; i < ch; i++)
+      out[i] = EOPLL_RateConv_getData(conv, i);
+    return;
+  }
+
+  /* all channels share the same fractional position and thus the same filter phase */
+  phase = (uint32_t)((((uint64_t)dist << (POLY_RESO_BITS + 1)) / period + 1) / 2); /* round to the nearest phase */
+  coef = &conv->poly_table[phase * LW];
+  for (i = 0; i < ch; i++) {
+    const int32_t *hist = &conv->buf[i][conv->pos[i]];
+    int32_t sum = 0;
+    int k;
+    for (k = 0; k < LW; k++)
+      sum += hist[k] * coef[k];
+    out[i] = sum >> SINC_AMP_BITS;
+  }
+}
+
 void EOPLL_RateConv_delete(EOPLL_RateConv *conv) {
   int i;
   for (i = 0; i < conv->ch; i++) {
     free(conv->buf[i]);
   }
   free(conv->buf);
+  free(conv->pos);
   free(conv->sinc_table);
+  free(conv->poly_table);
   free(conv);
 }
 
@@ -421,14 +485,13 @@ static void makeDefaultPatch() {
       EOPLL_getDefaultPatch(i, j, &default_patch[i][j * 2]);
 }
 
-static uint8_t table_initialized = 0;
+static EMU_ONCE tablesOnce = EMU_ONCE_INIT;
 
-static void initializeTables() {
+static void initializeTables(void) {
   makeTllTable();
   makeRksTable();
   makeSinTable();
   makeDefaultPatch();
-  table_initialized = 1;
 }
 
 /*********************************************************
@@ -1101,9 +1164,7 @@ EOPLL *EOPLL_new(uint32_t clk, uint32_t rate) {
   EOPLL *opll;
   int i;
 
-  if (!table_initialized) {
-    initializeTables();
-  }
+  Emu_CallOnce(&tablesOnce, initializeTables);
 
   opll = (EOPLL *)calloc(1, sizeof(EOPLL));
   if (opll == NULL)
@@ -1155,6 +1216,7 @@ static void reset_rate_conversion_params(EOPLL *opll) {
 
   if (floor(f_inp) != f_out && floor(f_inp + 0.5) != f_out) {
     opll->conv = EOPLL_RateConv_new(f_inp, f_out, 2);
+    opll->conv->legacy = opll->conv_legacy;
   } else {
     opll->inp_step = opll->out_step;
   }
@@ -1502,7 +1564,7 @@ int32_t EOPLL_calc(EOPLL *opll) {
   }
   opll->out_time -= opll->out_step;
   if (opll->conv) {
-    opll->mix_out[0] = EOPLL_RateConv_getData(opll->conv, 0);
+    EOPLL_RateConv_getFrame(opll->conv, opll->mix_out, 1, opll->inp_step - opll->out_time, opll->inp_step);
   }
   return opll->mix_out[0];
 }
@@ -1515,8 +1577,7 @@ void EOPLL_calcStereo(EOPLL *opll, int32_t out[2]) {
   }
   opll->out_time -= opll->out_step;
   if (opll->conv) {
-    out[0] = EOPLL_RateConv_getData(opll->conv, 0);
-    out[1] = EOPLL_RateConv_getData(opll->conv, 1);
+    EOPLL_RateConv_getFrame(opll->conv, out, 2, opll->inp_step - opll->out_time, opll->inp_step);
   } else {
     out[0] = opll->mix_out[0];
     out[1] = opll->mix_out[1];
@@ -1603,6 +1664,24 @@ static void ym2413_set_mute_mask_emu(void *chip, UINT32 MuteMask)
 	return;
 }
 
+static void ym2413_set_options_emu(void *chip, UINT32 Flags)
+{
+	EOPLL *opll = (EOPLL *)chip;
+	uint8_t legacy = (Flags & OPT_YM2413_LEGACY_RATECONV) ? 1 : 0;
+	
+	if (opll->conv_legacy == legacy)
+		return;
+	opll->conv_legacy = legacy;
+	if (opll->conv)
+	{
+		// the history layouts differ, so restart the converter
+		opll->conv->legacy = legacy;
+		EOPLL_RateConv_reset(opll->conv);
+	}
+	
+	return;
+}
+
 static const uint8_t PAN_MAP[14] = {
 	0, 1, 2, 3, 4, 5, 6, 7, 8,
 	9, 11, 12, 13, 10
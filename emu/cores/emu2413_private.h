@@ -76,12 +76,17 @@ typedef struct __EOPLL_RateConv {
   double f_ratio;
   int16_t *sinc_table;
   int32_t **buf;
+  /* [libvgm] polyphase mode: ring buffer history + fixed-point phase */
+  uint8_t legacy;       /* 1 = use the original converter (per-tap table lookup, shifting history) */
+  uint32_t *pos;        /* ring buffer position (oldest sample) of each channel */
+  int16_t *poly_table;  /* [POLY_RESO + 1][LW] filter coefficients for each phase */
 } EOPLL_RateConv;
 
 EOPLL_RateConv *EOPLL_RateConv_new(double f_inp, double f_out, int ch);
 void EOPLL_RateConv_reset(EOPLL_RateConv *conv);
 void EOPLL_RateConv_putData(EOPLL_RateConv *conv, int ch, int32_t data);
 int32_t EOPLL_RateConv_getData(EOPLL_RateConv *conv, int ch);
+void EOPLL_RateConv_getFrame(EOPLL_RateConv *conv, int32_t *out, int ch, uint32_t dist, uint32_t period);
 void EOPLL_RateConv_delete(EOPLL_RateConv *conv);
 
 typedef struct __EOPLL {
@@ -128,6 +133,7 @@ typedef struct __EOPLL {
   int32_t mix_out[2];
 
   EOPLL_RateConv *conv;
+  uint8_t conv_legacy;
 } EOPLL;
 
 EOPLL *EOPLL_new(uint32_t clk, uint32_t rate);
@@ -294,7 +294,7 @@ static UINT8 device_start_es5503(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 {
 	ES5503Chip *chip;
 
-	chip = (ES5503Chip *)calloc(1, sizeof(ES5503Chip));
+	chip = (ES5503Chip *)DevData_Alloc(cfg->memArena, sizeof(ES5503Chip));
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -328,7 +328,7 @@ static void device_stop_es5503(void *info)
 	ES5503Chip *chip = (ES5503Chip *)info;
 	
 	free(chip->docram);
-	free(chip);
+	DevData_Free(chip);
 	
 	return;
 }
@@ -1,10 +1,1290 @@
-#include <stddef.h>
+// license:BSD-3-Clause
+// copyright-holders:Aaron Giles
+/**********************************************************************************************
+
+     Ensoniq ES5505/6 driver
+     by Aaron Giles
+
+Ensoniq OTIS - ES5505                                            Ensoniq OTTO - ES5506
+
+  OTIS is a VLSI device designed in a 2 micron double metal        OTTO is a VLSI device designed in a 1.5 micron double metal
+   CMOS process. The device is the next generation of audio         CMOS process. The device is the next generation of audio
+   technology from ENSONIQ. This new chip achieves a new            technology from ENSONIQ. All calculations in the device are
+   level of audio fidelity performance. These improvements          made with at least 18-bit accuracy.
+   are achieved through the use of frequency interpolation
+   and on board real time digital filters. All primary
+   sound generation is performed digitally.
+
+  - 32 independent voices, 4-pole digital filter per voice, sample rate = clock / (16 * voices)
+  - ES5505: 16-bit registers, 2 wave ROM banks, 1M words each, 4 stereo outputs
+  - ES5506: 32-bit registers (accessed as 4 bytes), 4 wave ROM banks, 2M words each,
+    6 stereo outputs, volume/filter envelopes, 8-bit compressed (u-law) samples
+
+  libvgm notes:
+  The voices are rendered voice-major in blocks of ES_BLOCK samples. Each running voice
+  first fills one column of a [sample][voice] buffer with interpolated sample data
+  (in spans between loop/end events), then the filter, envelope and volume stages run over
+  all voices ("lanes") of a sample at once, which lets the compiler vectorize them.
+
+***********************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
 
 #include "../../stdtype.h"
 #include "../EmuStructs.h"
+#include "../EmuCores.h"
+#include "../snddef.h"
+#include "../EmuHelper.h"
 #include "es5506.h"
 
+
+static void es5506_w(void *info, UINT8 offset, UINT8 data);
+static UINT8 es5506_r(void *info, UINT8 offset);
+static void es5506_w16(void *info, UINT8 offset, UINT16 data);
+static UINT16 es5506_r16(void *info, UINT8 offset);
+
+static void es5506_update(void *param, UINT32 samples, DEV_SMPL **outputs);
+static UINT8 device_start_es5506(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
+static void device_stop_es5506(void *info);
+static void device_reset_es5506(void *info);
+
+static void es5506_alloc_rom(void* info, UINT32 memsize);
+static void es5506_write_rom(void *info, UINT32 offset, UINT32 length, const UINT8* data);
+
+static void es5506_set_mute_mask(void *info, UINT32 MuteMask);
+static void es5506_set_srchg_cb(void *info, DEVCB_SRATE_CHG CallbackFunc, void* DataPtr);
+
+
+static DEVDEF_RWFUNC devFunc[] =
+{
+	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, es5506_w},
+	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, es5506_r},
+	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D16, 0, es5506_w16},
+	{RWF_REGISTER | RWF_READ, DEVRW_A8D16, 0, es5506_r16},
+	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, es5506_write_rom},
+	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, es5506_alloc_rom},
+	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, es5506_set_mute_mask},
+	{0x00, 0x00, 0, NULL}
+};
+static DEV_DEF devDef =
+{
+	"ES5506", "MAME", FCC_MAME,
+
+	device_start_es5506,
+	device_stop_es5506,
+	device_reset_es5506,
+	es5506_update,
+
+	NULL,	// SetOptionBits
+	es5506_set_mute_mask,
+	NULL,	// SetPanning
+	es5506_set_srchg_cb,	// SetSampleRateChangeCallback
+	NULL,	// LinkDevice
+
+	devFunc,	// rwFuncs
+};
+
 const DEV_DEF* devDefList_ES5506[] =
 {
+	&devDef,
 	NULL
 };
+
+
+/**********************************************************************************************
+
+     CONSTANTS
+
+***********************************************************************************************/
+
+#define MAX_VOICES			32
+#define ES_BLOCK			64	// number of samples rendered per voice pass
+#define LANE_GRP			8	// voices per filter group (MAX_VOICES must be a multiple)
+
+#define ULAW_MAXBITS		8
+#define ADDRESS_FRAC_BIT	11
+#define FILTER_SHIFT		4
+#define FILTER_BIT			12
+
+// control register bits (ES5506 layout, the ES5505 bits are translated to it)
+#define CONTROL_STOP0		0x0001
+#define CONTROL_STOP1		0x0002
+#define CONTROL_LEI			0x0004
+#define CONTROL_LPE			0x0008
+#define CONTROL_BLE			0x0010
+#define CONTROL_IRQE		0x0020
+#define CONTROL_DIR			0x0040
+#define CONTROL_IRQ			0x0080
+#define CONTROL_LP3			0x0100
+#define CONTROL_LP4			0x0200
+#define CONTROL_CA0			0x0400
+#define CONTROL_CA1			0x0800
+#define CONTROL_CA2			0x1000
+#define CONTROL_CMPD		0x2000
+#define CONTROL_BS0			0x4000
+#define CONTROL_BS1			0x8000
+
+#define CONTROL_STOPMASK	(CONTROL_STOP1 | CONTROL_STOP0)
+#define CONTROL_LOOPMASK	(CONTROL_BLE | CONTROL_LPE)
+#define CONTROL_LPMASK		(CONTROL_LP4 | CONTROL_LP3)
+
+#define CHIP_ES5505			0
+#define CHIP_ES5506			1
+
+
+/**********************************************************************************************
+
+     INTERNAL DATA STRUCTURES
+
+***********************************************************************************************/
+
+typedef struct
+{
+	UINT32 control;		// control register
+	UINT32 freqcount;	// frequency count register
+	UINT32 start;		// loop start register
+	UINT32 end;			// loop end register
+	UINT32 accum;		// accumulator register
+	UINT32 lvol;		// left volume (16 bits, the ES5505 uses the upper 8 bits)
+	UINT32 rvol;		// right volume
+	UINT32 lvramp;		// left volume ramp
+	UINT32 rvramp;		// right volume ramp
+	UINT32 ecount;		// envelope counter
+	UINT32 k2;			// k2 filter constant
+	UINT32 k2ramp;		// k2 ramp (bit 31 = slow mode)
+	UINT32 k1;			// k1 filter constant
+	UINT32 k1ramp;		// k1 ramp (bit 31 = slow mode)
+	INT32 o4n1;			// filter storage O4(n-1)
+	INT32 o3n1;			// filter storage O3(n-1)
+	INT32 o3n2;			// filter storage O3(n-2)
+	INT32 o2n1;			// filter storage O2(n-1)
+	INT32 o2n2;			// filter storage O2(n-2)
+	INT32 o1n1;			// filter storage O1(n-1)
+	UINT32 filtcount;	// filter count for slow ramping
+
+	UINT8 Muted;
+} ES5506_VOICE;
+
+typedef struct
+{
+	UINT16* data;		// sample words
+	UINT32 size;		// size in words, power of 2
+} ES5506_REGION;
+
+typedef struct
+{
+	DEV_DATA _devData;
+
+	UINT8 chipType;
+	UINT32 clock;
+	UINT32 sample_rate;
+	UINT8 output_channels;
+	UINT32 accmask;		// accumulator mask (address + fraction)
+	UINT32 maxWords;	// maximum size of a ROM region
+
+	UINT8 current_page;
+	UINT8 active_voices;
+	UINT8 mode;
+	UINT32 write_latch;
+	UINT32 read_latch;
+
+	UINT32 romSize;		// size requested via DEVRW_MEMSIZE
+	ES5506_REGION region[4];
+
+	ES5506_VOICE voice[MAX_VOICES];
+
+	INT16 ulaw_lookup[1 << ULAW_MAXBITS];
+	INT32 smpBuf[ES_BLOCK][MAX_VOICES];	// interpolated samples, [sample][lane]
+
+	DEVCB_SRATE_CHG SmpRateFunc;
+	void* SmpRateData;
+} ES5506Chip;
+
+static const UINT16 zeroWord = 0x0000;
+
+
+/**********************************************************************************************
+
+     VOICE RENDERING
+
+***********************************************************************************************/
+
+// volume -> linear gain, 4.8 floating point
+INLINE INT32 vol_gain(UINT32 vol)
+{
+	vol >>= 4;
+	return (INT32)((((vol & 0xFF) | 0x100) << 11) >> (20 - (vol >> 8)));
+}
+
+INLINE UINT32 ramp_value(UINT32 value, UINT32 ramp, UINT32 count)
+{
+	INT32 val = (INT32)value + (INT8)ramp * (INT32)count;
+	return (val < 0) ? 0 : (val > 0xFFFF) ? 0xFFFF : (UINT32)val;
+}
+
+// processes "samples" envelope steps at once, same result as calling it once per sample
+static void update_envelopes(ES5506_VOICE* voice, UINT32 samples)
+{
+	UINT32 count = (samples > voice->ecount) ? voice->ecount : samples;
+	UINT32 slowCnt;
+
+	// slow ramps are only applied on every 8th step
+	slowCnt = ((voice->filtcount + count + 7) >> 3) - ((voice->filtcount + 7) >> 3);
+	voice->ecount -= count;
+
+	if (voice->lvramp)
+		voice->lvol = ramp_value(voice->lvol, voice->lvramp, count);
+	if (voice->rvramp)
+		voice->rvol = ramp_value(voice->rvol, voice->rvramp, count);
+	if (voice->k1ramp)
+		voice->k1 = ramp_value(voice->k1, voice->k1ramp, ((INT32)voice->k1ramp >= 0) ? count : slowCnt);
+	if (voice->k2ramp)
+		voice->k2 = ramp_value(voice->k2, voice->k2ramp, ((INT32)voice->k2ramp >= 0) ? count : slowCnt);
+
+	voice->filtcount += count;
+
+	return;
+}
+
+// advances the accumulator by one sample and handles the loop points
+// returns 1 when the voice stopped
+static UINT8 advance_voice(ES5506Chip* chip, ES5506_VOICE* voice, UINT32* accPtr)
+{
+	UINT32 accum = *accPtr;
+	UINT8 stopped = 0;
+
+	if (voice->control & CONTROL_DIR)
+	{
+		accum = (accum - voice->freqcount) & chip->accmask;
+		if (accum < voice->start && ! (voice->control & CONTROL_LEI))
+		{
+			if (voice->control & CONTROL_IRQE)
+				voice->control |= CONTROL_IRQ;
+
+			switch(voice->control & CONTROL_LOOPMASK)
+			{
+			case 0:	// non-looping
+				voice->control |= CONTROL_STOP0;
+				stopped = 1;
+				break;
+			case CONTROL_LPE:	// uni-directional looping
+				accum = (voice->end - (voice->start - accum)) & chip->accmask;
+				break;
+			case CONTROL_BLE:	// trans-wave looping
+				accum = (voice->end - (voice->start - accum)) & chip->accmask;
+				voice->control = (voice->control & ~CONTROL_LOOPMASK) | CONTROL_LEI;
+				break;
+			case CONTROL_LOOPMASK:	// bi-directional looping
+				accum = (voice->start + (voice->start - accum)) & chip->accmask;
+				voice->control ^= CONTROL_DIR;
+				break;
+			}
+		}
+	}
+	else
+	{
+		accum = (accum + voice->freqcount) & chip->accmask;
+		if (accum > voice->end && ! (voice->control & CONTROL_LEI))
+		{
+			if (voice->control & CONTROL_IRQE)
+				voice->control |= CONTROL_IRQ;
+
+			switch(voice->control & CONTROL_LOOPMASK)
+			{
+			case 0:	// non-looping
+				voice->control |= CONTROL_STOP0;
+				stopped = 1;
+				break;
+			case CONTROL_LPE:	// uni-directional looping
+				accum = (voice->start + (accum - voice->end)) & chip->accmask;
+				break;
+			case CONTROL_BLE:	// trans-wave looping
+				accum = (voice->start + (accum - voice->end)) & chip->accmask;
+				voice->control = (voice->control & ~CONTROL_LOOPMASK) | CONTROL_LEI;
+				break;
+			case CONTROL_LOOPMASK:	// bi-directional looping
+				accum = (voice->end - (accum - voice->end)) & chip->accmask;
+				voice->control ^= CONTROL_DIR;
+				break;
+			}
+		}
+	}
+
+	*accPtr = accum;
+	return stopped;
+}
+
+// number of accumulator steps that can be done without reaching a loop point or wrapping around
+static UINT32 span_length(const ES5506Chip* chip, const ES5506_VOICE* voice, UINT32 accum, UINT32 maxLen)
+{
+	UINT32 limit;
+	UINT32 steps;
+
+	if (voice->control & CONTROL_DIR)
+	{
+		limit = (voice->control & CONTROL_LEI) ? 0 : voice->start;
+		if (accum < limit)
+			return 0;
+		steps = accum - limit;
+	}
+	else
+	{
+		limit = (voice->control & CONTROL_LEI) ? chip->accmask : voice->end;
+		if (limit > chip->accmask)
+			limit = chip->accmask;
+		if (accum > limit)
+			return 0;
+		steps = limit - accum;
+	}
+	if (! voice->freqcount)
+		return maxLen;
+	steps /= voice->freqcount;
+	return (steps < maxLen) ? steps : maxLen;
+}
+
+// Stage 1: fill column "lane" of smpBuf with interpolated sample data
+// returns the number of samples the voice played before it stopped
+static UINT32 fetch_voice(ES5506Chip* chip, ES5506_VOICE* voice, UINT8 lane, UINT32 length)
+{
+	const ES5506_REGION* rgn;
+	const UINT16* rom;
+	UINT32 romMask;
+	const INT16* ulaw;
+	UINT32 accum;
+	UINT32 step;
+	UINT32 span;
+	UINT32 addr;
+	UINT32 frac;
+	INT32 val1, val2;
+	UINT32 smpl;
+
+	if (chip->chipType == CHIP_ES5506)
+		rgn = &chip->region[(voice->control >> 14) & 0x03];
+	else
+		rgn = &chip->region[(voice->control >> 14) & 0x01];
+	if (rgn->data != NULL)
+	{
+		rom = rgn->data;
+		romMask = rgn->size - 1;
+	}
+	else
+	{
+		rom = &zeroWord;
+		romMask = 0x00;
+	}
+	ulaw = NULL;
+	if (chip->chipType == CHIP_ES5506 && (voice->control & CONTROL_CMPD))
+		ulaw = chip->ulaw_lookup;
+
+	accum = voice->accum & chip->accmask;
+	smpl = 0;
+	while(smpl < length)
+	{
+		// the span can be rendered without any checks, the mask is never hit
+		span = span_length(chip, voice, accum, length - smpl);
+		step = (voice->control & CONTROL_DIR) ? (0 - voice->freqcount) : voice->freqcount;
+		if (ulaw == NULL)
+		{
+			for (; span > 0; span --, smpl ++)
+			{
+				addr = accum >> ADDRESS_FRAC_BIT;
+				frac = accum & ((1 << ADDRESS_FRAC_BIT) - 1);
+				val1 = (INT16)rom[addr & romMask];
+				val2 = (INT16)rom[(addr + 1) & romMask];
+				chip->smpBuf[smpl][lane] = (val1 * (INT32)(0x800 - frac) + val2 * (INT32)frac) >> 11;
+				accum += step;
+			}
+		}
+		else
+		{
+			for (; span > 0; span --, smpl ++)
+			{
+				addr = accum >> ADDRESS_FRAC_BIT;
+				frac = accum & ((1 << ADDRESS_FRAC_BIT) - 1);
+				val1 = ulaw[rom[addr & romMask] >> (16 - ULAW_MAXBITS)];
+				val2 = ulaw[rom[(addr + 1) & romMask] >> (16 - ULAW_MAXBITS)];
+				chip->smpBuf[smpl][lane] = (val1 * (INT32)(0x800 - frac) + val2 * (INT32)frac) >> 11;
+				accum += step;
+			}
+		}
+		if (smpl >= length)
+			break;
+
+		// this sample's step reaches a loop point
+		addr = accum >> ADDRESS_FRAC_BIT;
+		frac = accum & ((1 << ADDRESS_FRAC_BIT) - 1);
+		if (ulaw == NULL)
+		{
+			val1 = (INT16)rom[addr & romMask];
+			val2 = (INT16)rom[(addr + 1) & romMask];
+		}
+		else
+		{
+			val1 = ulaw[rom[addr & romMask] >> (16 - ULAW_MAXBITS)];
+			val2 = ulaw[rom[(addr + 1) & romMask] >> (16 - ULAW_MAXBITS)];
+		}
+		chip->smpBuf[smpl][lane] = (val1 * (INT32)(0x800 - frac) + val2 * (INT32)frac) >> 11;
+		smpl ++;
+		if (advance_voice(chip, voice, &accum))
+			break;
+	}
+	voice->accum = accum;
+
+	return smpl;
+}
+
+// Stage 2: filters, envelopes and volume for all lanes, summed into the output
+// The lanes are processed in groups of LANE_GRP, so that the compiler can vectorize them
+// even at optimization levels without loop vectorization. Mode selections use bit masks.
+static void mix_lanes(ES5506Chip* chip, UINT8 lanes, const UINT8* laneVoc, const UINT32* laneLen,
+	UINT32 length, DEV_SMPL* bufL, DEV_SMPL* bufR)
+{
+	INT32 o1n1[MAX_VOICES], o2n1[MAX_VOICES], o2n2[MAX_VOICES];
+	INT32 o3n1[MAX_VOICES], o3n2[MAX_VOICES], o4n1[MAX_VOICES];
+	INT32 k1[MAX_VOICES], k2[MAX_VOICES];
+	INT32 lp3[MAX_VOICES], lp3k1[MAX_VOICES], lp4[MAX_VOICES];	// filter mode masks
+	INT32 runLen[MAX_VOICES];
+	INT32 enable[MAX_VOICES];	// 0 = muted/unconnected output
+	INT32 gainL[MAX_VOICES], gainR[MAX_VOICES];
+	INT32 lvol[MAX_VOICES], rvol[MAX_VOICES];
+	INT32 ecount[MAX_VOICES], filtcount[MAX_VOICES];
+	INT32 lvramp[MAX_VOICES], rvramp[MAX_VOICES], k1ramp[MAX_VOICES], k2ramp[MAX_VOICES];
+	INT32 k1slow[MAX_VOICES], k2slow[MAX_VOICES];
+	INT32 outY[MAX_VOICES];
+	UINT32 lanesPad;
+	UINT8 envAny;
+	UINT32 smpl;
+	UINT32 grp;
+	UINT32 l;
+
+	// padding lanes have no gain and never become active
+	lanesPad = (lanes + LANE_GRP - 1) & ~(LANE_GRP - 1);
+	memset(o1n1, 0x00, sizeof(o1n1));	memset(o2n1, 0x00, sizeof(o2n1));	memset(o2n2, 0x00, sizeof(o2n2));
+	memset(o3n1, 0x00, sizeof(o3n1));	memset(o3n2, 0x00, sizeof(o3n2));	memset(o4n1, 0x00, sizeof(o4n1));
+	memset(k1, 0x00, sizeof(k1));	memset(k2, 0x00, sizeof(k2));
+	memset(lp3, 0x00, sizeof(lp3));	memset(lp3k1, 0x00, sizeof(lp3k1));	memset(lp4, 0x00, sizeof(lp4));
+	memset(runLen, 0x00, sizeof(runLen));
+	memset(gainL, 0x00, sizeof(gainL));	memset(gainR, 0x00, sizeof(gainR));
+	envAny = 0;
+	for (l = 0; l < lanes; l ++)
+	{
+		const ES5506_VOICE* voice = &chip->voice[laneVoc[l]];
+		UINT32 ca = (voice->control >> 10) & ((chip->chipType == CHIP_ES5506) ? 0x07 : 0x03);	// CA0..CA2
+
+		o1n1[l] = voice->o1n1;	o2n1[l] = voice->o2n1;	o2n2[l] = voice->o2n2;
+		o3n1[l] = voice->o3n1;	o3n2[l] = voice->o3n2;	o4n1[l] = voice->o4n1;
+		k1[l] = voice->k1;
+		k2[l] = voice->k2;
+		lp3[l] = (voice->control & CONTROL_LPMASK) ? -1 : 0;
+		lp3k1[l] = (voice->control & CONTROL_LP3) ? -1 : 0;
+		lp4[l] = (voice->control & CONTROL_LP4) ? -1 : 0;
+		runLen[l] = laneLen[l];
+		enable[l] = (ca < chip->output_channels && ! voice->Muted) ? 1 : 0;
+		lvol[l] = voice->lvol;
+		rvol[l] = voice->rvol;
+		gainL[l] = vol_gain(voice->lvol) * enable[l];
+		gainR[l] = vol_gain(voice->rvol) * enable[l];
+		ecount[l] = voice->ecount;
+		filtcount[l] = voice->filtcount;
+		lvramp[l] = (INT8)voice->lvramp;
+		rvramp[l] = (INT8)voice->rvramp;
+		k1ramp[l] = (INT8)voice->k1ramp;
+		k2ramp[l] = (INT8)voice->k2ramp;
+		k1slow[l] = ((INT32)voice->k1ramp < 0) ? 7 : 0;
+		k2slow[l] = ((INT32)voice->k2ramp < 0) ? 7 : 0;
+		if (voice->ecount)
+			envAny = 1;
+	}
+
+	for (smpl = 0; smpl < length; smpl ++)
+	{
+		const INT32* input = chip->smpBuf[smpl];
+		INT32 sumL[LANE_GRP];
+		INT32 sumR[LANE_GRP];
+
+		// 4-pole filter, all modes are calculated and selected per lane
+		for (grp = 0; grp < lanesPad; grp += LANE_GRP)
+		{
+			UINT32 j;
+			for (j = 0; j < LANE_GRP; j ++)
+			{
+				UINT32 i = grp + j;
+				INT32 act = -(INT32)((INT32)smpl < runLen[i]);
+				INT32 kf1 = k1[i] >> FILTER_SHIFT;
+				INT32 kf2 = k2[i] >> FILTER_SHIFT;
+				INT32 kf3 = (kf1 & lp3k1[i]) | (kf2 & ~lp3k1[i]);
+				INT32 x, y1, y2, y3, y4, hp, lp;
+
+				x = input[i];
+				// poles 1 and 2 are always low-pass using K1
+				y1 = kf1 * (x - o1n1[i]) / (1 << FILTER_BIT) + o1n1[i];
+				y2 = kf1 * (y1 - o2n1[i]) / (1 << FILTER_BIT) + o2n1[i];
+				// pole 3: high-pass using K2 or low-pass using K1/K2
+				hp = y2 - o2n1[i] + kf2 * o3n1[i] / (1 << (FILTER_BIT + 1)) + o3n1[i] / 2;
+				lp = kf3 * (y2 - o3n1[i]) / (1 << FILTER_BIT) + o3n1[i];
+				y3 = (lp & lp3[i]) | (hp & ~lp3[i]);
+				// pole 4: high-pass or low-pass using K2
+				hp = y3 - o3n1[i] + kf2 * o4n1[i] / (1 << (FILTER_BIT + 1)) + o4n1[i] / 2;
+				lp = kf2 * (y3 - o4n1[i]) / (1 << FILTER_BIT) + o4n1[i];
+				y4 = (lp & lp4[i]) | (hp & ~lp4[i]);
+
+				o2n2[i] = (o2n1[i] & act) | (o2n2[i] & ~act);
+				o3n2[i] = (o3n1[i] & act) | (o3n2[i] & ~act);
+				o1n1[i] = (y1 & act) | (o1n1[i] & ~act);
+				o2n1[i] = (y2 & act) | (o2n1[i] & ~act);
+				o3n1[i] = (y3 & act) | (o3n1[i] & ~act);
+				o4n1[i] = (y4 & act) | (o4n1[i] & ~act);
+				outY[i] = y4 & act;
+			}
+		}
+
+		if (envAny)
+		{
+			for (l = 0; l < lanes; l ++)
+			{
+				INT32 val;
+
+				if (! ecount[l] || (INT32)smpl >= runLen[l])
+					continue;
+				ecount[l] --;
+				val = lvol[l] + lvramp[l];
+				lvol[l] = (val < 0) ? 0 : (val > 0xFFFF) ? 0xFFFF : val;
+				val = rvol[l] + rvramp[l];
+				rvol[l] = (val < 0) ? 0 : (val > 0xFFFF) ? 0xFFFF : val;
+				if (k1ramp[l] && ! (filtcount[l] & k1slow[l]))
+				{
+					val = k1[l] + k1ramp[l];
+					k1[l] = (val < 0) ? 0 : (val > 0xFFFF) ? 0xFFFF : val;
+				}
+				if (k2ramp[l] && ! (filtcount[l] & k2slow[l]))
+				{
+					val = k2[l] + k2ramp[l];
+					k2[l] = (val < 0) ? 0 : (val > 0xFFFF) ? 0xFFFF : val;
+				}
+				filtcount[l] ++;
+				gainL[l] = vol_gain(lvol[l]) * enable[l];
+				gainR[l] = vol_gain(rvol[l]) * enable[l];
+			}
+		}
+
+		memset(sumL, 0x00, sizeof(sumL));
+		memset(sumR, 0x00, sizeof(sumR));
+		for (grp = 0; grp < lanesPad; grp += LANE_GRP)
+		{
+			UINT32 j;
+			for (j = 0; j < LANE_GRP; j ++)
+			{
+				sumL[j] += (outY[grp + j] * gainL[grp + j]) >> 11;
+				sumR[j] += (outY[grp + j] * gainR[grp + j]) >> 11;
+			}
+		}
+		for (l = 0; l < LANE_GRP; l ++)
+		{
+			bufL[smpl] += sumL[l];
+			bufR[smpl] += sumR[l];
+		}
+	}
+
+	for (l = 0; l < lanes; l ++)
+	{
+		ES5506_VOICE* voice = &chip->voice[laneVoc[l]];
+
+		voice->o1n1 = o1n1[l];	voice->o2n1 = o2n1[l];	voice->o2n2 = o2n2[l];
+		voice->o3n1 = o3n1[l];	voice->o3n2 = o3n2[l];	voice->o4n1 = o4n1[l];
+		voice->k1 = k1[l];
+		voice->k2 = k2[l];
+		voice->lvol = lvol[l];
+		voice->rvol = rvol[l];
+		voice->ecount = ecount[l];
+		voice->filtcount = filtcount[l];
+	}
+
+	return;
+}
+
+static void render_block(ES5506Chip* chip, UINT32 length, DEV_SMPL* bufL, DEV_SMPL* bufR)
+{
+	UINT8 laneVoc[MAX_VOICES];
+	UINT32 laneLen[MAX_VOICES];
+	UINT8 lanes;
+	UINT8 curVoc;
+	UINT8 l;
+
+	lanes = 0;
+	for (curVoc = 0; curVoc <= chip->active_voices; curVoc ++)
+	{
+		ES5506_VOICE* voice = &chip->voice[curVoc];
+
+		// special case: if end == start, stop the voice
+		if (voice->start == voice->end)
+			voice->control |= CONTROL_STOP0;
+		if (voice->control & CONTROL_STOPMASK)
+		{
+			if (voice->ecount)
+				update_envelopes(voice, length);
+			continue;
+		}
+
+		laneLen[lanes] = fetch_voice(chip, voice, lanes, length);
+		laneVoc[lanes] = curVoc;
+		lanes ++;
+	}
+	if (! lanes)
+		return;
+
+	mix_lanes(chip, lanes, laneVoc, laneLen, length, bufL, bufR);
+
+	// voices that stopped within the block process the rest of their envelope
+	for (l = 0; l < lanes; l ++)
+	{
+		ES5506_VOICE* voice = &chip->voice[laneVoc[l]];
+		if (laneLen[l] < length && voice->ecount)
+			update_envelopes(voice, length - laneLen[l]);
+	}
+
+	return;
+}
+
+static void es5506_update(void *param, UINT32 samples, DEV_SMPL **outputs)
+{
+	ES5506Chip *chip = (ES5506Chip *)param;
+	UINT32 pos;
+	UINT32 len;
+
+	memset(outputs[0], 0, samples * sizeof(DEV_SMPL));
+	memset(outputs[1], 0, samples * sizeof(DEV_SMPL));
+
+	for (pos = 0; pos < samples; pos += len)
+	{
+		len = samples - pos;
+		if (len > ES_BLOCK)
+			len = ES_BLOCK;
+		render_block(chip, len, &outputs[0][pos], &outputs[1][pos]);
+	}
+
+	return;
+}
+
+
+/**********************************************************************************************
+
+     DEVICE INTERFACE
+
+***********************************************************************************************/
+
+static void compute_tables(ES5506Chip* chip)
+{
+	UINT32 i;
+
+	// u-law lookup table
+	for (i = 0; i < (1 << ULAW_MAXBITS); i ++)
+	{
+		UINT16 rawval = (i << (16 - ULAW_MAXBITS)) | (1 << (15 - ULAW_MAXBITS));
+		UINT8 exponent = rawval >> 13;
+		UINT32 mantissa = (rawval << 3) & 0xFFFF;
+
+		if (exponent == 0)
+		{
+			chip->ulaw_lookup[i] = (INT16)mantissa >> 7;
+		}
+		else
+		{
+			mantissa = (mantissa >> 1) | (~mantissa & 0x8000);
+			chip->ulaw_lookup[i] = (INT16)mantissa >> (7 - exponent);
+		}
+	}
+
+	return;
+}
+
+static void es5506_set_rate(ES5506Chip* chip)
+{
+	UINT32 newRate;
+
+	newRate = chip->clock / (16 * (chip->active_voices + 1));
+	if (newRate == chip->sample_rate)
+		return;
+	chip->sample_rate = newRate;
+	if (chip->SmpRateFunc != NULL)
+		chip->SmpRateFunc(chip->SmpRateData, chip->sample_rate);
+
+	return;
+}
+
+static UINT8 device_start_es5506(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
+{
+	ES5506Chip *chip;
+
+	chip = (ES5506Chip *)DevData_Alloc(cfg->memArena, sizeof(ES5506Chip));
+	if (chip == NULL)
+		return 0xFF;
+
+	chip->chipType = (cfg->flags & 0x01) ? CHIP_ES5506 : CHIP_ES5505;
+	chip->clock = cfg->clock;
+	chip->output_channels = cfg->flags >> 1;
+	if (! chip->output_channels)
+		chip->output_channels = 1;
+	if (chip->chipType == CHIP_ES5506)
+	{
+		chip->accmask = 0xFFFFFFFF;
+		chip->maxWords = 0x200000;	// 2M words (4 MB)
+	}
+	else
+	{
+		chip->accmask = 0x7FFFFFFF;
+		chip->maxWords = 0x100000;	// 1M words (2 MB)
+	}
+	compute_tables(chip);
+
+	chip->active_voices = 0x1F;
+	chip->sample_rate = chip->clock / (16 * (chip->active_voices + 1));
+
+	es5506_set_mute_mask(chip, 0x00000000);
+
+	chip->_devData.chipInf = chip;
+	INIT_DEVINF(retDevInf, &chip->_devData, chip->sample_rate, &devDef);
+
+	return 0x00;
+}
+
+static void device_stop_es5506(void *info)
+{
+	ES5506Chip *chip = (ES5506Chip *)info;
+	UINT8 curRgn;
+
+	for (curRgn = 0; curRgn < 4; curRgn ++)
+		free(chip->region[curRgn].data);
+	DevData_Free(chip);
+
+	return;
+}
+
+static void device_reset_es5506(void *info)
+{
+	ES5506Chip *chip = (ES5506Chip *)info;
+	UINT8 curVoc;
+	ES5506_VOICE* voice;
+	UINT8 muted;
+
+	for (curVoc = 0; curVoc < MAX_VOICES; curVoc ++)
+	{
+		voice = &chip->voice[curVoc];
+		muted = voice->Muted;
+		memset(voice, 0x00, sizeof(ES5506_VOICE));
+		voice->Muted = muted;
+		voice->control = CONTROL_STOPMASK;
+		voice->lvol = (chip->chipType == CHIP_ES5506) ? 0xFFFF : 0xFF00;
+		voice->rvol = voice->lvol;
+	}
+
+	chip->current_page = 0x00;
+	chip->mode = 0x00;
+	chip->write_latch = 0x00;
+	chip->read_latch = 0x00;
+	chip->active_voices = 0x1F;
+	es5506_set_rate(chip);
+
+	return;
+}
+
+// returns the voice number of the first pending IRQ and acknowledges it, 0x80 = no IRQ
+static UINT8 read_irqv(ES5506Chip* chip)
+{
+	UINT8 curVoc;
+
+	for (curVoc = 0; curVoc <= chip->active_voices; curVoc ++)
+	{
+		if (chip->voice[curVoc].control & CONTROL_IRQ)
+		{
+			chip->voice[curVoc].control &= ~CONTROL_IRQ;
+			return curVoc;
+		}
+	}
+	return 0x80;
+}
+
+
+// ---- ES5506 register interface ----
+
+static void es5506_reg_write(ES5506Chip* chip, UINT8 reg, UINT32 data)
+{
+	ES5506_VOICE* voice = &chip->voice[chip->current_page & 0x1F];
+
+	switch(reg)
+	{
+	case 0x0D:	// PAR (read only)
+	case 0x0E:	// IRQV (read only)
+		return;
+	case 0x0F:	// PAGE
+		chip->current_page = data & 0x7F;
+		return;
+	}
+
+	if (chip->current_page < 0x20)
+	{
+		switch(reg)
+		{
+		case 0x00:	// CR
+			voice->control = data & 0xFFFF;
+			break;
+		case 0x01:	// FC
+			voice->freqcount = data & 0x1FFFF;
+			break;
+		case 0x02:	// LVOL
+			voice->lvol = data & 0xFFFF;
+			break;
+		case 0x03:	// LVRAMP
+			voice->lvramp = (data & 0xFF00) >> 8;
+			break;
+		case 0x04:	// RVOL
+			voice->rvol = data & 0xFFFF;
+			break;
+		case 0x05:	// RVRAMP
+			voice->rvramp = (data & 0xFF00) >> 8;
+			break;
+		case 0x06:	// ECOUNT
+			voice->ecount = data & 0x1FF;
+			voice->filtcount = 0;
+			break;
+		case 0x07:	// K2
+			voice->k2 = data & 0xFFFF;
+			break;
+		case 0x08:	// K2RAMP
+			voice->k2ramp = ((data & 0xFF00) >> 8) | ((data & 0x0001) << 31);
+			break;
+		case 0x09:	// K1
+			voice->k1 = data & 0xFFFF;
+			break;
+		case 0x0A:	// K1RAMP
+			voice->k1ramp = ((data & 0xFF00) >> 8) | ((data & 0x0001) << 31);
+			break;
+		case 0x0B:	// ACTV
+			chip->active_voices = data & 0x1F;
+			es5506_set_rate(chip);
+			break;
+		case 0x0C:	// MODE
+			chip->mode = data & 0x1F;
+			break;
+		}
+	}
+	else if (chip->current_page < 0x40)
+	{
+		switch(reg)
+		{
+		case 0x00:	// CR
+			voice->control = data & 0xFFFF;
+			break;
+		case 0x01:	// START
+			voice->start = data & 0xFFFFF800;
+			break;
+		case 0x02:	// END
+			voice->end = data & 0xFFFFFF80;
+			break;
+		case 0x03:	// ACCUM
+			voice->accum = data;
+			break;
+		// filter storage registers are 18-bit signed
+		case 0x04:	// O4(n-1)
+			voice->o4n1 = (INT32)(data << 14) >> 14;
+			break;
+		case 0x05:	// O3(n-1)
+			voice->o3n1 = (INT32)(data << 14) >> 14;
+			break;
+		case 0x06:	// O3(n-2)
+			voice->o3n2 = (INT32)(data << 14) >> 14;
+			break;
+		case 0x07:	// O2(n-1)
+			voice->o2n1 = (INT32)(data << 14) >> 14;
+			break;
+		case 0x08:	// O2(n-2)
+			voice->o2n2 = (INT32)(data << 14) >> 14;
+			break;
+		case 0x09:	// O1(n-1)
+			voice->o1n1 = (INT32)(data << 14) >> 14;
+			break;
+		// 0x0A..0x0C: W_ST, W_END, LR_END (host DMA, not emulated)
+		}
+	}
+	else
+	{
+		switch(reg)
+		{
+		case 0x0B:	// ACTV
+			chip->active_voices = data & 0x1F;
+			es5506_set_rate(chip);
+			break;
+		case 0x0C:	// MODE
+			chip->mode = data & 0x1F;
+			break;
+		}
+	}
+
+	return;
+}
+
+static UINT32 es5506_reg_read(ES5506Chip* chip, UINT8 reg)
+{
+	const ES5506_VOICE* voice = &chip->voice[chip->current_page & 0x1F];
+
+	switch(reg)
+	{
+	case 0x0D:	// PAR
+		return 0x00;
+	case 0x0E:	// IRQV
+		return read_irqv(chip);
+	case 0x0F:	// PAGE
+		return chip->current_page;
+	}
+
+	if (chip->current_page < 0x20)
+	{
+		switch(reg)
+		{
+		case 0x00:	return voice->control;
+		case 0x01:	return voice->freqcount;
+		case 0x02:	return voice->lvol;
+		case 0x03:	return voice->lvramp << 8;
+		case 0x04:	return voice->rvol;
+		case 0x05:	return voice->rvramp << 8;
+		case 0x06:	return voice->ecount;
+		case 0x07:	return voice->k2;
+		case 0x08:	return ((voice->k2ramp << 8) & 0xFF00) | (voice->k2ramp >> 31);
+		case 0x09:	return voice->k1;
+		case 0x0A:	return ((voice->k1ramp << 8) & 0xFF00) | (voice->k1ramp >> 31);
+		case 0x0B:	return chip->active_voices;
+		case 0x0C:	return chip->mode;
+		}
+	}
+	else if (chip->current_page < 0x40)
+	{
+		switch(reg)
+		{
+		case 0x00:	return voice->control;
+		case 0x01:	return voice->start;
+		case 0x02:	return voice->end;
+		case 0x03:	return voice->accum;
+		case 0x04:	return voice->o4n1 & 0x3FFFF;
+		case 0x05:	return voice->o3n1 & 0x3FFFF;
+		case 0x06:	return voice->o3n2 & 0x3FFFF;
+		case 0x07:	return voice->o2n1 & 0x3FFFF;
+		case 0x08:	return voice->o2n2 & 0x3FFFF;
+		case 0x09:	return voice->o1n1 & 0x3FFFF;
+		}
+	}
+	else
+	{
+		switch(reg)
+		{
+		case 0x0B:	return chip->active_voices;
+		case 0x0C:	return chip->mode;
+		}
+	}
+
+	return 0x00;
+}
+
+
+// ---- ES5505 register interface ----
+
+// returns the current register value (without side effects)
+static UINT16 es5505_reg_get(ES5506Chip* chip, UINT8 reg)
+{
+	const ES5506_VOICE* voice = &chip->voice[chip->current_page & 0x1F];
+
+	switch(reg)
+	{
+	case 0x0D:	// ACT
+		return chip->active_voices;
+	case 0x0E:	// IRQV
+		return 0x00;
+	case 0x0F:	// PAGE
+		return chip->current_page;
+	}
+
+	if (chip->current_page < 0x40 && reg == 0x00)	// CR
+	{
+		return (voice->control & (CONTROL_STOPMASK | CONTROL_LOOPMASK | CONTROL_IRQE | CONTROL_DIR | CONTROL_IRQ)) |
+			((voice->control & CONTROL_BS0) >> 12) | ((voice->control & CONTROL_LPMASK) << 2) |
+			((voice->control & (CONTROL_CA0 | CONTROL_CA1)) >> 2) | 0xF000;
+	}
+	if (chip->current_page < 0x20)
+	{
+		switch(reg)
+		{
+		case 0x01:	return voice->freqcount >> 1;	// FC
+		case 0x02:	return (voice->start >> 18) & 0x1FFF;	// STRT (hi)
+		case 0x03:	return (voice->start >> 2) & 0xFFE0;	// STRT (lo)
+		case 0x04:	return (voice->end >> 18) & 0x1FFF;	// END (hi)
+		case 0x05:	return (voice->end >> 2) & 0xFFE0;	// END (lo)
+		case 0x06:	return voice->k2;	// K2
+		case 0x07:	return voice->k1;	// K1
+		case 0x08:	return voice->lvol;	// LVOL
+		case 0x09:	return voice->rvol;	// RVOL
+		case 0x0A:	return (voice->accum >> 18) & 0x1FFF;	// ACC (hi)
+		case 0x0B:	return (voice->accum >> 2) & 0xFFFF;	// ACC (lo)
+		}
+	}
+	else if (chip->current_page < 0x40)
+	{
+		switch(reg)
+		{
+		case 0x01:	return (UINT16)voice->o4n1;
+		case 0x02:	return (UINT16)voice->o3n1;
+		case 0x03:	return (UINT16)voice->o3n2;
+		case 0x04:	return (UINT16)voice->o2n1;
+		case 0x05:	return (UINT16)voice->o2n2;
+		case 0x06:	return (UINT16)voice->o1n1;
+		}
+	}
+
+	return 0x0000;
+}
+
+static void es5505_reg_write(ES5506Chip* chip, UINT8 reg, UINT16 data)
+{
+	ES5506_VOICE* voice = &chip->voice[chip->current_page & 0x1F];
+
+	switch(reg)
+	{
+	case 0x0D:	// ACT
+		chip->active_voices = data & 0x1F;
+		es5506_set_rate(chip);
+		return;
+	case 0x0E:	// IRQV (read only)
+		return;
+	case 0x0F:	// PAGE
+		chip->current_page = data & 0x7F;
+		return;
+	}
+
+	if (chip->current_page < 0x40 && reg == 0x00)	// CR
+	{
+		voice->control &= ~(CONTROL_STOPMASK | CONTROL_BS0 | CONTROL_LOOPMASK | CONTROL_IRQE | CONTROL_DIR | CONTROL_IRQ |
+							CONTROL_LPMASK | CONTROL_CA0 | CONTROL_CA1);
+		voice->control |= (data & (CONTROL_STOPMASK | CONTROL_LOOPMASK | CONTROL_IRQE | CONTROL_DIR | CONTROL_IRQ)) |
+							((data << 12) & CONTROL_BS0) | ((data >> 2) & CONTROL_LPMASK) |
+							((data << 2) & (CONTROL_CA0 | CONTROL_CA1));
+		return;
+	}
+	if (chip->current_page < 0x20)
+	{
+		switch(reg)
+		{
+		case 0x01:	// FC
+			voice->freqcount = (data & 0xFFFF) << 1;
+			break;
+		case 0x02:	// STRT (hi)
+			voice->start = (voice->start & ~0x7FFC0000) | ((data & 0x1FFF) << 18);
+			break;
+		case 0x03:	// STRT (lo)
+			voice->start = (voice->start & ~0x0003FF80) | ((data & 0xFFE0) << 2);
+			break;
+		case 0x04:	// END (hi)
+			voice->end = (voice->end & ~0x7FFC0000) | ((data & 0x1FFF) << 18);
+			break;
+		case 0x05:	// END (lo)
+			voice->end = (voice->end & ~0x0003FF80) | ((data & 0xFFE0) << 2);
+			break;
+		case 0x06:	// K2
+			voice->k2 = data & 0xFFF0;
+			break;
+		case 0x07:	// K1
+			voice->k1 = data & 0xFFF0;
+			break;
+		case 0x08:	// LVOL
+			voice->lvol = data & 0xFF00;
+			break;
+		case 0x09:	// RVOL
+			voice->rvol = data & 0xFF00;
+			break;
+		case 0x0A:	// ACC (hi)
+			voice->accum = (voice->accum & ~0x7FFC0000) | ((data & 0x1FFF) << 18);
+			break;
+		case 0x0B:	// ACC (lo)
+			voice->accum = (voice->accum & ~0x0003FFFC) | ((data & 0xFFFF) << 2);
+			break;
+		}
+	}
+	else if (chip->current_page < 0x40)
+	{
+		switch(reg)
+		{
+		case 0x01:	voice->o4n1 = (INT16)data;	break;
+		case 0x02:	voice->o3n1 = (INT16)data;	break;
+		case 0x03:	voice->o3n2 = (INT16)data;	break;
+		case 0x04:	voice->o2n1 = (INT16)data;	break;
+		case 0x05:	voice->o2n2 = (INT16)data;	break;
+		case 0x06:	voice->o1n1 = (INT16)data;	break;
+		}
+	}
+
+	return;
+}
+
+
+// ES5506: offset = byte address (register * 4 + byte, MSB first)
+// ES5505: offset = byte address (register * 2 + byte, MSB first)
+static void es5506_w(void *info, UINT8 offset, UINT8 data)
+{
+	ES5506Chip *chip = (ES5506Chip *)info;
+
+	if (chip->chipType == CHIP_ES5506)
+	{
+		UINT8 shift = 8 * (offset & 0x03);
+
+		// accumulate the data, the register is written with the last byte
+		chip->write_latch = (chip->write_latch & ~(0xFF000000 >> shift)) | ((UINT32)data << (24 - shift));
+		if (shift != 24)
+			return;
+		es5506_reg_write(chip, (offset >> 2) & 0x0F, chip->write_latch);
+		chip->write_latch = 0x00;
+	}
+	else
+	{
+		UINT8 reg = (offset >> 1) & 0x0F;
+		UINT16 regData = es5505_reg_get(chip, reg);
+
+		if (offset & 0x01)
+			regData = (regData & 0xFF00) | (data << 0);
+		else
+			regData = (regData & 0x00FF) | (data << 8);
+		es5505_reg_write(chip, reg, regData);
+	}
+
+	return;
+}
+
+static UINT8 es5506_r(void *info, UINT8 offset)
+{
+	ES5506Chip *chip = (ES5506Chip *)info;
+
+	if (chip->chipType == CHIP_ES5506)
+	{
+		UINT8 shift = 8 * (offset & 0x03);
+
+		// the register is latched with the first byte
+		if (! shift)
+			chip->read_latch = es5506_reg_read(chip, (offset >> 2) & 0x0F);
+		return (chip->read_latch >> (24 - shift)) & 0xFF;
+	}
+	else
+	{
+		UINT16 regData = es5506_r16(info, offset >> 1);
+		return (offset & 0x01) ? (regData & 0xFF) : (regData >> 8);
+	}
+}
+
+// ES5505: offset = register
+// ES5506: offset = byte address of the upper byte of a 16-bit word
+static void es5506_w16(void *info, UINT8 offset, UINT16 data)
+{
+	ES5506Chip *chip = (ES5506Chip *)info;
+
+	if (chip->chipType == CHIP_ES5506)
+	{
+		es5506_w(chip, offset | 0, data >> 8);
+		es5506_w(chip, offset | 1, data & 0xFF);
+	}
+	else
+	{
+		es5505_reg_write(chip, offset & 0x0F, data);
+	}
+
+	return;
+}
+
+static UINT16 es5506_r16(void *info, UINT8 offset)
+{
+	ES5506Chip *chip = (ES5506Chip *)info;
+
+	if (chip->chipType == CHIP_ES5506)
+		return (es5506_r(chip, offset | 0) << 8) | (es5506_r(chip, offset | 1) << 0);
+
+	offset &= 0x0F;
+	if (offset == 0x0E)	// IRQV
+		return 0xFF00 | read_irqv(chip);
+	return es5505_reg_get(chip, offset);
+}
+
+
+// ROM offset: Bits 0-27 = byte offset, bits 28-29 = region (ES5505: bit 28)
+// The sample data consists of 16-bit little endian words.
+static void es5506_alloc_rom(void* info, UINT32 memsize)
+{
+	ES5506Chip *chip = (ES5506Chip *)info;
+
+	chip->romSize = memsize;
+
+	return;
+}
+
+static void es5506_write_rom(void *info, UINT32 offset, UINT32 length, const UINT8* data)
+{
+	ES5506Chip *chip = (ES5506Chip *)info;
+	ES5506_REGION* rgn;
+	UINT32 endWord;
+	UINT32 newSize;
+	UINT32 curByte;
+
+	rgn = &chip->region[(offset >> 28) & ((chip->chipType == CHIP_ES5506) ? 0x03 : 0x01)];
+	offset &= 0x0FFFFFFF;
+	if (offset >= chip->maxWords * 2)
+		return;
+	if (length > chip->maxWords * 2 - offset)
+		length = chip->maxWords * 2 - offset;
+	if (! length)
+		return;
+
+	// allocate the region on first use, rounded up to a power of 2 for address masking
+	endWord = (offset + length + 1) / 2;
+	if (endWord < chip->romSize / 2)
+		endWord = chip->romSize / 2;
+	if (endWord > chip->maxWords)
+		endWord = chip->maxWords;
+	if (endWord > rgn->size)
+	{
+		UINT16* newData;
+
+		newSize = pow2_mask(endWord) + 1;	// endWord <= maxWords, which is a power of 2
+		newData = (UINT16*)realloc(rgn->data, newSize * sizeof(UINT16));
+		if (newData == NULL)
+			return;
+		memset(&newData[rgn->size], 0x00, (newSize - rgn->size) * sizeof(UINT16));
+		rgn->data = newData;
+		rgn->size = newSize;
+	}
+
+	for (curByte = 0; curByte < length; curByte ++, offset ++)
+	{
+		UINT16* word = &rgn->data[offset >> 1];
+		if (offset & 0x01)
+			*word = (*word & 0x00FF) | (data[curByte] << 8);
+		else
+			*word = (*word & 0xFF00) | (data[curByte] << 0);
+	}
+
+	return;
+}
+
+static void es5506_set_mute_mask(void *info, UINT32 MuteMask)
+{
+	ES5506Chip *chip = (ES5506Chip *)info;
+	UINT8 CurChn;
+
+	for (CurChn = 0; CurChn < MAX_VOICES; CurChn ++)
+		chip->voice[CurChn].Muted = (MuteMask >> CurChn) & 0x01;
+
+	return;
+}
+
+static void es5506_set_srchg_cb(void *info, DEVCB_SRATE_CHG CallbackFunc, void* DataPtr)
+{
+	ES5506Chip *chip = (ES5506Chip *)info;
+
+	// set Sample Rate Change Callback routine
+	chip->SmpRateFunc = CallbackFunc;
+	chip->SmpRateData = DataPtr;
+
+	return;
+}
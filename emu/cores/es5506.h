@@ -3,7 +3,9 @@
 
 #include "../EmuStructs.h"
 
-// cfg.flags: output channels (ES5505: 1..4, ES5506: 1..6, downmixed to stereo)
+// cfg.flags: Bit 0 - chip type (0 = ES5505, 1 = ES5506, like bit 31 of the VGM clock)
+//            Bits 1-7 - output channels (ES5505: 1..4, ES5506: 1..6, downmixed to stereo)
+// ROM offsets: Bits 0-27 = byte offset, bits 28-29 = bank (ES5505: bit 28 only)
 
 extern const DEV_DEF* devDefList_ES5506[];
 
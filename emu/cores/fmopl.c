@@ -78,6 +78,7 @@ Revision History:
 #include "../../stdtype.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 
 #ifndef SNDDEV_SELECT
 #define SNDDEV_YM3812
@@ -586,10 +587,6 @@ static const INT8 lfo_pm_table[8*8*2] = {
 };
 
 
-/* lock level of common table */
-static int num_lock = 0;
-
-
 #define SLOT7_1 (&OPL->P_CH[7].SLOT[SLOT1])
 #define SLOT7_2 (&OPL->P_CH[7].SLOT[SLOT2])
 #define SLOT8_1 (&OPL->P_CH[8].SLOT[SLOT1])
@@ -597,7 +594,7 @@ static int num_lock = 0;
 
 
 
-static UINT8 tablesInit = 0;
+static EMU_ONCE tablesOnce = EMU_ONCE_INIT;
 
 /* status set and IRQ handling */
 INLINE void OPL_STATUS_SET(FM_OPL *OPL,int flag)
@@ -1120,16 +1117,12 @@ INLINE void OPL_CALC_RH( FM_OPL *OPL, OPL_CH *CH, unsigned int noise )
 
 
 /* generic table initialize */
-static int init_tables(void)
+static void init_tables(void)
 {
 	signed int i,x;
 	signed int n;
 	double o,m;
 
-	if (tablesInit)
-		return 1;
-	tablesInit = 1;
-
 	for (x=0; x<TL_RES_LEN; x++)
 	{
 		m = (1<<16) / pow(2, (x+1) * (ENV_STEP/4.0) / 8.0);
@@ -1220,13 +1213,6 @@ static int init_tables(void)
 		logerror("FMOPL.C: sin3[%4i]= %4i (tl_tab value=%5i)\n", i, sin_tab[3*SIN_LEN+i], tl_tab[sin_tab[3*SIN_LEN+i]] );*/
 	}
 	/*logerror("FMOPL.C: ENV_QUIET= %08x (dec*8=%i)\n", ENV_QUIET, ENV_QUIET*8 );*/
-
-
-	return 1;
-}
-
-static void OPLCloseTable( void )
-{
 }
 
 
@@ -1685,34 +1671,6 @@ static void OPLWriteReg(FM_OPL *OPL, UINT8 r, UINT8 v)
 	}
 }
 
-/* lock/unlock for common table */
-static int OPL_LockTable(void)
-{
-	num_lock++;
-	if(num_lock>1) return 0;
-
-	/* first time */
-
-	/* allocate total level table (128kb space) */
-	if( !init_tables() )
-	{
-		num_lock--;
-		return -1;
-	}
-
-	return 0;
-}
-
-static void OPL_UnLockTable(void)
-{
-	if(num_lock) num_lock--;
-	if(num_lock) return;
-
-	/* last time */
-
-	OPLCloseTable();
-}
-
 static void OPLResetChip(FM_OPL *OPL)
 {
 	int c,s;
@@ -1774,7 +1732,7 @@ static FM_OPL *OPLCreate(UINT32 clock, UINT32 rate, int type)
 	FM_OPL *OPL;
 	int state_size;
 
-	if (OPL_LockTable() == -1) return NULL;
+	Emu_CallOnce(&tablesOnce, init_tables);
 
 	/* calculate OPL state size */
 	state_size  = sizeof(FM_OPL);
@@ -1811,7 +1769,6 @@ static FM_OPL *OPLCreate(UINT32 clock, UINT32 rate, int type)
 /* Destroy one of virtual YM3812 */
 static void OPLDestroy(FM_OPL *OPL)
 {
-	OPL_UnLockTable();
 	free(OPL);
 }
 
@@ -121,6 +121,7 @@
 #include "../../stdtype.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 
 #ifndef SNDDEV_SELECT
 #define SNDDEV_YM2203
@@ -675,7 +676,7 @@ typedef struct
 }
 
 
-static UINT8 tablesInit = 0;
+static EMU_ONCE tablesOnce = EMU_ONCE_INIT;
 
 /* status set and IRQ handling */
 INLINE void FM_STATUS_SET(FM_ST *ST,int flag)
@@ -1526,16 +1527,12 @@ static void reset_channels( FM_ST *ST , FM_CH *CH , int num )
 }
 
 /* initialize generic tables */
-static int init_tables(void)
+static void init_tables(void)
 {
 	signed int i,x;
 	signed int n;
 	double o,m;
 
-	if (tablesInit)
-		return 1;
-	tablesInit = 1;
-
 	for (x=0; x<TL_RES_LEN; x++)
 	{
 		m = (1<<16) / pow(2, (x+1) * (ENV_STEP/4.0) / 8.0);
@@ -1634,9 +1631,6 @@ static int init_tables(void)
 
 		}
 	}
-
-	return 1;
-
 }
 
 
@@ -2251,8 +2245,7 @@ void * ym2203_init(void *param, UINT32 clock, UINT32 rate,
 {
 	YM2203 *F2203;
 
-	if( !init_tables() )
-		return NULL;
+	Emu_CallOnce(&tablesOnce, init_tables);
 
 	/* allocate ym2203 state space */
 	F2203 = (YM2203 *)calloc(1,sizeof(YM2203));
@@ -2472,6 +2465,7 @@ static const int step_inc[8] = { -1*16, -1*16, -1*16, -1*16, 2*16, 5*16, 7*16, 9
 
 /* speedup purposes only */
 static int jedi_table[ 49*16 ];
+static EMU_ONCE adpcmaTableOnce = EMU_ONCE_INIT;
 
 
 static void Init_ADPCMATable(void)
@@ -2894,8 +2888,7 @@ void * ym2608_init(void *param, UINT32 clock, UINT32 rate,
 	YM2608 *F2608;
 
 	/* allocate total level table (128kb space) */
-	if( !init_tables() )
-		return NULL;
+	Emu_CallOnce(&tablesOnce, init_tables);
 
 	/* allocate extend state space */
 	F2608 = (YM2608 *)calloc(1,sizeof(YM2608));
@@ -2936,7 +2929,7 @@ void * ym2608_init(void *param, UINT32 clock, UINT32 rate,
 	F2608->pcmbuf   = (UINT8*)YM2608_ADPCM_ROM;
 	F2608->pcm_size = 0x2000;
 
-	Init_ADPCMATable();
+	Emu_CallOnce(&adpcmaTableOnce, Init_ADPCMATable);
 
 	ym2608_set_mutemask(F2608, 0x00);
 
@@ -3577,8 +3570,7 @@ void *ym2610_init(void *param, UINT32 clock, UINT32 rate,
 	YM2610 *F2610;
 
 	/* allocate total level table (128kb space) */
-	if( !init_tables() )
-		return NULL;
+	Emu_CallOnce(&tablesOnce, init_tables);
 
 	/* allocate extend state space */
 	F2610 = (YM2610 *)calloc(1,sizeof(YM2610));
@@ -3612,7 +3604,7 @@ void *ym2610_init(void *param, UINT32 clock, UINT32 rate,
 
 	YM_DELTAT_ADPCM_Init(&F2610->deltaT,YM_DELTAT_EMULATION_MODE_YM2610,8,F2610->OPN.out_delta,1<<23);
 
-	Init_ADPCMATable();
+	Emu_CallOnce(&adpcmaTableOnce, Init_ADPCMATable);
 
 	ym2610_set_mutemask(F2610, 0x00);
 
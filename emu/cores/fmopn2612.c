@@ -143,6 +143,7 @@
 #include "../../stdtype.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 
 #ifndef SNDDEV_YM2612
 #define SNDDEV_YM2612
@@ -173,6 +174,12 @@
 
 #define FREQ_MASK       ((1<<FREQ_SH)-1)
 
+/* Number of samples that are rendered channel-by-channel at once.
+   (used when neither SSG-EG, CSM nor the DAC test mode is active, 0 = always render sample-by-sample) */
+#ifndef FM_BLOCK_LEN
+#define FM_BLOCK_LEN    64
+#endif
+
 /* envelope generator */
 #define ENV_BITS        10
 #define ENV_LEN         (1<<ENV_BITS)
@@ -696,7 +703,7 @@ typedef struct
 #define LOG(n,x) do { if( (n)>=LOG_LEVEL ) logerror x; } while (0)
 #endif
 
-static UINT8 tablesInit = 0;
+static EMU_ONCE tablesOnce = EMU_ONCE_INIT;
 
 /* status set and IRQ handling */
 INLINE void FM_STATUS_SET(FM_ST2 *ST,int flag)
@@ -1605,6 +1612,30 @@ INLINE signed int op_calc1(UINT32 phase, unsigned int env, signed int pm)
 	return tl_tab[p];
 }
 
+/* advance the phase counters of one channel by one sample */
+INLINE void chan_update_phase(YM2612 *F2612, FM_OPN2 *OPN, FM_CH *CH)
+{
+	if(CH->pms)
+	{
+		/* add support for 3 slot mode */
+		if ((OPN->ST.mode & 0xC0) && (CH == &F2612->CH[2]))
+		{
+			update_phase_lfo_slot(OPN, &CH->SLOT[SLOT1], CH->pms, OPN->SL3.block_fnum[1]);
+			update_phase_lfo_slot(OPN, &CH->SLOT[SLOT2], CH->pms, OPN->SL3.block_fnum[2]);
+			update_phase_lfo_slot(OPN, &CH->SLOT[SLOT3], CH->pms, OPN->SL3.block_fnum[0]);
+			update_phase_lfo_slot(OPN, &CH->SLOT[SLOT4], CH->pms, CH->block_fnum);
+		}
+		else update_phase_lfo_channel(OPN, CH);
+	}
+	else  /* no LFO phase modulation */
+	{
+		CH->SLOT[SLOT1].phase += CH->SLOT[SLOT1].Incr;
+		CH->SLOT[SLOT2].phase += CH->SLOT[SLOT2].Incr;
+		CH->SLOT[SLOT3].phase += CH->SLOT[SLOT3].Incr;
+		CH->SLOT[SLOT4].phase += CH->SLOT[SLOT4].Incr;
+	}
+}
+
 INLINE void chan_calc(YM2612 *F2612, FM_OPN2 *OPN, FM_CH *CH)
 {
 	UINT32 AM = OPN->LFO_AM >> CH->ams;
@@ -1661,25 +1692,7 @@ INLINE void chan_calc(YM2612 *F2612, FM_OPN2 *OPN, FM_CH *CH)
 	CH->mem_value = OPN->mem;
 
 	/* update phase counters AFTER output calculations */
-	if(CH->pms)
-	{
-		/* add support for 3 slot mode */
-		if ((OPN->ST.mode & 0xC0) && (CH == &F2612->CH[2]))
-		{
-			update_phase_lfo_slot(OPN, &CH->SLOT[SLOT1], CH->pms, OPN->SL3.block_fnum[1]);
-			update_phase_lfo_slot(OPN, &CH->SLOT[SLOT2], CH->pms, OPN->SL3.block_fnum[2]);
-			update_phase_lfo_slot(OPN, &CH->SLOT[SLOT3], CH->pms, OPN->SL3.block_fnum[0]);
-			update_phase_lfo_slot(OPN, &CH->SLOT[SLOT4], CH->pms, CH->block_fnum);
-		}
-		else update_phase_lfo_channel(OPN, CH);
-	}
-	else  /* no LFO phase modulation */
-	{
-		CH->SLOT[SLOT1].phase += CH->SLOT[SLOT1].Incr;
-		CH->SLOT[SLOT2].phase += CH->SLOT[SLOT2].Incr;
-		CH->SLOT[SLOT3].phase += CH->SLOT[SLOT3].Incr;
-		CH->SLOT[SLOT4].phase += CH->SLOT[SLOT4].Incr;
-	}
+	chan_update_phase(F2612, OPN, CH);
 }
 
 
@@ -2057,10 +2070,6 @@ static void init_tables(void)
 	signed int n;
 	double o,m;
 
-	if (tablesInit)
-		return;
-	tablesInit = 1;
-
 	/* build Linear Power Table */
 	for (x=0; x<TL_RES_LEN; x++)
 	{
@@ -2158,6 +2167,416 @@ static void init_tables(void)
 /*      YM2612 local section                                                   */
 /*******************************************************************************/
 
+/* clip and mix the channel outputs of one sample, then update timer A and CSM key state */
+INLINE void mix_sample(YM2612 *F2612, INT32 dacout, DEV_SMPL *bufL, DEV_SMPL *bufR)
+{
+	FM_OPN2 *OPN  = &F2612->OPN;
+	INT32 *out_fm = OPN->out_fm;
+	INT32 lt,rt;
+
+	if (out_fm[0] > 8192) out_fm[0] = 8192;
+	else if (out_fm[0] < -8192) out_fm[0] = -8192;
+	if (out_fm[1] > 8192) out_fm[1] = 8192;
+	else if (out_fm[1] < -8192) out_fm[1] = -8192;
+	if (out_fm[2] > 8192) out_fm[2] = 8192;
+	else if (out_fm[2] < -8192) out_fm[2] = -8192;
+	if (out_fm[3] > 8192) out_fm[3] = 8192;
+	else if (out_fm[3] < -8192) out_fm[3] = -8192;
+	if (out_fm[4] > 8192) out_fm[4] = 8192;
+	else if (out_fm[4] < -8192) out_fm[4] = -8192;
+	if (out_fm[5] > 8192) out_fm[5] = 8192;
+	else if (out_fm[5] < -8192) out_fm[5] = -8192;
+
+	/* 6-channels mixing  */
+	lt  = ((out_fm[0]>>0) & OPN->pan[0]);
+	rt  = ((out_fm[0]>>0) & OPN->pan[1]);
+	lt += ((out_fm[1]>>0) & OPN->pan[2]);
+	rt += ((out_fm[1]>>0) & OPN->pan[3]);
+	lt += ((out_fm[2]>>0) & OPN->pan[4]);
+	rt += ((out_fm[2]>>0) & OPN->pan[5]);
+	lt += ((out_fm[3]>>0) & OPN->pan[6]);
+	rt += ((out_fm[3]>>0) & OPN->pan[7]);
+	if (! F2612->dac_test)
+	{
+		lt += ((out_fm[4]>>0) & OPN->pan[8]);
+		rt += ((out_fm[4]>>0) & OPN->pan[9]);
+	}
+	else
+	{
+		// DAC test mode ignores panning for channel 4
+		lt += dacout;
+		lt += dacout;
+	}
+	lt += ((out_fm[5]>>0) & OPN->pan[10]);
+	rt += ((out_fm[5]>>0) & OPN->pan[11]);
+
+	/* buffering */
+	if (F2612->WaveOutMode)
+	{
+		if (F2612->WaveOutMode & 0x01)
+			F2612->WaveL = lt;
+		if (F2612->WaveOutMode & 0x02)
+			F2612->WaveR = rt;
+		F2612->WaveOutMode ^= 0x03;
+	}
+	else
+	{
+		F2612->WaveL = lt;
+		F2612->WaveR = rt;
+	}
+	*bufL = F2612->WaveL;
+	*bufR = F2612->WaveR;
+
+	/* CSM mode: if CSM Key ON has occured, CSM Key OFF need to be sent       */
+	/* only if Timer A does not overflow again (i.e CSM Key ON not set again) */
+	OPN->SL3.key_csm <<= 1;
+
+	/* timer A control */
+	//INTERNAL_TIMER_A( &OPN->ST , &F2612->CH[2] )
+	{
+		if( OPN->ST.TAC && (OPN->ST.timer_handler==0) )
+			if( (OPN->ST.TAC -= (int)(OPN->ST.freqbase*4096)) <= 0 )
+			{
+				TimerAOver( &OPN->ST );
+				// CSM mode total level latch and auto key on
+				if( OPN->ST.mode & 0x80 )
+					CSMKeyControll( OPN, &F2612->CH[2] );
+			}
+	}
+
+	/* CSM Mode Key ON still disabled */
+	if (OPN->SL3.key_csm & 2)
+	{
+		/* CSM Mode Key OFF (verified by Nemesis on real hardware) */
+		FM_KEYOFF_CSM(&F2612->CH[2],SLOT1);
+		FM_KEYOFF_CSM(&F2612->CH[2],SLOT2);
+		FM_KEYOFF_CSM(&F2612->CH[2],SLOT3);
+		FM_KEYOFF_CSM(&F2612->CH[2],SLOT4);
+		OPN->SL3.key_csm = 0;
+	}
+}
+
+#if FM_BLOCK_LEN
+/* per-block data that is shared by all channels or reused for each channel */
+typedef struct
+{
+	UINT32 lfo_am[FM_BLOCK_LEN];    /* LFO state during each sample */
+	UINT32 lfo_pm[FM_BLOCK_LEN];
+	UINT32 eg_pos[FM_BLOCK_LEN * 2];/* sample index before each EG step (EG steps are <= 1 per sample at usual sample rates) */
+	UINT32 eg_steps;                /* number of EG steps in this block */
+	UINT32 phase[4][FM_BLOCK_LEN];  /* phase of each slot */
+	UINT32 env[4][FM_BLOCK_LEN];    /* envelope + AM of each slot */
+	INT32 bus[5][FM_BLOCK_LEN];     /* operator inputs: m2, c1, c2, mem, (unused) */
+	INT32 out[6][FM_BLOCK_LEN];     /* channel outputs */
+} FM_BLOCK;
+
+#define BUS_M2  0
+#define BUS_C1  1
+#define BUS_C2  2
+#define BUS_MEM 3
+#define BUS_OUT 4   /* the channel output (stored in FM_BLOCK.out) */
+
+/* The channel-major path can't be used when the channels interact with each other
+   on a per-sample basis or the EG state affects the phase (SSG-EG, CSM, DAC test mode). */
+static UINT8 block_path_usable(YM2612 *F2612)
+{
+	FM_OPN2 *OPN = &F2612->OPN;
+	UINT8 c;
+
+	if (F2612->dac_test || (OPN->ST.mode & 0x80) || OPN->SL3.key_csm)
+		return 0;
+	if (OPN->eg_timer_add / OPN->eg_timer_overflow >= FM_BLOCK_LEN)
+		return 0;   /* very low sample rate, see ym2612_update_block */
+	for (c = 0; c < 6; c ++)
+	{
+		const FM_SLOT *SLOT = F2612->CH[c].SLOT;
+		if ((SLOT[0].ssg | SLOT[1].ssg | SLOT[2].ssg | SLOT[3].ssg) & 0x08)
+			return 0;
+	}
+	return 1;
+}
+
+/* map a connection pointer to the respective bus */
+INLINE UINT8 conn_bus(FM_OPN2 *OPN, const INT32 *conn)
+{
+	if (conn == &OPN->m2)
+		return BUS_M2;
+	else if (conn == &OPN->c1)
+		return BUS_C1;
+	else if (conn == &OPN->c2)
+		return BUS_C2;
+	else if (conn == &OPN->mem)
+		return BUS_MEM;
+	else
+		return BUS_OUT;
+}
+
+/* fill the envelope output (EG + AM) of samples start .. end-1 */
+INLINE void env_fill(UINT32 *env, UINT32 vol, UINT32 AMmask, UINT8 ams, const UINT32 *lfo_am,
+					 UINT32 start, UINT32 end)
+{
+	UINT32 i;
+
+	if (! AMmask)
+	{
+		for (i = start; i < end; i ++)
+			env[i] = vol;
+	}
+	else
+	{
+		for (i = start; i < end; i ++)
+			env[i] = vol + ((lfo_am[i] >> ams) & AMmask);
+	}
+}
+
+/* Calculate a modulated operator (SLOT 2/3/4) for a whole block.
+   There is no dependency between samples, so the loop can be unrolled/vectorized.
+   (The ENV_QUIET check of op_calc is implied by the TL_TAB_LEN check.) */
+INLINE void op_calc_block(const UINT32 *phase, const UINT32 *env, const INT32 *pm, INT32 *dst, UINT32 length)
+{
+	UINT32 i;
+
+	for (i = 0; i < length; i ++)
+	{
+		UINT32 p = (env[i]<<3) + sin_tab[ ( ((signed int)((phase[i] & ~FREQ_MASK) + (pm[i]<<15))) >> FREQ_SH ) & SIN_MASK ];
+		dst[i] += (p < TL_TAB_LEN) ? tl_tab[p] : 0;
+	}
+}
+
+/* Render one channel for a whole block. (out == NULL: only advance the envelope generator)
+   Envelope and phase of all samples are calculated first. Then each operator is calculated
+   for the whole block, in the order SLOT1 (serial due to feedback), SLOT2, SLOT3, SLOT4.
+   This works for all algorithms, because a slot is only modulated by earlier slots in this
+   order or by the MEM value of the previous sample. */
+static void chan_calc_block(YM2612 *F2612, FM_OPN2 *OPN, FM_CH *CH, FM_BLOCK *blk,
+							UINT32 length, UINT32 eg_cnt, INT32 *out)
+{
+	INT32 *bus[5];
+	UINT32 vol[4];
+	UINT32 env_min[4];
+	UINT32 lfo_pm;
+	UINT32 i;
+	UINT32 step, eg_steps;
+	UINT32 start, end;
+	UINT8 s;
+
+	/* envelope generator, the output only changes at EG steps and with the AM value */
+	OPN->eg_cnt = eg_cnt;
+	for (s = 0; s < 4; s ++)
+		vol[s] = CH->SLOT[s].vol_out;
+	/* nothing to do when all slots are off */
+	eg_steps = (CH->SLOT[0].state | CH->SLOT[1].state | CH->SLOT[2].state | CH->SLOT[3].state) ? blk->eg_steps : 0;
+	start = 0;
+	for (step = 0; step < eg_steps; step ++)
+	{
+		OPN->eg_cnt++;
+		advance_eg_channel(OPN, &CH->SLOT[SLOT1]);
+		if (out == NULL)
+			continue;
+		if (CH->SLOT[0].vol_out == vol[0] && CH->SLOT[1].vol_out == vol[1] &&
+			CH->SLOT[2].vol_out == vol[2] && CH->SLOT[3].vol_out == vol[3])
+			continue;
+
+		end = blk->eg_pos[step] + 1;
+		for (s = 0; s < 4; s ++)
+		{
+			env_fill(blk->env[s], vol[s], CH->SLOT[s].AMmask, CH->ams, blk->lfo_am, start, end);
+			vol[s] = CH->SLOT[s].vol_out;
+		}
+		start = end;
+	}
+	if (out == NULL)
+		return;
+	for (s = 0; s < 4; s ++)
+	{
+		const UINT32 *env = blk->env[s];
+		UINT32 emin;
+
+		env_fill(blk->env[s], vol[s], CH->SLOT[s].AMmask, CH->ams, blk->lfo_am, start, length);
+		emin = ENV_QUIET;
+		for (i = 0; i < length; i ++)
+			emin = (env[i] < emin) ? env[i] : emin;
+		env_min[s] = emin;
+	}
+
+	/* phase generator, the phase increment stays the same as long as LFO_PM doesn't change */
+	lfo_pm = OPN->LFO_PM;
+	for (start = 0; start < length; start = end)
+	{
+		UINT32 incr[4];
+
+		if (! CH->pms)
+		{
+			end = length;
+			for (s = 0; s < 4; s ++)
+				incr[s] = (UINT32)CH->SLOT[s].Incr;
+		}
+		else
+		{
+			for (end = start + 1; end < length && blk->lfo_pm[end] == blk->lfo_pm[start]; end ++)
+				;
+			/* get the increment by advancing the phase once */
+			OPN->LFO_PM = blk->lfo_pm[start];
+			for (s = 0; s < 4; s ++)
+				incr[s] = CH->SLOT[s].phase;
+			chan_update_phase(F2612, OPN, CH);
+			for (s = 0; s < 4; s ++)
+			{
+				incr[s] = CH->SLOT[s].phase - incr[s];
+				CH->SLOT[s].phase -= incr[s];
+			}
+		}
+		for (s = 0; s < 4; s ++)
+		{
+			UINT32 *phase = blk->phase[s];
+			UINT32 ph = CH->SLOT[s].phase;
+			UINT32 inc = incr[s];
+
+			for (i = start; i < end; i ++)
+			{
+				phase[i] = ph;
+				ph += inc;
+			}
+			CH->SLOT[s].phase = ph;
+		}
+	}
+	OPN->LFO_PM = lfo_pm;
+
+	bus[BUS_M2] = blk->bus[BUS_M2];
+	bus[BUS_C1] = blk->bus[BUS_C1];
+	bus[BUS_C2] = blk->bus[BUS_C2];
+	bus[BUS_MEM] = blk->bus[BUS_MEM];
+	bus[BUS_OUT] = out;
+	for (s = 0; s < 5; s ++)
+		memset(bus[s], 0x00, length * sizeof(INT32));
+
+	/* SLOT 1 */
+	{
+		const UINT32 *phase = blk->phase[SLOT1];
+		const UINT32 *env = blk->env[SLOT1];
+		INT32 *dst = CH->connect1 ? bus[conn_bus(OPN, CH->connect1)] : NULL;
+		INT32 op_prev = CH->op1_out[0];
+		INT32 op_cur = CH->op1_out[1];
+
+		for (i = 0; i < length; i ++)
+		{
+			INT32 fb = CH->FB ? (op_prev + op_cur) : 0;
+
+			op_prev = op_cur;
+			if (dst == NULL)
+			{
+				/* algorithm 5  */
+				bus[BUS_MEM][i] = bus[BUS_C1][i] = bus[BUS_C2][i] = op_prev;
+			}
+			else
+			{
+				/* other algorithms */
+				dst[i] += op_prev;
+			}
+
+			op_cur = 0;
+			if (env[i] < ENV_QUIET)
+				op_cur = op_calc1(phase[i], env[i], (fb<<CH->FB) );
+		}
+		CH->op1_out[0] = op_prev;
+		CH->op1_out[1] = op_cur;
+	}
+
+	/* SLOT 2 */
+	if (env_min[SLOT2] < ENV_QUIET)
+		op_calc_block(blk->phase[SLOT2], blk->env[SLOT2], bus[BUS_C1], bus[conn_bus(OPN, CH->connect2)], length);
+
+	/* delayed sample (MEM) */
+	if (CH->mem_connect != &OPN->mem)
+	{
+		INT32 *dst = bus[conn_bus(OPN, CH->mem_connect)];
+
+		dst[0] += CH->mem_value;
+		for (i = 1; i < length; i ++)
+			dst[i] += bus[BUS_MEM][i - 1];
+		CH->mem_value = bus[BUS_MEM][length - 1];
+	}
+
+	/* SLOT 3 */
+	if (env_min[SLOT3] < ENV_QUIET)
+		op_calc_block(blk->phase[SLOT3], blk->env[SLOT3], bus[BUS_M2], bus[conn_bus(OPN, CH->connect3)], length);
+
+	/* SLOT 4 */
+	if (env_min[SLOT4] < ENV_QUIET)
+		op_calc_block(blk->phase[SLOT4], blk->env[SLOT4], bus[BUS_C2], bus[BUS_OUT], length);
+}
+
+static void ym2612_update_block(YM2612 *F2612, UINT32 length, DEV_SMPL *bufL, DEV_SMPL *bufR, INT32 dacout)
+{
+	FM_OPN2 *OPN = &F2612->OPN;
+	FM_BLOCK blk;
+	UINT32 len;
+	UINT32 eg_cnt;
+	UINT32 eg_max;
+	UINT32 i;
+	UINT8 c;
+
+	eg_max = OPN->eg_timer_add / OPN->eg_timer_overflow + 1;
+	while (length)
+	{
+		len = (length < FM_BLOCK_LEN) ? length : FM_BLOCK_LEN;
+
+		/* LFO and EG timing are the same for all channels */
+		blk.eg_steps = 0;
+		for (i = 0; i < len; i ++)
+		{
+			if (blk.eg_steps + eg_max > FM_BLOCK_LEN * 2)
+				break;  /* end the block early when the EG step list might overflow */
+			blk.lfo_am[i] = OPN->LFO_AM;
+			blk.lfo_pm[i] = OPN->LFO_PM;
+			advance_lfo(OPN);
+
+			OPN->eg_timer += OPN->eg_timer_add;
+			while (OPN->eg_timer >= OPN->eg_timer_overflow)
+			{
+				OPN->eg_timer -= OPN->eg_timer_overflow;
+				blk.eg_pos[blk.eg_steps] = i;
+				blk.eg_steps ++;
+			}
+		}
+		len = i;
+
+		eg_cnt = OPN->eg_cnt;
+		for (c = 0; c < 6; c ++)
+		{
+			FM_CH *CH = &F2612->CH[c];
+
+			if (c == 5 && F2612->dacen)
+			{
+				chan_calc_block(F2612, OPN, CH, &blk, len, eg_cnt, NULL);
+				for (i = 0; i < len; i ++)
+					blk.out[c][i] = dacout;
+			}
+			else if (CH->Muted)
+			{
+				chan_calc_block(F2612, OPN, CH, &blk, len, eg_cnt, NULL);
+				memset(blk.out[c], 0x00, len * sizeof(INT32));
+			}
+			else
+			{
+				chan_calc_block(F2612, OPN, CH, &blk, len, eg_cnt, blk.out[c]);
+			}
+		}
+		OPN->eg_cnt = eg_cnt + blk.eg_steps;
+
+		for (i = 0; i < len; i ++)
+		{
+			for (c = 0; c < 6; c ++)
+				OPN->out_fm[c] = blk.out[c][i];
+			mix_sample(F2612, dacout, &bufL[i], &bufR[i]);
+		}
+		bufL += len;
+		bufR += len;
+		length -= len;
+	}
+}
+#endif
+
 /* Generate samples for one of the YM2612s */
 void ym2612_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 {
@@ -2168,7 +2587,6 @@ void ym2612_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 	DEV_SMPL  *bufL,*bufR;
 	INT32 dacout;
 	FM_CH   *cch[6];
-	INT32 lt,rt;
 
 	/* set buffer */
 	if (buffer != NULL)
@@ -2221,9 +2639,17 @@ void ym2612_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 		update_ssg_eg_channel(&cch[5]->SLOT[SLOT1]);
 	}
 
+	i = 0;
+#if FM_BLOCK_LEN
+	if (length && block_path_usable(F2612))
+	{
+		ym2612_update_block(F2612, length, bufL, bufR, dacout);
+		i = length;
+	}
+#endif
 
 	/* buffering */
-	for(i=0; i < length ; i++)
+	for(; i < length ; i++)
 	{
 		/* clear outputs */
 		out_fm[0] = 0;
@@ -2279,86 +2705,7 @@ void ym2612_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 			advance_eg_channel(OPN, &cch[5]->SLOT[SLOT1]);
 		}
 
-		if (out_fm[0] > 8192) out_fm[0] = 8192;
-		else if (out_fm[0] < -8192) out_fm[0] = -8192;
-		if (out_fm[1] > 8192) out_fm[1] = 8192;
-		else if (out_fm[1] < -8192) out_fm[1] = -8192;
-		if (out_fm[2] > 8192) out_fm[2] = 8192;
-		else if (out_fm[2] < -8192) out_fm[2] = -8192;
-		if (out_fm[3] > 8192) out_fm[3] = 8192;
-		else if (out_fm[3] < -8192) out_fm[3] = -8192;
-		if (out_fm[4] > 8192) out_fm[4] = 8192;
-		else if (out_fm[4] < -8192) out_fm[4] = -8192;
-		if (out_fm[5] > 8192) out_fm[5] = 8192;
-		else if (out_fm[5] < -8192) out_fm[5] = -8192;
-
-		/* 6-channels mixing  */
-		lt  = ((out_fm[0]>>0) & OPN->pan[0]);
-		rt  = ((out_fm[0]>>0) & OPN->pan[1]);
-		lt += ((out_fm[1]>>0) & OPN->pan[2]);
-		rt += ((out_fm[1]>>0) & OPN->pan[3]);
-		lt += ((out_fm[2]>>0) & OPN->pan[4]);
-		rt += ((out_fm[2]>>0) & OPN->pan[5]);
-		lt += ((out_fm[3]>>0) & OPN->pan[6]);
-		rt += ((out_fm[3]>>0) & OPN->pan[7]);
-		if (! F2612->dac_test)
-		{
-			lt += ((out_fm[4]>>0) & OPN->pan[8]);
-			rt += ((out_fm[4]>>0) & OPN->pan[9]);
-		}
-		else
-		{
-			// DAC test mode ignores panning for channel 4
-			lt += dacout;
-			lt += dacout;
-		}
-		lt += ((out_fm[5]>>0) & OPN->pan[10]);
-		rt += ((out_fm[5]>>0) & OPN->pan[11]);
-
-		/* buffering */
-		if (F2612->WaveOutMode)
-		{
-			if (F2612->WaveOutMode & 0x01)
-				F2612->WaveL = lt;
-			if (F2612->WaveOutMode & 0x02)
-				F2612->WaveR = rt;
-			F2612->WaveOutMode ^= 0x03;
-		}
-		else
-		{
-			F2612->WaveL = lt;
-			F2612->WaveR = rt;
-		}
-		bufL[i] = F2612->WaveL;
-		bufR[i] = F2612->WaveR;
-
-		/* CSM mode: if CSM Key ON has occured, CSM Key OFF need to be sent       */
-		/* only if Timer A does not overflow again (i.e CSM Key ON not set again) */
-		OPN->SL3.key_csm <<= 1;
-
-		/* timer A control */
-		//INTERNAL_TIMER_A( &OPN->ST , cch[2] )
-		{
-			if( OPN->ST.TAC && (OPN->ST.timer_handler==0) )
-				if( (OPN->ST.TAC -= (int)(OPN->ST.freqbase*4096)) <= 0 )
-				{
-					TimerAOver( &OPN->ST );
-					// CSM mode total level latch and auto key on
-					if( OPN->ST.mode & 0x80 )
-						CSMKeyControll( OPN, cch[2] );
-				}
-		}
-
-		/* CSM Mode Key ON still disabled */
-		if (OPN->SL3.key_csm & 2)
-		{
-			/* CSM Mode Key OFF (verified by Nemesis on real hardware) */
-			FM_KEYOFF_CSM(cch[2],SLOT1);
-			FM_KEYOFF_CSM(cch[2],SLOT2);
-			FM_KEYOFF_CSM(cch[2],SLOT3);
-			FM_KEYOFF_CSM(cch[2],SLOT4);
-			OPN->SL3.key_csm = 0;
-		}
+		mix_sample(F2612, dacout, &bufL[i], &bufR[i]);
 	}
 
 	/* timer B control */
@@ -2383,7 +2730,7 @@ void * ym2612_init(void *param, UINT32 clock, UINT32 rate,
 	if (param == NULL)
 		param = F2612;
 	/* allocate total level table (128kb space) */
-	init_tables();
+	Emu_CallOnce(&tablesOnce, init_tables);
 
 	F2612->OPN.ST.param = param;
 	F2612->OPN.type = TYPE_YM2612;
@@ -1179,7 +1179,7 @@ static UINT8 device_start_gameboy_sound(const DEV_GEN_CFG* cfg, DEV_INFO* retDev
 {
 	gb_sound_t *gb;
 
-	gb = (gb_sound_t *)calloc(1, sizeof(gb_sound_t));
+	gb = (gb_sound_t *)DevData_Alloc(cfg->memArena, sizeof(gb_sound_t));
 	if (gb == NULL)
 		return 0xFF;
 
@@ -1204,7 +1204,7 @@ static void device_stop_gameboy_sound(void *chip)
 {
 	gb_sound_t *gb = (gb_sound_t *)chip;
 	
-	free(gb);
+	DevData_Free(gb);
 	
 	return;
 }
@@ -314,7 +314,7 @@ static UINT8 device_start_iremga20(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 {
 	ga20_state *chip;
 
-	chip = (ga20_state *)calloc(1, sizeof(ga20_state));
+	chip = (ga20_state *)DevData_Alloc(cfg->memArena, sizeof(ga20_state));
 	if (chip == NULL)
 		return 0xFF;
 
@@ -336,7 +336,7 @@ static void device_stop_iremga20(void *info)
 	ga20_state *chip = (ga20_state *)info;
 	
 	free(chip->rom);
-	free(chip);
+	DevData_Free(chip);
 	
 	return;
 }
@@ -200,7 +200,7 @@ static UINT8 device_start_k051649(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 {
 	k051649_state *info;
 
-	info = (k051649_state *)calloc(1, sizeof(k051649_state));
+	info = (k051649_state *)DevData_Alloc(cfg->memArena, sizeof(k051649_state));
 	if (info == NULL)
 		return 0xFF;
 
@@ -224,7 +224,7 @@ static void device_stop_k051649(void *chip)
 	k051649_state *info = (k051649_state *)chip;
 	
 	free(info->mixer_table);
-	free(info);
+	DevData_Free(info);
 	
 	return;
 }
@@ -200,7 +200,7 @@ static UINT8 device_start_k053260(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	UINT32 rate;
 	int i;
 
-	info = (k053260_state *)calloc(1, sizeof(k053260_state));
+	info = (k053260_state *)DevData_Alloc(cfg->memArena, sizeof(k053260_state));
 	if (info == NULL)
 		return 0xFF;
 
@@ -230,7 +230,7 @@ static void device_stop_k053260(void* chip)
 	k053260_state *info = (k053260_state *)chip;
 
 	free(info->rom);
-	free(info);
+	DevData_Free(info);
 
 	return;
 }
@@ -572,7 +572,7 @@ static UINT8 device_start_k054539(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	int i;
 	k054539_state *info;
 
-	info = (k054539_state *)calloc(1, sizeof(k054539_state));
+	info = (k054539_state *)DevData_Alloc(cfg->memArena, sizeof(k054539_state));
 	if (info == NULL)
 		return 0xFF;
 
@@ -634,7 +634,7 @@ static void device_stop_k054539(void *chip)
 	
 	free(info->rom);	info->rom = NULL;
 	free(info->ram);	info->ram = NULL;
-	free(info);
+	DevData_Free(info);
 	
 	return;
 }
@@ -43,6 +43,7 @@
 #include "../EmuCores.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "multipcm.h"
 
 static void MultiPCM_update(void *info, UINT32 samples, DEV_SMPL **outputs);
@@ -196,7 +197,7 @@ struct _MultiPCM
 };
 
 
-static UINT8 IsInit = 0;
+static EMU_ONCE tablesOnce = EMU_ONCE_INIT;
 
 static INT32 left_pan_table[0x800];
 static INT32 right_pan_table[0x800];
@@ -626,84 +627,85 @@ static UINT8 multipcm_r(void *info, UINT8 offset)
 	return 0;
 }
 
-static UINT8 device_start_multipcm(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
+static void multipcm_init_tables(void)
 {
-	MultiPCM *ptChip;
+	INT32 level;
 	INT32 i;
 
-	ptChip = (MultiPCM *)calloc(1, sizeof(MultiPCM));
-	if (ptChip == NULL)
-		return 0xFF;
-	
-	ptChip->ROM = NULL;
-	ptChip->ROMSize = 0x00;
-	ptChip->ROMMask = 0x00;
-	ptChip->rate = (float)cfg->clock / MULTIPCM_CLOCKDIV;
-
-	if (! IsInit)
+	// Volume + pan table
+	for (level = 0; level < 0x80; ++level)
 	{
-		INT32 level;
-
-		IsInit = 1;
+		const float vol_db = (float)level * (-24.0f) / 64.0f;
+		const float total_level = powf(10.0f, vol_db / 20.0f) / 4.0f;
+		INT32 pan;
 
-		// Volume + pan table
-		for (level = 0; level < 0x80; ++level)
+		for (pan = 0; pan < 0x10; ++pan)
 		{
-			const float vol_db = (float)level * (-24.0f) / 64.0f;
-			const float total_level = powf(10.0f, vol_db / 20.0f) / 4.0f;
-			INT32 pan;
-
-			for (pan = 0; pan < 0x10; ++pan)
+			float pan_left, pan_right;
+			if (pan == 0x8)
 			{
-				float pan_left, pan_right;
-				if (pan == 0x8)
-				{
-					pan_left = 0.0;
-					pan_right = 0.0;
-				}
-				else if (pan == 0x0)
-				{
-					pan_left = 1.0;
-					pan_right = 1.0;
-				}
-				else if (pan & 0x8)
-				{
-					const INT32 inverted_pan = 0x10 - pan;
-					const float pan_vol_db = (float)inverted_pan * (-12.0f) / 4.0f;
-
-					pan_left = 1.0;
-					pan_right = powf(10.0f, pan_vol_db / 20.0f);
+				pan_left = 0.0;
+				pan_right = 0.0;
+			}
+			else if (pan == 0x0)
+			{
+				pan_left = 1.0;
+				pan_right = 1.0;
+			}
+			else if (pan & 0x8)
+			{
+				const INT32 inverted_pan = 0x10 - pan;
+				const float pan_vol_db = (float)inverted_pan * (-12.0f) / 4.0f;
 
-					if ((inverted_pan & 0x7) == 7)
-						pan_right = 0.0;
-				}
-				else
-				{
-					const float pan_vol_db = (float)pan * (-12.0f) / 4.0f;
+				pan_left = 1.0;
+				pan_right = powf(10.0f, pan_vol_db / 20.0f);
 
-					pan_left = powf(10.0f, pan_vol_db / 20.0f);
-					pan_right = 1.0;
+				if ((inverted_pan & 0x7) == 7)
+					pan_right = 0.0;
+			}
+			else
+			{
+				const float pan_vol_db = (float)pan * (-12.0f) / 4.0f;
 
-					if ((pan & 0x7) == 7)
-						pan_left = 0.0;
-				}
+				pan_left = powf(10.0f, pan_vol_db / 20.0f);
+				pan_right = 1.0;
 
-				left_pan_table[(pan << 7) | level] = value_to_fixed(TL_SHIFT, pan_left * total_level);
-				right_pan_table[(pan << 7) | level] = value_to_fixed(TL_SHIFT, pan_right * total_level);
+				if ((pan & 0x7) == 7)
+					pan_left = 0.0;
 			}
-		}
 
-		// build the linear->exponential ramps
-		for(i = 0; i < 0x400; ++i)
-		{
-			const float db = -(96.0f - (96.0f * (float)i / (float)0x400));
-			const float exp_volume = powf(10.0f, db / 20.0f);
-			linear_to_exp_volume[i] = value_to_fixed(TL_SHIFT, exp_volume);
+			left_pan_table[(pan << 7) | level] = value_to_fixed(TL_SHIFT, pan_left * total_level);
+			right_pan_table[(pan << 7) | level] = value_to_fixed(TL_SHIFT, pan_right * total_level);
 		}
+	}
 
-		lfo_init();
+	// build the linear->exponential ramps
+	for(i = 0; i < 0x400; ++i)
+	{
+		const float db = -(96.0f - (96.0f * (float)i / (float)0x400));
+		const float exp_volume = powf(10.0f, db / 20.0f);
+		linear_to_exp_volume[i] = value_to_fixed(TL_SHIFT, exp_volume);
 	}
 
+	lfo_init();
+}
+
+static UINT8 device_start_multipcm(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
+{
+	MultiPCM *ptChip;
+	INT32 i;
+
+	ptChip = (MultiPCM *)DevData_Alloc(cfg->memArena, sizeof(MultiPCM));
+	if (ptChip == NULL)
+		return 0xFF;
+	
+	ptChip->ROM = NULL;
+	ptChip->ROMSize = 0x00;
+	ptChip->ROMMask = 0x00;
+	ptChip->rate = (float)cfg->clock / MULTIPCM_CLOCKDIV;
+
+	Emu_CallOnce(&tablesOnce, multipcm_init_tables);
+
 	//Pitch steps
 	for (i = 0; i < 0x400; ++i)
 	{
@@ -743,7 +745,7 @@ static void device_stop_multipcm(void *info)
 	MultiPCM *ptChip = (MultiPCM *)info;
 	
 	free(ptChip->ROM);
-	free(ptChip);
+	DevData_Free(ptChip);
 	
 	return;
 }
@@ -85,7 +85,7 @@ struct _nesapu_state
 	uint32  sync_times2[SYNCS_MAX2]; /* Samples per sync table */
 };
 
-static UINT8 DPCMBase0 = 0x01;
+static const UINT8 DPCMBase0 = 0x01;
 
 /* INTERNAL FUNCTIONS */
 
@@ -197,13 +197,13 @@ static UINT8 device_start_nes_mame(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	rate = cfg->clock / 4;
 	SRATE_CUSTOM_HIGHEST(cfg->srMode, rate, cfg->smplRate);
 	
-	info = (NESAPU_INF*)calloc(1, sizeof(NESAPU_INF));
+	info = (NESAPU_INF*)DevData_Alloc(cfg->memArena, sizeof(NESAPU_INF));
 	if (info == NULL)
 		return 0xFF;
 	info->chip_apu = device_start_nesapu(cfg->clock, rate);
 	if (info->chip_apu == NULL)
 	{
-		free(info);
+		DevData_Free(info);
 		return 0xFF;
 	}
 	info->chip_dmc = NULL;
@@ -245,20 +245,20 @@ static UINT8 device_start_nes_nsfplay(const DEV_GEN_CFG* cfg, DEV_INFO* retDevIn
 	rate = cfg->clock / 4;
 	SRATE_CUSTOM_HIGHEST(cfg->srMode, rate, cfg->smplRate);
 	
-	info = (NESAPU_INF*)calloc(1, sizeof(NESAPU_INF));
+	info = (NESAPU_INF*)DevData_Alloc(cfg->memArena, sizeof(NESAPU_INF));
 	if (info == NULL)
 		return 0xFF;
 	info->chip_apu = NES_APU_np_Create(cfg->clock, rate);
 	if (info->chip_apu == NULL)
 	{
-		free(info);
+		DevData_Free(info);
 		return 0xFF;
 	}
 	info->chip_dmc = NES_DMC_np_Create(cfg->clock, rate);
 	if (info->chip_dmc == NULL)
 	{
 		NES_APU_np_Destroy(info->chip_apu);
-		free(info);
+		DevData_Free(info);
 		return 0xFF;
 	}
 	NES_DMC_np_SetAPU(info->chip_dmc, info->chip_apu);
@@ -326,7 +326,7 @@ static void device_stop_nes_common(NESAPU_INF* info)
 	if (info->memory != NULL)
 		free(info->memory);
 	
-	free(info);
+	DevData_Free(info);
 	return;
 }
 
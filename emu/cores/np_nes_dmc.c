@@ -3,7 +3,6 @@
 // Updated to NSFPlay 2.3 on 26 September 2013
 // (Note: Encoding is UTF-8)
 
-#include <stdlib.h>	// for rand
 #include <stdlib.h>
 #include <stddef.h>	// for NULL
 
@@ -11,6 +10,7 @@
 #include "../../stdbool.h"
 #include "../snddef.h"
 #include "../RatioCntr.h"
+#include "../EmuHelper.h"	// for emu_rand
 #include "np_nes_apu.h"	// for NES_APU_np_FrameSequence
 #include "np_nes_dmc.h"
 
@@ -84,6 +84,7 @@ struct _NES_DMC
 
 	int noise_volume;
 	UINT32 noise, noise_tap;
+	UINT32 noise_seed;	// random number generator state for OPT_RANDOMIZE_NOISE
 
 	// noise envelope
 	bool envelope_loop;
@@ -164,6 +165,7 @@ void* NES_DMC_np_Create(UINT32 clock, UINT32 rate)
 			dmc->sm[c][t] = 128;
 
 	dmc->mask = 0;
+	dmc->noise_seed = 1;
 
 	return dmc;
 }
@@ -632,7 +634,7 @@ void NES_DMC_np_Reset(void* chip)
 	dmc->noise_tap = (1<<1);
 	if (dmc->option[OPT_RANDOMIZE_NOISE])
 	{
-		dmc->noise |= rand();
+		dmc->noise |= emu_rand(&dmc->noise_seed);
 	}
 
 	NES_DMC_np_SetRate(dmc, dmc->rate);
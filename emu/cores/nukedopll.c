@@ -1342,7 +1342,7 @@ static UINT8 device_start_ym2413_nuked(const DEV_GEN_CFG* cfg, DEV_INFO* retDevI
 	rate = cfg->clock / 72;
 	SRATE_CUSTOM_HIGHEST(cfg->srMode, rate, cfg->smplRate);
 	
-	chip = (opll_t*)calloc(1, sizeof(opll_t));
+	chip = (opll_t*)DevData_Alloc(cfg->memArena, sizeof(opll_t));
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -1358,7 +1358,7 @@ static UINT8 device_start_ym2413_nuked(const DEV_GEN_CFG* cfg, DEV_INFO* retDevI
 
 static void nukedopll_shutdown(void *chip)
 {
-	free(chip);
+	DevData_Free(chip);
 	
 	return;
 }
@@ -13,6 +13,7 @@
 #include <math.h>
 
 #include "../../stdtype.h"
+#include "../EmuOnce.h"
 #include "okiadpcm.h"
 
 
@@ -21,7 +22,7 @@
 //**************************************************************************
 
 // ADPCM state and tables
-static UINT8 s_tables_computed = 0;
+static EMU_ONCE s_tables_once = EMU_ONCE_INIT;
 static const INT8 s_index_shift[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
 static INT16 s_diff_lookup[49*16];
 
@@ -56,7 +57,7 @@ void oki_adpcm_init(oki_adpcm_state* adpcm, const INT8* custom_index_shift, cons
 	}
 	else
 	{
-		compute_tables();
+		Emu_CallOnce(&s_tables_once, compute_tables);
 		adpcm->diff_lookup = s_diff_lookup;
 	}
 	oki_adpcm_reset(adpcm);
@@ -120,11 +121,6 @@ static void compute_tables(void)
 	};
 	int step, nib;
 
-	// skip if we already did it
-	if (s_tables_computed)
-		return;
-	s_tables_computed = 1;
-
 	// loop over all possible steps
 	for (step = 0; step <= 48; step++)
 	{
@@ -19,6 +19,7 @@
 #include "../snddef.h"
 #include "../EmuHelper.h"
 #include "../EmuCores.h"
+#include "../EmuOnce.h"
 #include "okim6258.h"
 
 
@@ -135,7 +136,7 @@ static const int index_shift[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
 static int diff_lookup[49*16];
 
 /* tables computed? */
-static int tables_computed = 0;
+static EMU_ONCE tables_computed = EMU_ONCE_INIT;
 
 
 INLINE UINT32 ReadLE32(const UINT8* buffer)
@@ -172,9 +173,6 @@ static void compute_tables(void)
 
 	int step, nib;
 
-	if (tables_computed)
-		return;
-	
 	/* loop over all possible steps */
 	for (step = 0; step <= 48; step++)
 	{
@@ -191,8 +189,6 @@ static void compute_tables(void)
 				 stepval/8);
 		}
 	}
-
-	tables_computed = 1;
 }
 
 
@@ -327,7 +323,7 @@ static UINT8 device_start_okim6258(const OKIM6258_CFG* cfg, DEV_INFO* retDevInf)
 {
 	okim6258_state *info;
 
-	info = (okim6258_state *)calloc(1, sizeof(okim6258_state));
+	info = (okim6258_state *)DevData_Alloc(cfg->_genCfg.memArena, sizeof(okim6258_state));
 	if (info == NULL)
 		return 0xFF;
 
@@ -337,7 +333,7 @@ static UINT8 device_start_okim6258(const OKIM6258_CFG* cfg, DEV_INFO* retDevInf)
 	if (! info->adpcm_type)
 		info->adpcm_type = 4;
 
-	compute_tables();
+	Emu_CallOnce(&tables_computed, compute_tables);
 
 	info->master_clock = info->initial_clock;
 	WriteLE32(info->clock_buffer, info->master_clock);
@@ -371,7 +367,7 @@ static void device_stop_okim6258(void *chip)
 {
 	okim6258_state *info = (okim6258_state *)chip;
 	
-	free(info);
+	DevData_Free(info);
 	return;
 }
 
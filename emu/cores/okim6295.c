@@ -57,6 +57,7 @@
 #include "../snddef.h"
 #include "../EmuHelper.h"
 #include "../EmuCores.h"
+#include "../PcmCache.h"
 #include "okim6295.h"
 #include "okiadpcm.h"
 
@@ -78,7 +79,9 @@ static void okim6295_w(void* chip, UINT8 offset, UINT8 data);
 
 static void okim6295_alloc_rom(void* info, UINT32 memsize);
 static void okim6295_write_rom(void* info, UINT32 offset, UINT32 length, const UINT8* data);
+static void okim6295_set_options(void *info, UINT32 Flags);
 static void okim6295_set_mute_mask(void *info, UINT32 MuteMask);
+static UINT8 okim6295_hash_state(void *info, UINT64* hash);
 static void okim6295_set_srchg_cb(void* chip, DEVCB_SRATE_CHG CallbackFunc, void* DataPtr);
 
 
@@ -91,6 +94,7 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_CLOCK | RWF_WRITE, DEVRW_VALUE, 0, okim6295_set_clock},
 	{RWF_SRATE | RWF_READ, DEVRW_VALUE, 0, okim6295_get_rate},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, okim6295_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, okim6295_hash_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef =
@@ -102,7 +106,7 @@ static DEV_DEF devDef =
 	device_reset_okim6295,
 	okim6295_update,
 	
-	NULL,	// SetOptionBits
+	okim6295_set_options,
 	okim6295_set_mute_mask,
 	NULL,	// SetPanning
 	okim6295_set_srchg_cb,	// SetSampleRateChangeCallback
@@ -129,6 +133,8 @@ typedef struct _okim_voice
 
 	INT32           volume;         // output volume
 	UINT8           Muted;
+
+	PCM_CACHE_ENTRY* cache;         // decoded sample data, NULL = decode from ROM
 } okim_voice;
 
 struct _okim6295_state
@@ -154,6 +160,7 @@ struct _okim6295_state
 	
 	UINT32  ROMSize;
 	UINT8*  ROM;
+	PCM_CACHE* cache;
 	
 	DEVCB_SRATE_CHG SmpRateFunc;
 	void* SmpRateData;
@@ -245,6 +252,34 @@ static UINT8 memory_raw_read_byte(okim6295_state *chip, UINT32 offset)
 		return 0x00;
 }
 
+// restore the ADPCM state after reading samples from the cache
+INLINE void okim6295_cache_sync(okim_voice *voice)
+{
+	PCM_CACHE_ENTRY *entry = voice->cache;
+
+	if (voice->sample > 0 && voice->sample <= entry->length)
+	{
+		voice->adpcm.signal = entry->smpl[voice->sample - 1];
+		voice->adpcm.step = entry->state[voice->sample - 1];
+	}
+}
+
+// stop using cached data, required when the sample data changes during playback
+static void okim6295_cache_detach(okim6295_state *chip)
+{
+	int i;
+
+	for (i = 0; i < OKIM6295_VOICES; i++)
+	{
+		okim_voice *voice = &chip->voice[i];
+		if (voice->cache == NULL)
+			continue;
+		if (voice->playing)
+			okim6295_cache_sync(voice);
+		voice->cache = NULL;
+	}
+}
+
 static void generate_adpcm(okim6295_state *chip, okim_voice *voice, DEV_SMPL *buffer, UINT32 samples)
 {
 	UINT32 i;
@@ -253,15 +288,40 @@ static void generate_adpcm(okim6295_state *chip, okim_voice *voice, DEV_SMPL *bu
 	if (!voice->playing || voice->Muted)
 		return;
 
+	i = 0;
+	if (voice->cache != NULL)
+	{
+		PCM_CACHE_ENTRY *entry = voice->cache;
+
+		// play the part that was already decoded
+		for (; i < samples && voice->sample < entry->length; i++)
+		{
+			buffer[i] += entry->smpl[voice->sample] * voice->volume / 2;
+			if (++voice->sample >= voice->count)
+			{
+				voice->playing = 0;
+				return;
+			}
+		}
+		if (i >= samples)
+			return;
+
+		// continue decoding from the cached state
+		okim6295_cache_sync(voice);
+	}
+
 	// loop while we still have samples to generate
-	for (i = 0; i < samples; i++)
+	for (; i < samples; i++)
 	{
 		// fetch the next sample byte
 		UINT8 nibble = memory_raw_read_byte(chip, voice->base_offset + voice->sample / 2) >> (((voice->sample & 1) << 2) ^ 4);
+		INT16 signal = oki_adpcm_clock(&voice->adpcm, nibble);
 
 		// output to the buffer, scaling by the volume
 		// signal in range -2048..2047, volume in range 2..32 => signal * volume / 2 in range -32768..32767
-		buffer[i] += oki_adpcm_clock(&voice->adpcm, nibble) * voice->volume / 2;
+		buffer[i] += signal * voice->volume / 2;
+		if (voice->cache != NULL)
+			PcmCache_Append(chip->cache, voice->cache, voice->sample, signal, voice->adpcm.step);
 
 		// next!
 		if (++voice->sample >= voice->count)
@@ -309,7 +369,7 @@ static UINT8 device_start_okim6295(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	UINT32 divisor;
 	int voicenum;
 
-	info = (okim6295_state *)calloc(1, sizeof(okim6295_state));
+	info = (okim6295_state *)DevData_Alloc(cfg->memArena, sizeof(okim6295_state));
 	if (info == NULL)
 		return 0xFF;
 
@@ -322,6 +382,7 @@ static UINT8 device_start_okim6295(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	memset(info->nmk_bank, 0x00, 4 * sizeof(UINT8));
 	info->ROM = NULL;
 	info->ROMSize = 0x00;
+	info->cache = NULL;
 
 	info->initial_clock = cfg->clock;
 	info->pin7_initial = cfg->flags;
@@ -343,8 +404,10 @@ static void device_stop_okim6295(void* chipptr)
 {
 	okim6295_state *chip = (okim6295_state *)chipptr;
 	
+	if (chip->cache != NULL)
+		PcmCache_Deinit(chip->cache);
 	free(chip->ROM);
-	free(chip);
+	DevData_Free(chip);
 	
 	return;
 }
@@ -377,6 +440,7 @@ static void device_reset_okim6295(void *chip)
 		oki_adpcm_reset(&info->voice[voice].adpcm);
 		
 		info->voice[voice].playing = 0;
+		info->voice[voice].cache = NULL;
 	}
 }
 
@@ -502,6 +566,18 @@ static void okim6295_write_command(okim6295_state *info, UINT8 data)
 						// also reset the ADPCM parameters
 						oki_adpcm_reset(&voice->adpcm);
 						voice->volume = volume_table[data & 0x0f];
+
+						voice->cache = NULL;
+						if (info->cache != NULL)
+						{
+							// The decoded data depends on the sample range and the bank configuration.
+							UINT32 key[PCMCACHE_KEY_LEN];
+							key[0] = start;
+							key[1] = voice->count;
+							key[2] = info->nmk_mode ? ReadLE32(info->nmk_bank) : info->bank_offs;
+							key[3] = info->nmk_mode;
+							voice->cache = PcmCache_Get(info->cache, key, voice->count);
+						}
 					}
 
 					// invalid samples go here
@@ -564,15 +640,21 @@ static void okim6295_w(void* chip, UINT8 offset, UINT8 data)
 		okim6295_set_pin7(info, data);
 		break;
 	case 0x0E:	// NMK112 bank switch enable
+		if (info->nmk_mode != data)
+			okim6295_cache_detach(info);	// playing samples continue with different data
 		info->nmk_mode = data;
 		break;
 	case 0x0F:
+		if (info->bank_offs != (UINT32)data << 18)
+			okim6295_cache_detach(info);
 		okim6295_set_bank_base(info, data << 18);
 		break;
 	case 0x10:
 	case 0x11:
 	case 0x12:
 	case 0x13:
+		if (info->nmk_bank[offset & 0x03] != data)
+			okim6295_cache_detach(info);
 		info->nmk_bank[offset & 0x03] = data;
 		break;
 	}
@@ -587,6 +669,11 @@ static void okim6295_alloc_rom(void* info, UINT32 memsize)
 	if (chip->ROMSize == memsize)
 		return;
 	
+	if (chip->cache != NULL)
+	{
+		okim6295_cache_detach(chip);
+		PcmCache_Clear(chip->cache);
+	}
 	chip->ROM = (UINT8*)realloc(chip->ROM, memsize);
 	chip->ROMSize = memsize;
 	memset(chip->ROM, 0xFF, chip->ROMSize);
@@ -603,12 +690,36 @@ static void okim6295_write_rom(void* info, UINT32 offset, UINT32 length, const U
 	if (offset + length > chip->ROMSize)
 		length = chip->ROMSize - offset;
 	
+	if (chip->cache != NULL)
+	{
+		okim6295_cache_detach(chip);
+		PcmCache_Clear(chip->cache);
+	}
 	memcpy(&chip->ROM[offset], data, length);
 	
 	return;
 }
 
 
+static void okim6295_set_options(void *info, UINT32 Flags)
+{
+	okim6295_state *chip = (okim6295_state *)info;
+	
+	if (Flags & OPT_OKIM6295_PCM_CACHE)
+	{
+		if (chip->cache == NULL)
+			PcmCache_Init(&chip->cache, 0);	// on failure, samples are just decoded live
+	}
+	else if (chip->cache != NULL)
+	{
+		okim6295_cache_detach(chip);
+		PcmCache_Deinit(chip->cache);
+		chip->cache = NULL;
+	}
+	
+	return;
+}
+
 static void okim6295_set_mute_mask(void *info, UINT32 MuteMask)
 {
 	okim6295_state *chip = (okim6295_state *)info;
@@ -620,6 +731,42 @@ static void okim6295_set_mute_mask(void *info, UINT32 MuteMask)
 	return;
 }
 
+static UINT8 okim6295_hash_state(void *info, UINT64* hash)
+{
+	okim6295_state *chip = (okim6295_state *)info;
+	UINT64 h = *hash;
+	UINT8 CurChn;
+	
+	for (CurChn = 0; CurChn < OKIM6295_VOICES; CurChn ++)
+	{
+		okim_voice *voice = &chip->voice[CurChn];
+		
+		h = EmuHash_Data(h, &voice->playing, sizeof(voice->playing));
+		h = EmuHash_Data(h, &voice->Muted, sizeof(voice->Muted));
+		if (! voice->playing)
+			continue;	// everything else is initialized when the voice is started
+		h = EmuHash_Data(h, &voice->adpcm.signal, sizeof(voice->adpcm.signal));
+		h = EmuHash_Data(h, &voice->adpcm.step, sizeof(voice->adpcm.step));
+		h = EmuHash_Data(h, &voice->base_offset, sizeof(voice->base_offset));
+		h = EmuHash_Data(h, &voice->sample, sizeof(voice->sample));
+		h = EmuHash_Data(h, &voice->count, sizeof(voice->count));
+		h = EmuHash_Data(h, &voice->volume, sizeof(voice->volume));
+	}
+	h = EmuHash_Data(h, &chip->command, sizeof(chip->command));
+	h = EmuHash_Data(h, &chip->bank_offs, sizeof(chip->bank_offs));
+	h = EmuHash_Data(h, &chip->pin7_state, sizeof(chip->pin7_state));
+	h = EmuHash_Data(h, &chip->nmk_mode, sizeof(chip->nmk_mode));
+	h = EmuHash_Data(h, chip->nmk_bank, sizeof(chip->nmk_bank));
+	h = EmuHash_Data(h, &chip->master_clock, sizeof(chip->master_clock));
+	h = EmuHash_Data(h, chip->clock_buffer, sizeof(chip->clock_buffer));
+	h = EmuHash_Data(h, &chip->ROMSize, sizeof(chip->ROMSize));
+	if (chip->ROM != NULL)
+		h = EmuHash_Data(h, chip->ROM, chip->ROMSize);
+	*hash = h;
+	
+	return 0x00;
+}
+
 static void okim6295_set_srchg_cb(void* chip, DEVCB_SRATE_CHG CallbackFunc, void* DataPtr)
 {
 	okim6295_state *info = (okim6295_state *)chip;
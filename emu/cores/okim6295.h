@@ -5,6 +5,8 @@
 
 // cfg.flags: pin 7 state, controls clock divider - 0 = clk/165, 1 = clk/132
 
+#define OPT_OKIM6295_PCM_CACHE	0x01	// cache decoded samples for repeated playback (default: disabled)
+
 extern const DEV_DEF* devDefList_OKIM6295[];
 
 #endif	// __OKIM6295_H__
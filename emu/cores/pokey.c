@@ -652,7 +652,7 @@ static UINT8 device_start_pokey(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 
 	sample_rate = cfg->clock;
 
-	chip = (pokey_state *)calloc(1, sizeof(pokey_state));
+	chip = (pokey_state *)DevData_Alloc(cfg->memArena, sizeof(pokey_state));
 	if (chip == NULL)
 		return 0xFF;
 
@@ -691,7 +691,7 @@ static void device_stop_pokey(void *info)
 {
 	pokey_state *chip = (pokey_state *)info;
 	
-	free(chip);
+	DevData_Free(chip);
 	
 	return;
 }
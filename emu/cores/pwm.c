@@ -194,7 +194,7 @@ static UINT8 device_start_pwm(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	pwm_chip *chip;
 	UINT32 rate;
 	
-	chip = (pwm_chip *)calloc(1, sizeof(pwm_chip));
+	chip = (pwm_chip *)DevData_Alloc(cfg->memArena, sizeof(pwm_chip));
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -214,7 +214,7 @@ static UINT8 device_start_pwm(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 static void device_stop_pwm(void* info)
 {
 	pwm_chip* chip = (pwm_chip*)info;
-	free(chip);
+	DevData_Free(chip);
 	
 	return;
 }
@@ -178,7 +178,7 @@ static UINT8 device_start_qsound_ctr(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf
 {
 	struct qsound_chip* chip;
 	
-	chip = (struct qsound_chip*)calloc(1, sizeof(struct qsound_chip));
+	chip = (struct qsound_chip*)DevData_Alloc(cfg->memArena, sizeof(struct qsound_chip));
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -202,7 +202,7 @@ static void device_stop_qsound_ctr(void* info)
 	struct qsound_chip* chip = (struct qsound_chip*)info;
 	
 	free(chip->romData);
-	free(chip);
+	DevData_Free(chip);
 	
 	return;
 }
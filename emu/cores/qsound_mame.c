@@ -132,7 +132,7 @@ static UINT8 device_start_qsound(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	qsound_state *chip;
 	int i;
 
-	chip = (qsound_state *)calloc(1, sizeof(qsound_state));
+	chip = (qsound_state *)DevData_Alloc(cfg->memArena, sizeof(qsound_state));
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -159,7 +159,7 @@ static void device_stop_qsound(void *info)
 {
 	qsound_state *chip = (qsound_state *)info;
 	free(chip->sample_rom);
-	free(chip);
+	DevData_Free(chip);
 }
 
 static void device_reset_qsound(void *info)
@@ -13,6 +13,7 @@
 #include "../EmuStructs.h"
 #include "../EmuHelper.h"
 #include "../EmuCores.h"
+#include "../VoiceMix.h"
 #include "rf5c68.h"
 
 
@@ -78,6 +79,7 @@ struct _pcm_channel
 	UINT16		step;
 	UINT16		loopst;
 	UINT8		Muted;
+	VMIX_VOICE	mix;
 };
 
 
@@ -98,6 +100,15 @@ struct _rf5c68_state
 };
 
 
+static INT32 rf5c68_level(UINT8 data, UINT32 volume)
+{
+	/* samples are stored as sign + magnitude */
+	if (data & 0x80)
+		return ((data & 0x7f) * (INT32)volume) >> 5;
+	else
+		return -((data * (INT32)volume) >> 5);
+}
+
 //-------------------------------------------------
 //    RF5C68 stream update
 //-------------------------------------------------
@@ -126,47 +137,42 @@ static void rf5c68_update(void *info, UINT32 samples, DEV_SMPL **outputs)
 		/* if this channel is active, accumulate samples */
 		if (chan->enable && ! chan->Muted)
 		{
-			int lv = (chan->pan & 0x0f) * chan->env;
-			int rv = ((chan->pan >> 4) & 0x0f) * chan->env;
+			VMIX_VOICE *mix = &chan->mix;
+			UINT32 span;
+
+			VoiceMix_SetVolume(mix, (chan->pan & 0x0f) * chan->env, ((chan->pan >> 4) & 0x0f) * chan->env, rf5c68_level);
+			mix->step = chan->step;
+			mix->pos = chan->addr;
 
 			/* loop over the sample buffer */
-			for (j = 0; j < samples; j++)
+			for (j = 0; j < samples; j += span)
 			{
-				int sample;
-
 				/* trigger sample callback */
 				if(chip->sample_end_cb)
 				{
-					if(((chan->addr >> 11) & 0xfff) == 0xfff)
-						chip->sample_end_cb(chip->sample_cb_param,(chan->addr >> 11)/0x2000);
-				}
-
-				/* fetch the sample and handle looping */
-				sample = chip->data[(chan->addr >> 11) & 0xffff];
-				if (sample == 0xff)
-				{
-					chan->addr = chan->loopst << 11;
-					sample = chip->data[(chan->addr >> 11) & 0xffff];
-
-					/* if we loop to a loop point, we're effectively dead */
-					if (sample == 0xff)
-						break;
-				}
-				chan->addr += chan->step;
-
-				/* add to the buffer */
-				if (sample & 0x80)
-				{
-					sample &= 0x7f;
-					left[j] += (sample * lv) >> 5;
-					right[j] += (sample * rv) >> 5;
+					if(((mix->pos >> 11) & 0xfff) == 0xfff)
+						chip->sample_end_cb(chip->sample_cb_param,(mix->pos >> 11)/0x2000);
+					span = 1;
 				}
 				else
 				{
-					left[j] -= (sample * lv) >> 5;
-					right[j] -= (sample * rv) >> 5;
+					span = samples - j;
 				}
+
+				/* fetch the samples and add them to the buffer, stop at the loop marker */
+				span = VoiceMix_Render(mix, chip->data, &left[j], &right[j], span);
+				if (span > 0)
+					continue;
+
+				/* handle looping */
+				mix->pos = chan->loopst << 11;
+
+				/* if we loop to a loop point, we're effectively dead */
+				if (chip->data[(mix->pos >> 11) & 0xffff] == 0xff)
+					break;
+				span = VoiceMix_Render(mix, chip->data, &left[j], &right[j], 1);
 			}
+			chan->addr = mix->pos;
 		}
 	}
 	
@@ -215,6 +221,7 @@ static UINT8 device_start_rf5c68_mame(const DEV_GEN_CFG* cfg, DEV_INFO* retDevIn
 void* device_start_rf5c68(UINT32 clock)
 {
 	rf5c68_state *chip;
+	UINT8 i;
 	
 	/* allocate memory for the chip */
 	chip = (rf5c68_state *)calloc(1, sizeof(rf5c68_state));
@@ -227,6 +234,11 @@ void* device_start_rf5c68(UINT32 clock)
 	chip->sample_end_cb = NULL;
 	chip->sample_cb_param = NULL;
 	rf5c68_set_mute_mask(chip, 0x00);
+	for (i = 0; i < NUM_CHANNELS; i ++)
+	{
+		VoiceMix_Init(&chip->chan[i].mix, 11, 0xFFFF);
+		chip->chan[i].mix.endMarker = 0xFF;
+	}
 	
 	return chip;
 }
@@ -84,7 +84,7 @@ static void saa1099_data_w(void *info, UINT8 data);
 
 static void saa1099m_update(void *param, UINT32 samples, DEV_SMPL **outputs);
 static UINT8 device_start_saa1099_mame(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
-static void* saa1099m_create(UINT32 clock, UINT32 sampleRate);
+static void* saa1099m_create(UINT32 clock, UINT32 sampleRate, MEM_ARENA* arena);
 static void saa1099m_destroy(void *info);
 static void saa1099m_reset(void *info);
 
@@ -384,7 +384,7 @@ static UINT8 device_start_saa1099_mame(const DEV_GEN_CFG* cfg, DEV_INFO* retDevI
 	rate = cfg->clock / 128;	// /128 seems right based on the highest noise frequency
 	SRATE_CUSTOM_HIGHEST(cfg->srMode, rate, cfg->smplRate);
 	
-	chip = saa1099m_create(cfg->clock, rate);
+	chip = saa1099m_create(cfg->clock, rate, cfg->memArena);
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -394,11 +394,11 @@ static UINT8 device_start_saa1099_mame(const DEV_GEN_CFG* cfg, DEV_INFO* retDevI
 	return 0x00;
 }
 
-static void* saa1099m_create(UINT32 clock, UINT32 sampleRate)
+static void* saa1099m_create(UINT32 clock, UINT32 sampleRate, MEM_ARENA* arena)
 {
 	saa1099_state *saa;
 
-	saa = (saa1099_state*)calloc(1, sizeof(saa1099_state));
+	saa = (saa1099_state*)DevData_Alloc(arena, sizeof(saa1099_state));
 	if (saa == NULL)
 		return NULL;
 
@@ -415,7 +415,7 @@ static void saa1099m_destroy(void *info)
 {
 	saa1099_state *saa = (saa1099_state *)info;
 	
-	free(saa);
+	DevData_Free(saa);
 	
 	return;
 }
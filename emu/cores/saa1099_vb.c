@@ -36,7 +36,7 @@ typedef struct saa_channel SAA_CHN;
 typedef struct saa_chip SAA_CHIP;
 
 static UINT8 device_start_saa1099_vb(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
-static void* saa1099v_create(UINT32 clock, UINT32 sampleRate);
+static void* saa1099v_create(UINT32 clock, UINT32 sampleRate, MEM_ARENA* arena);
 static void saa1099v_destroy(void* info);
 static void saa1099v_reset(void* info);
 static void saa1099v_set_mute_mask(void* info, UINT32 MuteMask);
@@ -191,7 +191,7 @@ static UINT8 device_start_saa1099_vb(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf
 	rate = cfg->clock / 128;
 	SRATE_CUSTOM_HIGHEST(cfg->srMode, rate, cfg->smplRate);
 	
-	chip = saa1099v_create(cfg->clock, rate);
+	chip = saa1099v_create(cfg->clock, rate, cfg->memArena);
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -201,12 +201,12 @@ static UINT8 device_start_saa1099_vb(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf
 	return 0x00;
 }
 
-static void* saa1099v_create(UINT32 clock, UINT32 sampleRate)
+static void* saa1099v_create(UINT32 clock, UINT32 sampleRate, MEM_ARENA* arena)
 {
 	SAA_CHIP* saa;
 	UINT8 curVol;
 	
-	saa = (SAA_CHIP*)calloc(1, sizeof(SAA_CHIP));
+	saa = (SAA_CHIP*)DevData_Alloc(arena, sizeof(SAA_CHIP));
 	if (saa == NULL)
 		return NULL;
 	
@@ -226,7 +226,7 @@ static void saa1099v_destroy(void* info)
 {
 	SAA_CHIP* saa = (SAA_CHIP*)info;
 	
-	free(saa);
+	DevData_Free(saa);
 	
 	return;
 }
@@ -20,7 +20,7 @@
 
 
 static UINT8 device_start_rf5c68_gens(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
-static void*SCD_PCM_Init(UINT32 Clock, UINT32 Rate, UINT8 smpl0patch);
+static void*SCD_PCM_Init(UINT32 Clock, UINT32 Rate, UINT8 smpl0patch, MEM_ARENA* arena);
 static void SCD_PCM_Deinit(void* info);
 static void SCD_PCM_Set_Rate(void* info, UINT32 Clock, UINT32 Rate);
 static void SCD_PCM_Reset(void* info);
@@ -105,7 +105,7 @@ static UINT8 device_start_rf5c68_gens(const DEV_GEN_CFG* cfg, DEV_INFO* retDevIn
 	rate = cfg->clock / 384;
 	SRATE_CUSTOM_HIGHEST(cfg->srMode, rate, cfg->smplRate);
 	
-	chip = SCD_PCM_Init(cfg->clock, rate, cfg->flags);
+	chip = SCD_PCM_Init(cfg->clock, rate, cfg->flags, cfg->memArena);
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -118,13 +118,14 @@ static UINT8 device_start_rf5c68_gens(const DEV_GEN_CFG* cfg, DEV_INFO* retDevIn
 /**
  * SCD_PCM_Init(): Initialize the PCM chip.
  * @param Rate Sample rate.
+ * @param arena Memory arena for the chip structure. (NULL = heap)
  * @return 0 if successful.
  */
-static void* SCD_PCM_Init(UINT32 Clock, UINT32 Rate, UINT8 smpl0patch)
+static void* SCD_PCM_Init(UINT32 Clock, UINT32 Rate, UINT8 smpl0patch, MEM_ARENA* arena)
 {
 	struct pcm_chip_ *chip;
 	
-	chip = (struct pcm_chip_ *)calloc(1, sizeof(struct pcm_chip_));
+	chip = (struct pcm_chip_ *)DevData_Alloc(arena, sizeof(struct pcm_chip_));
 	if (chip == NULL)
 		return NULL;
 	
@@ -143,7 +144,7 @@ static void SCD_PCM_Deinit(void* info)
 {
 	struct pcm_chip_ *chip = (struct pcm_chip_ *)info;
 	free(chip->RAM);	chip->RAM = NULL;
-	free(chip);
+	DevData_Free(chip);
 	
 	return;
 }
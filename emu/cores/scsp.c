@@ -39,6 +39,7 @@
 #include "../EmuCores.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "scsp.h"
 #include "scspdsp.h"
 
@@ -309,6 +310,9 @@ struct _scsp_state
 
 	INT16 *RBUFDST;   //this points to where the sample will be stored in the RingBuf
 
+	UINT8 BypassDSP;
+	UINT32 noise_seed;	// random number generator state for the noise generator
+
 	//LFO
 	//int PLFO_TRI[256], PLFO_SQR[256], PLFO_SAW[256], PLFO_NOI[256];
 	//int ALFO_TRI[256], ALFO_SQR[256], ALFO_SAW[256], ALFO_NOI[256];
@@ -321,9 +325,6 @@ struct _scsp_state
 
 static const float SDLT[8]={-1000000.0f,-36.0f,-30.0f,-24.0f,-18.0f,-12.0f,-6.0f,0.0f};
 
-
-static UINT8 BypassDSP = 0x01;
-
 static int Get_AR(scsp_state *scsp,int base,int R)
 {
 	int Rate=base+(R<<1);
@@ -973,7 +974,7 @@ INLINE INT32 SCSP_UpdateSlot(scsp_state *scsp, SCSP_SLOT *slot)
 		}
 	}
 	else if (SSCTL(slot) == 1)  // Internally generated data (Noise)
-		sample = (INT16)(rand() & 0xffff); // Unknown algorithm
+		sample = (INT16)emu_rand(&scsp->noise_seed); // Unknown algorithm
 	else if (SSCTL(slot) >= 2)  // Internally generated data (All 0)
 		sample = 0;
 
@@ -1107,7 +1108,7 @@ static void SCSP_DoMasterSamples(void* info, UINT32 nsamples, DEV_SMPL **outputs
 
 				sample=SCSP_UpdateSlot(scsp, slot);
 
-				if (! BypassDSP)
+				if (! scsp->BypassDSP)
 				{
 					Enc=((TL(slot))<<0x0)|((IMXL(slot))<<0xd);
 					SCSPDSP_SetSample(&scsp->DSP,(sample*scsp->LPANTABLE[Enc])>>(SHIFT-2),ISEL(slot),IMXL(slot));
@@ -1130,7 +1131,7 @@ static void SCSP_DoMasterSamples(void* info, UINT32 nsamples, DEV_SMPL **outputs
 #endif
 		}
 
-		if (! BypassDSP)
+		if (! scsp->BypassDSP)
 		{
 			SCSPDSP_Step(&scsp->DSP);
 
@@ -1178,7 +1179,7 @@ static UINT8 device_start_scsp(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 {
 	scsp_state *scsp;
 
-	scsp = (scsp_state *)calloc(1, sizeof(scsp_state));
+	scsp = (scsp_state *)DevData_Alloc(cfg->memArena, sizeof(scsp_state));
 	if (scsp == NULL)
 		return 0xFF;
 
@@ -1186,6 +1187,8 @@ static UINT8 device_start_scsp(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	SCSP_Init(scsp, cfg->clock);
 
 	scsp_set_mute_mask(scsp, 0x00000000);
+	scsp->BypassDSP = 0x01;
+	scsp->noise_seed = 1;
 
 	scsp->_devData.chipInf = scsp;
 	INIT_DEVINF(retDevInf, &scsp->_devData, scsp->rate, &devDef);
@@ -1198,7 +1201,7 @@ static void device_stop_scsp(void* info)
 	scsp_state *scsp = (scsp_state *)info;
 	
 	free(scsp->SCSPRAM);
-	free(scsp);
+	DevData_Free(scsp);
 	
 	return;
 }
@@ -1299,7 +1302,9 @@ static void scsp_set_mute_mask(void* info, UINT32 MuteMask)
 
 static void scsp_set_options(void* info, UINT32 Flags)
 {
-	BypassDSP = (Flags & 0x01) >> 0;
+	scsp_state *scsp = (scsp_state *)info;
+	
+	scsp->BypassDSP = (Flags & 0x01) >> 0;
 	
 	return;
 }
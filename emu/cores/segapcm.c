@@ -12,6 +12,7 @@
 #include "../EmuCores.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../VoiceMix.h"
 
 #include "segapcm.h"
 
@@ -30,6 +31,7 @@ static void sega_pcm_fwrite_romusage(void *chip);
 #endif
 
 static void segapcm_set_mute_mask(void *chip, UINT32 MuteMask);
+static UINT8 segapcm_hash_state(void *chip, UINT64* hash);
 
 
 static DEVDEF_RWFUNC devFunc[] =
@@ -39,6 +41,7 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, sega_pcm_write_rom},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, sega_pcm_alloc_rom},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, segapcm_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, segapcm_hash_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef =
@@ -82,8 +85,14 @@ struct _segapcm_state
 	UINT8 bankmask;
 	UINT8 intf_mask;
 	UINT8 Muted[16];
+	VMIX_VOICE mix[16];
 };
 
+static INT32 segapcm_level(UINT8 data, UINT32 volume)
+{
+	return (INT8)(data - 0x80) * (INT32)volume;
+}
+
 static void SEGAPCM_update(void *chip, UINT32 samples, DEV_SMPL **outputs)
 {
 	segapcm_state *spcm = (segapcm_state *)chip;
@@ -126,13 +135,17 @@ static void SEGAPCM_update(void *chip, UINT32 samples, DEV_SMPL **outputs)
 			UINT32 addr = (regs[0x85] << 16) | (regs[0x84] << 8) | spcm->low[ch];
 			UINT32 loop = (regs[0x05] << 16) | (regs[0x04] << 8);
 			UINT8 end = regs[6] + 1;
-			UINT32 i;
+			VMIX_VOICE *mix = &spcm->mix[ch];
+			UINT32 i, span;
+
+			// fixed Bitmask for volume multiplication, thanks to ctr -Valley Bell
+			VoiceMix_SetVolume(mix, regs[2] & 0x7F, regs[3] & 0x7F, segapcm_level);
+			mix->idxBase = offset;
+			mix->step = regs[7];
 
 			/* loop over samples on this channel */
-			for (i = 0; i < samples; i++)
+			for (i = 0; i < samples; i += span)
 			{
-				INT8 v = 0;
-
 				/* handle looping if we've hit the end */
 				if ((addr >> 16) == end)
 				{
@@ -144,19 +157,18 @@ static void SEGAPCM_update(void *chip, UINT32 samples, DEV_SMPL **outputs)
 					else addr = loop;
 				}
 
-				/* fetch the sample */
-				v = spcm->rom[offset | (addr >> 8)] - 0x80;
-//#ifdef _DEBUG
-//				if ((spcm->romusage[(offset | addr >> 8)] & 0x03) == 0x02 && (regs[2] || regs[3]))
-//					printf("Access to empty ROM section! (0x%06X)\n", offset | ((addr >> 8)));
-//				spcm->romusage[offset | (addr >> 8)] |= 0x01;
-//#endif
-
-				/* apply panning and advance */
-				// fixed Bitmask for volume multiplication, thanks to ctr -Valley Bell
-				outputs[0][i] += v * (regs[2] & 0x7F);
-				outputs[1][i] += v * (regs[3] & 0x7F);
-				addr = (addr + regs[7]) & 0xffffff;
+				/* render until the address reaches the end page */
+				if ((addr >> 16) == end)
+					span = 1;	// the loop point is in the end page
+				else
+					span = VoiceMix_StepsTo(0, regs[7], (((UINT32)end << 16) - addr) & 0xffffff);
+				if (span > samples - i)
+					span = samples - i;
+
+				/* fetch the samples, apply panning and advance */
+				mix->pos = addr;
+				VoiceMix_Render(mix, spcm->rom, &outputs[0][i], &outputs[1][i], span);
+				addr = mix->pos & 0xffffff;
 			}
 
 			/* store back the updated address */
@@ -171,8 +183,9 @@ static UINT8 device_start_segapcm(const SEGAPCM_CFG* cfg, DEV_INFO* retDevInf)
 {
 	static const UINT32 STD_ROM_SIZE = 0x80000;
 	segapcm_state *spcm;
+	UINT8 ch;
 	
-	spcm = (segapcm_state *)calloc(1, sizeof(segapcm_state));
+	spcm = (segapcm_state *)DevData_Alloc(cfg->_genCfg.memArena, sizeof(segapcm_state));
 	spcm->bankshift = cfg->bnkshift;
 	spcm->intf_mask = cfg->bnkmask;
 	if (! spcm->intf_mask)
@@ -190,6 +203,8 @@ static UINT8 device_start_segapcm(const SEGAPCM_CFG* cfg, DEV_INFO* retDevInf)
 	sega_pcm_alloc_rom(spcm, STD_ROM_SIZE);
 	
 	segapcm_set_mute_mask(spcm, 0x0000);
+	for (ch = 0; ch < 16; ch ++)
+		VoiceMix_Init(&spcm->mix[ch], 8, 0xFFFF);
 	
 	spcm->_devData.chipInf = spcm;
 	INIT_DEVINF(retDevInf, &spcm->_devData, cfg->_genCfg.clock / 128, &devDef);
@@ -205,7 +220,7 @@ void device_stop_segapcm(void *chip)
 	free(spcm->romusage);
 #endif
 	free(spcm->ram);
-	free(spcm);
+	DevData_Free(spcm);
 	
 	return;
 }
@@ -305,3 +320,23 @@ static void segapcm_set_mute_mask(void *chip, UINT32 MuteMask)
 	
 	return;
 }
+
+static UINT8 segapcm_hash_state(void *chip, UINT64* hash)
+{
+	segapcm_state *spcm = (segapcm_state *)chip;
+	UINT64 h = *hash;
+	
+	// the mixer voices are set up from the registers on each update
+	h = EmuHash_Data(h, spcm->ram, 0x800);
+	h = EmuHash_Data(h, spcm->low, sizeof(spcm->low));
+	h = EmuHash_Data(h, &spcm->bankshift, sizeof(spcm->bankshift));
+	h = EmuHash_Data(h, &spcm->bankmask, sizeof(spcm->bankmask));
+	h = EmuHash_Data(h, &spcm->intf_mask, sizeof(spcm->intf_mask));
+	h = EmuHash_Data(h, spcm->Muted, sizeof(spcm->Muted));
+	h = EmuHash_Data(h, &spcm->ROMSize, sizeof(spcm->ROMSize));
+	if (spcm->rom != NULL)
+		h = EmuHash_Data(h, spcm->rom, spcm->ROMSize);
+	*hash = h;
+	
+	return 0x00;
+}
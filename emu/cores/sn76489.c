@@ -73,10 +73,10 @@ static const int PSGVolumeValues[16] = {
 };
 
 
-static SN76489_Context* SN76489_Init( UINT32 PSGClockValue, UINT32 SamplingRate)
+static SN76489_Context* SN76489_Init( UINT32 PSGClockValue, UINT32 SamplingRate, MEM_ARENA* arena)
 {
 	int i;
-	SN76489_Context* chip = (SN76489_Context*)calloc(1, sizeof(SN76489_Context));
+	SN76489_Context* chip = (SN76489_Context*)DevData_Alloc(arena, sizeof(SN76489_Context));
 	if(chip)
 	{
 		chip->dClock=(float)PSGClockValue/16.0f/SamplingRate;
@@ -142,7 +142,7 @@ static void SN76489_Reset(SN76489_Context* chip)
 
 static void SN76489_Shutdown(SN76489_Context* chip)
 {
-	free(chip);
+	DevData_Free(chip);
 }
 
 static void SN76489_Config(SN76489_Context* chip, UINT32 feedback, UINT8 sr_width)
@@ -190,6 +190,87 @@ static void SN76489_GGStereoWrite(SN76489_Context* chip, UINT8 data)
 	chip->PSGStereo=data;
 }
 
+static void SN76489_CalcOutput(SN76489_Context* chip, SN76489_Context* chip_t, SN76489_Context* chip_n, DEV_SMPL* outL, DEV_SMPL* outR)
+{
+	UINT32 i;
+	
+	/* Tone channels */
+	for ( i = 0; i <= 2; ++i )
+		if ( (chip_t->Mute >> i) & 1 )
+		{
+			if ( chip_t->IntermediatePos[i] != FLT_MIN )
+				/* Intermediate position (antialiasing) */
+				chip->ChannelState[i] = chip_t->IntermediatePos[i];
+			else
+				/* Flat (no antialiasing needed) */
+				chip->ChannelState[i] = (float)chip_t->ToneFreqPos[i];
+		}
+		else
+			/* Muted channel */
+			chip->ChannelState[i] = 0.0f;
+
+	/* Noise channel */
+	if ( (chip_t->Mute >> 3) & 1 )
+	{
+		//chip->Channels[3] = PSGVolumeValues[chip->Registers[7]] * ( chip_n->NoiseShiftRegister & 0x1 ) * 2; /* double noise volume */
+		// Now the noise is bipolar, too. -Valley Bell
+		chip->ChannelState[3] = (float)( (int)( chip_n->NoiseShiftRegister & 0x1 ) * 2 - 1 );
+		// due to the way the white noise works here, it seems twice as loud as it should be
+		if (chip_n->Registers[6] & 0x4 )
+			chip->ChannelState[3] /= 2.0f;
+	}
+	else
+		chip->ChannelState[3] = 0.0f;
+
+	// Build stereo result into buffer
+	*outL = 0;
+	*outR = 0;
+	if (! chip->NgpFlags)
+	{
+		// For all 4 channels
+		for ( i = 0; i <= 3; ++i )
+		{
+			int chnOut = (int)(PSGVolumeValues[chip->Registers[2 * i + 1]] * chip->ChannelState[i]);
+			if ( ( ( chip->PSGStereo >> i ) & 0x11 ) == 0x11 )
+			{
+				// no GG stereo for this channel
+				*outL += APPLY_PANNING_S( chnOut, chip->panning[i][0] ); // left
+				*outR += APPLY_PANNING_S( chnOut, chip->panning[i][1] ); // right
+			}
+			else
+			{
+				// GG stereo overrides panning
+				*outL += ( chip->PSGStereo >> (i+4) & 0x1 ) * chnOut; // left
+				*outR += ( chip->PSGStereo >>  i    & 0x1 ) * chnOut; // right
+			}
+		}
+	}
+	else
+	{
+		int chnOut;
+		if (! (chip->NgpFlags & 0x01))
+		{
+			// For all 3 tone channels
+			for (i = 0; i < 3; i ++)
+			{
+				chnOut = (int)(PSGVolumeValues[chip_t->Registers[2 * i + 1]] * chip->ChannelState[i]);
+				*outL += (chip->PSGStereo >> (i+4) & 0x1 ) * chnOut; // left
+				chnOut = (int)(PSGVolumeValues[chip_n->Registers[2 * i + 1]] * chip->ChannelState[i]);
+				*outR += (chip->PSGStereo >>  i    & 0x1 ) * chnOut; // right
+			}
+		}
+		else
+		{
+			// noise channel
+			i = 3;
+			chnOut = (int)(PSGVolumeValues[chip_t->Registers[2 * i + 1]] * chip->ChannelState[i]);
+			*outL += (chip->PSGStereo >> (i+4) & 0x1 ) * chnOut; // left
+			chnOut = (int)(PSGVolumeValues[chip_n->Registers[2 * i + 1]] * chip->ChannelState[i]);
+			*outR += (chip->PSGStereo >>  i    & 0x1 ) * chnOut; // right
+		}
+	}
+}
+
 static void SN76489_Update(SN76489_Context* chip, UINT32 length, DEV_SMPL **buffer)
 {
 	UINT32 i, j;
@@ -216,86 +297,42 @@ static void SN76489_Update(SN76489_Context* chip, UINT32 length, DEV_SMPL **buff
 	
 	for( j = 0; j < length; j++ )
 	{
-		/* Tone channels */
-		for ( i = 0; i <= 2; ++i )
-			if ( (chip_t->Mute >> i) & 1 )
-			{
-				if ( chip_t->IntermediatePos[i] != FLT_MIN )
-					/* Intermediate position (antialiasing) */
-					chip->ChannelState[i] = chip_t->IntermediatePos[i];
-				else
-					/* Flat (no antialiasing needed) */
-					chip->ChannelState[i] = (float)chip_t->ToneFreqPos[i];
-			}
-			else
-				/* Muted channel */
-				chip->ChannelState[i] = 0.0f;
+		SN76489_CalcOutput(chip, chip_t, chip_n, &buffer[0][j], &buffer[1][j]);
 
-		/* Noise channel */
-		if ( (chip_t->Mute >> 3) & 1 )
-		{
-			//chip->Channels[3] = PSGVolumeValues[chip->Registers[7]] * ( chip_n->NoiseShiftRegister & 0x1 ) * 2; /* double noise volume */
-			// Now the noise is bipolar, too. -Valley Bell
-			chip->ChannelState[3] = (float)( (int)( chip_n->NoiseShiftRegister & 0x1 ) * 2 - 1 );
-			// due to the way the white noise works here, it seems twice as loud as it should be
-			if (chip_n->Registers[6] & 0x4 )
-				chip->ChannelState[3] /= 2.0f;
-		}
-		else
-			chip->ChannelState[3] = 0.0f;
-
-		// Build stereo result into buffer
-		buffer[0][j] = 0;
-		buffer[1][j] = 0;
-		if (! chip->NgpFlags)
-		{
-			// For all 4 channels
-			for ( i = 0; i <= 3; ++i )
-			{
-				int chnOut = (int)(PSGVolumeValues[chip->Registers[2 * i + 1]] * chip->ChannelState[i]);
-				if ( ( ( chip->PSGStereo >> i ) & 0x11 ) == 0x11 )
-				{
-					// no GG stereo for this channel
-					buffer[0][j] += APPLY_PANNING_S( chnOut, chip->panning[i][0] ); // left
-					buffer[1][j] += APPLY_PANNING_S( chnOut, chip->panning[i][1] ); // right
-				}
-				else
-				{
-					// GG stereo overrides panning
-					buffer[0][j] += ( chip->PSGStereo >> (i+4) & 0x1 ) * chnOut; // left
-					buffer[1][j] += ( chip->PSGStereo >>  i    & 0x1 ) * chnOut; // right
-				}
-			}
-		}
-		else
+		/* Increment clock by 1 sample length */
+		chip->Clock += chip->dClock;
+		chip->NumClocksForSample = (UINT32)chip->Clock;   /* truncate */
+		chip->Clock -= chip->NumClocksForSample;      /* remove integer part */
+	
+		if (! chip->NgpFlags && chip->IntermediatePos[0] == FLT_MIN &&
+			chip->IntermediatePos[1] == FLT_MIN && chip->IntermediatePos[2] == FLT_MIN)
 		{
-			int chnOut;
-			if (! (chip->NgpFlags & 0x01))
+			/* The current sample is "flat". As long as no counter expires, the following samples
+			   are the same, so only the clock needs to be advanced for them. */
+			INT32 minCount = chip->ToneFreqVals[0];
+			UINT32 clocks = 0;
+			for ( i = 1; i <= 3; ++i )
 			{
-				// For all 3 tone channels
-				for (i = 0; i < 3; i ++)
-				{
-					chnOut = (int)(PSGVolumeValues[chip_t->Registers[2 * i + 1]] * chip->ChannelState[i]);
-					buffer[0][j] += (chip->PSGStereo >> (i+4) & 0x1 ) * chnOut; // left
-					chnOut = (int)(PSGVolumeValues[chip_n->Registers[2 * i + 1]] * chip->ChannelState[i]);
-					buffer[1][j] += (chip->PSGStereo >>  i    & 0x1 ) * chnOut; // right
-				}
+				if (i == 3 && chip->NoiseFreq == 0x80)
+					break;	/* matches tone2 */
+				if (minCount > chip->ToneFreqVals[i])
+					minCount = chip->ToneFreqVals[i];
 			}
-			else
+			while ( j + 1 < length && minCount - (INT32)(clocks + chip->NumClocksForSample) > 0 )
 			{
-				// noise channel
-				i = 3;
-				chnOut = (int)(PSGVolumeValues[chip_t->Registers[2 * i + 1]] * chip->ChannelState[i]);
-				buffer[0][j] += (chip->PSGStereo >> (i+4) & 0x1 ) * chnOut; // left
-				chnOut = (int)(PSGVolumeValues[chip_n->Registers[2 * i + 1]] * chip->ChannelState[i]);
-				buffer[1][j] += (chip->PSGStereo >>  i    & 0x1 ) * chnOut; // right
+				clocks += chip->NumClocksForSample;
+				j ++;
+				buffer[0][j] = buffer[0][j - 1];
+				buffer[1][j] = buffer[1][j - 1];
+				chip->Clock += chip->dClock;
+				chip->NumClocksForSample = (UINT32)chip->Clock;
+				chip->Clock -= chip->NumClocksForSample;
 			}
+			for ( i = 0; i <= 2; ++i )
+				chip->ToneFreqVals[i] -= clocks;
+			if ( chip->NoiseFreq != 0x80 )
+				chip->ToneFreqVals[3] -= clocks;
 		}
-
-		/* Increment clock by 1 sample length */
-		chip->Clock += chip->dClock;
-		chip->NumClocksForSample = (UINT32)chip->Clock;   /* truncate */
-		chip->Clock -= chip->NumClocksForSample;      /* remove integer part */
 	
 		/* Decrement tone channel counters */
 		for ( i = 0; i <= 2; ++i )
@@ -397,7 +434,7 @@ static UINT8 device_start_sn76496_maxim(const SN76496_CFG* cfg, DEV_INFO* retDev
 	UINT32 rate;
 	
 	rate = cfg->_genCfg.smplRate;
-	chip = SN76489_Init(cfg->_genCfg.clock, rate);
+	chip = SN76489_Init(cfg->_genCfg.clock, rate, cfg->_genCfg.memArena);
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -70,7 +70,7 @@ struct _SN76489_Context
 };
 
 /* Function prototypes */
-static SN76489_Context* SN76489_Init(UINT32 PSGClockValue, UINT32 SamplingRate);
+static SN76489_Context* SN76489_Init(UINT32 PSGClockValue, UINT32 SamplingRate, MEM_ARENA* arena);
 static void SN76489_ConnectT6W28(SN76489_Context* noisechip, SN76489_Context* tonechip);
 static void SN76489_Reset(SN76489_Context* chip);
 static void SN76489_Shutdown(SN76489_Context* chip);
@@ -144,6 +144,7 @@
 #include "../EmuStructs.h"
 #include "../EmuCores.h"
 #include "../EmuHelper.h"
+#include "../BlipBuf.h"
 #include "sn764intf.h"
 #include "sn76496.h"
 
@@ -153,11 +154,13 @@ static void sn76496_write_reg(void *chip, UINT8 offset, UINT8 data);
 static void sn76496_stereo_w(void *chip, UINT8 offset, UINT8 data);
 
 static void sn76496_update(void *param, UINT32 samples, DEV_SMPL** outputs);
+static void sn76496_update_mix(void *param, UINT32 samples, DEV_SMPL* mixBuf, INT32 volL, INT32 volR);
 static void sn76496_connect_t6w28(void *noisechip, void *tonechip);
 static void sn76496_shutdown(void *chip);
 static void sn76496_reset(void *chip);
 static void sn76496_freq_limiter(void* chip, UINT32 sample_rate);
 static void sn76496_set_mutemask(void *chip, UINT32 MuteMask);
+static UINT8 sn76496_hash_state(void *chip, UINT64* hash);
 
 static UINT8 device_start_sn76496_mame(const SN76496_CFG* cfg, DEV_INFO* retDevInf);
 static void sn76496_w_mame(void *chip, UINT8 reg, UINT8 data);
@@ -167,6 +170,8 @@ static DEVDEF_RWFUNC devFunc[] =
 {
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, sn76496_w_mame},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, sn76496_set_mutemask},
+	{RWF_STATE | RWF_READ, DEVRW_ALL, 0, sn76496_hash_state},
+	{RWF_UPDATE_MIX, DEVRW_ALL, 0, sn76496_update_mix},
 	{0x00, 0x00, 0, NULL}
 };
 DEV_DEF devDef_SN76496_MAME =
@@ -189,6 +194,7 @@ DEV_DEF devDef_SN76496_MAME =
 
 
 #define MAX_OUTPUT 0x8000
+#define BLIP_FRAME 0x800    // maximum number of samples per frame in output rate mode
 
 
 typedef struct _sn76496_state sn76496_state;
@@ -225,6 +231,9 @@ struct _sn76496_state
 	UINT32 MuteMsk[4];
 	UINT8 NgpFlags;         // bit 7 - NGP Mode on/off, bit 0 - is 2nd NGP chip
 	sn76496_state* NgpChip2;    // pointer to other chip instance of T6W28
+	
+	BLIP_BUF* blip[2];      // output rate mode: band-limited steps at the output sample rate (NULL = native rate)
+	DEV_SMPL blipLast[2];
 };
 
 
@@ -319,219 +328,418 @@ INLINE void countdown_cycles(sn76496_state *R)
 	}
 }
 
-static void sn76496_update(void* param, UINT32 samples, DEV_SMPL** outputs)
+INLINE void sn76496_calc_output(sn76496_state *R, sn76496_state *R2, DEV_SMPL *outL, DEV_SMPL *outR)
 {
-	UINT32 i;
-	UINT32 j;
-	sn76496_state *R = (sn76496_state *)param;
-	sn76496_state *R2;
-	DEV_SMPL* lbuffer = outputs[0];
-	DEV_SMPL* rbuffer = outputs[1];
-	DEV_SMPL out = 0;
-	DEV_SMPL out2 = 0;
+	UINT32 i = 3;	// The T6W28 code below relies on this being left at 3 by the channel loop.
+	DEV_SMPL out;
+	DEV_SMPL out2;
 	INT32 vol[4];
 	INT32 ggst[2];
-
-	R2 = R->NgpFlags ? R->NgpChip2 : NULL;
-	if (R->NgpFlags)
-	{
-		// Speed Hack
-		out = 0;
-		for (i = 0; i < 3; i ++)
-		{
-			if (R->period[i] || R->volume[i])
-			{
-				out = 1;
-				break;
-			}
-		}
-		if (R->volume[3])
-			out = 1;
-		if (! out)
-		{
-			memset(lbuffer, 0x00, sizeof(DEV_SMPL) * samples);
-			memset(rbuffer, 0x00, sizeof(DEV_SMPL) * samples);
-			return;
-		}
-	}
 	
 	ggst[0] = 0x01;
 	ggst[1] = 0x01;
-	for (j = 0; j < samples; j++)
+
+#if 0
+	if (R->stereo)
 	{
-		// disabled, because dividing the output sample rate is easier and faster
-	//	// clock chip once
-	//	if (R->current_clock > 0) // not ready for new divided clock
-	//	{
-	//		R->current_clock--;
-	//	}
-	//	else // ready for new divided clock, make a new sample
-	//	{
-	//		R->current_clock = R->clock_divider-1;
-			// decrement Cycles to READY by one
-			countdown_cycles(R);
+		out = ((((R->stereo_mask & 0x10)!=0) && (R->output[0]!=0))? R->volume[0] : 0)
+			+ ((((R->stereo_mask & 0x20)!=0) && (R->output[1]!=0))? R->volume[1] : 0)
+			+ ((((R->stereo_mask & 0x40)!=0) && (R->output[2]!=0))? R->volume[2] : 0)
+			+ ((((R->stereo_mask & 0x80)!=0) && (R->output[3]!=0))? R->volume[3] : 0);
+
+		out2= ((((R->stereo_mask & 0x1)!=0) && (R->output[0]!=0))? R->volume[0] : 0)
+			+ ((((R->stereo_mask & 0x2)!=0) && (R->output[1]!=0))? R->volume[1] : 0)
+			+ ((((R->stereo_mask & 0x4)!=0) && (R->output[2]!=0))? R->volume[2] : 0)
+			+ ((((R->stereo_mask & 0x8)!=0) && (R->output[3]!=0))? R->volume[3] : 0);
+	}
+	else
+	{
+		out= ((R->output[0]!=0)? R->volume[0]:0)
+			+((R->output[1]!=0)? R->volume[1]:0)
+			+((R->output[2]!=0)? R->volume[2]:0)
+			+((R->output[3]!=0)? R->volume[3]:0);
+		out2 = out;
+	}
+#endif
 
-			// handle channels 0,1,2
-			for (i = 0; i < 3; i++)
+	// --- CUSTOM CODE START --
+	out = out2 = 0;
+	if (! R->NgpFlags)
+	{
+		for (i = 0; i < 4; i ++)
+		{
+			// --- Preparation Start ---
+			// Bipolar output
+			vol[i] = R->output[i] ? +1 : -1;
+			
+			// Disable high frequencies (> SampleRate / 2) for tone channels
+			// Freq. 0/1 isn't disabled because it would also disable PCM
+			if (i != 3)
 			{
-				R->count[i]--;
-				if (R->count[i] <= 0)
-				{
-					R->output[i] ^= 1;
-					R->count[i] = R->period[i];
-				}
+				if (R->period[i] <= R->FNumLimit && R->period[i] > 1)
+					vol[i] = 0;
 			}
-
-			// handle channel 3
-			R->count[3]--;
-			if (R->count[3] <= 0)
+			vol[i] &= R->MuteMsk[i];
+			// --- Preparation End ---
+			
+			if (R->stereo)
 			{
-				// if noisemode is 1, both taps are enabled
-				// if noisemode is 0, the lower tap, whitenoisetap2, is held at 0
-				// The != was a bit-XOR (^) before
-				if (((R->RNG & R->whitenoise_tap1)!=0) != (((R->RNG & R->whitenoise_tap2)!=(R->ncr_style_psg?R->whitenoise_tap2:0)) && in_noise_mode(R)))
-				{
-					R->RNG >>= 1;
-					R->RNG |= R->feedback_mask;
-				}
-				else
-				{
-					R->RNG >>= 1;
-				}
-				R->output[3] = R->RNG & 1;
-
-				R->count[3] = R->period[3];
+				ggst[0] = (R->stereo_mask & (0x10 << i)) ? 1 : 0;
+				ggst[1] = (R->stereo_mask & (0x01 << i)) ? 1 : 0;
+			}
+			if (R->period[i] > 1 || i == 3)
+			{
+				out += vol[i] * R->volume[i] * ggst[0];
+				out2 += vol[i] * R->volume[i] * ggst[1];
+			}
+			else if (R->MuteMsk[i])
+			{
+				// Make Bipolar Output with PCM possible
+				out += R->volume[i] * ggst[0];
+				out2 += R->volume[i] * ggst[1];
 			}
-		//}
-
-#if 0
-		if (R->stereo)
-		{
-			out = ((((R->stereo_mask & 0x10)!=0) && (R->output[0]!=0))? R->volume[0] : 0)
-				+ ((((R->stereo_mask & 0x20)!=0) && (R->output[1]!=0))? R->volume[1] : 0)
-				+ ((((R->stereo_mask & 0x40)!=0) && (R->output[2]!=0))? R->volume[2] : 0)
-				+ ((((R->stereo_mask & 0x80)!=0) && (R->output[3]!=0))? R->volume[3] : 0);
-
-			out2= ((((R->stereo_mask & 0x1)!=0) && (R->output[0]!=0))? R->volume[0] : 0)
-				+ ((((R->stereo_mask & 0x2)!=0) && (R->output[1]!=0))? R->volume[1] : 0)
-				+ ((((R->stereo_mask & 0x4)!=0) && (R->output[2]!=0))? R->volume[2] : 0)
-				+ ((((R->stereo_mask & 0x8)!=0) && (R->output[3]!=0))? R->volume[3] : 0);
-		}
-		else
-		{
-			out= ((R->output[0]!=0)? R->volume[0]:0)
-				+((R->output[1]!=0)? R->volume[1]:0)
-				+((R->output[2]!=0)? R->volume[2]:0)
-				+((R->output[3]!=0)? R->volume[3]:0);
-			out2 = out;
 		}
-#endif
-
-		// --- CUSTOM CODE START --
-		out = out2 = 0;
-		if (! R->NgpFlags)
+	}
+	else
+	{
+		if (! (R->NgpFlags & 0x01))
 		{
-			for (i = 0; i < 4; i ++)
+			// Tone Channel 1-3
+			if (R->stereo)
+			{
+				ggst[0] = (R->stereo_mask & (0x10 << i)) ? 1 : 0;
+				ggst[1] = (R->stereo_mask & (0x01 << i)) ? 1 : 0;
+			}
+			for (i = 0; i < 3; i ++)
 			{
 				// --- Preparation Start ---
 				// Bipolar output
 				vol[i] = R->output[i] ? +1 : -1;
 				
 				// Disable high frequencies (> SampleRate / 2) for tone channels
-				// Freq. 0/1 isn't disabled because it would also disable PCM
-				if (i != 3)
-				{
-					if (R->period[i] <= R->FNumLimit && R->period[i] > 1)
-						vol[i] = 0;
-				}
+				// Freq. 0 isn't disabled becaus it would also disable PCM
+				if (R->period[i] <= R->FNumLimit && R->period[i] > 1)
+					vol[i] = 0;
 				vol[i] &= R->MuteMsk[i];
 				// --- Preparation End ---
 				
-				if (R->stereo)
-				{
-					ggst[0] = (R->stereo_mask & (0x10 << i)) ? 1 : 0;
-					ggst[1] = (R->stereo_mask & (0x01 << i)) ? 1 : 0;
-				}
-				if (R->period[i] > 1 || i == 3)
+				if (R->period[i])
 				{
 					out += vol[i] * R->volume[i] * ggst[0];
-					out2 += vol[i] * R->volume[i] * ggst[1];
+					out2 += vol[i] * R2->volume[i] * ggst[1];
 				}
 				else if (R->MuteMsk[i])
 				{
 					// Make Bipolar Output with PCM possible
 					out += R->volume[i] * ggst[0];
-					out2 += R->volume[i] * ggst[1];
+					out2 += R2->volume[i] * ggst[1];
 				}
 			}
 		}
 		else
 		{
-			if (! (R->NgpFlags & 0x01))
+			// --- Preparation Start ---
+			// Bipolar output
+			vol[i] = R->output[i] ? +1 : -1;
+			
+			vol[i] &= R2->MuteMsk[i];	// use MuteMask from chip 0
+			// --- Preparation End ---
+			
+			// Noise Channel
+			if (R->stereo)
 			{
-				// Tone Channel 1-3
-				if (R->stereo)
+				ggst[0] = (R->stereo_mask & 0x80) ? 1 : 0;
+				ggst[1] = (R->stereo_mask & 0x08) ? 1 : 0;
+			}
+			else
+			{
+				ggst[0] = 1;
+				ggst[1] = 1;
+			}
+			out += vol[3] * R2->volume[3] * ggst[0];
+			out2 += vol[3] * R->volume[3] * ggst[1];
+		}
+	}
+	// --- CUSTOM CODE END --
+	
+	if(R->negate) { out = -out; out2 = -out2; }
+
+	*outL = out >> 1;	// >>1 to make up for bipolar output
+	*outR = out2 >> 1;
+}
+
+INLINE void countdown_cycles_span(sn76496_state *R, UINT32 cycles)
+{
+	if (R->cycles_to_ready >= (INT32)cycles)
+	{
+		R->cycles_to_ready -= cycles;
+		R->ready_state = 0;
+	}
+	else
+	{
+		if (R->cycles_to_ready > 0)
+			R->cycles_to_ready = 0;
+		R->ready_state = 1;
+	}
+}
+
+// returns the number of samples until a counter expires (the expiring sample included)
+INLINE UINT32 sn76496_steps_to_event(const sn76496_state *R, UINT32 maxSteps)
+{
+	UINT32 i;
+	UINT32 steps = maxSteps;
+	
+	for (i = 0; i < 4; i++)
+	{
+		if (R->count[i] <= 1)
+			return 1;
+		if (steps > (UINT32)R->count[i])
+			steps = (UINT32)R->count[i];
+	}
+	return steps;
+}
+
+// advances the counters by the specified number of steps - there must be no counter event in between
+INLINE void sn76496_skip(sn76496_state *R, UINT32 steps)
+{
+	UINT32 i;
+	
+	countdown_cycles_span(R, steps);
+	for (i = 0; i < 4; i++)
+		R->count[i] -= steps;
+}
+
+// clocks the tone and noise generators once
+INLINE void sn76496_step(sn76496_state *R)
+{
+	UINT32 i;
+	
+	// decrement Cycles to READY by one
+	countdown_cycles(R);
+
+	// handle channels 0,1,2
+	for (i = 0; i < 3; i++)
+	{
+		R->count[i]--;
+		if (R->count[i] <= 0)
+		{
+			R->output[i] ^= 1;
+			R->count[i] = R->period[i];
+		}
+	}
+
+	// handle channel 3
+	R->count[3]--;
+	if (R->count[3] <= 0)
+	{
+		// if noisemode is 1, both taps are enabled
+		// if noisemode is 0, the lower tap, whitenoisetap2, is held at 0
+		// The != was a bit-XOR (^) before
+		if (((R->RNG & R->whitenoise_tap1)!=0) != (((R->RNG & R->whitenoise_tap2)!=(R->ncr_style_psg?R->whitenoise_tap2:0)) && in_noise_mode(R)))
+		{
+			R->RNG >>= 1;
+			R->RNG |= R->feedback_mask;
+		}
+		else
+		{
+			R->RNG >>= 1;
+		}
+		R->output[3] = R->RNG & 1;
+
+		R->count[3] = R->period[3];
+	}
+}
+
+INLINE void sn76496_blip_output(sn76496_state *R, UINT32 time, DEV_SMPL outL, DEV_SMPL outR)
+{
+	if (outL != R->blipLast[0])
+	{
+		Blip_AddDelta(R->blip[0], time, outL - R->blipLast[0]);
+		R->blipLast[0] = outL;
+	}
+	if (outR != R->blipLast[1])
+	{
+		Blip_AddDelta(R->blip[1], time, outR - R->blipLast[1]);
+		R->blipLast[1] = outR;
+	}
+}
+
+// output rate mode: run the generators at the native rate, but only report the level changes
+// The samples are written to outputs or, when mixBuf is set, added to the interleaved buffer mixBuf.
+static void sn76496_update_blip(sn76496_state *R, sn76496_state *R2, UINT32 samples, DEV_SMPL** outputs,
+								DEV_SMPL* mixBuf, INT32 volL, INT32 volR, UINT8 silent)
+{
+	UINT32 smpl_pos;
+	UINT32 frm_smpls;
+	UINT32 frm_steps;
+	UINT32 cur_step;
+	UINT32 span;
+	DEV_SMPL out;
+	DEV_SMPL out2;
+	
+	for (smpl_pos = 0; smpl_pos < samples; smpl_pos += frm_smpls)
+	{
+		frm_smpls = samples - smpl_pos;
+		if (frm_smpls > BLIP_FRAME)
+			frm_smpls = BLIP_FRAME;
+		frm_steps = Blip_ClocksNeeded(R->blip[0], frm_smpls);
+		
+		if (silent)
+		{
+			sn76496_blip_output(R, 0, 0, 0);
+		}
+		else
+		{
+			sn76496_calc_output(R, R2, &out, &out2);	// register writes may have changed the output
+			sn76496_blip_output(R, 0, out, out2);
+			for (cur_step = 0; cur_step < frm_steps; cur_step++)
+			{
+				span = sn76496_steps_to_event(R, frm_steps - cur_step);
+				if (span > 1)
 				{
-					ggst[0] = (R->stereo_mask & (0x10 << i)) ? 1 : 0;
-					ggst[1] = (R->stereo_mask & (0x01 << i)) ? 1 : 0;
+					span --;
+					sn76496_skip(R, span);
+					cur_step += span;
 				}
-				for (i = 0; i < 3; i ++)
+				sn76496_step(R);
+				sn76496_calc_output(R, R2, &out, &out2);
+				sn76496_blip_output(R, cur_step, out, out2);
+			}
+		}
+		
+		Blip_EndFrame(R->blip[0], frm_steps);
+		Blip_EndFrame(R->blip[1], frm_steps);
+		if (mixBuf == NULL)
+		{
+			Blip_ReadSamples(R->blip[0], &outputs[0][smpl_pos], frm_smpls);
+			Blip_ReadSamples(R->blip[1], &outputs[1][smpl_pos], frm_smpls);
+		}
+		else
+		{
+			Blip_MixSamples(R->blip[0], &mixBuf[smpl_pos * 2 + 0], frm_smpls, 2, volL);
+			Blip_MixSamples(R->blip[1], &mixBuf[smpl_pos * 2 + 1], frm_smpls, 2, volR);
+		}
+	}
+}
+
+// native rate mode: render to bufL/bufR, the samples are 'stride' entries apart
+// mix = 0: store the samples, mix = 1: add (sample * volL/volR)
+INLINE void sn76496_render(sn76496_state *R, sn76496_state *R2, UINT32 samples,
+							DEV_SMPL* bufL, DEV_SMPL* bufR, UINT32 stride, INT32 volL, INT32 volR, UINT8 mix)
+{
+	UINT32 j;
+	UINT32 k;
+	UINT32 span;
+	DEV_SMPL out;
+	DEV_SMPL out2;
+	
+	for (j = 0; j < samples; j++)
+	{
+		// The output stays constant until one of the counters expires.
+		// Skip ahead to that sample and fill the span in one go.
+		span = sn76496_steps_to_event(R, samples - j);
+		if (span > 1)
+		{
+			span --;
+			sn76496_skip(R, span);
+			
+			sn76496_calc_output(R, R2, &out, &out2);
+			if (mix)
+			{
+				out *= volL;
+				out2 *= volR;
+				for (k = 0; k < span; k++)
 				{
-					// --- Preparation Start ---
-					// Bipolar output
-					vol[i] = R->output[i] ? +1 : -1;
-					
-					// Disable high frequencies (> SampleRate / 2) for tone channels
-					// Freq. 0 isn't disabled becaus it would also disable PCM
-					if (R->period[i] <= R->FNumLimit && R->period[i] > 1)
-						vol[i] = 0;
-					vol[i] &= R->MuteMsk[i];
-					// --- Preparation End ---
-					
-					if (R->period[i])
-					{
-						out += vol[i] * R->volume[i] * ggst[0];
-						out2 += vol[i] * R2->volume[i] * ggst[1];
-					}
-					else if (R->MuteMsk[i])
-					{
-						// Make Bipolar Output with PCM possible
-						out += R->volume[i] * ggst[0];
-						out2 += R2->volume[i] * ggst[1];
-					}
+					bufL[(j + k) * stride] += out;
+					bufR[(j + k) * stride] += out2;
 				}
 			}
 			else
 			{
-				// --- Preparation Start ---
-				// Bipolar output
-				vol[i] = R->output[i] ? +1 : -1;
-				
-				vol[i] &= R2->MuteMsk[i];	// use MuteMask from chip 0
-				// --- Preparation End ---
-				
-				// Noise Channel
-				if (R->stereo)
-				{
-					ggst[0] = (R->stereo_mask & 0x80) ? 1 : 0;
-					ggst[1] = (R->stereo_mask & 0x08) ? 1 : 0;
-				}
-				else
+				for (k = 0; k < span; k++)
 				{
-					ggst[0] = 1;
-					ggst[1] = 1;
+					bufL[(j + k) * stride] = out;
+					bufR[(j + k) * stride] = out2;
 				}
-				out += vol[3] * R2->volume[3] * ggst[0];
-				out2 += vol[3] * R->volume[3] * ggst[1];
 			}
+			j += span;
 		}
-		// --- CUSTOM CODE END --
 		
-		if(R->negate) { out = -out; out2 = -out2; }
+		// disabled, because dividing the output sample rate is easier and faster
+	//	// clock chip once
+	//	if (R->current_clock > 0) // not ready for new divided clock
+	//	{
+	//		R->current_clock--;
+	//	}
+	//	else // ready for new divided clock, make a new sample
+	//	{
+	//		R->current_clock = R->clock_divider-1;
+			sn76496_step(R);
+		//}
+
+		sn76496_calc_output(R, R2, &out, &out2);
+		if (mix)
+		{
+			bufL[j * stride] += out * volL;
+			bufR[j * stride] += out2 * volR;
+		}
+		else
+		{
+			bufL[j * stride] = out;
+			bufR[j * stride] = out2;
+		}
+	}
+}
+
+// NeoGeoPocket speed hack: returns 1 when all channels are silent
+static UINT8 sn76496_is_silent(const sn76496_state *R)
+{
+	UINT32 i;
+	
+	if (! R->NgpFlags)
+		return 0;
+	for (i = 0; i < 3; i ++)
+	{
+		if (R->period[i] || R->volume[i])
+			return 0;
+	}
+	return R->volume[3] ? 0 : 1;
+}
+
+static void sn76496_update(void* param, UINT32 samples, DEV_SMPL** outputs)
+{
+	sn76496_state *R = (sn76496_state *)param;
+	sn76496_state *R2 = R->NgpFlags ? R->NgpChip2 : NULL;
+	UINT8 silent = sn76496_is_silent(R);
+	
+	if (R->blip[0] != NULL)
+	{
+		sn76496_update_blip(R, R2, samples, outputs, NULL, 0, 0, silent);
+		return;
+	}
+	if (silent)
+	{
+		memset(outputs[0], 0x00, sizeof(DEV_SMPL) * samples);
+		memset(outputs[1], 0x00, sizeof(DEV_SMPL) * samples);
+		return;
+	}
+	sn76496_render(R, R2, samples, outputs[0], outputs[1], 1, 0, 0, 0);
+}
 
-		lbuffer[j] = out >> 1;	// >>1 to make up for bipolar output
-		rbuffer[j] = out2 >> 1;
+static void sn76496_update_mix(void* param, UINT32 samples, DEV_SMPL* mixBuf, INT32 volL, INT32 volR)
+{
+	sn76496_state *R = (sn76496_state *)param;
+	sn76496_state *R2 = R->NgpFlags ? R->NgpChip2 : NULL;
+	UINT8 silent = sn76496_is_silent(R);
+	
+	if (R->blip[0] != NULL)
+	{
+		sn76496_update_blip(R, R2, samples, NULL, mixBuf, volL, volR, silent);
+		return;
 	}
+	if (silent)
+		return;	// nothing to add
+	sn76496_render(R, R2, samples, &mixBuf[0], &mixBuf[1], 2, volL, volR, 1);
 }
 
 static void sn76496_connect_t6w28(void *noisechip, void *tonechip)
@@ -552,7 +760,11 @@ static void sn76496_shutdown(void *chip)
 {
 	sn76496_state *R = (sn76496_state*)chip;
 	
-	free(R);
+	if (R->blip[0] != NULL)
+		Blip_Deinit(R->blip[0]);
+	if (R->blip[1] != NULL)
+		Blip_Deinit(R->blip[1]);
+	DevData_Free(R);
 	return;
 }
 
@@ -585,6 +797,13 @@ static void sn76496_reset(void *chip)
 	//R->current_clock = R->clock_divider-1;
 
 	R->ready_state = 1;
+	
+	if (R->blip[0] != NULL)
+	{
+		Blip_Clear(R->blip[0]);
+		Blip_Clear(R->blip[1]);
+		R->blipLast[0] = R->blipLast[1] = 0;
+	}
 
 	return;
 }
@@ -598,6 +817,33 @@ static void sn76496_freq_limiter(void* chip, UINT32 sample_rate)
 	return;
 }
 
+static UINT8 sn76496_set_output_rate(sn76496_state *R, UINT32 sample_rate)
+{
+	double step_rate;
+	UINT8 retVal;
+	
+	if (! sample_rate)
+		return 0x80;
+	step_rate = R->clock / (2.0 * R->clock_divider);
+	retVal = Blip_Init(&R->blip[0], BLIP_FRAME);
+	if (! retVal)
+		retVal = Blip_Init(&R->blip[1], BLIP_FRAME);
+	if (! retVal)
+		retVal = Blip_SetRates(R->blip[0], step_rate, sample_rate);
+	if (retVal)
+	{
+		if (R->blip[0] != NULL)
+			Blip_Deinit(R->blip[0]);
+		if (R->blip[1] != NULL)
+			Blip_Deinit(R->blip[1]);
+		R->blip[0] = R->blip[1] = NULL;
+		return retVal;
+	}
+	Blip_SetRates(R->blip[1], step_rate, sample_rate);
+	
+	return 0x00;
+}
+
 static void sn76496_set_mutemask(void *chip, UINT32 MuteMask)
 {
 	sn76496_state *R = (sn76496_state*)chip;
@@ -609,6 +855,31 @@ static void sn76496_set_mutemask(void *chip, UINT32 MuteMask)
 	return;
 }
 
+static UINT8 sn76496_hash_state(void *chip, UINT64* hash)
+{
+	sn76496_state *R = (sn76496_state*)chip;
+	UINT64 h = *hash;
+	
+	if (R->blip[0] != NULL)
+		return 0x80;	// the step buffers contain pending output
+	
+	h = EmuHash_Data(h, R->Register, sizeof(R->Register));
+	h = EmuHash_Data(h, &R->last_register, sizeof(R->last_register));
+	h = EmuHash_Data(h, R->volume, sizeof(R->volume));
+	h = EmuHash_Data(h, &R->RNG, sizeof(R->RNG));
+	h = EmuHash_Data(h, &R->stereo_mask, sizeof(R->stereo_mask));
+	h = EmuHash_Data(h, R->period, sizeof(R->period));
+	h = EmuHash_Data(h, R->count, sizeof(R->count));
+	h = EmuHash_Data(h, R->output, sizeof(R->output));
+	h = EmuHash_Data(h, &R->cycles_to_ready, sizeof(R->cycles_to_ready));
+	h = EmuHash_Data(h, &R->ready_state, sizeof(R->ready_state));
+	h = EmuHash_Data(h, R->MuteMsk, sizeof(R->MuteMsk));
+	h = EmuHash_Data(h, &R->NgpFlags, sizeof(R->NgpFlags));
+	*hash = h;
+	
+	return 0x00;
+}
+
 static UINT8 device_start_sn76496_mame(const SN76496_CFG* cfg, DEV_INFO* retDevInf)
 {
 	sn76496_state* chip;
@@ -619,7 +890,7 @@ static UINT8 device_start_sn76496_mame(const SN76496_CFG* cfg, DEV_INFO* retDevI
 	int i;
 	double out;
 	
-	chip = (sn76496_state*)calloc(1, sizeof(sn76496_state));
+	chip = (sn76496_state*)DevData_Alloc(cfg->_genCfg.memArena, sizeof(sn76496_state));
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -665,6 +936,13 @@ static UINT8 device_start_sn76496_mame(const SN76496_CFG* cfg, DEV_INFO* retDevI
 	if (cfg->t6w28_tone != NULL)
 		sn76496_connect_t6w28(chip, cfg->t6w28_tone);
 	sn76496_freq_limiter(chip, cfg->_genCfg.smplRate);
+	if (cfg->_genCfg.srMode == DEVRI_SRMODE_CUSTOM ||
+		(cfg->_genCfg.srMode == DEVRI_SRMODE_HIGHEST && rate < cfg->_genCfg.smplRate))
+	{
+		// render directly at the output sample rate using band-limited steps
+		if (! sn76496_set_output_rate(chip, cfg->_genCfg.smplRate))
+			rate = cfg->_genCfg.smplRate;
+	}
 	
 	devData = &chip->_devData;
 	devData->chipInf = chip;
@@ -739,7 +739,7 @@ static UINT8 device_start_upd7759(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 {
 	upd7759_state *chip;
 
-	chip = (upd7759_state *)calloc(1, sizeof(upd7759_state));
+	chip = (upd7759_state *)DevData_Alloc(cfg->memArena, sizeof(upd7759_state));
 	if (chip == NULL)
 		return 0xFF;
 
@@ -791,7 +791,7 @@ static void device_stop_upd7759(void *info)
 	upd7759_state *chip = (upd7759_state *)info;
 	
 	free(chip->rombase);
-	free(chip);
+	DevData_Free(chip);
 	
 	return;
 }
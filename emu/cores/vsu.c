@@ -540,7 +540,7 @@ static UINT8 device_start_vsu(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 {
 	vsu_state* chip;
 	
-	chip = (vsu_state*)calloc(1, sizeof(vsu_state));
+	chip = (vsu_state*)DevData_Alloc(cfg->memArena, sizeof(vsu_state));
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -564,7 +564,7 @@ static void device_stop_vsu(void* info)
 {
 	vsu_state* chip = (vsu_state*)info;
 	
-	free(chip);
+	DevData_Free(chip);
 	
 	return;
 }
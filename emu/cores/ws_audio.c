@@ -142,7 +142,7 @@ static UINT8 ws_audio_init(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 {
 	wsa_state* chip;
 	
-	chip = (wsa_state*)calloc(1, sizeof(wsa_state));
+	chip = (wsa_state*)DevData_Alloc(cfg->memArena, sizeof(wsa_state));
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -196,7 +196,7 @@ static void ws_audio_done(void* info)
 	wsa_state* chip = (wsa_state*)info;
 	
 	free(chip->ws_internalRam);
-	free(chip);
+	DevData_Free(chip);
 	
 	return;
 }
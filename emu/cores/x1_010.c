@@ -61,6 +61,7 @@ Registers:
 #include "../EmuCores.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../VoiceMix.h"
 #include "x1_010.h"
 
 
@@ -157,8 +158,14 @@ struct _x1_010_state
 	UINT32 base_clock;
 
 	UINT8 Muted[SETA_NUM_CHANNELS];
+	VMIX_VOICE mix[SETA_NUM_CHANNELS];
 };
 
+static INT32 x1_010_level(UINT8 data, UINT32 volume)
+{
+	return (INT8)data * (INT32)volume / 256;
+}
+
 
 /*--------------------------------------------------------------
  generate sound to the mix buffer
@@ -173,6 +180,8 @@ static void seta_update(void *param, UINT32 samples, DEV_SMPL **outputs)
 	INT8    *start, *end, data;
 	UINT8   *env;
 	UINT32  smp_offs, smp_step, env_offs, env_step, delta;
+	UINT32  span;
+	VMIX_VOICE *mix;
 	DEV_SMPL *bufL = outputs[0];
 	DEV_SMPL *bufR = outputs[1];
 
@@ -202,17 +211,24 @@ static void seta_update(void *param, UINT32 samples, DEV_SMPL **outputs)
 					LOG_SOUND(( "Play sample %p - %p, channel %X volume %d:%d freq %X step %X offset %X\n",
 						start, end, ch, volL, volR, freq, smp_step, smp_offs ));
 				}
-				for( i = 0; i < samples; i++ ) {
+				mix = &info->mix[ch];
+				VoiceMix_SetVolume(mix, volL, volR, x1_010_level);
+				mix->step = smp_step;
+				for( i = 0; i < samples; i += span ) {
 					delta = smp_offs>>FREQ_BASE_BITS;
 					// sample ended?
 					if( start+delta >= end ) {
 						reg->status &= ~0x01;                   // Key off
 						break;
 					}
-					data = start[delta];
-					bufL[i] += (data*volL/256);
-					bufR[i] += (data*volR/256);
-					smp_offs += smp_step;
+					// render until the end address is reached
+					span = VoiceMix_StepsTo(smp_offs, smp_step, (UINT64)(end - start) << FREQ_BASE_BITS);
+					if( span > samples - i ) {
+						span = samples - i;
+					}
+					mix->pos = smp_offs;
+					VoiceMix_Render(mix, (const UINT8 *)start, &bufL[i], &bufR[i], span);
+					smp_offs = mix->pos;
 				}
 				info->smp_offset[ch] = smp_offs;
 			} else {                                            // Wave form
@@ -258,8 +274,9 @@ static void seta_update(void *param, UINT32 samples, DEV_SMPL **outputs)
 static UINT8 device_start_x1_010(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 {
 	x1_010_state *info;
+	UINT8 ch;
 
-	info = (x1_010_state *)calloc(1, sizeof(x1_010_state));
+	info = (x1_010_state *)DevData_Alloc(cfg->memArena, sizeof(x1_010_state));
 	if (info == NULL)
 		return 0xFF;
 
@@ -274,6 +291,8 @@ static UINT8 device_start_x1_010(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	//LOG_SOUND(("masterclock = %d rate = %d\n", info->base_clock, info->rate ));
 
 	x1_010_set_mute_mask(info, 0x0000);
+	for (ch = 0; ch < SETA_NUM_CHANNELS; ch ++)
+		VoiceMix_Init(&info->mix[ch], FREQ_BASE_BITS, 0xFFFFFFFF >> FREQ_BASE_BITS);
 
 	info->_devData.chipInf = info;
 	INIT_DEVINF(retDevInf, &info->_devData, info->rate, &devDef);
@@ -286,7 +305,7 @@ static void device_stop_x1_010(void *chip)
 	x1_010_state *info = (x1_010_state *)chip;
 	
 	free(info->rom);
-	free(info);
+	DevData_Free(info);
 	
 	return;
 }
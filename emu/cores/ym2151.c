@@ -40,6 +40,7 @@
 #include "../EmuCores.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "ym2151.h"
 
 #ifdef _MSC_VER
@@ -49,7 +50,7 @@
 
 static void ym2151_write_reg(void *_chip, UINT8 r, UINT8 v);
 static int ym2151_read_status( void *_chip );
-static void * ym2151_init(UINT32 clock, UINT32 rate);
+static void * ym2151_init(UINT32 clock, UINT32 rate, MEM_ARENA* arena);
 static void ym2151_shutdown(void *_chip);
 static void ym2151_reset_chip(void *_chip);
 static void ym2151_update_one(void *chip, UINT32 length, DEV_SMPL **buffers);
@@ -532,17 +533,13 @@ static const UINT8 lfo_noise_waveform[256] = {
 
 
 
-static UINT8 tablesInit = 0;
+static EMU_ONCE tablesOnce = EMU_ONCE_INIT;
 
 static void init_tables(void)
 {
 	signed int i,x,n;
 	double o,m;
 
-	if (tablesInit)
-		return;
-	tablesInit = 1;
-
 	for (x=0; x<TL_RES_LEN; x++)
 	{
 		// note: this formula is broken in MAME 0.183
@@ -1225,11 +1222,11 @@ static int ym2151_read_status( void *_chip )
 *   'clock' is the chip clock in Hz
 *   'rate' is sampling rate
 */
-static void * ym2151_init(UINT32 clock, UINT32 rate)
+static void * ym2151_init(UINT32 clock, UINT32 rate, MEM_ARENA* arena)
 {
 	YM2151 *PSG;
 
-	PSG = (YM2151 *)calloc(1, sizeof(YM2151));
+	PSG = (YM2151 *)DevData_Alloc(arena, sizeof(YM2151));
 	if (PSG == NULL)
 		return NULL;
 
@@ -1238,7 +1235,7 @@ static void * ym2151_init(UINT32 clock, UINT32 rate)
 	PSG->irqhandler = NULL;
 	PSG->portwritehandler = NULL;
 
-	init_tables();
+	Emu_CallOnce(&tablesOnce, init_tables);
 	init_chip_tables(PSG);
 
 	PSG->tim_A      = 0;
@@ -1260,7 +1257,7 @@ static void ym2151_shutdown(void *_chip)
 {
 	YM2151 *chip = (YM2151 *)_chip;
 
-	free (chip);
+	DevData_Free(chip);
 }
 
 
@@ -2051,7 +2048,7 @@ static UINT8 device_start_ym2151(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	rate = cfg->clock / 64;
 	SRATE_CUSTOM_HIGHEST(cfg->srMode, rate, cfg->smplRate);
 	
-	chip = ym2151_init(cfg->clock, rate);
+	chip = ym2151_init(cfg->clock, rate, cfg->memArena);
 	
 	devData = (DEV_DATA*)chip;
 	devData->chipInf = chip;
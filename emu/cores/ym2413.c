@@ -49,6 +49,7 @@ to do:
 #include "../EmuStructs.h"
 #include "../EmuCores.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "ym2413.h"
 
 #ifdef _MSC_VER
@@ -57,7 +58,7 @@ to do:
 
 
 static UINT8 device_start_ym2413_mame(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
-static void *ym2413_init(UINT32 clock, UINT32 rate);
+static void *ym2413_init(UINT32 clock, UINT32 rate, MEM_ARENA* arena);
 static void ym2413_shutdown(void *chip);
 static void ym2413_reset_chip(void *chip);
 static void ym2413_write(void *chip, UINT8 a, UINT8 v);
@@ -597,7 +598,7 @@ static unsigned char vrc7_instable[(16 + 3) * 8] =
 #define SLOT8_2 (&chip->P_CH[8].SLOT[SLOT2])
 
 
-static UINT8 tablesInit = 0;
+static EMU_ONCE tablesOnce = EMU_ONCE_INIT;
 
 /* advance LFO to next sample */
 INLINE void advance_lfo(YM2413 *chip)
@@ -1115,16 +1116,12 @@ INLINE void rhythm_calc( YM2413 *chip, OPLL_CH *CH, unsigned int noise )
 
 
 /* generic table initialize */
-static int init_tables(void)
+static void init_tables(void)
 {
 	signed int i,x;
 	signed int n;
 	double o,m;
 
-	if (tablesInit)
-		return 1;
-	tablesInit = 1;
-
 	for (x=0; x<TL_RES_LEN; x++)
 	{
 		m = (1<<16) / pow(2, (x+1) * (ENV_STEP/4.0) / 8.0);
@@ -1178,8 +1175,6 @@ static int init_tables(void)
 		else
 			sin_tab[1*SIN_LEN+i] = sin_tab[i];
 	}
-
-	return 1;
 }
 
 
@@ -1774,15 +1769,14 @@ static void OPLLResetChip(YM2413 *chip)
 /* Create one of virtual YM2413 */
 /* 'clock' is chip clock in Hz  */
 /* 'rate'  is sampling rate  */
-static YM2413 *OPLLCreate(UINT32 clock, UINT32 rate)
+static YM2413 *OPLLCreate(UINT32 clock, UINT32 rate, MEM_ARENA* arena)
 {
 	YM2413 *chip;
 
-	if( !init_tables() )
-		return NULL;
+	Emu_CallOnce(&tablesOnce, init_tables);
 
 	/* allocate memory block */
-	chip = (YM2413 *)calloc(1, sizeof(YM2413));
+	chip = (YM2413 *)DevData_Alloc(arena, sizeof(YM2413));
 
 	if (chip==NULL)
 		return NULL;
@@ -1804,7 +1798,7 @@ static YM2413 *OPLLCreate(UINT32 clock, UINT32 rate)
 /* Destroy one of virtual YM2413 */
 static void OPLLDestroy(YM2413 *chip)
 {
-	free(chip);
+	DevData_Free(chip);
 }
 
 /* Option handlers */
@@ -1841,7 +1835,7 @@ static UINT8 device_start_ym2413_mame(const DEV_GEN_CFG* cfg, DEV_INFO* retDevIn
 	rate = cfg->clock / 72;
 	SRATE_CUSTOM_HIGHEST(cfg->srMode, rate, cfg->smplRate);
 	
-	chip = ym2413_init(cfg->clock, rate);
+	chip = ym2413_init(cfg->clock, rate, cfg->memArena);
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -1853,10 +1847,10 @@ static UINT8 device_start_ym2413_mame(const DEV_GEN_CFG* cfg, DEV_INFO* retDevIn
 	return 0x00;
 }
 
-static void * ym2413_init(UINT32 clock, UINT32 rate)
+static void * ym2413_init(UINT32 clock, UINT32 rate, MEM_ARENA* arena)
 {
 	/* emulator create */
-	return OPLLCreate(clock, rate);
+	return OPLLCreate(clock, rate, arena);
 }
 
 static void ym2413_shutdown(void *chip)
@@ -29,6 +29,7 @@
 #include "../../stdtype.h"
 #include "../../common_def.h"
 #include "../snddef.h"
+#include "../EmuOnce.h"
 #include "ym2612.h"
 #include "ym2612_int.h"
 
@@ -140,6 +141,7 @@ static unsigned int NULL_RATE[32];      // Table for NULL rate
 
 static int LFO_ENV_TAB[LFO_LENGTH];             // LFO AMS TABLE (adjusted for 11.8 dB)
 static int LFO_FREQ_TAB[LFO_LENGTH];            // LFO FMS TABLE
+static EMU_ONCE tablesOnce = EMU_ONCE_INIT;
 //static int LFO_ENV_UP[MAX_UPDATE_LENGTH];       // Temporary calculated LFO AMS (adjusted for 11.8 dB)
 //static int LFO_FREQ_UP[MAX_UPDATE_LENGTH];      // Temporary calculated LFO FMS
 
@@ -1989,60 +1991,12 @@ static void Update_Chan_Algo7_LFO_Int(ym2612_ *YM2612, channel_ *CH, DEV_SMPL **
  ***********************************************/
 
 
-// Initialisation de l'émulateur YM2612
-ym2612_ *YM2612_Init(UINT32 Clock, UINT32 Rate, UINT8 Interpolation)
+// tables that are shared by all chips, independent of clock and sample rate
+static void YM2612_InitTables(void)
 {
-  ym2612_ *YM2612;
   int i, j;
   double x;
 
-  if ((Rate == 0) || (Clock == 0))
-    return NULL;
-
-  YM2612 = (ym2612_ *)calloc(1, sizeof(ym2612_));
-  if (YM2612 == NULL)
-    return YM2612;
-
-#if YM_DEBUG_LEVEL > 0
-  if (debug_file == NULL)
-  {
-    debug_file = fopen("ym2612.log", "w");
-    fprintf(debug_file, "YM2612 logging :\n\n");
-  }
-#endif
-
-  YM2612->Clock = Clock;
-  YM2612->Rate = Rate;
-
-  YM2612->DAC_Highpass_Enable = 0;
-  YM2612->Enable_SSGEG = 0;
-
-  // 144 = 12 * (prescale * 2) = 12 * 6 * 2
-  // prescale set to 6 by default
-
-  YM2612->Frequence = ((double)(YM2612->Clock) / (double)(YM2612->Rate)) / 144.0;
-  YM2612->TimerBase = (int) (YM2612->Frequence * 4096.0);
-
-  if ((Interpolation) && (YM2612->Frequence > 1.0))
-  {
-    YM2612->Inter_Step = (unsigned int) ((1.0 / YM2612->Frequence) * (double) (0x4000));
-    YM2612->Inter_Cnt = 0;
-
-    // We recalculate rate and frequence after interpolation
-
-    YM2612->Rate = YM2612->Clock / 144;
-    YM2612->Frequence = 1.0;
-  }
-  else
-  {
-    YM2612->Inter_Step = 0x4000;
-    YM2612->Inter_Cnt = 0;
-  }
-
-#if YM_DEBUG_LEVEL > 1
-  fprintf(debug_file, "YM2612 frequence = %g rate = %d  interp step = %.8X\n\n", YM2612->Frequence, YM2612->Rate, YM2612->Inter_Step);
-#endif
-
   // Tableau TL :
   // [0     -  4095] = +output  [4095  - ...] = +output overflow (fill with 0)
   // [12288 - 16383] = -output  [16384 - ...] = -output overflow (fill with 0)
@@ -2176,6 +2130,67 @@ ym2612_ *YM2612_Init(UINT32 Clock, UINT32 Rate, UINT8 Interpolation)
   j <<= ENV_LBITS;
   SL_TAB[15] = j + ENV_DECAY;
 
+  for (i = 0; i < 32; i++)
+    NULL_RATE[i] = 0;
+}
+
+// Initialisation de l'émulateur YM2612
+ym2612_ *YM2612_Init(UINT32 Clock, UINT32 Rate, UINT8 Interpolation)
+{
+  ym2612_ *YM2612;
+  int i, j;
+  double x;
+
+  if ((Rate == 0) || (Clock == 0))
+    return NULL;
+
+  YM2612 = (ym2612_ *)calloc(1, sizeof(ym2612_));
+  if (YM2612 == NULL)
+    return YM2612;
+
+#if YM_DEBUG_LEVEL > 0
+  if (debug_file == NULL)
+  {
+    debug_file = fopen("ym2612.log", "w");
+    fprintf(debug_file, "YM2612 logging :\n\n");
+  }
+#endif
+
+  YM2612->Clock = Clock;
+  YM2612->Rate = Rate;
+
+  YM2612->DAC_Highpass_Enable = 0;
+  YM2612->Enable_SSGEG = 0;
+
+  // 144 = 12 * (prescale * 2) = 12 * 6 * 2
+  // prescale set to 6 by default
+
+  YM2612->Frequence = ((double)(YM2612->Clock) / (double)(YM2612->Rate)) / 144.0;
+  YM2612->TimerBase = (int) (YM2612->Frequence * 4096.0);
+
+  if ((Interpolation) && (YM2612->Frequence > 1.0))
+  {
+    YM2612->Inter_Step = (unsigned int) ((1.0 / YM2612->Frequence) * (double) (0x4000));
+    YM2612->Inter_Cnt = 0;
+
+    // We recalculate rate and frequence after interpolation
+
+    YM2612->Rate = YM2612->Clock / 144;
+    YM2612->Frequence = 1.0;
+  }
+  else
+  {
+    YM2612->Inter_Step = 0x4000;
+    YM2612->Inter_Cnt = 0;
+  }
+
+  Emu_CallOnce(&tablesOnce, YM2612_InitTables);
+
+#if YM_DEBUG_LEVEL > 1
+  fprintf(debug_file, "YM2612 frequence = %g rate = %d  interp step = %.8X\n\n", YM2612->Frequence, YM2612->Rate, YM2612->Inter_Step);
+#endif
+
+
   // Tableau Frequency Step
 
   for (i = 0; i < 2048; i++)
@@ -2217,8 +2232,6 @@ ym2612_ *YM2612_Init(UINT32 Clock, UINT32 Rate, UINT8 Interpolation)
   {
     YM2612->AR_TAB[i] = YM2612->AR_TAB[63];
     YM2612->DR_TAB[i] = YM2612->DR_TAB[63];
-
-    NULL_RATE[i - 64] = 0;
   }
 
   // Tableau Detune
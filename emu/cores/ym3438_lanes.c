@@ -0,0 +1,1748 @@
+/*
+ * Lane-parallel version of the Nuked OPN2 (Yamaha YM3438) emulator.
+ * Based on ym3438.c, Copyright (C) 2017-2018 Alexey Khokholov (Nuke.YKT)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * All instances are clocked together, so the cycle counter (and everything that only
+ * depends on it) is shared. Everything else is stored as [...][lane], and each
+ * function of the scalar core became a loop over all lanes.
+ * Rarely active paths (register writes) are processed only for the lanes that need them.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../stdtype.h"
+#include "../snddef.h"
+#include "ym3438_lanes.h"
+#include "ym3438_int.h"
+#include "ym3438_tables.h"
+
+// superctr's MegaDrive model 1 filter
+#define FILTER_CUTOFF 0.512331301282628 // 5894Hz  single pole IIR low pass
+#define FILTER_CUTOFF_I (1-FILTER_CUTOFF)
+
+#define LANES   NOPN2L_LANES
+
+typedef struct
+{
+    Bit32u clock;
+    Bit32u smplRate;
+
+    /* shared by all lanes */
+    Bit32u cycles;
+    Bit32u channel;
+    Bit8u eg_cycle;
+    Bit16u eg_quotient;
+    Bit32u chip_type;
+    Bit32u use_filter;
+    Bit32s rateratio;
+    Bit32s samplecnt;
+    Bit64u writebuf_samplecnt;
+
+    Bit16s mol[LANES], mor[LANES];
+    /* IO */
+    Bit16u write_data[LANES];
+    Bit8u write_a[LANES];
+    Bit8u write_d[LANES];
+    Bit8u write_a_en[LANES];
+    Bit8u write_d_en[LANES];
+    Bit8u write_busy[LANES];
+    Bit8u write_busy_cnt[LANES];
+    Bit8u write_fm_address[LANES];
+    Bit8u write_fm_data[LANES];
+    Bit16u write_fm_mode_a[LANES];
+    Bit16u address[LANES];
+    Bit8u data[LANES];
+    Bit8u pin_test_in[LANES];
+    Bit8u busy[LANES];
+    /* LFO */
+    Bit8u lfo_en[LANES];
+    Bit8u lfo_freq[LANES];
+    Bit8u lfo_pm[LANES];
+    Bit8u lfo_am[LANES];
+    Bit8u lfo_cnt[LANES];
+    Bit8u lfo_inc[LANES];
+    Bit8u lfo_quotient[LANES];
+    /* Phase generator */
+    Bit16u pg_fnum[LANES];
+    Bit8u pg_block[LANES];
+    Bit8u pg_kcode[LANES];
+    Bit32u pg_inc[24][LANES];
+    Bit32u pg_phase[24][LANES];
+    Bit8u pg_reset[24][LANES];
+    Bit32u pg_read[LANES];
+    /* Envelope generator */
+    Bit8u eg_cycle_stop[LANES];
+    Bit8u eg_shift[LANES];
+    Bit8u eg_shift_lock[LANES];
+    Bit8u eg_timer_low_lock[LANES];
+    Bit16u eg_timer[LANES];
+    Bit8u eg_timer_inc[LANES];
+    Bit8u eg_custom_timer[LANES];
+    Bit8u eg_rate[LANES];
+    Bit8u eg_ksv[LANES];
+    Bit8u eg_inc[LANES];
+    Bit8u eg_ratemax[LANES];
+    Bit8u eg_sl[2][LANES];
+    Bit8u eg_lfo_am[LANES];
+    Bit8u eg_tl[2][LANES];
+    Bit8u eg_state[24][LANES];
+    Bit16u eg_level[24][LANES];
+    Bit16u eg_out[24][LANES];
+    Bit8u eg_kon[24][LANES];
+    Bit8u eg_kon_csm[24][LANES];
+    Bit8u eg_kon_latch[24][LANES];
+    Bit8u eg_ssg_enable[24][LANES];
+    Bit8u eg_ssg_pgrst_latch[24][LANES];
+    Bit8u eg_ssg_repeat_latch[24][LANES];
+    Bit8u eg_ssg_hold_up_latch[24][LANES];
+    Bit8u eg_ssg_dir[24][LANES];
+    Bit8u eg_ssg_inv[24][LANES];
+    Bit32u eg_read[2][LANES];
+    Bit8u eg_read_inc[LANES];
+    /* FM */
+    Bit16s fm_op1[6][2][LANES];
+    Bit16s fm_op2[6][LANES];
+    Bit16s fm_out[24][LANES];
+    Bit16u fm_mod[24][LANES];
+    /* Channel */
+    Bit16s ch_acc[6][LANES];
+    Bit16s ch_out[6][LANES];
+    Bit16s ch_lock[LANES];
+    Bit8u ch_lock_l[LANES];
+    Bit8u ch_lock_r[LANES];
+    Bit16s ch_read[LANES];
+    /* Timer */
+    Bit16u timer_a_cnt[LANES];
+    Bit16u timer_a_reg[LANES];
+    Bit8u timer_a_load_lock[LANES];
+    Bit8u timer_a_load[LANES];
+    Bit8u timer_a_enable[LANES];
+    Bit8u timer_a_reset[LANES];
+    Bit8u timer_a_load_latch[LANES];
+    Bit8u timer_a_overflow_flag[LANES];
+    Bit8u timer_a_overflow[LANES];
+
+    Bit16u timer_b_cnt[LANES];
+    Bit8u timer_b_subcnt[LANES];
+    Bit16u timer_b_reg[LANES];
+    Bit8u timer_b_load_lock[LANES];
+    Bit8u timer_b_load[LANES];
+    Bit8u timer_b_enable[LANES];
+    Bit8u timer_b_reset[LANES];
+    Bit8u timer_b_load_latch[LANES];
+    Bit8u timer_b_overflow_flag[LANES];
+    Bit8u timer_b_overflow[LANES];
+
+    /* Register set */
+    Bit8u mode_test_21[8][LANES];
+    Bit8u mode_test_2c[8][LANES];
+    Bit8u mode_ch3[LANES];
+    Bit8u mode_kon_channel[LANES];
+    Bit8u mode_kon_operator[4][LANES];
+    Bit8u mode_kon[24][LANES];
+    Bit8u mode_csm[LANES];
+    Bit8u mode_kon_csm[LANES];
+    Bit8u dacen[LANES];
+    Bit16s dacdata[LANES];
+
+    Bit8u ks[24][LANES];
+    Bit8u ar[24][LANES];
+    Bit8u sr[24][LANES];
+    Bit8u dt[24][LANES];
+    Bit8u multi[24][LANES];
+    Bit8u sl[24][LANES];
+    Bit8u rr[24][LANES];
+    Bit8u dr[24][LANES];
+    Bit8u am[24][LANES];
+    Bit8u tl[24][LANES];
+    Bit8u ssg_eg[24][LANES];
+
+    Bit16u fnum[6][LANES];
+    Bit8u block[6][LANES];
+    Bit8u kcode[6][LANES];
+    Bit16u fnum_3ch[6][LANES];
+    Bit8u block_3ch[6][LANES];
+    Bit8u kcode_3ch[6][LANES];
+    Bit8u reg_a4[LANES];
+    Bit8u reg_ac[LANES];
+    Bit8u connect[6][LANES];
+    Bit8u fb[6][LANES];
+    Bit8u pan_l[6][LANES], pan_r[6][LANES];
+    Bit8u ams[6][LANES];
+    Bit8u pms[6][LANES];
+    Bit8u status[LANES];
+    Bit32u status_time[LANES];
+
+    Bit32u mute[7][LANES];
+    Bit32s oldsamples[2][LANES];
+    Bit32s samples[2][LANES];
+
+    Bit32u writebuf_cur[LANES];
+    Bit32u writebuf_last[LANES];
+    Bit64u writebuf_lasttime[LANES];
+    opn2_writebuf writebuf[LANES][NOPN_WRITEBUF_SIZE];
+} ym3438_lanes_t;
+
+
+static void NOPN2L_DoIO(ym3438_lanes_t *chip)
+{
+    Bit32u l;
+    for (l = 0; l < LANES; l++)
+    {
+        /* Write signal check */
+        chip->write_a_en[l] = (chip->write_a[l] & 0x03) == 0x01;
+        chip->write_d_en[l] = (chip->write_d[l] & 0x03) == 0x01;
+        chip->write_a[l] <<= 1;
+        chip->write_d[l] <<= 1;
+        /* Busy counter */
+        chip->busy[l] = chip->write_busy[l];
+        chip->write_busy_cnt[l] += chip->write_busy[l];
+        chip->write_busy[l] = (chip->write_busy[l] && !(chip->write_busy_cnt[l] >> 5)) || chip->write_d_en[l];
+        chip->write_busy_cnt[l] &= 0x1f;
+    }
+}
+
+static void NOPN2L_DoRegWriteLane(ym3438_lanes_t *chip, Bit32u l)
+{
+    Bit32u i;
+    Bit32u slot = chip->cycles % 12;
+    Bit32u address;
+    Bit32u channel = chip->channel;
+    /* Update registers */
+    if (chip->write_fm_data[l])
+    {
+        /* Slot */
+        if (op_offset[slot] == (chip->address[l] & 0x107))
+        {
+            if (chip->address[l] & 0x08)
+            {
+                /* OP2, OP4 */
+                slot += 12;
+            }
+            address = chip->address[l] & 0xf0;
+            switch (address)
+            {
+            case 0x30: /* DT, MULTI */
+                chip->multi[slot][l] = chip->data[l] & 0x0f;
+                if (!chip->multi[slot][l])
+                {
+                    chip->multi[slot][l] = 1;
+                }
+                else
+                {
+                    chip->multi[slot][l] <<= 1;
+                }
+                chip->dt[slot][l] = (chip->data[l] >> 4) & 0x07;
+                break;
+            case 0x40: /* TL */
+                chip->tl[slot][l] = chip->data[l] & 0x7f;
+                break;
+            case 0x50: /* KS, AR */
+                chip->ar[slot][l] = chip->data[l] & 0x1f;
+                chip->ks[slot][l] = (chip->data[l] >> 6) & 0x03;
+                break;
+            case 0x60: /* AM, DR */
+                chip->dr[slot][l] = chip->data[l] & 0x1f;
+                chip->am[slot][l] = (chip->data[l] >> 7) & 0x01;
+                break;
+            case 0x70: /* SR */
+                chip->sr[slot][l] = chip->data[l] & 0x1f;
+                break;
+            case 0x80: /* SL, RR */
+                chip->rr[slot][l] = chip->data[l] & 0x0f;
+                chip->sl[slot][l] = (chip->data[l] >> 4) & 0x0f;
+                chip->sl[slot][l] |= (chip->sl[slot][l] + 1) & 0x10;
+                break;
+            case 0x90: /* SSG-EG */
+                chip->ssg_eg[slot][l] = chip->data[l] & 0x0f;
+                break;
+            default:
+                break;
+            }
+        }
+
+        /* Channel */
+        if (ch_offset[channel] == (chip->address[l] & 0x103))
+        {
+            address = chip->address[l] & 0xfc;
+            switch (address)
+            {
+            case 0xa0:
+                chip->fnum[channel][l] = (chip->data[l] & 0xff) | ((chip->reg_a4[l] & 0x07) << 8);
+                chip->block[channel][l] = (chip->reg_a4[l] >> 3) & 0x07;
+                chip->kcode[channel][l] = (chip->block[channel][l] << 2) | fn_note[chip->fnum[channel][l] >> 7];
+                break;
+            case 0xa4:
+                chip->reg_a4[l] = chip->data[l] & 0xff;
+                break;
+            case 0xa8:
+                chip->fnum_3ch[channel][l] = (chip->data[l] & 0xff) | ((chip->reg_ac[l] & 0x07) << 8);
+                chip->block_3ch[channel][l] = (chip->reg_ac[l] >> 3) & 0x07;
+                chip->kcode_3ch[channel][l] = (chip->block_3ch[channel][l] << 2) | fn_note[chip->fnum_3ch[channel][l] >> 7];
+                break;
+            case 0xac:
+                chip->reg_ac[l] = chip->data[l] & 0xff;
+                break;
+            case 0xb0:
+                chip->connect[channel][l] = chip->data[l] & 0x07;
+                chip->fb[channel][l] = (chip->data[l] >> 3) & 0x07;
+                break;
+            case 0xb4:
+                chip->pms[channel][l] = chip->data[l] & 0x07;
+                chip->ams[channel][l] = (chip->data[l] >> 4) & 0x03;
+                chip->pan_l[channel][l] = (chip->data[l] >> 7) & 0x01;
+                chip->pan_r[channel][l] = (chip->data[l] >> 6) & 0x01;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    if (chip->write_a_en[l] || chip->write_d_en[l])
+    {
+        /* Data */
+        if (chip->write_a_en[l])
+        {
+            chip->write_fm_data[l] = 0;
+        }
+
+        if (chip->write_fm_address[l] && chip->write_d_en[l])
+        {
+            chip->write_fm_data[l] = 1;
+        }
+
+        /* Address */
+        if (chip->write_a_en[l])
+        {
+            if ((chip->write_data[l] & 0xf0) != 0x00)
+            {
+                /* FM Write */
+                chip->address[l] = chip->write_data[l];
+                chip->write_fm_address[l] = 1;
+            }
+            else
+            {
+                /* SSG write */
+                chip->write_fm_address[l] = 0;
+            }
+        }
+
+        /* FM Mode */
+        /* Data */
+        if (chip->write_d_en[l] && (chip->write_data[l] & 0x100) == 0)
+        {
+            Bit16u wdata = chip->write_data[l];
+            switch (chip->write_fm_mode_a[l])
+            {
+            case 0x21: /* LSI test 1 */
+                for (i = 0; i < 8; i++)
+                {
+                    chip->mode_test_21[i][l] = (wdata >> i) & 0x01;
+                }
+                break;
+            case 0x22: /* LFO control */
+                if ((wdata >> 3) & 0x01)
+                {
+                    chip->lfo_en[l] = 0x7f;
+                }
+                else
+                {
+                    chip->lfo_en[l] = 0;
+                }
+                chip->lfo_freq[l] = wdata & 0x07;
+                break;
+            case 0x24: /* Timer A */
+                chip->timer_a_reg[l] &= 0x03;
+                chip->timer_a_reg[l] |= (wdata & 0xff) << 2;
+                break;
+            case 0x25:
+                chip->timer_a_reg[l] &= 0x3fc;
+                chip->timer_a_reg[l] |= wdata & 0x03;
+                break;
+            case 0x26: /* Timer B */
+                chip->timer_b_reg[l] = wdata & 0xff;
+                break;
+            case 0x27: /* CSM, Timer control */
+                chip->mode_ch3[l] = (wdata & 0xc0) >> 6;
+                chip->mode_csm[l] = chip->mode_ch3[l] == 2;
+                chip->timer_a_load[l] = wdata & 0x01;
+                chip->timer_a_enable[l] = (wdata >> 2) & 0x01;
+                chip->timer_a_reset[l] = (wdata >> 4) & 0x01;
+                chip->timer_b_load[l] = (wdata >> 1) & 0x01;
+                chip->timer_b_enable[l] = (wdata >> 3) & 0x01;
+                chip->timer_b_reset[l] = (wdata >> 5) & 0x01;
+                break;
+            case 0x28: /* Key on/off */
+                for (i = 0; i < 4; i++)
+                {
+                    chip->mode_kon_operator[i][l] = (wdata >> (4 + i)) & 0x01;
+                }
+                if ((wdata & 0x03) == 0x03)
+                {
+                    /* Invalid address */
+                    chip->mode_kon_channel[l] = 0xff;
+                }
+                else
+                {
+                    chip->mode_kon_channel[l] = (wdata & 0x03) + ((wdata >> 2) & 1) * 3;
+                }
+                break;
+            case 0x2a: /* DAC data */
+                chip->dacdata[l] &= 0x01;
+                chip->dacdata[l] |= (wdata ^ 0x80) << 1;
+                break;
+            case 0x2b: /* DAC enable */
+                chip->dacen[l] = wdata >> 7;
+                break;
+            case 0x2c: /* LSI test 2 */
+                for (i = 0; i < 8; i++)
+                {
+                    chip->mode_test_2c[i][l] = (wdata >> i) & 0x01;
+                }
+                chip->dacdata[l] &= 0x1fe;
+                chip->dacdata[l] |= chip->mode_test_2c[3][l];
+                chip->eg_custom_timer[l] = !chip->mode_test_2c[7][l] && chip->mode_test_2c[6][l];
+                break;
+            default:
+                break;
+            }
+        }
+
+        /* Address */
+        if (chip->write_a_en[l])
+        {
+            chip->write_fm_mode_a[l] = chip->write_data[l] & 0x1ff;
+        }
+    }
+
+    if (chip->write_fm_data[l])
+    {
+        chip->data[l] = chip->write_data[l] & 0xff;
+    }
+}
+
+static void NOPN2L_DoRegWrite(ym3438_lanes_t *chip)
+{
+    Bit32u l;
+    for (l = 0; l < LANES; l++)
+    {
+        if (chip->write_fm_data[l] | chip->write_a_en[l] | chip->write_d_en[l])
+        {
+            NOPN2L_DoRegWriteLane(chip, l);
+        }
+    }
+}
+
+static void NOPN2L_PhaseCalcIncrement(ym3438_lanes_t *chip)
+{
+    const Bit8u *pms_ch = chip->pms[chip->channel];
+    const Bit8u *dt_sl = chip->dt[chip->cycles];
+    const Bit8u *multi_sl = chip->multi[chip->cycles];
+    Bit32u *pg_inc = chip->pg_inc[chip->cycles];
+    Bit32u l;
+    for (l = 0; l < LANES; l++)
+    {
+        Bit32u fnum = chip->pg_fnum[l];
+        Bit32u fnum_h = fnum >> 4;
+        Bit32u fm;
+        Bit32u basefreq;
+        Bit8u lfo = chip->lfo_pm[l];
+        Bit8u lfo_l = lfo & 0x0f;
+        Bit8u pms = pms_ch[l];
+        Bit8u dt = dt_sl[l];
+        Bit8u dt_l = dt & 0x03;
+        Bit8u detune = 0;
+        Bit8u block, note;
+        Bit8u sum, sum_h, sum_l;
+        Bit8u kcode = chip->pg_kcode[l];
+
+        fnum <<= 1;
+        /* Apply LFO */
+        if (lfo_l & 0x08)
+        {
+            lfo_l ^= 0x0f;
+        }
+        fm = (fnum_h >> pg_lfo_sh1[pms][lfo_l]) + (fnum_h >> pg_lfo_sh2[pms][lfo_l]);
+        if (pms > 5)
+        {
+            fm <<= pms - 5;
+        }
+        fm >>= 2;
+        if (lfo & 0x10)
+        {
+            fnum -= fm;
+        }
+        else
+        {
+            fnum += fm;
+        }
+        fnum &= 0xfff;
+
+        basefreq = (fnum << chip->pg_block[l]) >> 2;
+
+        /* Apply detune */
+        if (dt_l)
+        {
+            if (kcode > 0x1c)
+            {
+                kcode = 0x1c;
+            }
+            block = kcode >> 2;
+            note = kcode & 0x03;
+            sum = block + 9 + ((dt_l == 3) | (dt_l & 0x02));
+            sum_h = sum >> 1;
+            sum_l = sum & 0x01;
+            detune = pg_detune[(sum_l << 2) | note] >> (9 - sum_h);
+        }
+        if (dt & 0x04)
+        {
+            basefreq -= detune;
+        }
+        else
+        {
+            basefreq += detune;
+        }
+        basefreq &= 0x1ffff;
+        pg_inc[l] = ((basefreq * multi_sl[l]) >> 1) & 0xfffff;
+    }
+}
+
+static void NOPN2L_PhaseGenerate(ym3438_lanes_t *chip)
+{
+    /* Mask increment */
+    Bit32u slot1 = (chip->cycles + 20) % 24;
+    /* Phase step */
+    Bit32u slot2 = (chip->cycles + 19) % 24;
+    Bit32u l;
+    for (l = 0; l < LANES; l++)
+    {
+        if (chip->pg_reset[slot1][l])
+        {
+            chip->pg_inc[slot1][l] = 0;
+        }
+    }
+    for (l = 0; l < LANES; l++)
+    {
+        if (chip->pg_reset[slot2][l] || chip->mode_test_21[3][l])
+        {
+            chip->pg_phase[slot2][l] = 0;
+        }
+        chip->pg_phase[slot2][l] = (chip->pg_phase[slot2][l] + chip->pg_inc[slot2][l]) & 0xfffff;
+    }
+}
+
+static void NOPN2L_EnvelopeSSGEG(ym3438_lanes_t *chip)
+{
+    Bit32u slot = chip->cycles;
+    Bit32u l;
+    for (l = 0; l < LANES; l++)
+    {
+        Bit8u ssg_eg = chip->ssg_eg[slot][l];
+        Bit8u direction = 0;
+        chip->eg_ssg_pgrst_latch[slot][l] = 0;
+        chip->eg_ssg_repeat_latch[slot][l] = 0;
+        chip->eg_ssg_hold_up_latch[slot][l] = 0;
+        chip->eg_ssg_inv[slot][l] = 0;
+        if (ssg_eg & 0x08)
+        {
+            direction = chip->eg_ssg_dir[slot][l];
+            if (chip->eg_level[slot][l] & 0x200)
+            {
+                /* Reset */
+                if ((ssg_eg & 0x03) == 0x00)
+                {
+                    chip->eg_ssg_pgrst_latch[slot][l] = 1;
+                }
+                /* Repeat */
+                if ((ssg_eg & 0x01) == 0x00)
+                {
+                    chip->eg_ssg_repeat_latch[slot][l] = 1;
+                }
+                /* Inverse */
+                if ((ssg_eg & 0x03) == 0x02)
+                {
+                    direction ^= 1;
+                }
+                if ((ssg_eg & 0x03) == 0x03)
+                {
+                    direction = 1;
+                }
+            }
+            /* Hold up */
+            if (chip->eg_kon_latch[slot][l]
+             && ((ssg_eg & 0x07) == 0x05 || (ssg_eg & 0x07) == 0x03))
+            {
+                chip->eg_ssg_hold_up_latch[slot][l] = 1;
+            }
+            direction &= chip->eg_kon[slot][l];
+            chip->eg_ssg_inv[slot][l] = (chip->eg_ssg_dir[slot][l] ^ ((ssg_eg >> 2) & 0x01))
+                                      & chip->eg_kon[slot][l];
+        }
+        chip->eg_ssg_dir[slot][l] = direction;
+        chip->eg_ssg_enable[slot][l] = (ssg_eg >> 3) & 0x01;
+    }
+}
+
+static void NOPN2L_EnvelopeADSR(ym3438_lanes_t *chip)
+{
+    Bit32u slot = (chip->cycles + 22) % 24;
+    Bit32u l;
+    for (l = 0; l < LANES; l++)
+    {
+        Bit8u nkon = chip->eg_kon_latch[slot][l];
+        Bit8u okon = chip->eg_kon[slot][l];
+        Bit8u kon_event;
+        Bit8u koff_event;
+        Bit8u eg_off;
+        Bit16s level;
+        Bit16s nextlevel = 0;
+        Bit16s ssg_level;
+        Bit8u state = chip->eg_state[slot][l];
+        Bit8u nextstate = state;
+        Bit16s inc = 0;
+        chip->eg_read[0][l] = chip->eg_read_inc[l];
+        chip->eg_read_inc[l] = chip->eg_inc[l] > 0;
+
+        /* Reset phase generator */
+        chip->pg_reset[slot][l] = (nkon && !okon) || chip->eg_ssg_pgrst_latch[slot][l];
+
+        /* KeyOn/Off */
+        kon_event = (nkon && !okon) || (okon && chip->eg_ssg_repeat_latch[slot][l]);
+        koff_event = okon && !nkon;
+
+        ssg_level = level = (Bit16s)chip->eg_level[slot][l];
+
+        if (chip->eg_ssg_inv[slot][l])
+        {
+            /* Inverse */
+            ssg_level = 512 - level;
+            ssg_level &= 0x3ff;
+        }
+        if (koff_event)
+        {
+            level = ssg_level;
+        }
+        if (chip->eg_ssg_enable[slot][l])
+        {
+            eg_off = level >> 9;
+        }
+        else
+        {
+            eg_off = (level & 0x3f0) == 0x3f0;
+        }
+        nextlevel = level;
+        if (kon_event)
+        {
+            nextstate = eg_num_attack;
+            /* Instant attack */
+            if (chip->eg_ratemax[l])
+            {
+                nextlevel = 0;
+            }
+            else if (state == eg_num_attack && level != 0 && chip->eg_inc[l] && nkon)
+            {
+                inc = (~level << chip->eg_inc[l]) >> 5;
+            }
+        }
+        else
+        {
+            switch (state)
+            {
+            case eg_num_attack:
+                if (level == 0)
+                {
+                    nextstate = eg_num_decay;
+                }
+                else if(chip->eg_inc[l] && !chip->eg_ratemax[l] && nkon)
+                {
+                    inc = (~level << chip->eg_inc[l]) >> 5;
+                }
+                break;
+            case eg_num_decay:
+                if ((level >> 5) == chip->eg_sl[1][l])
+                {
+                    nextstate = eg_num_sustain;
+                }
+                else if (!eg_off && chip->eg_inc[l])
+                {
+                    inc = 1 << (chip->eg_inc[l] - 1);
+                    if (chip->eg_ssg_enable[slot][l])
+                    {
+                        inc <<= 2;
+                    }
+                }
+                break;
+            case eg_num_sustain:
+            case eg_num_release:
+                if (!eg_off && chip->eg_inc[l])
+                {
+                    inc = 1 << (chip->eg_inc[l] - 1);
+                    if (chip->eg_ssg_enable[slot][l])
+                    {
+                        inc <<= 2;
+                    }
+                }
+                break;
+            default:
+                break;
+            }
+            if (!nkon)
+            {
+                nextstate = eg_num_release;
+            }
+        }
+        if (chip->eg_kon_csm[slot][l])
+        {
+            nextlevel |= chip->eg_tl[1][l] << 3;
+        }
+
+        /* Envelope off */
+        if (!kon_event && !chip->eg_ssg_hold_up_latch[slot][l] && state != eg_num_attack && eg_off)
+        {
+            nextstate = eg_num_release;
+            nextlevel = 0x3ff;
+        }
+
+        nextlevel += inc;
+
+        chip->eg_kon[slot][l] = nkon;
+        chip->eg_level[slot][l] = (Bit16u)nextlevel & 0x3ff;
+        chip->eg_state[slot][l] = nextstate;
+    }
+}
+
+static void NOPN2L_EnvelopePrepare(ym3438_lanes_t *chip)
+{
+    Bit32u slot = chip->cycles;
+    Bit32u chan = chip->channel;
+    Bit8u eg_q2 = (chip->eg_quotient == 2);
+    Bit32u l;
+    for (l = 0; l < LANES; l++)
+    {
+        Bit8u rate;
+        Bit8u sum;
+        Bit8u inc = 0;
+        Bit8u rate_sel;
+
+        /* Prepare increment */
+        rate = (chip->eg_rate[l] << 1) + chip->eg_ksv[l];
+
+        if (rate > 0x3f)
+        {
+            rate = 0x3f;
+        }
+
+        sum = ((rate >> 2) + chip->eg_shift_lock[l]) & 0x0f;
+        if (chip->eg_rate[l] != 0 && eg_q2)
+        {
+            if (rate < 48)
+            {
+                switch (sum)
+                {
+                case 12:
+                    inc = 1;
+                    break;
+                case 13:
+                    inc = (rate >> 1) & 0x01;
+                    break;
+                case 14:
+                    inc = rate & 0x01;
+                    break;
+                default:
+                    break;
+                }
+            }
+            else
+            {
+                inc = eg_stephi[rate & 0x03][chip->eg_timer_low_lock[l]] + (rate >> 2) - 11;
+                if (inc > 4)
+                {
+                    inc = 4;
+                }
+            }
+        }
+        chip->eg_inc[l] = inc;
+        chip->eg_ratemax[l] = (rate >> 1) == 0x1f;
+
+        /* Prepare rate & ksv */
+        rate_sel = chip->eg_state[slot][l];
+        if ((chip->eg_kon[slot][l] && chip->eg_ssg_repeat_latch[slot][l])
+         || (!chip->eg_kon[slot][l] && chip->eg_kon_latch[slot][l]))
+        {
+            rate_sel = eg_num_attack;
+        }
+        switch (rate_sel)
+        {
+        case eg_num_attack:
+            chip->eg_rate[l] = chip->ar[slot][l];
+            break;
+        case eg_num_decay:
+            chip->eg_rate[l] = chip->dr[slot][l];
+            break;
+        case eg_num_sustain:
+            chip->eg_rate[l] = chip->sr[slot][l];
+            break;
+        case eg_num_release:
+            chip->eg_rate[l] = (chip->rr[slot][l] << 1) | 0x01;
+            break;
+        default:
+            break;
+        }
+        chip->eg_ksv[l] = chip->pg_kcode[l] >> (chip->ks[slot][l] ^ 0x03);
+        if (chip->am[slot][l])
+        {
+            chip->eg_lfo_am[l] = chip->lfo_am[l] >> eg_am_shift[chip->ams[chan][l]];
+        }
+        else
+        {
+            chip->eg_lfo_am[l] = 0;
+        }
+        /* Delay TL & SL value */
+        chip->eg_tl[1][l] = chip->eg_tl[0][l];
+        chip->eg_tl[0][l] = chip->tl[slot][l];
+        chip->eg_sl[1][l] = chip->eg_sl[0][l];
+        chip->eg_sl[0][l] = chip->sl[slot][l];
+    }
+}
+
+static void NOPN2L_EnvelopeGenerate(ym3438_lanes_t *chip)
+{
+    Bit32u slot = (chip->cycles + 23) % 24;
+    Bit8u ch3 = (chip->channel == 2 + 1);
+    Bit16u *eg_out = chip->eg_out[slot];
+    Bit32u l;
+    for (l = 0; l < LANES; l++)
+    {
+        Bit16u level;
+
+        level = chip->eg_level[slot][l];
+
+        if (chip->eg_ssg_inv[slot][l])
+        {
+            /* Inverse */
+            level = 512 - level;
+        }
+        if (chip->mode_test_21[5][l])
+        {
+            level = 0;
+        }
+        level &= 0x3ff;
+
+        /* Apply AM LFO */
+        level += chip->eg_lfo_am[l];
+
+        /* Apply TL */
+        if (!(chip->mode_csm[l] && ch3))
+        {
+            level += chip->eg_tl[0][l] << 3;
+        }
+        if (level > 0x3ff)
+        {
+            level = 0x3ff;
+        }
+        eg_out[l] = level;
+    }
+}
+
+static void NOPN2L_UpdateLFO(ym3438_lanes_t *chip)
+{
+    Bit32u l;
+    for (l = 0; l < LANES; l++)
+    {
+        Bit32u cyc = lfo_cycles[chip->lfo_freq[l]];
+        if ((chip->lfo_quotient[l] & cyc) == cyc)
+        {
+            chip->lfo_quotient[l] = 0;
+            chip->lfo_cnt[l]++;
+        }
+        else
+        {
+            chip->lfo_quotient[l] += chip->lfo_inc[l];
+        }
+        chip->lfo_cnt[l] &= chip->lfo_en[l];
+    }
+}
+
+static void NOPN2L_FMPrepare(ym3438_lanes_t *chip)
+{
+    Bit32u slot = (chip->cycles + 6) % 24;
+    Bit32u channel = chip->channel;
+    Bit32u op = slot / 6;
+    Bit32u prevslot = (chip->cycles + 18) % 24;
+    Bit32u l;
+
+    for (l = 0; l < LANES; l++)
+    {
+        Bit8u connect = chip->connect[channel][l];
+        Bit16s mod, mod1, mod2;
+
+        /* Calculate modulation */
+        mod1 = mod2 = 0;
+
+        if (fm_algorithm[op][0][connect])
+        {
+            mod2 |= chip->fm_op1[channel][0][l];
+        }
+        if (fm_algorithm[op][1][connect])
+        {
+            mod1 |= chip->fm_op1[channel][1][l];
+        }
+        if (fm_algorithm[op][2][connect])
+        {
+            mod1 |= chip->fm_op2[channel][l];
+        }
+        if (fm_algorithm[op][3][connect])
+        {
+            mod2 |= chip->fm_out[prevslot][l];
+        }
+        if (fm_algorithm[op][4][connect])
+        {
+            mod1 |= chip->fm_out[prevslot][l];
+        }
+        mod = mod1 + mod2;
+        if (op == 0)
+        {
+            /* Feedback */
+            mod = mod >> (10 - chip->fb[channel][l]);
+            if (!chip->fb[channel][l])
+            {
+                mod = 0;
+            }
+        }
+        else
+        {
+            mod >>= 1;
+        }
+        chip->fm_mod[slot][l] = mod;
+    }
+
+    slot = (chip->cycles + 18) % 24;
+    /* OP1 */
+    if (slot / 6 == 0)
+    {
+        for (l = 0; l < LANES; l++)
+        {
+            chip->fm_op1[channel][1][l] = chip->fm_op1[channel][0][l];
+            chip->fm_op1[channel][0][l] = chip->fm_out[slot][l];
+        }
+    }
+    /* OP2 */
+    if (slot / 6 == 2)
+    {
+        for (l = 0; l < LANES; l++)
+        {
+            chip->fm_op2[channel][l] = chip->fm_out[slot][l];
+        }
+    }
+}
+
+static void NOPN2L_ChGenerate(ym3438_lanes_t *chip)
+{
+    Bit32u slot = (chip->cycles + 18) % 24;
+    Bit32u channel = chip->channel;
+    Bit32u op = slot / 6;
+    Bit32u l;
+    for (l = 0; l < LANES; l++)
+    {
+        Bit32u test_dac = chip->mode_test_2c[5][l];
+        Bit16s acc = chip->ch_acc[channel][l];
+        Bit16s add = test_dac;
+        Bit16s sum = 0;
+        if (op == 0 && !test_dac)
+        {
+            acc = 0;
+        }
+        if (fm_algorithm[op][5][chip->connect[channel][l]] && !test_dac)
+        {
+            add += chip->fm_out[slot][l] >> 5;
+        }
+        sum = acc + add;
+        /* Clamp */
+        if (sum > 255)
+        {
+            sum = 255;
+        }
+        else if(sum < -256)
+        {
+            sum = -256;
+        }
+
+        if (op == 0 || test_dac)
+        {
+            chip->ch_out[channel][l] = chip->ch_acc[channel][l];
+        }
+        chip->ch_acc[channel][l] = sum;
+    }
+}
+
+static void NOPN2L_ChOutput(ym3438_lanes_t *chip)
+{
+    Bit32u cycles = chip->cycles;
+    Bit32u channel = chip->channel;
+    Bit32u l;
+    if (cycles < 12)
+    {
+        /* Ch 4,5,6 */
+        channel++;
+    }
+    for (l = 0; l < LANES; l++)
+    {
+        Bit32u test_dac = chip->mode_test_2c[5][l];
+        Bit16s out;
+        Bit16s sign;
+        Bit32u out_en;
+        chip->ch_read[l] = chip->ch_lock[l];
+        if ((cycles & 3) == 0)
+        {
+            if (!test_dac)
+            {
+                /* Lock value */
+                chip->ch_lock[l] = chip->ch_out[channel][l];
+            }
+            chip->ch_lock_l[l] = chip->pan_l[channel][l];
+            chip->ch_lock_r[l] = chip->pan_r[channel][l];
+        }
+        /* Ch 6 */
+        if (((cycles >> 2) == 1 && chip->dacen[l]) || test_dac)
+        {
+            out = (Bit16s)chip->dacdata[l];
+            out <<= 7;
+            out >>= 7;
+        }
+        else
+        {
+            out = chip->ch_lock[l];
+        }
+        chip->mol[l] = 0;
+        chip->mor[l] = 0;
+
+        if (chip->chip_type & ym3438_mode_ym2612)
+        {
+            out_en = ((cycles & 3) == 3) || test_dac;
+            /* YM2612 DAC emulation(not verified) */
+            sign = out >> 8;
+            if (out >= 0)
+            {
+                out++;
+                sign++;
+            }
+            if (chip->ch_lock_l[l] && out_en)
+            {
+                chip->mol[l] = out;
+            }
+            else
+            {
+                chip->mol[l] = sign;
+            }
+            if (chip->ch_lock_r[l] && out_en)
+            {
+                chip->mor[l] = out;
+            }
+            else
+            {
+                chip->mor[l] = sign;
+            }
+            /* Amplify signal */
+            chip->mol[l] *= 3;
+            chip->mor[l] *= 3;
+        }
+        else
+        {
+            out_en = ((cycles & 3) != 0) || test_dac;
+            if (chip->ch_lock_l[l] && out_en)
+            {
+                chip->mol[l] = out;
+            }
+            if (chip->ch_lock_r[l] && out_en)
+            {
+                chip->mor[l] = out;
+            }
+        }
+    }
+}
+
+static void NOPN2L_FMGenerate(ym3438_lanes_t *chip)
+{
+    Bit32u slot = (chip->cycles + 19) % 24;
+    Bit32u l;
+    for (l = 0; l < LANES; l++)
+    {
+        /* Calculate phase */
+        Bit16u phase = (chip->fm_mod[slot][l] + (chip->pg_phase[slot][l] >> 10)) & 0x3ff;
+        Bit16u quarter;
+        Bit16u level;
+        Bit16s output;
+        Bit16s test = chip->mode_test_21[4][l] << 13;
+        if (phase & 0x100)
+        {
+            quarter = (phase ^ 0xff) & 0xff;
+        }
+        else
+        {
+            quarter = phase & 0xff;
+        }
+        level = logsinrom[quarter];
+        /* Apply envelope */
+        level += chip->eg_out[slot][l] << 2;
+        /* Transform */
+        if (level > 0x1fff)
+        {
+            level = 0x1fff;
+        }
+        output = ((exprom[(level & 0xff) ^ 0xff] | 0x400) << 2) >> (level >> 8);
+        if (phase & 0x200)
+        {
+            output = ((~output) ^ test) + 1;
+        }
+        else
+        {
+            output = output ^ test;
+        }
+        output <<= 2;
+        output >>= 2;
+        chip->fm_out[slot][l] = output;
+    }
+}
+
+static void NOPN2L_DoTimerA(ym3438_lanes_t *chip)
+{
+    Bit32u l;
+    for (l = 0; l < LANES; l++)
+    {
+        Bit16u time;
+        Bit8u load;
+        load = chip->timer_a_overflow[l];
+        if (chip->cycles == 2)
+        {
+            /* Lock load value */
+            load |= (!chip->timer_a_load_lock[l] && chip->timer_a_load[l]);
+            chip->timer_a_load_lock[l] = chip->timer_a_load[l];
+            if (chip->mode_csm[l])
+            {
+                /* CSM KeyOn */
+                chip->mode_kon_csm[l] = load;
+            }
+            else
+            {
+                chip->mode_kon_csm[l] = 0;
+            }
+        }
+        /* Load counter */
+        if (chip->timer_a_load_latch[l])
+        {
+            time = chip->timer_a_reg[l];
+        }
+        else
+        {
+            time = chip->timer_a_cnt[l];
+        }
+        chip->timer_a_load_latch[l] = load;
+        /* Increase counter */
+        if ((chip->cycles == 1 && chip->timer_a_load_lock[l]) || chip->mode_test_21[2][l])
+        {
+            time++;
+        }
+        /* Set overflow flag */
+        if (chip->timer_a_reset[l])
+        {
+            chip->timer_a_reset[l] = 0;
+            chip->timer_a_overflow_flag[l] = 0;
+        }
+        else
+        {
+            chip->timer_a_overflow_flag[l] |= chip->timer_a_overflow[l] & chip->timer_a_enable[l];
+        }
+        chip->timer_a_overflow[l] = (time >> 10);
+        chip->timer_a_cnt[l] = time & 0x3ff;
+    }
+}
+
+static void NOPN2L_DoTimerB(ym3438_lanes_t *chip)
+{
+    Bit32u l;
+    for (l = 0; l < LANES; l++)
+    {
+        Bit16u time;
+        Bit8u load;
+        load = chip->timer_b_overflow[l];
+        if (chip->cycles == 2)
+        {
+            /* Lock load value */
+            load |= (!chip->timer_b_load_lock[l] && chip->timer_b_load[l]);
+            chip->timer_b_load_lock[l] = chip->timer_b_load[l];
+        }
+        /* Load counter */
+        if (chip->timer_b_load_latch[l])
+        {
+            time = chip->timer_b_reg[l];
+        }
+        else
+        {
+            time = chip->timer_b_cnt[l];
+        }
+        chip->timer_b_load_latch[l] = load;
+        /* Increase counter */
+        if (chip->cycles == 1)
+        {
+            chip->timer_b_subcnt[l]++;
+        }
+        if ((chip->timer_b_subcnt[l] == 0x10 && chip->timer_b_load_lock[l]) || chip->mode_test_21[2][l])
+        {
+            time++;
+        }
+        chip->timer_b_subcnt[l] &= 0x0f;
+        /* Set overflow flag */
+        if (chip->timer_b_reset[l])
+        {
+            chip->timer_b_reset[l] = 0;
+            chip->timer_b_overflow_flag[l] = 0;
+        }
+        else
+        {
+            chip->timer_b_overflow_flag[l] |= chip->timer_b_overflow[l] & chip->timer_b_enable[l];
+        }
+        chip->timer_b_overflow[l] = (time >> 8);
+        chip->timer_b_cnt[l] = time & 0xff;
+    }
+}
+
+static void NOPN2L_KeyOn(ym3438_lanes_t *chip)
+{
+    Bit32u slot = chip->cycles;
+    Bit32u chan = chip->channel;
+    Bit32u l;
+    for (l = 0; l < LANES; l++)
+    {
+        /* Key On */
+        chip->eg_kon_latch[slot][l] = chip->mode_kon[slot][l];
+        chip->eg_kon_csm[slot][l] = 0;
+        if (chan == 2 && chip->mode_kon_csm[l])
+        {
+            /* CSM Key On */
+            chip->eg_kon_latch[slot][l] = 1;
+            chip->eg_kon_csm[slot][l] = 1;
+        }
+        if (slot == chip->mode_kon_channel[l])
+        {
+            /* OP1 */
+            chip->mode_kon[chan][l] = chip->mode_kon_operator[0][l];
+            /* OP2 */
+            chip->mode_kon[chan + 12][l] = chip->mode_kon_operator[1][l];
+            /* OP3 */
+            chip->mode_kon[chan + 6][l] = chip->mode_kon_operator[2][l];
+            /* OP4 */
+            chip->mode_kon[chan + 18][l] = chip->mode_kon_operator[3][l];
+        }
+    }
+}
+
+static void NOPN2L_Reset(ym3438_lanes_t *chip, Bit32u clock, Bit32u rate)
+{
+    Bit32u i;
+    Bit32u l;
+    memset(chip, 0, sizeof(ym3438_lanes_t));
+    chip->clock = clock;
+    chip->smplRate = rate;
+    for (l = 0; l < LANES; l++)
+    {
+        for (i = 0; i < 24; i++)
+        {
+            chip->eg_out[i][l] = 0x3ff;
+            chip->eg_level[i][l] = 0x3ff;
+            chip->eg_state[i][l] = eg_num_release;
+            chip->multi[i][l] = 1;
+        }
+        for (i = 0; i < 6; i++)
+        {
+            chip->pan_l[i][l] = 1;
+            chip->pan_r[i][l] = 1;
+        }
+    }
+    // ratio: sampleRate / (clock / 144) * (1 << resamplerFraction)
+    chip->rateratio = (Bit32s)((((Bit64u)144 * chip->smplRate) << RSM_FRAC) / chip->clock);
+    if (abs(chip->rateratio - (1 << RSM_FRAC)) <= 1)
+        chip->rateratio = (1 << RSM_FRAC);
+}
+
+static void NOPN2L_Clock(ym3438_lanes_t *chip)
+{
+    Bit32u slot = chip->cycles;
+    Bit8u eg_lock = (chip->cycles == 1 && chip->eg_quotient == 2);
+    Bit32u l;
+    Bit32u i;
+
+    chip->eg_cycle++;
+    for (l = 0; l < LANES; l++)
+    {
+        chip->lfo_inc[l] = chip->mode_test_21[1][l];
+        chip->pg_read[l] >>= 1;
+        chip->eg_read[1][l] >>= 1;
+        /* Lock envelope generator timer value */
+        if (eg_lock)
+        {
+            if (chip->eg_cycle_stop[l])
+            {
+                chip->eg_shift_lock[l] = 0;
+            }
+            else
+            {
+                chip->eg_shift_lock[l] = chip->eg_shift[l] + 1;
+            }
+            chip->eg_timer_low_lock[l] = chip->eg_timer[l] & 0x03;
+        }
+    }
+    /* Cycle specific functions */
+    switch (chip->cycles)
+    {
+    case 0:
+        for (l = 0; l < LANES; l++)
+        {
+            chip->lfo_pm[l] = chip->lfo_cnt[l] >> 2;
+            if (chip->lfo_cnt[l] & 0x40)
+            {
+                chip->lfo_am[l] = chip->lfo_cnt[l] & 0x3f;
+            }
+            else
+            {
+                chip->lfo_am[l] = chip->lfo_cnt[l] ^ 0x3f;
+            }
+            chip->lfo_am[l] <<= 1;
+        }
+        break;
+    case 1:
+        chip->eg_quotient++;
+        chip->eg_quotient %= 3;
+        chip->eg_cycle = 0;
+        for (l = 0; l < LANES; l++)
+        {
+            chip->eg_cycle_stop[l] = 1;
+            chip->eg_shift[l] = 0;
+            chip->eg_timer_inc[l] |= chip->eg_quotient >> 1;
+            chip->eg_timer[l] = chip->eg_timer[l] + chip->eg_timer_inc[l];
+            chip->eg_timer_inc[l] = chip->eg_timer[l] >> 12;
+            chip->eg_timer[l] &= 0xfff;
+        }
+        break;
+    case 2:
+        for (l = 0; l < LANES; l++)
+        {
+            chip->pg_read[l] = chip->pg_phase[21][l] & 0x3ff;
+            chip->eg_read[1][l] = chip->eg_out[0][l];
+        }
+        break;
+    case 13:
+        chip->eg_cycle = 0;
+        for (l = 0; l < LANES; l++)
+        {
+            chip->eg_cycle_stop[l] = 1;
+            chip->eg_shift[l] = 0;
+            chip->eg_timer[l] = chip->eg_timer[l] + chip->eg_timer_inc[l];
+            chip->eg_timer_inc[l] = chip->eg_timer[l] >> 12;
+            chip->eg_timer[l] &= 0xfff;
+        }
+        break;
+    case 23:
+        for (l = 0; l < LANES; l++)
+        {
+            chip->lfo_inc[l] |= 1;
+        }
+        break;
+    }
+    for (l = 0; l < LANES; l++)
+    {
+        chip->eg_timer[l] &= ~(chip->mode_test_21[5][l] << chip->eg_cycle);
+        if (((chip->eg_timer[l] >> chip->eg_cycle) | (chip->pin_test_in[l] & chip->eg_custom_timer[l])) & chip->eg_cycle_stop[l])
+        {
+            chip->eg_shift[l] = chip->eg_cycle;
+            chip->eg_cycle_stop[l] = 0;
+        }
+    }
+
+    NOPN2L_DoIO(chip);
+
+    NOPN2L_DoTimerA(chip);
+    NOPN2L_DoTimerB(chip);
+    NOPN2L_KeyOn(chip);
+
+    NOPN2L_ChOutput(chip);
+    NOPN2L_ChGenerate(chip);
+
+    NOPN2L_FMPrepare(chip);
+    NOPN2L_FMGenerate(chip);
+
+    NOPN2L_PhaseGenerate(chip);
+    NOPN2L_PhaseCalcIncrement(chip);
+
+    NOPN2L_EnvelopeADSR(chip);
+    NOPN2L_EnvelopeGenerate(chip);
+    NOPN2L_EnvelopeSSGEG(chip);
+    NOPN2L_EnvelopePrepare(chip);
+
+    /* Prepare fnum & block */
+    i = (chip->channel + 1) % 6;
+    for (l = 0; l < LANES; l++)
+    {
+        Bit32u ch3i = 0xff;
+        if (chip->mode_ch3[l])
+        {
+            /* Channel 3 special mode */
+            switch (slot)
+            {
+            case 1: /* OP1 */
+                ch3i = 1;
+                break;
+            case 7: /* OP3 */
+                ch3i = 0;
+                break;
+            case 13: /* OP2 */
+                ch3i = 2;
+                break;
+            case 19: /* OP4 */
+            default:
+                break;
+            }
+        }
+        if (ch3i != 0xff)
+        {
+            chip->pg_fnum[l] = chip->fnum_3ch[ch3i][l];
+            chip->pg_block[l] = chip->block_3ch[ch3i][l];
+            chip->pg_kcode[l] = chip->kcode_3ch[ch3i][l];
+        }
+        else
+        {
+            chip->pg_fnum[l] = chip->fnum[i][l];
+            chip->pg_block[l] = chip->block[i][l];
+            chip->pg_kcode[l] = chip->kcode[i][l];
+        }
+    }
+
+    NOPN2L_UpdateLFO(chip);
+    NOPN2L_DoRegWrite(chip);
+    chip->cycles = (chip->cycles + 1) % 24;
+    chip->channel = chip->cycles % 6;
+
+    for (l = 0; l < LANES; l++)
+    {
+        if (chip->status_time[l])
+            chip->status_time[l]--;
+    }
+}
+
+static void NOPN2L_Write(ym3438_lanes_t *chip, Bit32u lane, Bit32u port, Bit8u data)
+{
+    port &= 3;
+    chip->write_data[lane] = ((port << 7) & 0x100) | data;
+    if (port & 1)
+    {
+        /* Data */
+        chip->write_d[lane] |= 1;
+    }
+    else
+    {
+        /* Address */
+        chip->write_a[lane] |= 1;
+    }
+}
+
+static Bit8u NOPN2L_Read(ym3438_lanes_t *chip, Bit32u l, Bit32u port)
+{
+    if ((port & 3) == 0 || (chip->chip_type & ym3438_mode_readmode))
+    {
+        if (chip->mode_test_21[6][l])
+        {
+            /* Read test data */
+            Bit32u slot = (chip->cycles + 18) % 24;
+            Bit16u testdata = ((chip->pg_read[l] & 0x01) << 15)
+                            | ((chip->eg_read[chip->mode_test_21[0][l]][l] & 0x01) << 14);
+            if (chip->mode_test_2c[4][l])
+            {
+                testdata |= chip->ch_read[l] & 0x1ff;
+            }
+            else
+            {
+                testdata |= chip->fm_out[slot][l] & 0x3fff;
+            }
+            if (chip->mode_test_21[7][l])
+            {
+                chip->status[l] = testdata & 0xff;
+            }
+            else
+            {
+                chip->status[l] = testdata >> 8;
+            }
+        }
+        else
+        {
+            chip->status[l] = (chip->busy[l] << 7) | (chip->timer_b_overflow_flag[l] << 1)
+                 | chip->timer_a_overflow_flag[l];
+        }
+        if (chip->chip_type & ym3438_mode_ym2612)
+        {
+            chip->status_time[l] = 300000;
+        }
+        else
+        {
+            chip->status_time[l] = 40000000;
+        }
+    }
+    if (chip->status_time[l])
+    {
+        return chip->status[l];
+    }
+    return 0;
+}
+
+static void NOPN2L_WriteBuffered(ym3438_lanes_t *chip, Bit32u l, UINT8 port, UINT8 data)
+{
+    opn2_writebuf *writebuf = chip->writebuf[l];
+    Bit64u time1, time2;
+
+    if (writebuf[chip->writebuf_last[l]].port & 0x04)
+    {
+        // The buffer is full. The scalar core clocks the chip until the oldest write is due,
+        // but the lanes can't be clocked separately. So the write is just sent early.
+        NOPN2L_Write(chip, l, writebuf[chip->writebuf_last[l]].port & 0X03,
+                     writebuf[chip->writebuf_last[l]].data);
+        writebuf[chip->writebuf_last[l]].port &= 0x03;
+        chip->writebuf_cur[l] = (chip->writebuf_last[l] + 1) % NOPN_WRITEBUF_SIZE;
+    }
+
+    writebuf[chip->writebuf_last[l]].port = (port & 0x03) | 0x04;
+    writebuf[chip->writebuf_last[l]].data = data;
+    time1 = chip->writebuf_lasttime[l] + NOPN_WRITEBUF_DELAY;
+    time2 = chip->writebuf_samplecnt;
+
+    if (time1 < time2)
+    {
+        time1 = time2;
+    }
+
+    writebuf[chip->writebuf_last[l]].time = time1;
+    chip->writebuf_lasttime[l] = time1;
+    chip->writebuf_last[l] = (chip->writebuf_last[l] + 1) % NOPN_WRITEBUF_SIZE;
+}
+
+static void NOPN2L_GenerateResampled(ym3438_lanes_t *chip, Bit32s buf[2][LANES])
+{
+    Bit32u i;
+    Bit32u l;
+    Bit32u mutech;
+    Bit32u mute[LANES];
+
+    while (chip->samplecnt >= chip->rateratio)
+    {
+        for (l = 0; l < LANES; l++)
+        {
+            chip->oldsamples[0][l] = chip->samples[0][l];
+            chip->oldsamples[1][l] = chip->samples[1][l];
+            chip->samples[0][l] = chip->samples[1][l] = 0;
+        }
+        for (i = 0; i < 24; i++)
+        {
+            switch (chip->cycles >> 2)
+            {
+            case 0: // Ch 2
+                mutech = 1;
+                break;
+            case 1: // Ch 6, DAC
+                mutech = 5;
+                break;
+            case 2: // Ch 4
+                mutech = 3;
+                break;
+            case 3: // Ch 1
+                mutech = 0;
+                break;
+            case 4: // Ch 5
+                mutech = 4;
+                break;
+            case 5: // Ch 3
+                mutech = 2;
+                break;
+            default:
+                mutech = 0xff;
+                break;
+            }
+            for (l = 0; l < LANES; l++)
+            {
+                if (mutech == 5)
+                    mute[l] = chip->mute[5 + chip->dacen[l]][l];
+                else
+                    mute[l] = (mutech != 0xff) ? chip->mute[mutech][l] : 0;
+            }
+            NOPN2L_Clock(chip);
+            for (l = 0; l < LANES; l++)
+            {
+                if (!mute[l])
+                {
+                    chip->samples[0][l] += chip->mol[l];
+                    chip->samples[1][l] += chip->mor[l];
+                }
+            }
+
+            for (l = 0; l < LANES; l++)
+            {
+                opn2_writebuf *writebuf = chip->writebuf[l];
+                while (writebuf[chip->writebuf_cur[l]].time <= chip->writebuf_samplecnt)
+                {
+                    if (!(writebuf[chip->writebuf_cur[l]].port & 0x04))
+                    {
+                        break;
+                    }
+                    writebuf[chip->writebuf_cur[l]].port &= 0x03;
+                    NOPN2L_Write(chip, l, writebuf[chip->writebuf_cur[l]].port,
+                                 writebuf[chip->writebuf_cur[l]].data);
+                    chip->writebuf_cur[l] = (chip->writebuf_cur[l] + 1) % NOPN_WRITEBUF_SIZE;
+                }
+            }
+            chip->writebuf_samplecnt++;
+        }
+        for (l = 0; l < LANES; l++)
+        {
+            if(!chip->use_filter)
+            {
+                chip->samples[0][l] *= 11;
+                chip->samples[1][l] *= 11;
+            }
+            else
+            {
+                chip->samples[0][l] = chip->oldsamples[0][l] + FILTER_CUTOFF_I * (chip->samples[0][l]*(11+1) - chip->oldsamples[0][l]);
+                chip->samples[1][l] = chip->oldsamples[1][l] + FILTER_CUTOFF_I * (chip->samples[1][l]*(11+1) - chip->oldsamples[1][l]);
+            }
+        }
+        chip->samplecnt -= chip->rateratio;
+    }
+    for (l = 0; l < LANES; l++)
+    {
+        buf[0][l] = (Bit32s)((chip->oldsamples[0][l] * (chip->rateratio - chip->samplecnt)
+                            + chip->samples[0][l] * chip->samplecnt) / chip->rateratio);
+        buf[1][l] = (Bit32s)((chip->oldsamples[1][l] * (chip->rateratio - chip->samplecnt)
+                            + chip->samples[1][l] * chip->samplecnt) / chip->rateratio);
+    }
+    chip->samplecnt += 1 << RSM_FRAC;
+}
+
+
+void* nukedopn2l_init(UINT32 clock, UINT32 rate)
+{
+    ym3438_lanes_t *opn2;
+
+    opn2 = (ym3438_lanes_t*)calloc(1, sizeof(ym3438_lanes_t));
+    if (opn2 == NULL)
+        return NULL;
+
+    opn2->clock = clock;
+    opn2->smplRate = rate; // save for reset
+
+    return opn2;
+}
+
+void nukedopn2l_shutdown(void *chip)
+{
+    free(chip);
+}
+
+void nukedopn2l_reset_chip(void *chip)
+{
+    ym3438_lanes_t* opn2 = (ym3438_lanes_t*)chip;
+    Bit32u mute[7][LANES];
+    Bit32u type;
+    Bit32u filter;
+
+    memcpy(mute, opn2->mute, sizeof(mute));
+    type = opn2->chip_type;
+    filter = opn2->use_filter;
+
+    NOPN2L_Reset(opn2, opn2->clock, opn2->smplRate);
+
+    memcpy(opn2->mute, mute, sizeof(mute));
+    opn2->chip_type = type;
+    opn2->use_filter = filter;
+}
+
+void nukedopn2l_set_options(void *chip, UINT32 flags)
+{
+    ym3438_lanes_t* opn2 = (ym3438_lanes_t*)chip;
+    Bit32u type;
+    switch ((flags >> 4) & 0x03)
+    {
+    case 0x00: // YM2612
+    default:
+        type = ym3438_mode_ym2612;
+        break;
+    case 0x01: // ASIC YM3438
+        type = ym3438_mode_readmode;
+        break;
+    case 0x02: // Discrete YM3438
+        type = ym3438_mode_ym2612 | ym3438_mode_readmode;
+        break;
+    case 0x03: // YM2612 + MD1 filter (temporary hack)
+        type = ym3438_mode_ym2612 | 0x10;
+        break;
+    }
+    opn2->chip_type = type & 0x0F;
+    opn2->use_filter = type & 0x10;
+}
+
+void nukedopn2l_set_mutemask(void *chip, UINT32 lane, UINT32 mute)
+{
+    ym3438_lanes_t* opn2 = (ym3438_lanes_t*)chip;
+    Bit32u i;
+    if (lane >= LANES)
+        return;
+    for (i = 0; i < 7; i++)
+    {
+        opn2->mute[i][lane] = (mute >> i) & 0x01;
+    }
+}
+
+void nukedopn2l_write(void *chip, UINT32 lane, UINT8 port, UINT8 data)
+{
+    if (lane >= LANES)
+        return;
+    NOPN2L_WriteBuffered((ym3438_lanes_t *)chip, lane, port, data);
+}
+
+UINT8 nukedopn2l_read(void *chip, UINT32 lane, UINT8 port)
+{
+    if (lane >= LANES)
+        return 0x00;
+    return NOPN2L_Read((ym3438_lanes_t *)chip, lane, port);
+}
+
+void nukedopn2l_update(void *chip, UINT32 numsamples, DEV_SMPL **sndptr)
+{
+    ym3438_lanes_t* opn2 = (ym3438_lanes_t*)chip;
+    Bit32u i;
+    Bit32u l;
+    Bit32s buffer[2][LANES];
+
+    for (i = 0; i < numsamples; i++)
+    {
+        NOPN2L_GenerateResampled(opn2, buffer);
+        for (l = 0; l < LANES; l++)
+        {
+            if (sndptr[l * 2 + 0] != NULL)
+                sndptr[l * 2 + 0][i] = buffer[0][l];
+            if (sndptr[l * 2 + 1] != NULL)
+                sndptr[l * 2 + 1][i] = buffer[1][l];
+        }
+    }
+}
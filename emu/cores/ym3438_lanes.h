@@ -0,0 +1,24 @@
+#ifndef __YM3438_LANES_H__
+#define __YM3438_LANES_H__
+
+#include "../../stdtype.h"
+#include "../snddef.h"
+
+// Lane-parallel Nuked OPN2: runs NOPN2L_LANES independent YM2612/YM3438 instances in lockstep.
+// The state is stored as structure-of-arrays with one SIMD lane per instance, so that
+// the per-cycle logic is executed for all instances at once.
+// All lanes share clock, sample rate and chip type. The output of each lane is identical
+// to the one of the scalar core (ym3438.c) that gets the same writes.
+#define NOPN2L_LANES	8
+
+void* nukedopn2l_init(UINT32 clock, UINT32 rate);
+void nukedopn2l_shutdown(void *chip);
+void nukedopn2l_reset_chip(void *chip);	// resets all lanes
+void nukedopn2l_set_options(void *chip, UINT32 flags);
+void nukedopn2l_set_mutemask(void *chip, UINT32 lane, UINT32 mute);
+void nukedopn2l_write(void *chip, UINT32 lane, UINT8 port, UINT8 data);
+UINT8 nukedopn2l_read(void *chip, UINT32 lane, UINT8 port);
+// renders all lanes, sndptr[lane * 2 + 0] = left, sndptr[lane * 2 + 1] = right (NULL = discard)
+void nukedopn2l_update(void *chip, UINT32 numsamples, DEV_SMPL **sndptr);
+
+#endif	// __YM3438_LANES_H__
@@ -64,6 +64,7 @@ differences between OPL2 and OPL3 shown in datasheets:
 #include "../../stdtype.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "ymf262.h"
 
 #ifdef _MSC_VER
@@ -570,9 +571,6 @@ static const INT8 lfo_pm_table[8*8*2] = {
 };
 
 
-/* lock level of common table */
-static int num_lock = 0;
-
 /* work table */
 #define SLOT7_1 (&chip->P_CH[7].SLOT[SLOT1])
 #define SLOT7_2 (&chip->P_CH[7].SLOT[SLOT2])
@@ -581,7 +579,7 @@ static int num_lock = 0;
 
 
 
-static UINT8 tablesInit = 0;
+static EMU_ONCE tablesOnce = EMU_ONCE_INIT;
 
 /* status set and IRQ handling */
 INLINE void OPL3_STATUS_SET(OPL3 *chip,int flag)
@@ -1109,16 +1107,12 @@ INLINE void chan_calc_rhythm( OPL3 *chip, OPL3_CH *CH, unsigned int noise )
 
 
 /* generic table initialize */
-static int init_tables(void)
+static void init_tables(void)
 {
 	signed int i,x;
 	signed int n;
 	double o,m;
 
-	if (tablesInit)
-		return 1;
-	tablesInit = 1;
-
 	for (x=0; x<TL_RES_LEN; x++)
 	{
 		m = (1<<16) / pow(2, (x+1) * (ENV_STEP/4.0) / 8.0);
@@ -1262,12 +1256,6 @@ static int init_tables(void)
 		//logerror("YMF262.C: sin7[%4i]= %4i (tl_tab value=%5i)\n", i, sin_tab[7*SIN_LEN+i], tl_tab[sin_tab[7*SIN_LEN+i]] );
 	}
 	/*logerror("YMF262.C: ENV_QUIET= %08x (dec*8=%i)\n", ENV_QUIET, ENV_QUIET*8 );*/
-
-	return 1;
-}
-
-static void OPLCloseTable( void )
-{
 }
 
 
@@ -2204,32 +2192,6 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 	}
 }
 
-/* lock/unlock for common table */
-static int OPL3_LockTable()
-{
-	num_lock++;
-	if(num_lock>1) return 0;
-
-	/* first time */
-
-	if( !init_tables() )
-	{
-		num_lock--;
-		return -1;
-	}
-
-	return 0;
-}
-
-static void OPL3_UnLockTable(void)
-{
-	if(num_lock) num_lock--;
-	if(num_lock) return;
-
-	/* last time */
-	OPLCloseTable();
-}
-
 static void OPL3ResetChip(OPL3 *chip)
 {
 	int c,s;
@@ -2281,7 +2243,7 @@ static OPL3 *OPL3Create(UINT32 clock, UINT32 rate, int type)
 {
 	OPL3 *chip;
 
-	if (OPL3_LockTable() == -1) return NULL;
+	Emu_CallOnce(&tablesOnce, init_tables);
 
 	/* allocate memory block */
 	chip = (OPL3 *)calloc(1, sizeof(OPL3));
@@ -2304,7 +2266,6 @@ static OPL3 *OPL3Create(UINT32 clock, UINT32 rate, int type)
 /* Destroy one of virtual YMF262 */
 static void OPL3Destroy(OPL3 *chip)
 {
-	OPL3_UnLockTable();
 	free(chip);
 }
 
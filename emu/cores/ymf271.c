@@ -1828,7 +1828,7 @@ static UINT8 device_start_ymf271(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	YMF271Chip *chip;
 	UINT32 rate;
 
-	chip = (YMF271Chip *)calloc(1, sizeof(YMF271Chip));
+	chip = (YMF271Chip *)DevData_Alloc(cfg->memArena, sizeof(YMF271Chip));
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -1874,7 +1874,7 @@ void device_stop_ymf271(void *info)
 		free(chip->lut_alfo[i]);
 	
 	free(chip->mix_buffer);
-	free(chip);
+	DevData_Free(chip);
 	
 	return;
 }
@@ -104,6 +104,7 @@
 #include "../SoundDevs.h"
 #include "../SoundEmu.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "ymf278b.h"
 
 
@@ -413,7 +414,7 @@ static const UINT8 am_depth[8] = {
 };
 
 
-static UINT8 tablesInit = 0;
+static EMU_ONCE tablesOnce = EMU_ONCE_INIT;
 
 // Sign extend a 4-bit value to 8-bit int
 // require: x in range [0..15]
@@ -1400,13 +1401,35 @@ static void init_opl3_devinfo(DEV_INFO* devInf, const DEV_GEN_CFG* baseCfg)
 	return;
 }
 
+static void init_tables(void)
+{
+	UINT32 i;
+	
+	// Volume table (envelope levels)
+	for (i = 0x00; i < ENV_LEN; i ++)
+	{
+		if (i < MAX_ATT_INDEX)
+		{
+			int vol_mul = 0x80 - (i & 0x3F);	// 0x40 values per 6 db
+			int vol_shift = 7 + (i >> 6);		// approximation: -6 dB == divide by two (shift right)
+			vol_tab[i] = (0x8000 * vol_mul) >> vol_shift;
+		}
+		else
+		{
+			// OPL4 hardware seems to clip to silence here below -60 db.
+			vol_tab[i] = 0;
+		}
+	}
+	
+	return;
+}
+
 static UINT8 device_start_ymf278b(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 {
 	YMF278BChip *chip;
 	UINT32 rate;
-	UINT32 i;
 
-	chip = (YMF278BChip *)calloc(1, sizeof(YMF278BChip));
+	chip = (YMF278BChip *)DevData_Alloc(cfg->memArena, sizeof(YMF278BChip));
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -1426,26 +1449,7 @@ static UINT8 device_start_ymf278b(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 
 	chip->memadr = 0; // avoid UMR
 
-	if (! tablesInit)
-	{
-		tablesInit = 1;
-		
-		// Volume table (envelope levels)
-		for (i = 0x00; i < ENV_LEN; i ++)
-		{
-			if (i < MAX_ATT_INDEX)
-			{
-				int vol_mul = 0x80 - (i & 0x3F);	// 0x40 values per 6 db
-				int vol_shift = 7 + (i >> 6);		// approximation: -6 dB == divide by two (shift right)
-				vol_tab[i] = (0x8000 * vol_mul) >> vol_shift;
-			}
-			else
-			{
-				// OPL4 hardware seems to clip to silence here below -60 db.
-				vol_tab[i] = 0;
-			}
-		}
-	}
+	Emu_CallOnce(&tablesOnce, init_tables);
 
 	ymf278b_set_mute_mask(chip, 0x000000);
 
@@ -1462,7 +1466,7 @@ static void device_stop_ymf278b(void *info)
 	
 	free(chip->ram);
 	free(chip->rom);
-	free(chip);
+	DevData_Free(chip);
 	
 	return;
 }
@@ -39,6 +39,7 @@
 #include "../EmuCores.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../PcmCache.h"
 #include "ymz280b.h"
 
 static void update_irq_state_timer_common(void *param, int voicenum);
@@ -52,6 +53,7 @@ static void ymz280b_w(void *info, UINT8 offset, UINT8 data);
 static void ymz280b_alloc_rom(void* info, UINT32 memsize);
 static void ymz280b_write_rom(void *info, UINT32 offset, UINT32 length, const UINT8* data);
 
+static void ymz280b_set_options(void *info, UINT32 Flags);
 static void ymz280b_set_mute_mask(void *info, UINT32 MuteMask);
 
 
@@ -73,7 +75,7 @@ static DEV_DEF devDef =
 	device_reset_ymz280b,
 	ymz280b_update,
 	
-	NULL,	// SetOptionBits
+	ymz280b_set_options,
 	ymz280b_set_mute_mask,
 	NULL,	// SetPanning
 	NULL,	// SetSampleRateChangeCallback
@@ -134,6 +136,9 @@ struct YMZ280BVoice
 	INT16 curr_sample;      /* current sample target */
 	UINT8 irq_schedule;     /* 1 if the IRQ state is updated by timer */
 	UINT8 Muted;            /* used for muting */
+
+	PCM_CACHE_ENTRY *cache; /* decoded ADPCM data, NULL = decode from memory */
+	UINT32 cache_base;      /* position of the first cached sample, in nibbles */
 };
 
 typedef struct _ymz280b_state ymz280b_state;
@@ -166,6 +171,7 @@ struct _ymz280b_state
 	UINT8 *mem_base;                /* pointer to the base of the region */
 	UINT32 mem_size;
 	INT16 *scratch; // not having to use scratch memory would be nice, but it's required for resampling
+	PCM_CACHE *cache;
 };
 
 static void write_to_register(ymz280b_state *chip, UINT8 data);
@@ -174,9 +180,12 @@ static void write_to_register(ymz280b_state *chip, UINT8 data);
 /* step size index shift table */
 static const int index_scale[8] = { 0x0e6, 0x0e6, 0x0e6, 0x0e6, 0x133, 0x199, 0x200, 0x266 };
 
-/* lookup table for the precomputed difference */
-static int diff_lookup[16];
-static UINT8 lookup_init = 0x00;	/* lookup-table is initialized */
+/* lookup table for the precomputed difference: (nib & 0x07) * 2 + 1, negative when bit 3 is set */
+static const int diff_lookup[16] =
+{
+	 1,  3,  5,  7,  9,  11,  13,  15,
+	-1, -3, -5, -7, -9, -11, -13, -15
+};
 
 
 INLINE UINT8 ymz280b_read_memory(ymz280b_state *chip, UINT32 offset)
@@ -270,41 +279,63 @@ static void update_irq_state_timer_common(void *param, int voicenum)
 
 /**********************************************************************************************
 
-     compute_tables -- compute the difference tables
+     generate_adpcm -- general ADPCM decoding routine
 
 ***********************************************************************************************/
 
-static void compute_tables(void)
+INLINE void decode_adpcm(ymz280b_state *chip, struct YMZ280BVoice *voice, UINT32 position, INT32 *signal, INT32 *step)
 {
-	int nib;
-
-	if (lookup_init)
-		return;
+	UINT8 val;
 
-	/* loop over all nibbles and compute the difference */
-	for (nib = 0; nib < 16; nib++)
+	/* use the cached result, if there is one */
+	if (voice->cache != NULL && position - voice->cache_base < voice->cache->length)
 	{
-		int value = (nib & 0x07) * 2 + 1;
-		diff_lookup[nib] = (nib & 0x08) ? -value : value;
+		*signal = voice->cache->smpl[position - voice->cache_base];
+		*step = voice->cache->state[position - voice->cache_base];
+		return;
 	}
-	
-	lookup_init = 0x01;
-}
-
-
 
-/**********************************************************************************************
-
-     generate_adpcm -- general ADPCM decoding routine
+	val = ymz280b_read_memory(chip, position / 2) >> ((~position & 1) << 2);
+	*signal = (*signal * 254) / 256;
+	*signal += (*step * diff_lookup[val & 15]) / 8;
+
+	/* clamp to the maximum */
+	if (*signal > 32767)
+		*signal = 32767;
+	else if (*signal < -32768)
+		*signal = -32768;
+
+	/* adjust the step size and clamp */
+	*step = (*step * index_scale[val & 7]) >> 8;
+	if (*step > 0x6000)
+		*step = 0x6000;
+	else if (*step < 0x7f)
+		*step = 0x7f;
+
+	if (voice->cache != NULL)
+		PcmCache_Append(chip->cache, voice->cache, position - voice->cache_base, (INT16)*signal, (INT16)*step);
+}
 
-***********************************************************************************************/
+/* check whether the decoder state after a loop matches the cached data */
+INLINE UINT8 cache_state_valid(struct YMZ280BVoice *voice, UINT32 position, INT32 signal, INT32 step)
+{
+	UINT32 idx;
+
+	if (position < voice->cache_base)
+		return 0;
+	if (position == voice->cache_base)
+		return (signal == 0 && step == 0x7f);	/* initial state */
+	idx = position - voice->cache_base - 1;
+	if (idx >= voice->cache->length)
+		return 0;
+	return (voice->cache->smpl[idx] == signal && voice->cache->state[idx] == step);
+}
 
 static int generate_adpcm(ymz280b_state *chip, struct YMZ280BVoice *voice, INT16 *buffer, UINT32 samples)
 {
 	UINT32 position = voice->position;
 	INT32 signal = voice->signal;
 	INT32 step = voice->step;
-	UINT8 val;
 
 	/* two cases: first cases is non-looping */
 	if (!voice->looping)
@@ -313,22 +344,7 @@ static int generate_adpcm(ymz280b_state *chip, struct YMZ280BVoice *voice, INT16
 		while (samples)
 		{
 			/* compute the new amplitude and update the current step */
-			val = ymz280b_read_memory(chip, position / 2) >> ((~position & 1) << 2);
-			signal = (signal * 254) / 256;
-			signal += (step * diff_lookup[val & 15]) / 8;
-
-			/* clamp to the maximum */
-			if (signal > 32767)
-				signal = 32767;
-			else if (signal < -32768)
-				signal = -32768;
-
-			/* adjust the step size and clamp */
-			step = (step * index_scale[val & 7]) >> 8;
-			if (step > 0x6000)
-				step = 0x6000;
-			else if (step < 0x7f)
-				step = 0x7f;
+			decode_adpcm(chip, voice, position, &signal, &step);
 
 			/* output to the buffer, scaling by the volume */
 			*buffer++ = signal;
@@ -351,22 +367,7 @@ static int generate_adpcm(ymz280b_state *chip, struct YMZ280BVoice *voice, INT16
 		while (samples)
 		{
 			/* compute the new amplitude and update the current step */
-			val = ymz280b_read_memory(chip, position / 2) >> ((~position & 1) << 2);
-			signal = (signal * 254) / 256;
-			signal += (step * diff_lookup[val & 15]) / 8;
-
-			/* clamp to the maximum */
-			if (signal > 32767)
-				signal = 32767;
-			else if (signal < -32768)
-				signal = -32768;
-
-			/* adjust the step size and clamp */
-			step = (step * index_scale[val & 7]) >> 8;
-			if (step > 0x6000)
-				step = 0x6000;
-			else if (step < 0x7f)
-				step = 0x7f;
+			decode_adpcm(chip, voice, position, &signal, &step);
 
 			/* output to the buffer, scaling by the volume */
 			*buffer++ = signal;
@@ -387,6 +388,8 @@ static int generate_adpcm(ymz280b_state *chip, struct YMZ280BVoice *voice, INT16
 					signal = voice->loop_signal;
 					step = voice->loop_step;
 					voice->loop_count++;
+					if (voice->cache != NULL && ! cache_state_valid(voice, position, signal, step))
+						voice->cache = NULL;
 				}
 			}
 			if (position >= voice->stop)
@@ -703,13 +706,10 @@ static UINT8 device_start_ymz280b(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 {
 	ymz280b_state *chip;
 
-	chip = (ymz280b_state *)calloc(1, sizeof(ymz280b_state));
+	chip = (ymz280b_state *)DevData_Alloc(cfg->memArena, sizeof(ymz280b_state));
 	if (chip == NULL)
 		return 0xFF;
 
-	/* compute ADPCM tables */
-	compute_tables();
-
 	/* initialize the rest of the structure */
 	chip->master_clock = (double)cfg->clock / 384.0;
 	chip->rate = chip->master_clock * 2.0;
@@ -718,6 +718,7 @@ static UINT8 device_start_ymz280b(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	
 	chip->mem_size = 0x00;
 	chip->mem_base = NULL;
+	chip->cache = NULL;
 	chip->irq_handler = NULL;
 	chip->irq_param = NULL;
 	chip->ext_read_handler = NULL;
@@ -738,9 +739,11 @@ static UINT8 device_start_ymz280b(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 static void device_stop_ymz280b(void *info)
 {
 	ymz280b_state *chip = (ymz280b_state *)info;
+	if (chip->cache != NULL)
+		PcmCache_Deinit(chip->cache);
 	free(chip->mem_base);
 	free(chip->scratch);
-	free(chip);
+	DevData_Free(chip);
 	
 	return;
 }
@@ -772,6 +775,7 @@ static void device_reset_ymz280b(void *info)
 		voice->last_sample = 0;
 		voice->output_pos = FRAC_ONE;
 		voice->playing = 0;
+		voice->cache = NULL;
 	}
 	
 	return;
@@ -816,6 +820,16 @@ static void write_to_register(ymz280b_state *chip, UINT8 data)
 
 					/* if update_irq_state_timer is set, cancel it. */
 					voice->irq_schedule = 0;
+
+					/* samples started at the same address decode identically */
+					voice->cache = NULL;
+					if (chip->cache != NULL && voice->mode == 1)
+					{
+						UINT32 key[PCMCACHE_KEY_LEN] = {0};
+						key[0] = voice->start;
+						voice->cache = PcmCache_Get(chip->cache, key, 0);
+						voice->cache_base = voice->start;
+					}
 				}
 				else if (voice->keyon && !(data & 0x80))
 				{
@@ -825,6 +839,8 @@ static void write_to_register(ymz280b_state *chip, UINT8 data)
 					voice->irq_schedule = 0;
 				}
 				voice->keyon = (data & 0x80) >> 7;
+				if (voice->mode != 1)
+					voice->cache = NULL;	/* the ADPCM state isn't updated in PCM modes */
 				update_step(chip, voice);
 				break;
 
@@ -1028,6 +1044,20 @@ static void ymz280b_w(void *info, UINT8 offset, UINT8 data)
 		write_to_register(chip, data);
 }
 
+static void ymz280b_cache_clear(ymz280b_state *chip)
+{
+	int i;
+	
+	if (chip->cache == NULL)
+		return;
+	
+	for (i = 0; i < 8; i++)
+		chip->voice[i].cache = NULL;
+	PcmCache_Clear(chip->cache);
+	
+	return;
+}
+
 static void ymz280b_alloc_rom(void* info, UINT32 memsize)
 {
 	ymz280b_state *chip = (ymz280b_state *)info;
@@ -1035,6 +1065,7 @@ static void ymz280b_alloc_rom(void* info, UINT32 memsize)
 	if (chip->mem_size == memsize)
 		return;
 	
+	ymz280b_cache_clear(chip);
 	chip->mem_base = (UINT8*)realloc(chip->mem_base, memsize);
 	chip->mem_size = memsize;
 	memset(chip->mem_base, 0xFF, memsize);
@@ -1051,12 +1082,34 @@ static void ymz280b_write_rom(void *info, UINT32 offset, UINT32 length, const UI
 	if (offset + length > chip->mem_size)
 		length = chip->mem_size - offset;
 	
+	ymz280b_cache_clear(chip);
 	memcpy(chip->mem_base + offset, data, length);
 	
 	return;
 }
 
 
+static void ymz280b_set_options(void *info, UINT32 Flags)
+{
+	ymz280b_state *chip = (ymz280b_state *)info;
+	int i;
+	
+	if (Flags & OPT_YMZ280B_PCM_CACHE)
+	{
+		if (chip->cache == NULL)
+			PcmCache_Init(&chip->cache, 0);	// on failure, samples are just decoded live
+	}
+	else if (chip->cache != NULL)
+	{
+		for (i = 0; i < 8; i++)
+			chip->voice[i].cache = NULL;
+		PcmCache_Deinit(chip->cache);
+		chip->cache = NULL;
+	}
+	
+	return;
+}
+
 static void ymz280b_set_mute_mask(void *info, UINT32 MuteMask)
 {
 	ymz280b_state *chip = (ymz280b_state *)info;
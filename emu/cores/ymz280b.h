@@ -3,6 +3,8 @@
 
 #include "../EmuStructs.h"
 
+#define OPT_YMZ280B_PCM_CACHE	0x01	// cache decoded ADPCM samples for repeated playback (default: disabled)
+
 extern const DEV_DEF* devDefList_YMZ280B[];
 
 #endif	// __YMZ280B_H__
@@ -61,6 +61,8 @@ typedef struct
 
 typedef struct _dac_control
 {
+	DEV_DATA _devData;
+	
 	const DEV_DEF* devDef;
 	DEV_DATA* chipData;	// points to chip data structure
 	DEVREAD_FUNCS Read;
@@ -304,7 +306,7 @@ UINT8 device_start_daccontrol(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	dac_control* chip;
 	DEV_DATA* devData;
 	
-	chip = (dac_control*)calloc(1, sizeof(dac_control));
+	chip = (dac_control*)DevData_Alloc(cfg->memArena, sizeof(dac_control));
 	if (chip == NULL)
 		return 0xFF;
 	
@@ -326,7 +328,7 @@ void device_stop_daccontrol(void* info)
 {
 	dac_control* chip = (dac_control*)info;
 	
-	free(chip);
+	DevData_Free(chip);
 	
 	return;
 }
@@ -527,3 +529,32 @@ void daccontrol_stop(void* info)
 	
 	return;
 }
+
+UINT8 daccontrol_hash_state(void* info, UINT64* hash)
+{
+	dac_control* chip = (dac_control*)info;
+	UINT64 h = *hash;
+	
+	// The data is only referenced here and PCM banks are never modified in-place,
+	// so its address and size identify it.
+	h = EmuHash_Data(h, &chip->chipData, sizeof(chip->chipData));
+	h = EmuHash_Data(h, &chip->DstCommand, sizeof(chip->DstCommand));
+	h = EmuHash_Data(h, &chip->Frequency, sizeof(chip->Frequency));
+	h = EmuHash_Data(h, &chip->Data, sizeof(chip->Data));
+	h = EmuHash_Data(h, &chip->DataLen, sizeof(chip->DataLen));
+	h = EmuHash_Data(h, &chip->DataStart, sizeof(chip->DataStart));
+	h = EmuHash_Data(h, &chip->StepSize, sizeof(chip->StepSize));
+	h = EmuHash_Data(h, &chip->StepBase, sizeof(chip->StepBase));
+	h = EmuHash_Data(h, &chip->CmdsToSend, sizeof(chip->CmdsToSend));
+	h = EmuHash_Data(h, &chip->Running, sizeof(chip->Running));
+	if (! (chip->Running & 0x80) && (chip->Running & 0x01))
+	{
+		h = EmuHash_Data(h, &chip->Reverse, sizeof(chip->Reverse));
+		h = EmuHash_Data(h, &chip->stepCntr, sizeof(chip->stepCntr));
+		h = EmuHash_Data(h, &chip->RemainCmds, sizeof(chip->RemainCmds));
+		h = EmuHash_Data(h, &chip->RealPos, sizeof(chip->RealPos));
+	}
+	*hash = h;
+	
+	return 0x00;
+}
@@ -20,6 +20,7 @@ void daccontrol_refresh_data(void* info, UINT8* Data, UINT32 DataLen);
 void daccontrol_set_frequency(void* info, UINT32 Frequency);
 void daccontrol_start(void* info, UINT32 DataPos, UINT8 LenMode, UINT32 Length);
 void daccontrol_stop(void* info);
+UINT8 daccontrol_hash_state(void* info, UINT64* hash);
 
 #define DCTRL_LMODE_IGNORE	0x00
 #define DCTRL_LMODE_CMDS	0x01
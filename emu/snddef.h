@@ -12,6 +12,7 @@ typedef INT32 DEV_SMPL;
 typedef struct _device_data
 {
 	void* chipInf;	// pointer to CHIP_INF (depends on specific chip)
+	struct _mem_arena* memArena;	// arena the structure was allocated from, set by DevData_Alloc()
 } DEV_DATA;
 
 #endif	// __SNDDEF_H__
@@ -21,6 +21,7 @@ int main(int argc, char* argv[])
 	devCfg.srMode = DEVRI_SRMODE_NATIVE;
 	devCfg.flags = 0x00;
 	devCfg.clock = 3579545;
+	devCfg.memArena = NULL;
 	devCfg.smplRate = 44100;
 	snCfg._genCfg = devCfg;
 	snCfg.shiftRegWidth = 0x10;
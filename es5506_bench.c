@@ -0,0 +1,119 @@
+// ES5505/ES5506 rendering benchmark
+// Renders all 32 voices with looping samples, active filters and volume envelopes
+// and prints the render speed relative to realtime.
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "stdtype.h"
+#include "emu/EmuStructs.h"
+#include "emu/SoundEmu.h"
+#include "emu/SoundDevs.h"
+#include "emu/EmuCores.h"
+#include "utils/OSTimer.h"
+
+#define ROM_SIZE	0x100000	// 1 MB of sample data
+#define RENDER_SECS	60
+#define BUF_SMPLS	1024
+
+static DEVFUNC_WRITE_A8D8 esWrite;
+static void* esData;
+
+static void WriteReg32(UINT8 reg, UINT32 data)
+{
+	UINT8 curByte;
+
+	for (curByte = 0; curByte < 4; curByte ++)
+		esWrite(esData, (reg << 2) | curByte, (data >> (24 - curByte * 8)) & 0xFF);
+}
+
+static void SetupVoices(void)
+{
+	UINT8 curVoc;
+	UINT32 smplStart;
+
+	for (curVoc = 0; curVoc < 32; curVoc ++)
+	{
+		smplStart = curVoc * 0x4000;	// in words
+		WriteReg32(0x0F, 0x20 | curVoc);	// PAGE: high registers
+		WriteReg32(0x01, smplStart << 11);	// START
+		WriteReg32(0x02, (smplStart + 0x3000) << 11);	// END
+		WriteReg32(0x03, smplStart << 11);	// ACCUM
+
+		WriteReg32(0x0F, 0x00 | curVoc);	// PAGE: low registers
+		WriteReg32(0x01, 0x800 + curVoc * 97);	// FC
+		WriteReg32(0x02, 0xC000);	// LVOL
+		WriteReg32(0x04, 0xA000);	// RVOL
+		WriteReg32(0x07, 0x8000);	// K2
+		WriteReg32(0x09, 0x9000);	// K1
+		WriteReg32(0x03, 0x0100);	// LVRAMP
+		WriteReg32(0x0A, 0xFF00);	// K1RAMP
+		WriteReg32(0x06, 0x01FF);	// ECOUNT
+		// CR: forward loop, filter mode and output channel vary per voice
+		WriteReg32(0x00, 0x0008 | ((curVoc & 0x03) << 8) | ((curVoc % 6) << 10));
+	}
+	WriteReg32(0x0B, 0x1F);	// ACTV: 32 voices
+}
+
+int main(int argc, char* argv[])
+{
+	DEV_GEN_CFG devCfg;
+	DEV_INFO esDefInf;
+	DEVFUNC_WRITE_BLOCK esRomWrite;
+	UINT8* romData;
+	DEV_SMPL* smplData[2];
+	UINT32 smplCount;
+	UINT32 curSmpl;
+	UINT64 tmrStart;
+	UINT64 tmrEnd;
+	double renderTime;
+	UINT8 retVal;
+
+	devCfg.emuCore = 0;
+	devCfg.srMode = DEVRI_SRMODE_NATIVE;
+	devCfg.flags = 0x01 | (6 << 1);	// ES5506, 6 output channels
+	devCfg.clock = 16000000;
+	devCfg.memArena = NULL;
+	devCfg.smplRate = 44100;
+
+	retVal = SndEmu_Start(DEVID_ES5506, &devCfg, &esDefInf);
+	if (retVal)
+	{
+		printf("Error starting ES5506!\n");
+		return 1;
+	}
+	esData = esDefInf.dataPtr;
+	esDefInf.devDef->Reset(esData);
+	SndEmu_GetDeviceFunc(esDefInf.devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, (void**)&esWrite);
+	SndEmu_GetDeviceFunc(esDefInf.devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, (void**)&esRomWrite);
+
+	srand(1);
+	romData = (UINT8*)malloc(ROM_SIZE);
+	for (curSmpl = 0; curSmpl < ROM_SIZE; curSmpl ++)
+		romData[curSmpl] = (UINT8)rand();
+	esRomWrite(esData, 0x00, ROM_SIZE, romData);
+	free(romData);
+	SetupVoices();
+
+	smplData[0] = (DEV_SMPL*)malloc(BUF_SMPLS * sizeof(DEV_SMPL));
+	smplData[1] = (DEV_SMPL*)malloc(BUF_SMPLS * sizeof(DEV_SMPL));
+	smplCount = esDefInf.sampleRate * RENDER_SECS;
+
+	tmrStart = OSTimer_GetTime();
+	for (curSmpl = 0; curSmpl < smplCount; curSmpl += BUF_SMPLS)
+	{
+		if ((curSmpl % (BUF_SMPLS * 64)) == 0)
+			SetupVoices();	// restart the envelopes
+		esDefInf.devDef->Update(esData, BUF_SMPLS, smplData);
+	}
+	tmrEnd = OSTimer_GetTime();
+	renderTime = (double)(tmrEnd - tmrStart) / OSTimer_GetFreq();
+
+	printf("ES5506, 32 voices @ %u Hz: %u s rendered in %.3f s (%.1fx realtime)\n",
+		esDefInf.sampleRate, RENDER_SECS, renderTime, RENDER_SECS / renderTime);
+
+	free(smplData[0]);
+	free(smplData[1]);
+	SndEmu_Stop(&esDefInf);
+
+	return 0;
+}
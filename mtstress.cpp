@@ -0,0 +1,568 @@
+// Multi-threaded stress test for the sound cores and players
+// Runs the same jobs on several threads at the same time and checks that every thread
+// produces exactly the same output as a single-threaded render.
+// The threaded pass runs first, so that the one-time table setup of the sound cores
+// is done concurrently as well.
+//
+// Usage: mtstress [-t threads] [-r rounds] [-s streams] [song files ...]
+// The built-in jobs drive the sound cores directly using pseudo-random register writes.
+// Song files (VGM/S98/DRO) are additionally rendered using the players.
+// With -s, each song is also played as multiple streams through the PlayerScheduler.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+#include <string>
+
+#include "stdtype.h"
+#include "emu/EmuStructs.h"
+#include "emu/SoundEmu.h"
+#include "emu/SoundDevs.h"
+#include "emu/EmuCores.h"
+#include "emu/cores/okim6258.h"	// for OKIM6258_CFG
+#include "player/playerbase.hpp"
+#include "player/vgmplayer.hpp"
+#include "player/s98player.hpp"
+#include "player/droplayer.hpp"
+#include "player/playersched.hpp"
+#include "utils/DataLoader.h"
+#include "utils/MemoryLoader.h"
+#include "utils/OSThread.h"
+#include "utils/OSMutex.h"
+#include "utils/OSTimer.h"
+
+#define DEV_BLOCKS		200		// number of blocks to render per device job
+#define DEV_BLK_SMPLS	256		// samples per block
+#define DEV_BLK_WRITES	8		// register writes per block
+#define SONG_SMPLRATE	44100
+#define SONG_MAX_SECS	30
+#define SONG_BUF_SMPLS	1024
+#define MAX_THREADS		64
+
+// register write modes
+#define WM_NONE		0	// ROM-based chips: start/render only
+#define WM_DIRECT	1	// write data directly to offsets regLo..regHi
+#define WM_PORT1	2	// address/data at offsets 0/1
+#define WM_PORT2	3	// two address/data pairs at offsets 0/1 and 2/3
+
+struct DEV_JOB
+{
+	const char* name;
+	UINT8 devID;
+	UINT32 core;	// 0 = default core
+	UINT32 clock;
+	UINT8 writeMode;
+	UINT8 regLo;
+	UINT8 regHi;
+	INT16 initReg;	// register that is written once after the reset, -1 = none
+	UINT8 initData;
+};
+
+static const DEV_JOB DEV_JOBS[] =
+{
+	{"YM2413 (EMU2413)",	DEVID_YM2413,	FCC_EMU_,	3579545,	WM_PORT1,	0x00, 0x38, -1, 0x00},
+	{"YM2413 (MAME)",		DEVID_YM2413,	FCC_MAME,	3579545,	WM_PORT1,	0x00, 0x38, -1, 0x00},
+	{"YM2612 (GPGX)",		DEVID_YM2612,	FCC_GPGX,	7670454,	WM_PORT2,	0x21, 0xB6, -1, 0x00},
+	{"YM2612 (Gens)",		DEVID_YM2612,	FCC_GENS,	7670454,	WM_PORT2,	0x21, 0xB6, -1, 0x00},
+	{"YM2151",				DEVID_YM2151,	0,			3579545,	WM_PORT1,	0x08, 0xFF, -1, 0x00},
+	{"YM2203",				DEVID_YM2203,	0,			3993600,	WM_PORT1,	0x21, 0xB6, -1, 0x00},
+	{"YM2608",				DEVID_YM2608,	0,			7987200,	WM_PORT2,	0x21, 0xB6, -1, 0x00},
+	{"YM2610",				DEVID_YM2610,	0,			8000000,	WM_PORT2,	0x21, 0xB6, -1, 0x00},
+	{"YM3812 (MAME)",		DEVID_YM3812,	FCC_MAME,	3579545,	WM_PORT1,	0x01, 0xF5, -1, 0x00},
+	{"YM3812 (AdLibEmu)",	DEVID_YM3812,	FCC_ADLE,	3579545,	WM_PORT1,	0x01, 0xF5, -1, 0x00},
+	{"YM3526",				DEVID_YM3526,	0,			3579545,	WM_PORT1,	0x01, 0xF5, -1, 0x00},
+	{"YMF262 (MAME)",		DEVID_YMF262,	FCC_MAME,	14318180,	WM_PORT2,	0x01, 0xF5, -1, 0x00},
+	{"YMF262 (AdLibEmu)",	DEVID_YMF262,	FCC_ADLE,	14318180,	WM_PORT2,	0x01, 0xF5, -1, 0x00},
+	{"YMF278B",				DEVID_YMF278B,	0,			33868800,	WM_NONE,	0x00, 0x00, -1, 0x00},
+	{"MultiPCM",			DEVID_YMW258,	0,			9878400,	WM_NONE,	0x00, 0x00, -1, 0x00},
+	{"YMZ280B",				DEVID_YMZ280B,	0,			16934400,	WM_NONE,	0x00, 0x00, -1, 0x00},
+	{"OKIM6258",			DEVID_OKIM6258,	0,			4000000,	WM_DIRECT,	0x00, 0x01, -1, 0x00},
+	{"OKIM6295",			DEVID_OKIM6295,	0,			1056000,	WM_NONE,	0x00, 0x00, -1, 0x00},
+	{"SCSP",				DEVID_SCSP,		0,			22579200,	WM_NONE,	0x00, 0x00, -1, 0x00},
+	{"HuC6280 (MAME)",		DEVID_C6280,	FCC_MAME,	3579545,	WM_DIRECT,	0x00, 0x09, -1, 0x00},
+	{"HuC6280 (Ootake)",	DEVID_C6280,	FCC_OOTK,	3579545,	WM_DIRECT,	0x00, 0x09, -1, 0x00},
+	{"NES APU (NSFPlay)",	DEVID_NES_APU,	FCC_NSFP,	1789772,	WM_DIRECT,	0x00, 0x0F, 0x15, 0x0F},
+	{"NES APU (MAME)",		DEVID_NES_APU,	FCC_MAME,	1789772,	WM_DIRECT,	0x00, 0x0F, 0x15, 0x0F},
+};
+#define DEV_JOB_COUNT	(sizeof(DEV_JOBS) / sizeof(DEV_JOBS[0]))
+
+struct SONG_FILE
+{
+	std::string name;
+	std::vector<UINT8> data;
+};
+
+struct THREAD_ARGS
+{
+	UINT32 thrID;
+	std::vector<UINT64>* results;	// [round * jobCount + job]
+};
+
+static std::vector<SONG_FILE> songFiles;
+static UINT32 jobCount;
+static UINT32 roundCount = 2;
+static UINT32 schedStreams = 0;
+static OS_MUTEX* startMutex;
+
+
+static UINT64 HashData(UINT64 hash, const void* data, size_t size)
+{
+	const UINT8* bytes = (const UINT8*)data;
+	size_t curByte;
+
+	// FNV-1a
+	for (curByte = 0; curByte < size; curByte ++)
+	{
+		hash ^= bytes[curByte];
+		hash *= 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+static UINT32 NextRand(UINT32* seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return *seed >> 16;
+}
+
+static UINT64 RunDeviceJob(const DEV_JOB* job)
+{
+	OKIM6258_CFG okiCfg;
+	DEV_GEN_CFG* devCfg = &okiCfg._genCfg;
+	DEV_INFO devInf;
+	DEVFUNC_WRITE_A8D8 writeFunc;
+	DEV_SMPL smplL[DEV_BLK_SMPLS];
+	DEV_SMPL smplR[DEV_BLK_SMPLS];
+	DEV_SMPL* smplData[2];
+	UINT64 hash;
+	UINT32 seed;
+	UINT32 curBlk;
+	UINT32 curWrt;
+	UINT8 retVal;
+
+	memset(&okiCfg, 0x00, sizeof(OKIM6258_CFG));
+	devCfg->emuCore = job->core;
+	devCfg->srMode = DEVRI_SRMODE_NATIVE;
+	devCfg->clock = job->clock;
+	devCfg->smplRate = SONG_SMPLRATE;
+	retVal = SndEmu_Start(job->devID, devCfg, &devInf);
+	if (retVal)
+		return 0;	// 0 is never a valid hash, the comparison will report it
+	devInf.devDef->Reset(devInf.dataPtr);
+
+	writeFunc = NULL;
+	if (job->writeMode != WM_NONE)
+	{
+		retVal = SndEmu_GetDeviceFunc(devInf.devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, (void**)&writeFunc);
+		if (retVal)
+			writeFunc = NULL;
+	}
+	if (writeFunc != NULL && job->initReg >= 0)
+		writeFunc(devInf.dataPtr, (UINT8)job->initReg, job->initData);
+
+	smplData[0] = smplL;
+	smplData[1] = smplR;
+	hash = 0xCBF29CE484222325ULL;
+	seed = job->devID * 0x10000 + job->core;
+	for (curBlk = 0; curBlk < DEV_BLOCKS; curBlk ++)
+	{
+		for (curWrt = 0; writeFunc != NULL && curWrt < DEV_BLK_WRITES; curWrt ++)
+		{
+			UINT8 reg = job->regLo + (UINT8)(NextRand(&seed) % (job->regHi - job->regLo + 1));
+			UINT8 data = (UINT8)NextRand(&seed);
+
+			if (job->writeMode == WM_DIRECT)
+			{
+				writeFunc(devInf.dataPtr, reg, data);
+			}
+			else
+			{
+				UINT8 port = (job->writeMode == WM_PORT2) ? (UINT8)(NextRand(&seed) & 0x01) : 0x00;
+				writeFunc(devInf.dataPtr, (port << 1) | 0x00, reg);
+				writeFunc(devInf.dataPtr, (port << 1) | 0x01, data);
+			}
+		}
+		memset(smplL, 0x00, sizeof(smplL));
+		memset(smplR, 0x00, sizeof(smplR));
+		devInf.devDef->Update(devInf.dataPtr, DEV_BLK_SMPLS, smplData);
+		hash = HashData(hash, smplL, sizeof(smplL));
+		hash = HashData(hash, smplR, sizeof(smplR));
+	}
+
+	SndEmu_Stop(&devInf);
+	SndEmu_FreeDevLinkData(&devInf);
+	return hash;
+}
+
+static PlayerBase* OpenSong(const SONG_FILE* song, DATA_LOADER** retLoader, UINT32* retSmplCount)
+{
+	DATA_LOADER* dLoad;
+	PlayerBase* player;
+	UINT32 smplCount;
+	UINT8 retVal;
+
+	dLoad = MemoryLoader_Init(&song->data[0], (UINT32)song->data.size());
+	if (dLoad == NULL)
+		return NULL;
+	DataLoader_SetPreloadBytes(dLoad, 0x100);
+	retVal = DataLoader_Load(dLoad);
+	if (retVal)
+	{
+		DataLoader_Deinit(dLoad);
+		return NULL;
+	}
+
+	if (! VGMPlayer::PlayerCanLoadFile(dLoad))
+		player = new VGMPlayer;
+	else if (! S98Player::PlayerCanLoadFile(dLoad))
+		player = new S98Player;
+	else if (! DROPlayer::PlayerCanLoadFile(dLoad))
+		player = new DROPlayer;
+	else
+		player = NULL;
+	if (player == NULL || player->LoadFile(dLoad))
+	{
+		delete player;
+		DataLoader_Deinit(dLoad);
+		return NULL;
+	}
+
+	player->SetSampleRate(SONG_SMPLRATE);
+	player->Start();
+	smplCount = player->Tick2Sample(player->GetTotalPlayTicks(2));
+	if (smplCount > SONG_SMPLRATE * SONG_MAX_SECS)
+		smplCount = SONG_SMPLRATE * SONG_MAX_SECS;
+
+	*retLoader = dLoad;
+	*retSmplCount = smplCount;
+	return player;
+}
+
+static void CloseSong(PlayerBase* player, DATA_LOADER* dLoad)
+{
+	player->Stop();
+	player->UnloadFile();
+	delete player;
+	DataLoader_Deinit(dLoad);
+	return;
+}
+
+static UINT64 RunSongJob(const SONG_FILE* song)
+{
+	DATA_LOADER* dLoad;
+	PlayerBase* player;
+	std::vector<WAVE_32BS> smplBuf(SONG_BUF_SMPLS);
+	UINT64 hash;
+	UINT32 smplCount;
+	UINT32 curSmpl;
+	UINT32 renderSmpls;
+
+	player = OpenSong(song, &dLoad, &smplCount);
+	if (player == NULL)
+		return 0;
+
+	hash = 0xCBF29CE484222325ULL;
+	for (curSmpl = 0; curSmpl < smplCount; curSmpl += renderSmpls)
+	{
+		renderSmpls = smplCount - curSmpl;
+		if (renderSmpls > SONG_BUF_SMPLS)
+			renderSmpls = SONG_BUF_SMPLS;
+		memset(&smplBuf[0], 0x00, renderSmpls * sizeof(WAVE_32BS));
+		player->Render(renderSmpls, &smplBuf[0]);
+		hash = HashData(hash, &smplBuf[0], renderSmpls * sizeof(WAVE_32BS));
+	}
+
+	CloseSong(player, dLoad);
+	return hash;
+}
+
+struct SCHED_STREAM
+{
+	UINT32 songID;
+	PlayerBase* player;
+	DATA_LOADER* dLoad;
+	UINT32 streamID;
+	UINT32 smplCount;
+	UINT32 smplPos;
+	UINT64 hash;
+};
+
+// plays every song schedStreams times at once using the scheduler and compares against the reference hashes
+static UINT32 RunScheduledSongs(UINT32 workerCount, const std::vector<UINT64>& refResults)
+{
+	PlayerScheduler sched;
+	PLRSCHED_STREAM_CFG strmCfg;
+	std::vector<SCHED_STREAM> streams;
+	std::vector<WAVE_32BS> smplBuf(SONG_BUF_SMPLS);
+	UINT32 curSong;
+	UINT32 curStrm;
+	UINT32 activeStrms;
+	UINT32 errCount;
+
+	// The players' output depends on the size of the rendered blocks,
+	// so the quanta have to match the blocks of the reference render.
+	strmCfg.quantumSmpls = SONG_BUF_SMPLS;
+	strmCfg.bufSmpls = 0;
+	for (curSong = 0; curSong < songFiles.size(); curSong ++)
+	{
+		for (curStrm = 0; curStrm < schedStreams; curStrm ++)
+		{
+			SCHED_STREAM ss;
+
+			ss.songID = curSong;
+			ss.player = OpenSong(&songFiles[curSong], &ss.dLoad, &ss.smplCount);
+			if (ss.player == NULL)
+				continue;
+			strmCfg.smplLimit = ss.smplCount;
+			ss.streamID = sched.AddStream(ss.player, strmCfg);
+			if (ss.streamID == (UINT32)-1)
+			{
+				CloseSong(ss.player, ss.dLoad);
+				continue;
+			}
+			ss.smplPos = 0;
+			ss.hash = 0xCBF29CE484222325ULL;
+			streams.push_back(ss);
+		}
+	}
+
+	sched.Start(workerCount);
+	do
+	{
+		// read all streams as fast as possible, the hash doesn't depend on the block sizes
+		activeStrms = 0;
+		for (curStrm = 0; curStrm < streams.size(); curStrm ++)
+		{
+			SCHED_STREAM& ss = streams[curStrm];
+			UINT32 readSmpls;
+
+			if (ss.smplPos >= ss.smplCount)
+				continue;
+			activeStrms ++;
+			memset(&smplBuf[0], 0x00, SONG_BUF_SMPLS * sizeof(WAVE_32BS));
+			readSmpls = sched.ReadStream(ss.streamID, SONG_BUF_SMPLS, &smplBuf[0]);
+			ss.hash = HashData(ss.hash, &smplBuf[0], readSmpls * sizeof(WAVE_32BS));
+			ss.smplPos += readSmpls;
+			if (! readSmpls)
+			{
+				PLRSCHED_STATS stats;
+				sched.GetStreamStats(ss.streamID, stats);
+				if (stats.finished && ! stats.bufLevel)
+					ss.smplCount = ss.smplPos;	// the player ended early, the hash comparison will report it
+			}
+		}
+	} while(activeStrms > 0);
+	sched.Stop();
+
+	errCount = 0;
+	for (curStrm = 0; curStrm < streams.size(); curStrm ++)
+	{
+		SCHED_STREAM& ss = streams[curStrm];
+
+		if (ss.hash != refResults[DEV_JOB_COUNT + ss.songID])
+		{
+			printf("%s: mismatch in scheduled stream %u\n", songFiles[ss.songID].name.c_str(), curStrm);
+			errCount ++;
+		}
+		sched.RemoveStream(ss.streamID);
+		CloseSong(ss.player, ss.dLoad);
+	}
+	// Note: The streams are read faster than realtime, so missed deadlines are expected here.
+	printf("Scheduled pass: %u streams, %u missed deadlines\n", (UINT32)streams.size(), sched.GetMissedDeadlines());
+	return errCount;
+}
+
+static UINT64 RunJob(UINT32 jobID)
+{
+	if (jobID < DEV_JOB_COUNT)
+		return RunDeviceJob(&DEV_JOBS[jobID]);
+	else
+		return RunSongJob(&songFiles[jobID - DEV_JOB_COUNT]);
+}
+
+static const char* GetJobName(UINT32 jobID)
+{
+	if (jobID < DEV_JOB_COUNT)
+		return DEV_JOBS[jobID].name;
+	else
+		return songFiles[jobID - DEV_JOB_COUNT].name.c_str();
+}
+
+static void StressThread(void* args)
+{
+	THREAD_ARGS* tArgs = (THREAD_ARGS*)args;
+	UINT32 curRound;
+	UINT32 curJob;
+
+	// wait for all threads to be created, so that they really start at the same time
+	OSMutex_Lock(startMutex);
+	OSMutex_Unlock(startMutex);
+
+	for (curRound = 0; curRound < roundCount; curRound ++)
+	{
+		for (curJob = 0; curJob < jobCount; curJob ++)
+		{
+			// each thread uses a different job order
+			UINT32 jobID = (curJob + tArgs->thrID * 3 + curRound) % jobCount;
+			(*tArgs->results)[curRound * jobCount + jobID] = RunJob(jobID);
+		}
+	}
+
+	return;
+}
+
+static UINT8 LoadSongFile(const char* fileName, SONG_FILE* song)
+{
+	FILE* hFile;
+	long fileSize;
+
+	hFile = fopen(fileName, "rb");
+	if (hFile == NULL)
+		return 0xFF;
+	fseek(hFile, 0, SEEK_END);
+	fileSize = ftell(hFile);
+	fseek(hFile, 0, SEEK_SET);
+	if (fileSize <= 0)
+	{
+		fclose(hFile);
+		return 0x80;
+	}
+	song->name = fileName;
+	song->data.resize(fileSize);
+	song->data.resize(fread(&song->data[0], 1, fileSize, hFile));
+	fclose(hFile);
+	return 0x00;
+}
+
+int main(int argc, char* argv[])
+{
+	UINT32 thrCount = 4;
+	std::vector<OS_THREAD*> threads;
+	std::vector<THREAD_ARGS> thrArgs;
+	std::vector< std::vector<UINT64> > thrResults;
+	std::vector<UINT64> refResults;
+	UINT64 tmrStart;
+	double timeMT;
+	double timeST;
+	UINT32 errCount;
+	UINT32 curThr;
+	UINT32 curRes;
+	int argbase;
+	UINT8 retVal;
+
+	argbase = 1;
+	while (argbase < argc && argv[argbase][0] == '-')
+	{
+		if (! strcmp(argv[argbase], "-t") && argbase + 1 < argc)
+		{
+			thrCount = (UINT32)strtoul(argv[argbase + 1], NULL, 0);
+			argbase += 2;
+		}
+		else if (! strcmp(argv[argbase], "-r") && argbase + 1 < argc)
+		{
+			roundCount = (UINT32)strtoul(argv[argbase + 1], NULL, 0);
+			argbase += 2;
+		}
+		else if (! strcmp(argv[argbase], "-s") && argbase + 1 < argc)
+		{
+			schedStreams = (UINT32)strtoul(argv[argbase + 1], NULL, 0);
+			argbase += 2;
+		}
+		else
+		{
+			printf("Usage: %s [-t threads] [-r rounds] [-s streams] [song files ...]\n", argv[0]);
+			return 0;
+		}
+	}
+	if (thrCount < 1)
+		thrCount = 1;
+	else if (thrCount > MAX_THREADS)
+		thrCount = MAX_THREADS;
+	if (roundCount < 1)
+		roundCount = 1;
+
+	for (; argbase < argc; argbase ++)
+	{
+		SONG_FILE song;
+
+		retVal = LoadSongFile(argv[argbase], &song);
+		if (retVal)
+		{
+			printf("Error loading %s!\n", argv[argbase]);
+			continue;
+		}
+		songFiles.push_back(song);
+	}
+	jobCount = (UINT32)(DEV_JOB_COUNT + songFiles.size());
+
+	// pass 1: all threads at the same time
+	printf("Running %u jobs on %u threads, %u rounds ...\n", jobCount, thrCount, roundCount);
+	threads.resize(thrCount, NULL);
+	thrArgs.resize(thrCount);
+	thrResults.resize(thrCount, std::vector<UINT64>(roundCount * jobCount, 0));
+	OSMutex_Init(&startMutex, 1);
+	for (curThr = 0; curThr < thrCount; curThr ++)
+	{
+		thrArgs[curThr].thrID = curThr;
+		thrArgs[curThr].results = &thrResults[curThr];
+		retVal = OSThread_Init(&threads[curThr], &StressThread, &thrArgs[curThr]);
+		if (retVal)
+		{
+			printf("Error creating thread %u!\n", curThr);
+			threads[curThr] = NULL;
+		}
+	}
+	tmrStart = OSTimer_GetTime();
+	OSMutex_Unlock(startMutex);
+	for (curThr = 0; curThr < thrCount; curThr ++)
+	{
+		if (threads[curThr] == NULL)
+			continue;
+		OSThread_Join(threads[curThr]);
+		OSThread_Deinit(threads[curThr]);
+	}
+	timeMT = (double)(OSTimer_GetTime() - tmrStart) / OSTimer_GetFreq();
+	OSMutex_Deinit(startMutex);
+
+	// pass 2: single-threaded reference
+	refResults.resize(jobCount);
+	tmrStart = OSTimer_GetTime();
+	for (curRes = 0; curRes < jobCount; curRes ++)
+		refResults[curRes] = RunJob(curRes);
+	timeST = (double)(OSTimer_GetTime() - tmrStart) / OSTimer_GetFreq();
+
+	errCount = 0;
+	for (curRes = 0; curRes < jobCount; curRes ++)
+	{
+		if (refResults[curRes] == 0)
+		{
+			printf("%s: job failed\n", GetJobName(curRes));
+			errCount ++;
+		}
+	}
+	for (curThr = 0; curThr < thrCount; curThr ++)
+	{
+		for (curRes = 0; curRes < roundCount * jobCount; curRes ++)
+		{
+			UINT32 jobID = curRes % jobCount;
+			if (thrResults[curThr][curRes] != refResults[jobID])
+			{
+				printf("%s: mismatch in thread %u, round %u\n", GetJobName(jobID), curThr, curRes / jobCount);
+				errCount ++;
+			}
+		}
+	}
+
+	if (schedStreams > 0 && ! songFiles.empty())
+		errCount += RunScheduledSongs(thrCount, refResults);
+
+	printf("Multi-threaded pass: %.3f s, single-threaded pass: %.3f s (1 round)\n", timeMT, timeST);
+	if (errCount)
+	{
+		printf("%u errors found!\n", errCount);
+		return 1;
+	}
+	printf("All results match.\n");
+	return 0;
+}
@@ -0,0 +1,233 @@
+// Null audio driver test
+// Checks the simulated clock and the statistics of the null driver.
+// Callback mode: the number of buffers must match the real time that passed at the configured speed.
+// WriteData mode: all buffers are counted, but there are no render times.
+//
+// Usage: nulldrvtest
+// Returns 0 when all tests pass, 1 otherwise.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>	// for Sleep()
+#else
+#include <unistd.h>		// for usleep()
+#define	Sleep(msec)	usleep(msec * 1000)
+#endif
+
+#include "stdtype.h"
+#include "audio/AudioStream.h"
+#include "audio/AudioStream_SpcDrvFuns.h"
+#include "utils/OSTimer.h"
+
+#define SMPL_RATE	44100
+#define BUF_USEC	10000	// 10 ms per buffer
+#define BUF_COUNT	10
+#define RUN_MSEC	500
+#define WRITE_BUFS	100
+
+static UINT32 FillBuffer(void* drvStruct, void* userParam, UINT32 bufSize, void* data);
+static UINT8 InitNullDriver(UINT32 drvID, double speed, void** retAudDrv);
+static UINT8 TestCallback(UINT32 drvID, double speed);
+static UINT8 TestWriteData(UINT32 drvID, double speed);
+static UINT32 ExpectedBuffers(double usec, double speed);
+static UINT8 CheckRange(const char* name, UINT32 value, UINT32 expected);
+
+
+static UINT32 FillBuffer(void* drvStruct, void* userParam, UINT32 bufSize, void* data)
+{
+	memset(data, 0x00, bufSize);
+	return bufSize;
+}
+
+static UINT8 InitNullDriver(UINT32 drvID, double speed, void** retAudDrv)
+{
+	AUDIO_OPTS* opts;
+	void* audDrv;
+	UINT8 retVal;
+
+	retVal = AudioDrv_Init(drvID, &audDrv);
+	if (retVal)
+		return retVal;
+	opts = AudioDrv_GetOptions(audDrv);
+	opts->sampleRate = SMPL_RATE;
+	opts->numChannels = 2;
+	opts->numBitsPerSmpl = 16;
+	opts->usecPerBuf = BUF_USEC;
+	opts->numBuffers = BUF_COUNT;
+	NullDrv_SetSpeed(AudioDrv_GetDrvData(audDrv), speed);
+
+	*retAudDrv = audDrv;
+	return AERR_OK;
+}
+
+// The queue is filled right away, then the device takes one buffer per buffer period.
+static UINT32 ExpectedBuffers(double usec, double speed)
+{
+	return (BUF_COUNT - 1) + (UINT32)(usec * speed / BUF_USEC);
+}
+
+// allows for 2 buffers + 10% of scheduling delays
+static UINT8 CheckRange(const char* name, UINT32 value, UINT32 expected)
+{
+	UINT32 tolerance = 2 + expected / 10;
+
+	if (value + tolerance >= expected && value <= expected + tolerance)
+		return 0x00;
+	printf("\t%s: %u, expected %u\n", name, value, expected);
+	return 0x01;
+}
+
+static UINT8 TestCallback(UINT32 drvID, double speed)
+{
+	void* audDrv;
+	NULLDRV_STATS stats;
+	UINT64 tmrFreq;
+	UINT64 startTime;
+	UINT64 endTime;
+	UINT8 retVal;
+	UINT8 errors;
+
+	retVal = InitNullDriver(drvID, speed, &audDrv);
+	if (retVal)
+	{
+		printf("Unable to open null driver! (Error 0x%02X)\n", retVal);
+		return 0xFF;
+	}
+	AudioDrv_SetCallback(audDrv, FillBuffer, NULL);
+
+	tmrFreq = OSTimer_GetFreq();
+	startTime = OSTimer_GetTime();
+	retVal = AudioDrv_Start(audDrv, 0);
+	if (retVal)
+	{
+		printf("Unable to start null driver! (Error 0x%02X)\n", retVal);
+		AudioDrv_Deinit(&audDrv);
+		return 0xFF;
+	}
+	Sleep(RUN_MSEC);
+	NullDrv_GetStats(AudioDrv_GetDrvData(audDrv), &stats);
+	endTime = OSTimer_GetTime();
+	AudioDrv_Stop(audDrv);
+	AudioDrv_Deinit(&audDrv);
+
+	errors = 0x00;
+	errors |= CheckRange("buffers", stats.buffers,
+		ExpectedBuffers((endTime - startTime) * 1000000.0 / tmrFreq, speed));
+	errors |= CheckRange("buffer period", stats.bufPeriod, (UINT32)(BUF_USEC / speed + 0.5));
+	if (! (stats.renderMin <= stats.renderAvg && stats.renderAvg <= stats.renderMax))
+	{
+		printf("\trender time: min %u, avg %u, max %u\n", stats.renderMin, stats.renderAvg, stats.renderMax);
+		errors |= 0x01;
+	}
+	printf("Callback mode, speed %.1f: %s\n", speed, errors ? "FAILED" : "OK");
+	return errors;
+}
+
+static UINT8 TestWriteData(UINT32 drvID, double speed)
+{
+	void* audDrv;
+	NULLDRV_STATS stats;
+	UINT64 tmrFreq;
+	UINT64 startTime;
+	UINT64 endTime;
+	UINT8* buffer;
+	UINT32 bufSize;
+	UINT32 curBuf;
+	UINT8 retVal;
+	UINT8 errors;
+
+	retVal = InitNullDriver(drvID, speed, &audDrv);
+	if (retVal)
+	{
+		printf("Unable to open null driver! (Error 0x%02X)\n", retVal);
+		return 0xFF;
+	}
+
+	tmrFreq = OSTimer_GetFreq();
+	startTime = OSTimer_GetTime();
+	retVal = AudioDrv_Start(audDrv, 0);
+	if (retVal)
+	{
+		printf("Unable to start null driver! (Error 0x%02X)\n", retVal);
+		AudioDrv_Deinit(&audDrv);
+		return 0xFF;
+	}
+	bufSize = AudioDrv_GetBufferSize(audDrv);
+	buffer = (UINT8*)calloc(bufSize, 1);
+	errors = 0x00;
+	for (curBuf = 0; curBuf < WRITE_BUFS && buffer != NULL; curBuf ++)
+	{
+		retVal = AudioDrv_WriteData(audDrv, bufSize, buffer);
+		if (retVal)
+		{
+			printf("\tWriteData error 0x%02X\n", retVal);
+			errors |= 0x01;
+			break;
+		}
+	}
+	NullDrv_GetStats(AudioDrv_GetDrvData(audDrv), &stats);
+	endTime = OSTimer_GetTime();
+	AudioDrv_Stop(audDrv);
+	AudioDrv_Deinit(&audDrv);
+	free(buffer);
+
+	if (stats.buffers != WRITE_BUFS)
+	{
+		printf("\tbuffers: %u, expected %u\n", stats.buffers, WRITE_BUFS);
+		errors |= 0x01;
+	}
+	// WriteData blocks like a sound device, so the buffers must take the same time as in callback mode.
+	errors |= CheckRange("buffers (by time)", stats.buffers,
+		ExpectedBuffers((endTime - startTime) * 1000000.0 / tmrFreq, speed));
+	if (stats.renderMin || stats.renderAvg || stats.renderMax)
+	{
+		printf("\trender time: min %u, avg %u, max %u (no callback)\n",
+			stats.renderMin, stats.renderAvg, stats.renderMax);
+		errors |= 0x01;
+	}
+	printf("WriteData mode, speed %.1f: %s\n", speed, errors ? "FAILED" : "OK");
+	return errors;
+}
+
+int main(int argc, char* argv[])
+{
+	AUDDRV_INFO* drvInfo;
+	UINT32 drvCount;
+	UINT32 curDrv;
+	UINT32 idNull;
+	UINT8 retVal;
+
+	retVal = Audio_Init();
+	if (retVal && retVal != AERR_WASDONE)
+	{
+		printf("Audio_Init failed! (Error 0x%02X)\n", retVal);
+		return 1;
+	}
+	drvCount = Audio_GetDriverCount();
+	idNull = (UINT32)-1;
+	for (curDrv = 0; curDrv < drvCount; curDrv ++)
+	{
+		Audio_GetDriverInfo(curDrv, &drvInfo);
+		if (drvInfo->drvType == ADRVTYPE_NULL && drvInfo->drvSig == ADRVSIG_NULL)
+		{
+			idNull = curDrv;
+			break;
+		}
+	}
+	if (idNull == (UINT32)-1)
+	{
+		printf("Null driver not available!\n");
+		Audio_Deinit();
+		return 1;
+	}
+
+	retVal = 0x00;
+	retVal |= TestCallback(idNull, 1.0);
+	retVal |= TestCallback(idNull, 4.0);
+	retVal |= TestWriteData(idNull, 4.0);
+
+	Audio_Deinit();
+	return retVal ? 1 : 0;
+}
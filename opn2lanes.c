@@ -0,0 +1,528 @@
+// Nuked OPN2 lane test
+// Renders NOPN2L_LANES YM2612 instances with the lane-parallel core (ym3438_lanes.c) and
+// checks every lane against a scalar core instance (ym3438.c) that gets the same writes.
+// Without files, each lane gets its own random register stream in all four chip modes.
+// With VGM files, the YM2612 of each file is rendered in its own lane (batch rendering).
+//
+// Usage: opn2lanes [-w] [file1.vgm ...]
+//	-w	write the output of each lane to <file>.wav
+// Returns 0 when all lanes render exactly like the scalar core, 1 otherwise.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "stdtype.h"
+#include "emu/snddef.h"
+#include "emu/cores/ym3438.h"
+#include "emu/cores/ym3438_lanes.h"
+
+#define OPN2_CLOCK	7670453
+#define SMPL_RATE	44100
+#define BLOCK_SIZE	0x100
+#define RND_ROUNDS	500
+
+typedef struct _lane_file
+{
+	const char* fileName;
+	UINT8* data;
+	UINT32 size;
+	UINT32 pos;
+	UINT8* pcmData;
+	UINT32 pcmSize;
+	UINT32 pcmPos;
+	UINT32 wait;	// samples until the next command
+	UINT8 ended;
+	FILE* hWav;
+	UINT32 wavSmpls;
+} LANE_FILE;
+
+typedef struct _lane_test
+{
+	void* lanes;
+	void* scalar[NOPN2L_LANES];
+	DEV_SMPL* laneBuf[NOPN2L_LANES * 2];
+	DEV_SMPL* sclBuf[2];
+	UINT32 mismatches;
+} LANE_TEST;
+
+static UINT8 LaneTest_Init(LANE_TEST* lt, UINT32 clock, UINT32 options);
+static void LaneTest_Deinit(LANE_TEST* lt);
+static void LaneTest_Write(LANE_TEST* lt, UINT32 lane, UINT8 port, UINT8 data);
+static void LaneTest_Render(LANE_TEST* lt, UINT32 smplCount);
+static UINT32 Rnd_Next(UINT32* state);
+static UINT8 RunRandomTest(UINT32 options);
+static UINT8 LoadVGM(LANE_FILE* lf);
+static UINT32 GetVGMClock(const LANE_FILE* lf);
+static void ProcessVGM(LANE_TEST* lt, UINT32 lane, LANE_FILE* lf);
+static void WriteWave(LANE_FILE* lf, const DEV_SMPL* smplL, const DEV_SMPL* smplR, UINT32 smplCount);
+static void FinishWave(LANE_FILE* lf);
+static UINT8 RunFileTest(UINT32 fileCnt, char* fileNames[], UINT8 writeWav);
+
+static UINT8 LaneTest_Init(LANE_TEST* lt, UINT32 clock, UINT32 options)
+{
+	UINT32 curLane;
+
+	memset(lt, 0x00, sizeof(LANE_TEST));
+	lt->lanes = nukedopn2l_init(clock, SMPL_RATE);
+	if (lt->lanes == NULL)
+		return 0xFF;
+	nukedopn2l_set_options(lt->lanes, options);
+	nukedopn2l_reset_chip(lt->lanes);
+	for (curLane = 0; curLane < NOPN2L_LANES; curLane ++)
+	{
+		lt->scalar[curLane] = nukedopn2_init(clock, SMPL_RATE);
+		if (lt->scalar[curLane] == NULL)
+			return 0xFF;
+		nukedopn2_set_options(lt->scalar[curLane], options);
+		nukedopn2_reset_chip(lt->scalar[curLane]);
+	}
+	for (curLane = 0; curLane < NOPN2L_LANES * 2; curLane ++)
+		lt->laneBuf[curLane] = (DEV_SMPL*)malloc(BLOCK_SIZE * sizeof(DEV_SMPL));
+	lt->sclBuf[0] = (DEV_SMPL*)malloc(BLOCK_SIZE * sizeof(DEV_SMPL));
+	lt->sclBuf[1] = (DEV_SMPL*)malloc(BLOCK_SIZE * sizeof(DEV_SMPL));
+	return 0x00;
+}
+
+static void LaneTest_Deinit(LANE_TEST* lt)
+{
+	UINT32 curLane;
+
+	if (lt->lanes != NULL)
+		nukedopn2l_shutdown(lt->lanes);
+	for (curLane = 0; curLane < NOPN2L_LANES; curLane ++)
+	{
+		if (lt->scalar[curLane] != NULL)
+			nukedopn2_shutdown(lt->scalar[curLane]);
+	}
+	for (curLane = 0; curLane < NOPN2L_LANES * 2; curLane ++)
+		free(lt->laneBuf[curLane]);
+	free(lt->sclBuf[0]);
+	free(lt->sclBuf[1]);
+	return;
+}
+
+static void LaneTest_Write(LANE_TEST* lt, UINT32 lane, UINT8 port, UINT8 data)
+{
+	nukedopn2l_write(lt->lanes, lane, port, data);
+	nukedopn2_write(lt->scalar[lane], port, data);
+	return;
+}
+
+// renders smplCount (<= BLOCK_SIZE) samples and compares each lane with its scalar instance
+static void LaneTest_Render(LANE_TEST* lt, UINT32 smplCount)
+{
+	UINT32 curLane;
+
+	nukedopn2l_update(lt->lanes, smplCount, lt->laneBuf);
+	for (curLane = 0; curLane < NOPN2L_LANES; curLane ++)
+	{
+		nukedopn2_update(lt->scalar[curLane], smplCount, lt->sclBuf);
+		if (memcmp(lt->laneBuf[curLane * 2 + 0], lt->sclBuf[0], smplCount * sizeof(DEV_SMPL)) ||
+			memcmp(lt->laneBuf[curLane * 2 + 1], lt->sclBuf[1], smplCount * sizeof(DEV_SMPL)))
+			lt->mismatches |= (1 << curLane);
+	}
+	return;
+}
+
+static UINT32 Rnd_Next(UINT32* state)
+{
+	*state = *state * 1103515245 + 12345;
+	return (*state >> 8) & 0xFFFFFF;
+}
+
+static UINT8 RunRandomTest(UINT32 options)
+{
+	LANE_TEST lt;
+	UINT32 rndState[NOPN2L_LANES];
+	UINT32 curLane;
+	UINT32 curRound;
+	UINT32 wrtCnt;
+	UINT32 rnd;
+	UINT8 port;
+	UINT8 reg;
+	UINT32 readErrs;
+
+	if (LaneTest_Init(&lt, OPN2_CLOCK, options))
+	{
+		LaneTest_Deinit(&lt);
+		printf("Out of memory!\n");
+		return 0xFF;
+	}
+	for (curLane = 0; curLane < NOPN2L_LANES; curLane ++)
+		rndState[curLane] = 0x1234 + curLane * 0x9E3779B9 + options;
+
+	readErrs = 0;
+	for (curRound = 0; curRound < RND_ROUNDS; curRound ++)
+	{
+		for (curLane = 0; curLane < NOPN2L_LANES; curLane ++)
+		{
+			rnd = Rnd_Next(&rndState[curLane]);
+			if ((rnd & 0xFF) == 0x00)
+			{
+				nukedopn2l_set_mutemask(lt.lanes, curLane, rnd >> 16);
+				nukedopn2_set_mutemask(lt.scalar[curLane], rnd >> 16);
+			}
+			for (wrtCnt = (rnd >> 8) & 0x03; wrtCnt > 0; wrtCnt --)
+			{
+				rnd = Rnd_Next(&rndState[curLane]);
+				port = (rnd & 0x01) << 1;
+				switch((rnd >> 1) & 0x07)
+				{
+				case 0:	// key on/off
+					reg = 0x28;
+					break;
+				case 1:	// LFO, timers, channel 3 mode, DAC
+					reg = 0x22 + ((rnd >> 4) % 0x0A);
+					break;
+				default:	// operator/channel registers
+					reg = 0x30 + ((rnd >> 4) % 0x87);
+					break;
+				}
+				LaneTest_Write(&lt, curLane, port + 0, reg);
+				LaneTest_Write(&lt, curLane, port + 1, (UINT8)(rnd >> 12));
+			}
+			if (nukedopn2l_read(lt.lanes, curLane, rnd & 0x03) != nukedopn2_read(lt.scalar[curLane], rnd & 0x03))
+				readErrs |= (1 << curLane);
+		}
+		LaneTest_Render(&lt, 1 + (Rnd_Next(&rndState[0]) % 0x40));
+	}
+
+	printf("Random test, options 0x%02X: %s\n", options, (lt.mismatches | readErrs) ? "FAILED" : "OK");
+	if (lt.mismatches | readErrs)
+		printf("\tmismatching lanes: output 0x%02X, status 0x%02X\n", lt.mismatches, readErrs);
+	curLane = lt.mismatches | readErrs;
+	LaneTest_Deinit(&lt);
+	return curLane ? 0x01 : 0x00;
+}
+
+static UINT8 LoadVGM(LANE_FILE* lf)
+{
+	gzFile hFile;
+	UINT32 bufSize;
+	int readBytes;
+
+	hFile = gzopen(lf->fileName, "rb");
+	if (hFile == NULL)
+		return 0xFF;
+	bufSize = 0;
+	lf->size = 0;
+	do
+	{
+		bufSize += 0x100000;
+		lf->data = (UINT8*)realloc(lf->data, bufSize);
+		readBytes = gzread(hFile, &lf->data[lf->size], bufSize - lf->size);
+		if (readBytes > 0)
+			lf->size += readBytes;
+	} while(readBytes > 0 && lf->size == bufSize);
+	gzclose(hFile);
+
+	if (lf->size < 0x40 || memcmp(lf->data, "Vgm ", 4))
+		return 0x80;
+	lf->pos = 0x40;
+	if (lf->data[0x08] >= 0x50 || lf->data[0x09] > 0x01)	// v1.50+: data offset
+	{
+		UINT32 dataOfs = lf->data[0x34] | (lf->data[0x35] << 8) | (lf->data[0x36] << 16) | (lf->data[0x37] << 24);
+		if (dataOfs)
+			lf->pos = 0x34 + dataOfs;
+	}
+	return 0x00;
+}
+
+static UINT32 GetVGMClock(const LANE_FILE* lf)
+{
+	UINT32 hdrOfs;
+
+	// VGMs before v1.10 use the YM2413 clock for YM2612 and YM2151
+	hdrOfs = (lf->data[0x08] < 0x10 && lf->data[0x09] <= 0x01) ? 0x10 : 0x2C;
+	return (lf->data[hdrOfs + 0] | (lf->data[hdrOfs + 1] << 8) |
+		(lf->data[hdrOfs + 2] << 16) | (lf->data[hdrOfs + 3] << 24)) & 0x3FFFFFFF;
+}
+
+// processes all commands until the next delay
+static void ProcessVGM(LANE_TEST* lt, UINT32 lane, LANE_FILE* lf)
+{
+	const UINT8* vgmData = lf->data;
+	UINT8 cmd;
+	UINT32 len;
+
+	while(! lf->wait && ! lf->ended)
+	{
+		if (lf->pos >= lf->size)
+		{
+			lf->ended = 1;
+			break;
+		}
+		cmd = vgmData[lf->pos];
+		len = 0;
+		switch(cmd)
+		{
+		case 0x52:	// YM2612 port 0
+		case 0x53:	// YM2612 port 1
+			LaneTest_Write(lt, lane, ((cmd & 0x01) << 1) | 0, vgmData[lf->pos + 1]);
+			LaneTest_Write(lt, lane, ((cmd & 0x01) << 1) | 1, vgmData[lf->pos + 2]);
+			len = 0x03;
+			break;
+		case 0x61:
+			lf->wait = vgmData[lf->pos + 1] | (vgmData[lf->pos + 2] << 8);
+			len = 0x03;
+			break;
+		case 0x62:
+			lf->wait = 735;
+			len = 0x01;
+			break;
+		case 0x63:
+			lf->wait = 882;
+			len = 0x01;
+			break;
+		case 0x66:
+			lf->ended = 1;
+			break;
+		case 0x67:	// data block
+			len = vgmData[lf->pos + 3] | (vgmData[lf->pos + 4] << 8) |
+				(vgmData[lf->pos + 5] << 16) | ((vgmData[lf->pos + 6] & 0x7F) << 24);
+			if (vgmData[lf->pos + 2] == 0x00)	// YM2612 PCM data
+			{
+				lf->pcmData = (UINT8*)realloc(lf->pcmData, lf->pcmSize + len);
+				memcpy(&lf->pcmData[lf->pcmSize], &vgmData[lf->pos + 7], len);
+				lf->pcmSize += len;
+			}
+			len += 0x07;
+			break;
+		case 0xE0:	// PCM seek
+			lf->pcmPos = vgmData[lf->pos + 1] | (vgmData[lf->pos + 2] << 8) |
+				(vgmData[lf->pos + 3] << 16) | (vgmData[lf->pos + 4] << 24);
+			len = 0x05;
+			break;
+		default:
+			if (cmd >= 0x70 && cmd <= 0x7F)
+			{
+				lf->wait = 1 + (cmd & 0x0F);
+				len = 0x01;
+			}
+			else if (cmd >= 0x80 && cmd <= 0x8F)
+			{
+				if (lf->pcmPos < lf->pcmSize)
+				{
+					LaneTest_Write(lt, lane, 0, 0x2A);
+					LaneTest_Write(lt, lane, 1, lf->pcmData[lf->pcmPos]);
+					lf->pcmPos ++;
+				}
+				lf->wait = cmd & 0x0F;
+				len = 0x01;
+			}
+			else if (cmd >= 0x30 && cmd <= 0x3F)
+				len = 0x02;
+			else if ((cmd >= 0x40 && cmd <= 0x4E) || (cmd >= 0x51 && cmd <= 0x5F) || (cmd >= 0xA0 && cmd <= 0xBF))
+				len = 0x03;	// other chips
+			else if (cmd == 0x4F || cmd == 0x50 || cmd == 0x94)
+				len = 0x02;
+			else if (cmd >= 0xC0 && cmd <= 0xDF)
+				len = 0x04;
+			else if (cmd >= 0xE1 || cmd == 0x90 || cmd == 0x91 || cmd == 0x95)
+				len = 0x05;
+			else if (cmd == 0x92)
+				len = 0x06;
+			else if (cmd == 0x93)
+				len = 0x0B;
+			else if (cmd == 0x68)
+				len = 0x0C;
+			else
+				lf->ended = 1;	// unknown command
+			break;
+		}
+		lf->pos += len;
+	}
+	return;
+}
+
+static void WriteWave(LANE_FILE* lf, const DEV_SMPL* smplL, const DEV_SMPL* smplR, UINT32 smplCount)
+{
+	UINT32 curSmpl;
+	INT32 smpl;
+	UINT8 buf[4];
+	UINT8 curChn;
+
+	for (curSmpl = 0; curSmpl < smplCount; curSmpl ++)
+	{
+		for (curChn = 0; curChn < 2; curChn ++)
+		{
+			smpl = curChn ? smplR[curSmpl] : smplL[curSmpl];
+			if (smpl < -0x8000)
+				smpl = -0x8000;
+			else if (smpl > 0x7FFF)
+				smpl = 0x7FFF;
+			buf[curChn * 2 + 0] = (UINT8)(smpl >> 0);
+			buf[curChn * 2 + 1] = (UINT8)(smpl >> 8);
+		}
+		fwrite(buf, 1, 4, lf->hWav);
+	}
+	lf->wavSmpls += smplCount;
+	return;
+}
+
+static void FinishWave(LANE_FILE* lf)
+{
+	UINT8 hdr[0x2C];
+	UINT32 dataSize = lf->wavSmpls * 4;
+	UINT32 values[5];
+	UINT32 curVal;
+
+	memcpy(&hdr[0x00], "RIFF....WAVEfmt ", 0x10);
+	memcpy(&hdr[0x24], "data", 0x04);
+	values[0] = 0x24 + dataSize;	// RIFF size
+	values[1] = 0x10;	// fmt size
+	values[2] = SMPL_RATE;
+	values[3] = SMPL_RATE * 4;	// bytes per second
+	values[4] = dataSize;
+	for (curVal = 0; curVal < 4; curVal ++)
+	{
+		hdr[0x04 + curVal] = (UINT8)(values[0] >> (curVal * 8));
+		hdr[0x10 + curVal] = (UINT8)(values[1] >> (curVal * 8));
+		hdr[0x18 + curVal] = (UINT8)(values[2] >> (curVal * 8));
+		hdr[0x1C + curVal] = (UINT8)(values[3] >> (curVal * 8));
+		hdr[0x28 + curVal] = (UINT8)(values[4] >> (curVal * 8));
+	}
+	hdr[0x14] = 0x01;	hdr[0x15] = 0x00;	// PCM
+	hdr[0x16] = 0x02;	hdr[0x17] = 0x00;	// channels
+	hdr[0x20] = 0x04;	hdr[0x21] = 0x00;	// block align
+	hdr[0x22] = 0x10;	hdr[0x23] = 0x00;	// bits per sample
+	fseek(lf->hWav, 0, SEEK_SET);
+	fwrite(hdr, 1, 0x2C, lf->hWav);
+	fclose(lf->hWav);
+	lf->hWav = NULL;
+	return;
+}
+
+static UINT8 RunFileTest(UINT32 fileCnt, char* fileNames[], UINT8 writeWav)
+{
+	LANE_TEST lt;
+	LANE_FILE files[NOPN2L_LANES];
+	UINT32 curLane;
+	UINT32 clock;
+	UINT32 smplCount;
+	UINT32 totalSmpls;
+	UINT8 allEnded;
+	UINT8 retVal;
+
+	memset(files, 0x00, sizeof(files));
+	clock = 0;
+	for (curLane = 0; curLane < NOPN2L_LANES; curLane ++)
+	{
+		LANE_FILE* lf = &files[curLane];
+		if (curLane >= fileCnt)
+		{
+			lf->ended = 1;	// unused lanes stay silent
+			continue;
+		}
+		lf->fileName = fileNames[curLane];
+		retVal = LoadVGM(lf);
+		if (retVal)
+		{
+			printf("%s: Error loading file!\n", lf->fileName);
+			lf->ended = 1;
+			continue;
+		}
+		if (! clock)
+			clock = GetVGMClock(lf);
+		if (writeWav)
+		{
+			char* wavName = (char*)malloc(strlen(lf->fileName) + 5);
+			sprintf(wavName, "%s.wav", lf->fileName);
+			lf->hWav = fopen(wavName, "wb");
+			if (lf->hWav == NULL)
+				printf("%s: Error writing %s!\n", lf->fileName, wavName);
+			else
+				fseek(lf->hWav, 0x2C, SEEK_SET);
+			free(wavName);
+		}
+	}
+
+	// all lanes share the clock, so it is taken from the first file
+	if (! clock)
+		clock = OPN2_CLOCK;
+	if (LaneTest_Init(&lt, clock, 0x00))
+	{
+		LaneTest_Deinit(&lt);
+		printf("Out of memory!\n");
+		return 0xFF;
+	}
+
+	totalSmpls = 0;
+	while(1)
+	{
+		allEnded = 1;
+		smplCount = BLOCK_SIZE;
+		for (curLane = 0; curLane < NOPN2L_LANES; curLane ++)
+		{
+			LANE_FILE* lf = &files[curLane];
+			ProcessVGM(&lt, curLane, lf);
+			if (lf->ended)
+				continue;
+			allEnded = 0;
+			if (smplCount > lf->wait)
+				smplCount = lf->wait;
+		}
+		if (allEnded)
+			break;
+
+		LaneTest_Render(&lt, smplCount);
+		totalSmpls += smplCount;
+		for (curLane = 0; curLane < NOPN2L_LANES; curLane ++)
+		{
+			LANE_FILE* lf = &files[curLane];
+			if (lf->ended)
+				continue;
+			lf->wait -= smplCount;
+			if (lf->hWav != NULL)
+				WriteWave(lf, lt.laneBuf[curLane * 2 + 0], lt.laneBuf[curLane * 2 + 1], smplCount);
+		}
+	}
+
+	for (curLane = 0; curLane < fileCnt && curLane < NOPN2L_LANES; curLane ++)
+	{
+		LANE_FILE* lf = &files[curLane];
+		if (lf->data == NULL)
+			continue;
+		printf("%s: %s\n", lf->fileName, (lt.mismatches & (1 << curLane)) ? "FAILED" : "OK");
+		if (lf->hWav != NULL)
+			FinishWave(lf);
+		free(lf->data);
+		free(lf->pcmData);
+	}
+	printf("Rendered %u samples in %u lanes.\n", totalSmpls, NOPN2L_LANES);
+	retVal = lt.mismatches ? 0x01 : 0x00;
+	LaneTest_Deinit(&lt);
+	return retVal;
+}
+
+int main(int argc, char* argv[])
+{
+	UINT8 writeWav;
+	UINT8 retVal;
+	UINT32 options;
+	int argbase;
+
+	writeWav = 0;
+	argbase = 1;
+	if (argbase < argc && ! strcmp(argv[argbase], "-w"))
+	{
+		writeWav = 1;
+		argbase ++;
+	}
+
+	retVal = 0x00;
+	if (argbase >= argc)
+	{
+		for (options = 0x00; options < 0x40; options += 0x10)
+			retVal |= RunRandomTest(options);
+	}
+	else
+	{
+		if (argc - argbase > NOPN2L_LANES)
+			printf("Only the first %u files are rendered.\n", NOPN2L_LANES);
+		retVal = RunFileTest(argc - argbase, &argv[argbase], writeWav);
+	}
+
+	return retVal ? 1 : 0;
+}
@@ -142,8 +142,12 @@ int main(const int argc, char* argv[]) {
 		UINT32 fileSize;
 		auto* fileData = SlurpFile(argv[curSong], &fileSize);
 		dLoad = MemoryLoader_Init(fileData, fileSize);
+		if (dLoad != nullptr)
+			MemoryLoader_SetBackgroundInflate(dLoad, INFL_MODE_STREAM);
 #else
 	dLoad = FileLoader_Init(argv[curSong]);
+		if (dLoad != nullptr)
+			FileLoader_SetBackgroundInflate(dLoad, INFL_MODE_STREAM);
 #endif
 
 		if (dLoad == nullptr) continue;
@@ -0,0 +1,416 @@
+// Core Selector: picks sound cores by their measured cost
+#include <string.h>
+#include <vector>
+
+#include "coreselect.hpp"
+#include "playerbase.hpp"
+#include "../emu/EmuStructs.h"
+#include "../emu/SoundEmu.h"
+#include "../emu/SoundDevs.h"
+#include "../emu/EmuCores.h"
+#include "../utils/OSTimer.h"
+
+#define DEF_CALIB_MSEC	20
+#define CALIB_BLK_SMPLS	256
+#define CALIB_BLK_WRITES	8
+
+// accuracy ranks for devices with multiple cores, higher = more accurate
+// Cores that aren't listed get rank 2 when they are the device's default core and rank 1 otherwise.
+struct CORE_RANK
+{
+	UINT8 devType;
+	UINT32 coreID;
+	UINT8 accuracy;
+};
+static const CORE_RANK CORE_RANKS[] =
+{
+	{DEVID_YM2612,	FCC_NUKE, 3},
+	{DEVID_YM2612,	FCC_GPGX, 2},
+	{DEVID_YM2612,	FCC_GENS, 1},
+	{DEVID_YM2413,	FCC_NUKE, 3},
+	{DEVID_YM2413,	FCC_EMU_, 2},
+	{DEVID_YM2413,	FCC_MAME, 1},
+	{DEVID_YMF262,	FCC_NUKE, 3},
+	{DEVID_YMF262,	FCC_ADLE, 2},
+	{DEVID_YMF262,	FCC_MAME, 1},
+	{DEVID_YM3812,	FCC_NUKE, 3},
+	{DEVID_YM3812,	FCC_ADLE, 2},
+	{DEVID_YM3812,	FCC_MAME, 1},
+};
+
+// register writes for keeping the chips busy during the calibration
+#define WM_DIRECT	1	// write data directly to offsets regLo..regHi
+#define WM_PORT1	2	// address/data at offsets 0/1
+#define WM_PORT2	3	// two address/data pairs at offsets 0/1 and 2/3
+struct CALIB_WRITES
+{
+	UINT8 devType;
+	UINT8 writeMode;
+	UINT8 regLo;
+	UINT8 regHi;
+	INT16 initReg;	// register that is written once after the reset, -1 = none
+	UINT8 initData;
+};
+static const CALIB_WRITES CALIB_WRT_LIST[] =
+{
+	{DEVID_SN76496,	WM_DIRECT,	0x00, 0x00, -1, 0x00},
+	{DEVID_YM2413,	WM_PORT1,	0x00, 0x38, -1, 0x00},
+	{DEVID_YM2612,	WM_PORT2,	0x21, 0xB6, -1, 0x00},
+	{DEVID_YM2151,	WM_PORT1,	0x08, 0xFF, -1, 0x00},
+	{DEVID_YM2203,	WM_PORT1,	0x21, 0xB6, -1, 0x00},
+	{DEVID_YM2608,	WM_PORT2,	0x21, 0xB6, -1, 0x00},
+	{DEVID_YM2610,	WM_PORT2,	0x21, 0xB6, -1, 0x00},
+	{DEVID_YM3812,	WM_PORT1,	0x01, 0xF5, -1, 0x00},
+	{DEVID_YM3526,	WM_PORT1,	0x01, 0xF5, -1, 0x00},
+	{DEVID_YMF262,	WM_PORT2,	0x01, 0xF5, -1, 0x00},
+	{DEVID_AY8910,	WM_PORT1,	0x00, 0x0D, -1, 0x00},
+	{DEVID_NES_APU,	WM_DIRECT,	0x00, 0x0F, 0x15, 0x0F},
+	{DEVID_C6280,	WM_DIRECT,	0x00, 0x09, -1, 0x00},
+};
+
+
+static UINT32 NextRand(UINT32* seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return *seed >> 16;
+}
+
+CoreSelector::CoreSelector() :
+	_calibMSec(DEF_CALIB_MSEC),
+	_totalSpeed(0.0)
+{
+}
+
+void CoreSelector::SetCalibrationTime(UINT32 msec)
+{
+	_calibMSec = msec ? msec : DEF_CALIB_MSEC;
+	return;
+}
+
+/*static*/ UINT8 CoreSelector::GetCoreAccuracy(UINT8 devType, UINT32 coreID)
+{
+	const DEV_DEF** diList;
+	size_t curRank;
+
+	for (curRank = 0; curRank < sizeof(CORE_RANKS) / sizeof(CORE_RANKS[0]); curRank ++)
+	{
+		if (CORE_RANKS[curRank].devType == devType && CORE_RANKS[curRank].coreID == coreID)
+			return CORE_RANKS[curRank].accuracy;
+	}
+	diList = SndEmu_GetDevDefList(devType);
+	if (diList != NULL && diList[0] != NULL && diList[0]->coreID == coreID)
+		return 2;	// the default core is usually the better one
+	return 1;
+}
+
+static const CALIB_WRITES* GetCalibWrites(UINT8 devType)
+{
+	size_t curItm;
+	
+	for (curItm = 0; curItm < sizeof(CALIB_WRT_LIST) / sizeof(CALIB_WRT_LIST[0]); curItm ++)
+	{
+		if (CALIB_WRT_LIST[curItm].devType == devType)
+			return &CALIB_WRT_LIST[curItm];
+	}
+	return NULL;
+}
+
+double CoreSelector::MeasureCore(UINT8 devType, const DEV_DEF* devDef, const DEV_GEN_CFG* devCfg, UINT32* retSmplRate)
+{
+	const CALIB_WRITES* calWrt;
+	DEV_INFO devInf;
+	DEVFUNC_WRITE_A8D8 writeFunc;
+	DEV_SMPL smplL[CALIB_BLK_SMPLS];
+	DEV_SMPL smplR[CALIB_BLK_SMPLS];
+	DEV_SMPL* smplData[2];
+	UINT64 tmrFreq;
+	UINT64 tmrStart;
+	UINT64 tmrEnd;
+	UINT64 tmrMeasure;
+	UINT64 smplCount;
+	UINT32 seed;
+	UINT32 curWrt;
+	UINT8 retVal;
+	
+	memset(&devInf, 0x00, sizeof(DEV_INFO));
+	retVal = devDef->Start(devCfg, &devInf);
+	if (retVal)
+		return 0.0;
+	if (! devInf.sampleRate)
+	{
+		SndEmu_Stop(&devInf);
+		SndEmu_FreeDevLinkData(&devInf);
+		return 0.0;
+	}
+	devDef->Reset(devInf.dataPtr);
+	
+	calWrt = GetCalibWrites(devType);
+	writeFunc = NULL;
+	if (calWrt != NULL)
+	{
+		retVal = SndEmu_GetDeviceFunc(devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, (void**)&writeFunc);
+		if (retVal)
+			writeFunc = NULL;
+	}
+	if (writeFunc != NULL && calWrt->initReg >= 0)
+	{
+		if (calWrt->writeMode == WM_DIRECT)
+		{
+			writeFunc(devInf.dataPtr, (UINT8)calWrt->initReg, calWrt->initData);
+		}
+		else
+		{
+			writeFunc(devInf.dataPtr, 0, (UINT8)calWrt->initReg);
+			writeFunc(devInf.dataPtr, 1, calWrt->initData);
+		}
+	}
+	
+	smplData[0] = smplL;
+	smplData[1] = smplR;
+	seed = 0x1234;	// fixed seed, so that all cores get the same writes
+	tmrFreq = OSTimer_GetFreq();
+	tmrMeasure = tmrFreq * _calibMSec / 1000;
+	smplCount = 0;
+	tmrStart = OSTimer_GetTime();
+	do
+	{
+		if (writeFunc != NULL)
+		{
+			for (curWrt = 0; curWrt < CALIB_BLK_WRITES; curWrt ++)
+			{
+				UINT8 reg = calWrt->regLo + (UINT8)(NextRand(&seed) % (calWrt->regHi - calWrt->regLo + 1));
+				UINT8 data = (UINT8)NextRand(&seed);
+				UINT8 port = (calWrt->writeMode == WM_PORT2) ? (UINT8)(NextRand(&seed) & 0x02) : 0x00;
+				
+				if (calWrt->writeMode == WM_DIRECT)
+				{
+					writeFunc(devInf.dataPtr, reg, data);
+				}
+				else
+				{
+					writeFunc(devInf.dataPtr, port | 0x00, reg);
+					writeFunc(devInf.dataPtr, port | 0x01, data);
+				}
+			}
+		}
+		devDef->Update(devInf.dataPtr, CALIB_BLK_SMPLS, smplData);
+		smplCount += CALIB_BLK_SMPLS;
+		tmrEnd = OSTimer_GetTime();
+	} while(tmrEnd - tmrStart < tmrMeasure);
+	
+	*retSmplRate = devInf.sampleRate;
+	SndEmu_Stop(&devInf);
+	SndEmu_FreeDevLinkData(&devInf);
+	if (tmrEnd == tmrStart)
+		return 0.0;
+	return ((double)smplCount / *retSmplRate) / ((double)(tmrEnd - tmrStart) / tmrFreq);
+}
+
+UINT8 CoreSelector::Calibrate(UINT8 devType, const DEV_GEN_CFG* devCfg)
+{
+	const DEV_DEF** diList;
+	size_t curDev;
+	UINT8 newCores;
+	
+	diList = SndEmu_GetDevDefList(devType);
+	if (diList == NULL || diList[0] == NULL)
+		return 0xF0;
+	
+	newCores = 0;
+	for (curDev = 0; diList[curDev] != NULL; curDev ++)
+	{
+		const DEV_DEF* devDef = diList[curDev];
+		CORE_COST cost;
+		
+		if (GetCost(devType, devDef->coreID, devCfg->clock) != NULL)
+			continue;
+		cost.devType = devType;
+		cost.coreID = devDef->coreID;
+		cost.clock = devCfg->clock;
+		cost.accuracy = GetCoreAccuracy(devType, devDef->coreID);
+		cost.smplRate = 0;
+		cost.speed = MeasureCore(devType, devDef, devCfg, &cost.smplRate);
+		_costs.push_back(cost);
+		newCores ++;
+	}
+	
+	return newCores ? 0x00 : 0x01;
+}
+
+const CORE_COST* CoreSelector::GetCost(UINT8 devType, UINT32 coreID, UINT32 clock) const
+{
+	size_t curCost;
+	
+	for (curCost = 0; curCost < _costs.size(); curCost ++)
+	{
+		const CORE_COST& cost = _costs[curCost];
+		if (cost.devType == devType && cost.coreID == coreID && cost.clock == clock)
+			return &cost;
+	}
+	return NULL;
+}
+
+const std::vector<CORE_COST>& CoreSelector::GetCosts(void) const
+{
+	return _costs;
+}
+
+UINT8 CoreSelector::ApplyToPlayer(PlayerBase* player, double minSpeed)
+{
+	std::vector<PLR_DEV_INFO> devInfList;
+	std::vector< std::vector<const CORE_COST*> > devCands;	// usable cores per device, most accurate first
+	std::vector<size_t> devSel;	// selected candidate per device
+	size_t curDev;
+	double maxCost;
+	double totalCost;
+	UINT8 retVal;
+	
+	_choices.clear();
+	_totalSpeed = 0.0;
+	retVal = player->GetSongDeviceInfo(devInfList);
+	if (retVal >= 0x80)
+		return 0xFF;
+	
+	// Each device costs 1/speed seconds per second of audio.
+	// The devices are rendered one after another, so the costs add up.
+	maxCost = (minSpeed > 0.0) ? (1.0 / minSpeed) : 0.0;
+	// calibrate first, as adding costs invalidates pointers into _costs
+	for (curDev = 0; curDev < devInfList.size(); curDev ++)
+	{
+		if (devInfList[curDev].devCfg != NULL)
+			Calibrate(devInfList[curDev].type, devInfList[curDev].devCfg);
+	}
+	devCands.resize(devInfList.size());
+	devSel.resize(devInfList.size(), 0);
+	for (curDev = 0; curDev < devInfList.size(); curDev ++)
+	{
+		const PLR_DEV_INFO& pdi = devInfList[curDev];
+		std::vector<const CORE_COST*>& cands = devCands[curDev];
+		const DEV_DEF** diList;
+		size_t curCore;
+		
+		if (pdi.devCfg == NULL)
+			continue;	// the format doesn't provide a configuration (sound device not known yet)
+		diList = SndEmu_GetDevDefList(pdi.type);
+		if (diList == NULL)
+			continue;
+		for (curCore = 0; diList[curCore] != NULL; curCore ++)
+		{
+			const CORE_COST* cost = GetCost(pdi.type, diList[curCore]->coreID, pdi.devCfg->clock);
+			size_t insPos;
+			
+			if (cost == NULL || cost->speed <= 0.0)
+				continue;
+			// insertion sort: by accuracy, then by speed
+			for (insPos = 0; insPos < cands.size(); insPos ++)
+			{
+				if (cost->accuracy > cands[insPos]->accuracy ||
+					(cost->accuracy == cands[insPos]->accuracy && cost->speed > cands[insPos]->speed))
+					break;
+			}
+			cands.insert(cands.begin() + insPos, cost);
+		}
+	}
+	
+	totalCost = 0.0;
+	for (curDev = 0; curDev < devCands.size(); curDev ++)
+	{
+		if (! devCands[curDev].empty())
+			totalCost += 1.0 / devCands[curDev][0]->speed;
+	}
+	
+	// Downgrade one device at a time, always the one that saves the most time,
+	// until everything fits into the budget.
+	retVal = 0x00;
+	while(maxCost > 0.0 && totalCost > maxCost)
+	{
+		size_t bestDev = (size_t)-1;
+		size_t bestCand = 0;
+		double bestGain = 0.0;
+		
+		for (curDev = 0; curDev < devCands.size(); curDev ++)
+		{
+			const std::vector<const CORE_COST*>& cands = devCands[curDev];
+			size_t curCand;
+			
+			for (curCand = devSel[curDev] + 1; curCand < cands.size(); curCand ++)
+			{
+				double gain = 1.0 / cands[devSel[curDev]]->speed - 1.0 / cands[curCand]->speed;
+				if (gain > bestGain)
+				{
+					bestDev = curDev;
+					bestCand = curCand;
+					bestGain = gain;
+				}
+				if (gain > 0.0)
+					break;	// take the most accurate core that is faster
+			}
+		}
+		if (bestDev == (size_t)-1)
+		{
+			retVal = 0x01;	// no faster cores left
+			break;
+		}
+		devSel[bestDev] = bestCand;
+		totalCost -= bestGain;
+	}
+	if (retVal == 0x01)
+	{
+		// fall back to the fastest core of each device
+		totalCost = 0.0;
+		for (curDev = 0; curDev < devCands.size(); curDev ++)
+		{
+			const std::vector<const CORE_COST*>& cands = devCands[curDev];
+			size_t curCand;
+			
+			if (cands.empty())
+				continue;
+			for (curCand = 1; curCand < cands.size(); curCand ++)
+			{
+				if (cands[curCand]->speed > cands[devSel[curDev]]->speed)
+					devSel[curDev] = curCand;
+			}
+			totalCost += 1.0 / cands[devSel[curDev]]->speed;
+		}
+	}
+	
+	for (curDev = 0; curDev < devInfList.size(); curDev ++)
+	{
+		const PLR_DEV_INFO& pdi = devInfList[curDev];
+		CORE_CHOICE choice;
+		
+		choice.id = PLR_DEV_ID(pdi.type, pdi.instance);
+		choice.devType = pdi.type;
+		choice.coreID = 0;
+		choice.accuracy = 0;
+		choice.speed = 0.0;
+		if (! devCands[curDev].empty())
+		{
+			const CORE_COST* cost = devCands[curDev][devSel[curDev]];
+			PLR_DEV_OPTS devOpts;
+			
+			if (! player->GetDeviceOptions(choice.id, devOpts))
+			{
+				devOpts.emuCore[0] = cost->coreID;
+				player->SetDeviceOptions(choice.id, devOpts);
+				choice.coreID = cost->coreID;
+				choice.accuracy = cost->accuracy;
+				choice.speed = cost->speed;
+			}
+		}
+		_choices.push_back(choice);
+	}
+	_totalSpeed = (totalCost > 0.0) ? (1.0 / totalCost) : 0.0;
+	
+	return retVal;
+}
+
+const std::vector<CORE_CHOICE>& CoreSelector::GetChoices(void) const
+{
+	return _choices;
+}
+
+double CoreSelector::GetTotalSpeed(void) const
+{
+	return _totalSpeed;
+}
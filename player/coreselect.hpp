@@ -0,0 +1,68 @@
+#ifndef __CORESELECT_HPP__
+#define __CORESELECT_HPP__
+
+#include "../stdtype.h"
+#include "../emu/EmuStructs.h"	// for DEV_GEN_CFG
+#include "playerbase.hpp"
+#include <vector>
+
+struct CORE_COST
+{
+	UINT8 devType;		// sound device ID (see DEVID_ constants in SoundDevs.h)
+	UINT32 coreID;		// FCC of the sound core
+	UINT32 clock;		// chip clock used for the calibration
+	UINT8 accuracy;		// accuracy rank, higher = more accurate
+	UINT32 smplRate;	// native sample rate of the core
+	double speed;		// rendering speed relative to realtime, 0 = core failed to start
+};
+
+struct CORE_CHOICE
+{
+	UINT32 id;			// device ID for PlayerBase::SetDeviceOptions() (PLR_DEV_ID)
+	UINT8 devType;
+	UINT32 coreID;		// selected core, 0 = left at the player's default
+	UINT8 accuracy;
+	double speed;		// measured speed of the selected core
+};
+
+// Core Selector: picks the sound cores for a player based on their measured cost on the current machine.
+// Each core is calibrated by rendering a short time with pseudo-random register writes
+// (chips with sample ROMs are rendered idle). The results are cached per device type, core and clock.
+// Notes:
+//	- Only the main device is measured, linked devices (e.g. the SSG of an YM2203) are not included.
+//	- Speeds are for a single thread and assume that nothing else is running.
+class CoreSelector
+{
+public:
+	CoreSelector();
+
+	void SetCalibrationTime(UINT32 msec);	// measuring time per core (default: 20 ms)
+	// Measures all cores of a device type using the given configuration. (emuCore is ignored)
+	// Returns 0x00 on success, 0x01 if it was already measured, 0xF0 for unknown devices.
+	UINT8 Calibrate(UINT8 devType, const DEV_GEN_CFG* devCfg);
+	// Note: The returned pointer is invalidated by Calibrate() and ApplyToPlayer().
+	const CORE_COST* GetCost(UINT8 devType, UINT32 coreID, UINT32 clock) const;
+	const std::vector<CORE_COST>& GetCosts(void) const;
+
+	// Selects the most accurate core for each device of a loaded player, so that all devices together
+	// render at least minSpeed times faster than realtime. Must be called between LoadFile() and Start().
+	// Returns:
+	//	0x00 - the selection fits the budget
+	//	0x01 - the budget can't be met, the fastest cores were selected
+	//	0xFF - unable to get the device list
+	UINT8 ApplyToPlayer(PlayerBase* player, double minSpeed);
+	const std::vector<CORE_CHOICE>& GetChoices(void) const;	// decisions of the last ApplyToPlayer() call
+	double GetTotalSpeed(void) const;	// combined speed of the selected cores
+
+	static UINT8 GetCoreAccuracy(UINT8 devType, UINT32 coreID);
+
+protected:
+	double MeasureCore(UINT8 devType, const DEV_DEF* devDef, const DEV_GEN_CFG* devCfg, UINT32* retSmplRate);
+
+	UINT32 _calibMSec;
+	std::vector<CORE_COST> _costs;
+	std::vector<CORE_CHOICE> _choices;
+	double _totalSpeed;
+};
+
+#endif	// __CORESELECT_HPP__
@@ -15,6 +15,9 @@
 #include "../emu/EmuCores.h"
 #include "helper.h"
 #include "logging.h"
+#ifdef PLAYER_PROFILING
+#include "../utils/OSTimer.h"
+#endif
 
 enum DRO_HWTYPES
 {
@@ -624,17 +627,20 @@ UINT8 DROPlayer::Start(void)
 		
 		cDev->base.defInf.dataPtr = NULL;
 		cDev->base.linkDev = NULL;
+		cDev->shadow = NULL;
 		cDev->optID = DeviceID2OptionID(curDev);
 		
 		devOpts = (cDev->optID != (size_t)-1) ? &_devOpts[cDev->optID] : NULL;
 		devCfg->emuCore = (devOpts != NULL) ? devOpts->emuCore[0] : 0x00;
 		devCfg->srMode = (devOpts != NULL) ? devOpts->srMode : DEVRI_SRMODE_NATIVE;
+		devCfg->memArena = _memArena;
 		if (devOpts != NULL && devOpts->smplRate)
 			devCfg->smplRate = devOpts->smplRate;
 		else
 			devCfg->smplRate = _outSmplRate;
 		
 		retVal = SndEmu_Start(_devTypes[curDev], devCfg, &cDev->base.defInf);
+		devCfg->memArena = NULL;	// the stored configuration must not refer to the arena
 		if (retVal)
 		{
 			cDev->base.defInf.dataPtr = NULL;
@@ -659,6 +665,7 @@ UINT8 DROPlayer::Start(void)
 				clDev->defInf.devDef->SetMuteMask(clDev->defInf.dataPtr, devOpts->muteOpts.chnMute[0]);
 			
 			Resmpl_SetVals(&clDev->resmpl, 0xFF, 0x100, _outSmplRate);
+			clDev->resmpl.memArena = _memArena;
 			// do DualOPL2 hard panning by muting either the left or right speaker
 			if (_devPanning[curDev] & 0x02)
 				clDev->resmpl.volumeL = 0x00;
@@ -668,6 +675,7 @@ UINT8 DROPlayer::Start(void)
 			Resmpl_Init(&clDev->resmpl);
 		}
 	}
+	InitPlayStats(_devices.size(), 0);
 	
 	_playState |= PLAYSTATE_PLAY;
 	Reset();
@@ -686,9 +694,13 @@ UINT8 DROPlayer::Stop(void)
 	for (curDev = 0; curDev < _devices.size(); curDev ++)
 	{
 		DRO_CHIPDEV* cDev = &_devices[curDev];
+		if (cDev->shadow != NULL)
+			RegShadow_Deinit(cDev->shadow);
 		FreeDeviceTree(&cDev->base, 0);
 	}
 	_devices.clear();
+	if (_memArena != NULL)
+		MemArena_Reset(_memArena);
 	if (_eventCbFunc != NULL)
 		_eventCbFunc(this, _eventCbParam, PLREVT_STOP, NULL);
 	
@@ -766,21 +778,28 @@ UINT8 DROPlayer::Seek(UINT8 unit, UINT32 pos)
 	{
 	case PLAYPOS_FILEOFS:
 		_playState |= PLAYSTATE_SEEK;
+		InitRegShadows();
 		if (pos < _filePos)
 			Reset();
-		return SeekToFilePos(pos);
+		SeekToFilePos(pos);
+		break;
 	case PLAYPOS_SAMPLE:
 		pos = Sample2Tick(pos);
 		// fall through
 	case PLAYPOS_TICK:
 		_playState |= PLAYSTATE_SEEK;
+		InitRegShadows();
 		if (pos < _playTick)
 			Reset();
-		return SeekToTick(pos);
+		SeekToTick(pos);
+		break;
 	case PLAYPOS_COMMAND:
 	default:
 		return 0xFF;
 	}
+	FlushRegShadows();
+	
+	return 0x00;
 }
 
 UINT8 DROPlayer::SeekToTick(UINT32 tick)
@@ -813,6 +832,41 @@ UINT8 DROPlayer::SeekToFilePos(UINT32 pos)
 	return 0x00;
 }
 
+void DROPlayer::InitRegShadows(void)
+{
+	size_t curDev;
+	
+	if (_seekMode != PLRSEEK_FAST)
+		return;
+	
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		DRO_CHIPDEV* cDev = &_devices[curDev];
+		if (cDev->base.defInf.dataPtr == NULL || cDev->shadow != NULL)
+			continue;
+		RegShadow_Init(&cDev->shadow, _devTypes[curDev], &cDev->base.defInf, cDev->write);
+	}
+	
+	return;
+}
+
+void DROPlayer::FlushRegShadows(void)
+{
+	size_t curDev;
+	
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		DRO_CHIPDEV* cDev = &_devices[curDev];
+		if (cDev->shadow == NULL)
+			continue;
+		RegShadow_Flush(cDev->shadow);
+		RegShadow_Deinit(cDev->shadow);
+		cDev->shadow = NULL;
+	}
+	
+	return;
+}
+
 UINT32 DROPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 {
 	UINT32 curSmpl;
@@ -820,6 +874,10 @@ UINT32 DROPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 	UINT32 maxSmpl;
 	INT32 smplStep;	// might be negative due to rounding errors in Tick2Sample
 	size_t curDev;
+#ifdef PLAYER_PROFILING
+	UINT64 renderStart = OSTimer_GetTime();
+	UINT64 devStart;
+#endif
 	
 	// Note: use do {} while(), so that "smplCnt == 0" can be used to process until reaching the next sample.
 	curSmpl = 0;
@@ -842,11 +900,18 @@ UINT32 DROPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 			UINT8 disable = (cDev->optID != (size_t)-1) ? _devOpts[cDev->optID].muteOpts.disable : 0x00;
 			VGM_BASEDEV* clDev;
 			
+#ifdef PLAYER_PROFILING
+			devStart = OSTimer_GetTime();
+#endif
 			for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev, disable >>= 1)
 			{
 				if (clDev->defInf.dataPtr != NULL && ! (disable & 0x01))
 					Resmpl_Execute(&clDev->resmpl, smplStep, &data[curSmpl]);
 			}
+#ifdef PLAYER_PROFILING
+			_playStats.devStats[curDev].renderTime += OSTimer_GetTime() - devStart;
+			_playStats.devStats[curDev].smplCount += smplStep;
+#endif
 		}
 		curSmpl += smplStep;
 		_playSmpl += smplStep;
@@ -857,6 +922,10 @@ UINT32 DROPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 		}
 	} while(curSmpl < smplCnt);
 	
+#ifdef PLAYER_PROFILING
+	_playStats.renderTime += OSTimer_GetTime() - renderStart;
+	_playStats.smplCount += curSmpl;
+#endif
 	return curSmpl;
 }
 
@@ -998,8 +1067,16 @@ void DROPlayer::WriteReg(UINT8 port, UINT8 reg, UINT8 data)
 	DEV_DATA* dataPtr = cDev->base.defInf.dataPtr;
 	if (dataPtr == NULL || cDev->write == NULL)
 		return;
+#ifdef PLAYER_PROFILING
+	_playStats.devStats[devID].regWrites ++;
+#endif
 	
 	port &= _portMask;
+	if (cDev->shadow != NULL)
+	{
+		RegShadow_Write(cDev->shadow, port, reg, data);
+		return;
+	}
 	cDev->write(dataPtr, (port << 1) | 0, reg);
 	cDev->write(dataPtr, (port << 1) | 1, data);
 	
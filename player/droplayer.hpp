@@ -5,6 +5,7 @@
 #include "../emu/EmuStructs.h"
 #include "../emu/Resampler.h"
 #include "helper.h"
+#include "regshadow.h"
 #include "playerbase.hpp"
 #include "../utils/DataLoader.h"
 #include <vector>
@@ -76,6 +77,7 @@ struct _dro_chip_device
 	VGM_BASEDEV base;
 	size_t optID;
 	DEVFUNC_WRITE_A8D8 write;
+	REG_SHADOW* shadow;	// only used while seeking
 };
 
 class DROPlayer : public PlayerBase
@@ -134,6 +136,8 @@ private:
 	void GenerateDeviceConfig(void);
 	UINT8 SeekToTick(UINT32 tick);
 	UINT8 SeekToFilePos(UINT32 pos);
+	void InitRegShadows(void);
+	void FlushRegShadows(void);
 	void ParseFile(UINT32 ticks);
 	void DoCommand_v1(void);
 	void DoCommand_v2(void);
@@ -3,13 +3,20 @@
 #include <stdlib.h>
 #include <string.h>	// for memset()
 
+#ifdef PLAYER_PROFILING
+#include "../utils/OSTimer.h"
+#endif
+
 PlayerBase::PlayerBase() :
 	_outSmplRate(0),
 	_eventCbFunc(NULL),
 	_eventCbParam(NULL),
 	_fileReqCbFunc(NULL),
-	_fileReqCbParam(NULL)
+	_fileReqCbParam(NULL),
+	_memArena(NULL),
+	_seekMode(PLRSEEK_EXACT)
 {
+	InitPlayStats(0, 0);
 }
 
 PlayerBase::~PlayerBase()
@@ -36,6 +43,11 @@ UINT8 PlayerBase::CanLoadFile(DATA_LOADER *dataLoader) const
 	return this->PlayerCanLoadFile(dataLoader);
 }
 
+UINT8 PlayerBase::ProbeFile(DATA_LOADER *dataLoader)
+{
+	return this->LoadFile(dataLoader);
+}
+
 /*static*/ UINT8 PlayerBase::InitDeviceOptions(PLR_DEV_OPTS& devOpts)
 {
 	devOpts.emuCore[0] = 0x00;
@@ -83,6 +95,37 @@ void PlayerBase::SetFileReqCallback(PLAYER_FILEREQ_CB cbFunc, void* cbParam)
 	return;
 }
 
+void PlayerBase::SetMemArena(MEM_ARENA* arena)
+{
+	_memArena = arena;
+	
+	return;
+}
+
+MEM_ARENA* PlayerBase::GetMemArena(void) const
+{
+	return _memArena;
+}
+
+UINT8 PlayerBase::SetSeekMode(UINT8 mode)
+{
+	if (mode > PLRSEEK_FAST)
+		return 0x80;
+	_seekMode = mode;
+	
+	return 0x00;
+}
+
+UINT8 PlayerBase::GetSeekMode(void) const
+{
+	return _seekMode;
+}
+
+UINT8 PlayerBase::SetLoopCache(UINT32 maxSmpls)
+{
+	return 0x80;	// not supported
+}
+
 double PlayerBase::Sample2Second(UINT32 samples) const
 {
 	return samples / (double)_outSmplRate;
@@ -92,3 +135,50 @@ UINT32 PlayerBase::GetTotalPlayTicks(UINT32 numLoops) const
 {
 	return GetTotalTicks() + GetLoopTicks() * (numLoops - 1);
 }
+
+UINT8 PlayerBase::GetPlayStats(PLR_PLAY_STATS& stats) const
+{
+#ifdef PLAYER_PROFILING
+	stats = _playStats;
+	stats.timerFreq = OSTimer_GetFreq();
+	return 0x00;
+#else
+	return 0xFF;	// statistics are not collected
+#endif
+}
+
+UINT8 PlayerBase::ResetPlayStats(void)
+{
+	size_t curDev;
+	size_t curCmd;
+	
+	_playStats.renderTime = 0;
+	_playStats.smplCount = 0;
+	_playStats.dataBlkBytes = 0;
+	for (curDev = 0; curDev < _playStats.devStats.size(); curDev ++)
+	{
+		PLR_DEV_STATS& dStats = _playStats.devStats[curDev];
+		dStats.renderTime = 0;
+		dStats.smplCount = 0;
+		dStats.regWrites = 0;
+		dStats.dataBytes = 0;
+	}
+	for (curCmd = 0; curCmd < _playStats.cmdCount.size(); curCmd ++)
+		_playStats.cmdCount[curCmd] = 0;
+	
+	return 0x00;
+}
+
+void PlayerBase::InitPlayStats(size_t devCount, size_t cmdCount)
+{
+	size_t curDev;
+	
+	_playStats.timerFreq = 0;
+	_playStats.devStats.resize(devCount);
+	for (curDev = 0; curDev < devCount; curDev ++)
+		_playStats.devStats[curDev].id = (UINT32)curDev;
+	_playStats.cmdCount.resize(cmdCount);
+	ResetPlayStats();
+	
+	return;
+}
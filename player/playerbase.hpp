@@ -4,7 +4,9 @@
 #include "../stdtype.h"
 #include "../emu/EmuStructs.h"	// for DEV_GEN_CFG
 #include "../emu/Resampler.h"	// for WAVE_32BS
+#include "../emu/MemArena.h"
 #include "../utils/DataLoader.h"
+#include <stddef.h>	// for size_t
 #include <vector>
 
 
@@ -20,6 +22,10 @@
 #define PLAYPOS_SAMPLE	0x02	// sample number (scale: rendering sample rate)
 #define PLAYPOS_COMMAND	0x03	// internal command ID
 
+// SetSeekMode() modes
+#define PLRSEEK_EXACT	0x00	// send all register writes to the sound chips while seeking
+#define PLRSEEK_FAST	0x01	// collect register writes while seeking and send only the final register state (for supported chips)
+
 // callback functions and event constants
 class PlayerBase;
 typedef UINT8 (*PLAYER_EVENT_CB)(PlayerBase* player, void* userParam, UINT8 evtType, void* evtParam);
@@ -78,6 +84,25 @@ struct PLR_DEV_OPTS
 	PLR_PAN_OPTS panOpts;
 };
 
+// Note: Statistics are only collected when the player library is compiled with PLAYER_PROFILING.
+struct PLR_DEV_STATS
+{
+	UINT32 id;			// device ID (same as PLR_DEV_INFO::id)
+	UINT64 renderTime;	// time spent in Resmpl_Execute()/sound core Update() (unit: timer ticks)
+	UINT64 smplCount;	// number of samples rendered
+	UINT64 regWrites;	// number of write commands sent to the device
+	UINT64 dataBytes;	// number of bytes uploaded to the device's ROM/RAM
+};
+struct PLR_PLAY_STATS
+{
+	UINT64 timerFreq;	// timer ticks per second
+	UINT64 renderTime;	// total time spent in Render() (unit: timer ticks)
+	UINT64 smplCount;	// total number of samples rendered
+	UINT64 dataBlkBytes;	// number of bytes loaded into the player's PCM data banks
+	std::vector<PLR_DEV_STATS> devStats;
+	std::vector<UINT64> cmdCount;	// number of executions per command byte (empty if not supported by the format)
+};
+
 
 //	--- concept ---
 //	- Player class does file rendering at fixed volume (but changeable speed)
@@ -94,6 +119,9 @@ public:
 	static UINT8 PlayerCanLoadFile(DATA_LOADER *dataLoader);
 	virtual UINT8 CanLoadFile(DATA_LOADER *dataLoader) const;
 	virtual UINT8 LoadFile(DATA_LOADER *dataLoader) = 0;
+	// load only what is needed for tags, song and device info, Start() requires a LoadFile() afterwards
+	// The default implementation loads the whole file.
+	virtual UINT8 ProbeFile(DATA_LOADER *dataLoader);
 	virtual UINT8 UnloadFile(void) = 0;
 	
 	virtual const char* const* GetTags(void) = 0;
@@ -113,6 +141,18 @@ public:
 	virtual UINT8 SetPlaybackSpeed(double speed);
 	virtual void SetEventCallback(PLAYER_EVENT_CB cbFunc, void* cbParam);
 	virtual void SetFileReqCallback(PLAYER_FILEREQ_CB cbFunc, void* cbParam);
+	// Set an arena for per-session allocations. It is reset by Stop(), so it must not be shared with another player that is running at the same time.
+	// Must be called while the player is stopped. (NULL = use the heap)
+	virtual void SetMemArena(MEM_ARENA* arena);
+	MEM_ARENA* GetMemArena(void) const;
+	// PLRSEEK_FAST is much faster for long seeks, but the chip state can differ slightly from PLRSEEK_EXACT.
+	// Fast seeks may not match exact seeks. Register shadowing is only used with cores that were verified to match.
+	virtual UINT8 SetSeekMode(UINT8 mode);
+	UINT8 GetSeekMode(void) const;
+	// Loop output cache: When the complete playback state at the start of a loop equals the state at an earlier loop,
+	// the samples rendered since then are replayed instead of emulating the loop again.
+	// maxSmpls = maximum number of samples to be cached, 0 = disable (default)
+	virtual UINT8 SetLoopCache(UINT32 maxSmpls);	// returns 0x80 if the player doesn't support it
 	virtual UINT32 Tick2Sample(UINT32 ticks) const = 0;
 	virtual UINT32 Sample2Tick(UINT32 samples) const = 0;
 	virtual double Tick2Second(UINT32 ticks) const = 0;
@@ -131,12 +171,21 @@ public:
 	virtual UINT8 Seek(UINT8 unit, UINT32 pos) = 0; // seek to playback position
 	virtual UINT32 Render(UINT32 smplCnt, WAVE_32BS* data) = 0;
 	
+	// render statistics (reset by Start() and ResetPlayStats())
+	virtual UINT8 GetPlayStats(PLR_PLAY_STATS& stats) const;	// returns 0xFF when compiled without profiling support
+	virtual UINT8 ResetPlayStats(void);
+	
 protected:
+	void InitPlayStats(size_t devCount, size_t cmdCount);
+	
 	UINT32 _outSmplRate;
 	PLAYER_EVENT_CB _eventCbFunc;
 	void* _eventCbParam;
 	PLAYER_FILEREQ_CB _fileReqCbFunc;
 	void* _fileReqCbParam;
+	MEM_ARENA* _memArena;
+	UINT8 _seekMode;
+	PLR_PLAY_STATS _playStats;
 };
 
 #endif	// __PLAYERBASE_HPP__
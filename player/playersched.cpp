@@ -0,0 +1,400 @@
+// Player Scheduler: renders many players on a fixed pool of worker threads
+#include <string.h>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "playersched.hpp"
+#include "playerbase.hpp"
+#include "../utils/OSMutex.h"
+#include "../utils/OSSignal.h"
+#include "../utils/OSThread.h"
+#include "../utils/OSTimer.h"
+
+#define DEF_QUANTUM		512
+#define DEF_BUF_QUANTA	4
+
+
+PlayerScheduler::PlayerScheduler() :
+	_mutex(NULL),
+	_workSignal(NULL),
+	_quit(0),
+	_defQuantum(DEF_QUANTUM),
+	_tmrFreq(OSTimer_GetFreq()),
+	_streamCount(0),
+	_missedDeadlines(0)
+{
+	UINT8 retVal;
+
+	retVal = OSMutex_Init(&_mutex, 0);
+	if (retVal)
+		_mutex = NULL;
+	retVal = OSSignal_Init(&_workSignal, 0);
+	if (retVal)
+		_workSignal = NULL;
+}
+
+PlayerScheduler::~PlayerScheduler()
+{
+	size_t curStrm;
+
+	Stop();
+	for (curStrm = 0; curStrm < _streams.size(); curStrm ++)
+	{
+		STREAM* strm = _streams[curStrm];
+		if (strm == NULL)
+			continue;
+		OSSignal_Deinit(strm->doneSignal);
+		delete strm;
+	}
+	_streams.clear();
+
+	if (_workSignal != NULL)
+		OSSignal_Deinit(_workSignal);
+	if (_mutex != NULL)
+		OSMutex_Deinit(_mutex);
+}
+
+UINT8 PlayerScheduler::Start(UINT32 workerCount)
+{
+	UINT32 curWrk;
+	UINT8 retVal;
+
+	if (_mutex == NULL || _workSignal == NULL)
+		return 0xFF;
+	if (! _workers.empty())
+		return 0x01;	// already running
+	if (! workerCount)
+		workerCount = 1;
+
+	_quit = 0;
+	OSSignal_Reset(_workSignal);
+	_workers.resize(workerCount);
+	for (curWrk = 0; curWrk < workerCount; curWrk ++)
+	{
+		_workers[curWrk].sched = this;
+		retVal = OSThread_Init(&_workers[curWrk].thread, &PlayerScheduler::WorkerThread, &_workers[curWrk]);
+		if (retVal)
+		{
+			_workers.resize(curWrk);
+			Stop();
+			return 0x80;
+		}
+	}
+	return 0x00;
+}
+
+void PlayerScheduler::Stop(void)
+{
+	size_t curWrk;
+
+	if (_workers.empty())
+		return;
+
+	OSMutex_Lock(_mutex);
+	_quit = 1;
+	OSMutex_Unlock(_mutex);
+	OSSignal_Signal(_workSignal);	// each worker passes the signal on before exiting
+	for (curWrk = 0; curWrk < _workers.size(); curWrk ++)
+	{
+		OSThread_Join(_workers[curWrk].thread);
+		OSThread_Deinit(_workers[curWrk].thread);
+	}
+	_workers.clear();
+	_quit = 0;
+	return;
+}
+
+void PlayerScheduler::SetDefaultQuantum(UINT32 smplCnt)
+{
+	_defQuantum = smplCnt ? smplCnt : DEF_QUANTUM;
+	return;
+}
+
+UINT32 PlayerScheduler::AddStream(PlayerBase* player, const PLRSCHED_STREAM_CFG& cfg)
+{
+	STREAM* strm;
+	UINT32 streamID;
+	UINT8 retVal;
+
+	if (_mutex == NULL || player == NULL || ! player->GetSampleRate())
+		return (UINT32)-1;
+
+	strm = new STREAM;
+	retVal = OSSignal_Init(&strm->doneSignal, 0);
+	if (retVal)
+	{
+		delete strm;
+		return (UINT32)-1;
+	}
+	strm->player = player;
+	strm->smplRate = player->GetSampleRate();
+	strm->quantum = cfg.quantumSmpls ? cfg.quantumSmpls : _defQuantum;
+	strm->smplLimit = cfg.smplLimit;
+	strm->buf.resize(cfg.bufSmpls ? cfg.bufSmpls : strm->quantum * DEF_BUF_QUANTA);
+	if (strm->buf.size() < strm->quantum)
+		strm->buf.resize(strm->quantum);
+	strm->writeCnt = 0;
+	strm->readCnt = 0;
+	strm->lastRead = OSTimer_GetTime();
+	strm->deadline = 0;
+	strm->queued = 0;
+	strm->busy = 0;
+	strm->removing = 0;
+	strm->finished = 0;
+	memset(&strm->stats, 0x00, sizeof(PLRSCHED_STATS));
+	strm->stats.bufSize = (UINT32)strm->buf.size();
+
+	OSMutex_Lock(_mutex);
+	for (streamID = 0; streamID < _streams.size(); streamID ++)
+	{
+		if (_streams[streamID] == NULL)
+			break;
+	}
+	if (streamID < _streams.size())
+		_streams[streamID] = strm;
+	else
+		_streams.push_back(strm);
+	_streamCount ++;
+	UpdateQueue(streamID);
+	OSMutex_Unlock(_mutex);
+
+	OSSignal_Signal(_workSignal);
+	return streamID;
+}
+
+UINT8 PlayerScheduler::RemoveStream(UINT32 streamID)
+{
+	STREAM* strm;
+
+	if (_mutex == NULL)
+		return 0xFF;
+	OSMutex_Lock(_mutex);
+	if (streamID >= _streams.size() || _streams[streamID] == NULL || _streams[streamID]->removing)
+	{
+		OSMutex_Unlock(_mutex);
+		return 0xFF;
+	}
+	strm = _streams[streamID];
+	strm->removing = 1;
+	UpdateQueue(streamID);	// takes it out of the ready queue
+	while (strm->busy)
+	{
+		OSMutex_Unlock(_mutex);
+		OSSignal_Wait(strm->doneSignal);
+		OSMutex_Lock(_mutex);
+	}
+	_streams[streamID] = NULL;
+	_streamCount --;
+	OSMutex_Unlock(_mutex);
+
+	OSSignal_Deinit(strm->doneSignal);
+	delete strm;
+	return 0x00;
+}
+
+UINT32 PlayerScheduler::ReadStream(UINT32 streamID, UINT32 smplCnt, WAVE_32BS* data)
+{
+	STREAM* strm;
+	UINT32 bufSize;
+	UINT32 readCnt;
+	UINT32 bufPos;
+	UINT32 curSmpl;
+	UINT8 queued;
+
+	if (_mutex == NULL)
+		return 0;
+	OSMutex_Lock(_mutex);
+	if (streamID >= _streams.size() || _streams[streamID] == NULL)
+	{
+		OSMutex_Unlock(_mutex);
+		return 0;
+	}
+	strm = _streams[streamID];
+	readCnt = (UINT32)(strm->writeCnt - strm->readCnt);
+	if (readCnt > smplCnt)
+		readCnt = smplCnt;
+	OSMutex_Unlock(_mutex);
+
+	// The worker only writes to the free part of the buffer, so the samples can be copied without the lock.
+	bufSize = (UINT32)strm->buf.size();
+	bufPos = (UINT32)(strm->readCnt % bufSize);
+	for (curSmpl = 0; curSmpl < readCnt; curSmpl ++)
+	{
+		data[curSmpl].L += strm->buf[bufPos].L;
+		data[curSmpl].R += strm->buf[bufPos].R;
+		bufPos ++;
+		if (bufPos >= bufSize)
+			bufPos = 0;
+	}
+
+	OSMutex_Lock(_mutex);
+	strm->readCnt += readCnt;
+	strm->lastRead = OSTimer_GetTime();
+	if (readCnt < smplCnt && ! strm->finished)
+		strm->stats.underruns ++;
+	UpdateQueue(streamID);
+	queued = strm->queued;
+	OSMutex_Unlock(_mutex);
+
+	if (queued)
+		OSSignal_Signal(_workSignal);
+	return readCnt;
+}
+
+UINT8 PlayerScheduler::GetStreamStats(UINT32 streamID, PLRSCHED_STATS& stats) const
+{
+	const STREAM* strm;
+
+	if (_mutex == NULL)
+		return 0xFF;
+	OSMutex_Lock(_mutex);
+	if (streamID >= _streams.size() || _streams[streamID] == NULL)
+	{
+		OSMutex_Unlock(_mutex);
+		return 0xFF;
+	}
+	strm = _streams[streamID];
+	stats = strm->stats;
+	stats.bufLevel = (UINT32)(strm->writeCnt - strm->readCnt);
+	stats.finished = strm->finished;
+	OSMutex_Unlock(_mutex);
+	return 0x00;
+}
+
+UINT32 PlayerScheduler::GetStreamCount(void) const
+{
+	return _streamCount;
+}
+
+UINT32 PlayerScheduler::GetMissedDeadlines(void) const
+{
+	return _missedDeadlines;
+}
+
+/*static*/ void PlayerScheduler::WorkerThread(void* args)
+{
+	WORKER* wrk = (WORKER*)args;
+	wrk->sched->WorkerMain();
+	return;
+}
+
+void PlayerScheduler::WorkerMain(void)
+{
+	STREAM* strm;
+	UINT32 streamID;
+	UINT32 smplCnt;
+	UINT32 bufFree;
+	UINT64 startTime;
+
+	while(1)
+	{
+		OSMutex_Lock(_mutex);
+		if (_quit)
+		{
+			OSMutex_Unlock(_mutex);
+			OSSignal_Signal(_workSignal);	// wake up the next worker
+			break;
+		}
+		if (_ready.empty())
+		{
+			OSMutex_Unlock(_mutex);
+			OSSignal_Wait(_workSignal);
+			continue;
+		}
+
+		// earliest deadline first
+		streamID = _ready.begin()->second;
+		_ready.erase(_ready.begin());
+		strm = _streams[streamID];
+		strm->queued = 0;
+		strm->busy = 1;
+		startTime = OSTimer_GetTime();
+		if (strm->writeCnt > 0 && startTime > strm->deadline)
+		{
+			strm->stats.missedDeadlines ++;
+			_missedDeadlines ++;
+		}
+		bufFree = (UINT32)(strm->buf.size() - (strm->writeCnt - strm->readCnt));
+		smplCnt = (strm->quantum < bufFree) ? strm->quantum : bufFree;
+		if (strm->smplLimit && strm->writeCnt + smplCnt > strm->smplLimit)
+			smplCnt = (UINT32)(strm->smplLimit - strm->writeCnt);
+		if (! _ready.empty())
+			OSSignal_Signal(_workSignal);	// let another worker take the next stream
+		OSMutex_Unlock(_mutex);
+
+		RenderQuantum(strm, smplCnt);
+
+		OSMutex_Lock(_mutex);
+		strm->writeCnt += smplCnt;
+		strm->stats.smplCount += smplCnt;
+		strm->stats.quantaCount ++;
+		strm->stats.renderTime += OSTimer_GetTime() - startTime;
+		if (strm->smplLimit)
+			strm->finished = (strm->writeCnt >= strm->smplLimit);
+		else if (strm->player->GetState() & PLAYSTATE_END)
+			strm->finished = 1;
+		strm->busy = 0;
+		if (strm->removing)
+			OSSignal_Signal(strm->doneSignal);
+		else
+			UpdateQueue(streamID);
+		OSMutex_Unlock(_mutex);
+	}
+
+	return;
+}
+
+void PlayerScheduler::RenderQuantum(STREAM* strm, UINT32 smplCnt)
+{
+	UINT32 bufSize = (UINT32)strm->buf.size();
+	UINT32 bufPos = (UINT32)(strm->writeCnt % bufSize);
+
+	// the free part of the ring buffer may wrap around
+	while(smplCnt > 0)
+	{
+		UINT32 renderSmpls = bufSize - bufPos;
+		if (renderSmpls > smplCnt)
+			renderSmpls = smplCnt;
+		memset(&strm->buf[bufPos], 0x00, renderSmpls * sizeof(WAVE_32BS));
+		strm->player->Render(renderSmpls, &strm->buf[bufPos]);
+		smplCnt -= renderSmpls;
+		bufPos = 0;
+	}
+	return;
+}
+
+UINT64 PlayerScheduler::GetDeadline(const STREAM* strm) const
+{
+	// time when the buffer runs empty with realtime playback
+	UINT64 bufLevel = strm->writeCnt - strm->readCnt;
+	return strm->lastRead + bufLevel * _tmrFreq / strm->smplRate;
+}
+
+void PlayerScheduler::UpdateQueue(UINT32 streamID)
+{
+	STREAM* strm = _streams[streamID];
+	UINT32 bufFree;
+	UINT32 needSmpls;
+
+	if (strm->queued)
+	{
+		_ready.erase(READY_KEY(strm->deadline, streamID));
+		strm->queued = 0;
+	}
+	if (strm->busy || strm->finished || strm->removing)
+		return;
+
+	// wait until there is room for a whole quantum (or the rest of the stream)
+	bufFree = (UINT32)(strm->buf.size() - (strm->writeCnt - strm->readCnt));
+	needSmpls = strm->quantum;
+	if (strm->smplLimit && strm->writeCnt + needSmpls > strm->smplLimit)
+		needSmpls = (UINT32)(strm->smplLimit - strm->writeCnt);
+	if (bufFree < needSmpls)
+		return;
+
+	strm->deadline = GetDeadline(strm);
+	_ready.insert(READY_KEY(strm->deadline, streamID));
+	strm->queued = 1;
+	return;
+}
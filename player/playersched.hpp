@@ -0,0 +1,114 @@
+#ifndef __PLAYERSCHED_HPP__
+#define __PLAYERSCHED_HPP__
+
+#include "../stdtype.h"
+#include "../emu/Resampler.h"	// for WAVE_32BS
+#include "../utils/OSMutex.h"
+#include "../utils/OSSignal.h"
+#include "../utils/OSThread.h"
+#include "playerbase.hpp"
+#include <set>
+#include <utility>
+#include <vector>
+
+struct PLRSCHED_STREAM_CFG
+{
+	UINT32 quantumSmpls;	// samples rendered per scheduling step (0 = scheduler default)
+	UINT32 bufSmpls;		// size of the stream's output buffer in samples (0 = 4 quanta)
+	UINT32 smplLimit;		// end the stream after this many samples (0 = when the player reaches PLAYSTATE_END)
+};
+
+// Note: All times are in OSTimer ticks.
+struct PLRSCHED_STATS
+{
+	UINT32 bufLevel;		// samples that are ready to be read
+	UINT32 bufSize;			// buffer size in samples
+	UINT64 smplCount;		// samples rendered
+	UINT64 renderTime;		// time spent in the player's Render()
+	UINT32 quantaCount;		// number of rendered quanta
+	UINT32 missedDeadlines;	// quanta that were started after the buffer was expected to run empty
+	UINT32 underruns;		// ReadStream() calls that returned fewer samples than requested
+	UINT8 finished;			// all samples were rendered
+};
+
+// Player Scheduler: renders many players using a fixed pool of worker threads.
+// Each stream is a started player with a ring buffer. The workers render one quantum at a time,
+// always picking the stream whose buffer runs empty first (earliest deadline first).
+// The deadline assumes that the stream is consumed in realtime, starting from the last ReadStream() call.
+// Notes:
+//	- Players must be loaded, configured and started before calling AddStream().
+//	  They must not be used directly until RemoveStream() returns.
+//	- Each player is only rendered by one worker at a time, but consecutive quanta may be
+//	  rendered by different workers. Players with independent sound devices are required.
+//	- ReadStream() and GetStreamStats() never block on a worker that is rendering.
+//	  Each stream must only be read by one thread at a time and not while it is being removed.
+class PlayerScheduler
+{
+public:
+	PlayerScheduler();
+	~PlayerScheduler();
+
+	UINT8 Start(UINT32 workerCount);	// start the worker threads
+	void Stop(void);					// stop and join all worker threads, streams are kept
+	void SetDefaultQuantum(UINT32 smplCnt);	// default quantum size in samples (default: 512)
+
+	// Returns the stream ID or (UINT32)-1 on error.
+	UINT32 AddStream(PlayerBase* player, const PLRSCHED_STREAM_CFG& cfg);
+	// Waits until the stream isn't rendered anymore and removes it. The player is not stopped.
+	UINT8 RemoveStream(UINT32 streamID);
+	// Takes up to smplCnt samples out of the stream's buffer and adds them to data (like PlayerBase::Render()).
+	// Returns the number of samples read.
+	UINT32 ReadStream(UINT32 streamID, UINT32 smplCnt, WAVE_32BS* data);
+	UINT8 GetStreamStats(UINT32 streamID, PLRSCHED_STATS& stats) const;
+
+	UINT32 GetStreamCount(void) const;
+	UINT32 GetMissedDeadlines(void) const;	// total number of missed deadlines of all streams
+
+protected:
+	typedef std::pair<UINT64, UINT32> READY_KEY;	// (deadline, stream ID)
+
+	struct STREAM
+	{
+		PlayerBase* player;
+		UINT32 smplRate;
+		UINT32 quantum;
+		UINT32 smplLimit;
+		std::vector<WAVE_32BS> buf;
+		UINT64 writeCnt;	// total samples written into the buffer
+		UINT64 readCnt;		// total samples read from the buffer
+		UINT64 lastRead;	// time of the last ReadStream() call
+		UINT64 deadline;	// key in _ready (valid when queued)
+		UINT8 queued;		// is in _ready
+		UINT8 busy;			// is rendered by a worker
+		UINT8 removing;		// RemoveStream() is waiting for the worker
+		UINT8 finished;
+		OS_SIGNAL* doneSignal;	// set by the worker when "removing" is set
+		PLRSCHED_STATS stats;
+	};
+
+	struct WORKER
+	{
+		PlayerScheduler* sched;
+		OS_THREAD* thread;
+	};
+
+	static void WorkerThread(void* args);
+	void WorkerMain(void);
+	void RenderQuantum(STREAM* strm, UINT32 smplCnt);
+	UINT64 GetDeadline(const STREAM* strm) const;
+	void UpdateQueue(UINT32 streamID);	// must be called with _mutex locked
+
+	OS_MUTEX* _mutex;
+	OS_SIGNAL* _workSignal;	// wakes up one waiting worker
+	std::vector<WORKER> _workers;
+	volatile UINT8 _quit;
+	UINT32 _defQuantum;
+	UINT64 _tmrFreq;
+
+	std::vector<STREAM*> _streams;	// index = stream ID, NULL = free slot
+	std::set<READY_KEY> _ready;		// streams that have room for one quantum, ordered by deadline
+	UINT32 _streamCount;
+	UINT32 _missedDeadlines;
+};
+
+#endif	// __PLAYERSCHED_HPP__
@@ -0,0 +1,465 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../stdtype.h"
+#include "../common_def.h"	// for INLINE
+#include "../emu/EmuStructs.h"
+#include "../emu/SoundDevs.h"
+#include "../emu/EmuCores.h"
+#include "regshadow.h"
+
+#define RS_PORTS	2
+#define RS_EXTRA	0x10	// additional slots for registers that are shadowed per data value (e.g. key on/off per channel)
+#define RS_SLOT_EXT	(RS_PORTS * 0x100)
+#define RS_SLOTS	(RS_SLOT_EXT + RS_EXTRA)
+
+// register types
+#define RST_PASS	0x00	// send directly
+#define RST_STATE	0x01	// send last value
+#define RST_KEY		0x02	// send last value, replay key on/off changes
+#define RST_BARRIER	0x03	// send all pending writes, then send directly
+#define RST_LATCH	0x04	// like RST_STATE, the value is latched by the chip and used by RST_LATCHED registers
+#define RST_LATCHED	0x05	// like RST_STATE, the latched value is sent right before the register
+
+typedef struct _rs_register_info
+{
+	UINT8 type;
+	UINT8 keyMask;	// RST_KEY: key on/off bits
+	UINT8 latch;	// RST_LATCH/RST_LATCHED: latch group
+	UINT16 slot;
+} RS_REGINFO;
+
+typedef void (*RS_CLASSIFY)(UINT8 devType, UINT8 port, UINT8 reg, UINT8 data, RS_REGINFO* ri);
+
+typedef struct _rs_device
+{
+	UINT8 devType;
+	UINT8 ports;
+	RS_CLASSIFY classify;
+	const UINT32* noCoreIDs;	// emulation cores that don't support register shadowing (0-terminated list, NULL = none)
+} RS_DEVICE;
+
+typedef struct _rs_slot
+{
+	UINT32 seq;		// sequence number of the last write, 0 = no write pending
+	UINT8 port;
+	UINT8 reg;
+	UINT8 data;
+	UINT8 keyMask;
+	UINT8 keyOn;	// key bits that were set by any of the writes
+	UINT8 keyOff;	// key bits that were cleared by any of the writes
+	UINT8 latchValid;
+	UINT8 latch;
+} RS_SLOT;
+
+struct _register_shadow
+{
+	const RS_DEVICE* dev;
+	DEV_DATA* dataPtr;
+	DEVFUNC_WRITE_A8D8 write;
+	UINT32 seq;
+	UINT8 latchValid;	// bit mask of latch groups written during the current batch
+	UINT8 latch[2];
+	UINT16 pendCnt;
+	RS_SLOT* pending[RS_SLOTS];
+	RS_SLOT slots[RS_SLOTS];
+};
+
+
+static void Classify_PSG(UINT8 devType, UINT8 port, UINT8 reg, UINT8 data, RS_REGINFO* ri);
+static void Classify_OPN(UINT8 devType, UINT8 port, UINT8 reg, UINT8 data, RS_REGINFO* ri);
+static void Classify_OPM(UINT8 devType, UINT8 port, UINT8 reg, UINT8 data, RS_REGINFO* ri);
+static void Classify_OPL(UINT8 devType, UINT8 port, UINT8 reg, UINT8 data, RS_REGINFO* ri);
+static void Classify_OPLL(UINT8 devType, UINT8 port, UINT8 reg, UINT8 data, RS_REGINFO* ri);
+static void RS_SendSlot(REG_SHADOW* rs, const RS_SLOT* slot);
+static int RS_SlotSeqCompare(const void* p1, const void* p2);
+
+
+// Only cores whose output after a PLRSEEK_FAST seek was verified to be bit-identical to a PLRSEEK_EXACT seek
+// (seek-vs-exact render comparison) may use register shadowing. Excluded cores:
+// - Nuked OPN2 and Nuked OPLL emulate the chip's write pipeline: writes are queued and processed
+//   over several clock cycles, so they can't be treated as immediate register state changes.
+// - These cores modify the envelope when the key on write is processed, so the envelope state depends on
+//   the intermediate writes and not only on the final register state:
+//   AdLibEmu processes the envelope attack at write time, GPGX (YM2612) sets the attenuation to 0 for
+//   ar+ksr >= 94 and MAME's YM2151 core applies the first attack step at key on.
+// - Gens (YM2612), EMU2413, MAME's OPL/OPL2/OPL3 cores and Nuked OPL3 were found to differ in the comparison.
+static const UINT32 RS_NOCORES_OPLL[] = {FCC_NUKE, FCC_EMU_, 0};
+static const UINT32 RS_NOCORES_OPN2[] = {FCC_NUKE, FCC_GPGX, FCC_GENS, 0};
+static const UINT32 RS_NOCORES_MAME[] = {FCC_MAME, 0};
+static const UINT32 RS_NOCORES_OPL3[] = {FCC_ADLE, FCC_MAME, FCC_NUKE, 0};
+static const RS_DEVICE RS_DEVICES[] =
+{
+	{DEVID_YM2413,	1,	Classify_OPLL,	RS_NOCORES_OPLL},
+	{DEVID_YM2612,	2,	Classify_OPN,	RS_NOCORES_OPN2},
+	{DEVID_YM2151,	1,	Classify_OPM,	RS_NOCORES_MAME},
+	{DEVID_YM2203,	1,	Classify_OPN,	NULL},
+	{DEVID_YM2608,	2,	Classify_OPN,	NULL},
+	{DEVID_YM2610,	2,	Classify_OPN,	NULL},
+	{DEVID_YM3812,	1,	Classify_OPL,	RS_NOCORES_OPL3},
+	{DEVID_YM3526,	1,	Classify_OPL,	RS_NOCORES_MAME},
+	{DEVID_Y8950,	1,	Classify_OPL,	RS_NOCORES_MAME},
+	{DEVID_YMF262,	2,	Classify_OPL,	RS_NOCORES_OPL3},
+	{DEVID_AY8910,	1,	Classify_PSG,	NULL},
+};
+#define RS_DEVICE_COUNT	(sizeof(RS_DEVICES) / sizeof(RS_DEVICES[0]))
+
+
+static void Classify_PSG(UINT8 devType, UINT8 port, UINT8 reg, UINT8 data, RS_REGINFO* ri)
+{
+	ri->slot = (port << 8) | reg;
+	if (reg == 0x0D)
+		ri->type = RST_BARRIER;	// restarts the envelope, AY8930: bank/mode select
+	else if (reg < 0x10)
+		ri->type = RST_STATE;
+	else
+		ri->type = RST_PASS;
+	return;
+}
+
+static void Classify_OPN(UINT8 devType, UINT8 port, UINT8 reg, UINT8 data, RS_REGINFO* ri)
+{
+	ri->type = RST_PASS;
+	ri->slot = (port << 8) | reg;
+	if (reg < 0x30)
+	{
+		if (port != 0)
+			return;	// YM2608: ADPCM-B, YM2610: ADPCM-A
+		if (reg < 0x10)
+		{
+			// SSG
+			if (devType != DEVID_YM2612)
+				Classify_PSG(devType, port, reg, data, ri);
+		}
+		else if (reg < 0x20)
+		{
+			// YM2608: rhythm (0x10 = key on/dump, others = volume), YM2610: ADPCM-B
+			if (devType == DEVID_YM2608 && reg > 0x10)
+				ri->type = RST_STATE;
+		}
+		else
+		{
+			switch(reg)
+			{
+			case 0x22:	// LFO
+			case 0x24: case 0x25: case 0x26: case 0x27:	// timers, channel 3 mode
+			case 0x2A: case 0x2B:	// YM2612 DAC
+				ri->type = RST_STATE;
+				break;
+			case 0x28:	// key on/off
+				ri->type = RST_KEY;
+				ri->keyMask = 0xF0;
+				ri->slot = RS_SLOT_EXT + (data & 0x07);
+				break;
+			case 0x29:	// YM2608: 6-channel mode
+			case 0x2D: case 0x2E: case 0x2F:	// prescaler
+				ri->type = RST_BARRIER;
+				break;
+			}
+		}
+	}
+	else if (reg < 0xA0)
+	{
+		ri->type = RST_STATE;	// operator registers
+	}
+	else if (reg < 0xB0)
+	{
+		// frequency registers: 0xA4-0xA6/0xAC-0xAE are latched and applied when writing 0xA0-0xA2/0xA8-0xAA
+		if ((reg & 0x03) == 0x03)
+			return;
+		ri->type = (reg & 0x04) ? RST_LATCH : RST_LATCHED;
+		ri->latch = (reg & 0x08) >> 3;
+	}
+	else if (reg < 0xB8)
+	{
+		ri->type = RST_STATE;	// algorithm/feedback, panning/LFO sensitivity
+	}
+	return;
+}
+
+static void Classify_OPM(UINT8 devType, UINT8 port, UINT8 reg, UINT8 data, RS_REGINFO* ri)
+{
+	ri->type = RST_STATE;
+	ri->slot = (port << 8) | reg;
+	switch(reg)
+	{
+	case 0x08:	// key on/off
+		ri->type = RST_KEY;
+		ri->keyMask = 0x78;
+		ri->slot = RS_SLOT_EXT + (data & 0x07);
+		break;
+	case 0x19:	// AMD/PMD (selected via bit 7)
+		if (data & 0x80)
+			ri->slot = RS_SLOT_EXT + 0x08;
+		break;
+	case 0x0F:	// noise
+	case 0x10: case 0x11: case 0x12: case 0x14:	// timers
+	case 0x18:	// LFO frequency
+	case 0x1B:	// CT/LFO waveform
+		break;
+	default:
+		if (reg < 0x20)
+			ri->type = RST_PASS;	// test register, LFO reset
+		break;
+	}
+	return;
+}
+
+static void Classify_OPL(UINT8 devType, UINT8 port, UINT8 reg, UINT8 data, RS_REGINFO* ri)
+{
+	ri->type = RST_PASS;
+	ri->slot = (port << 8) | reg;
+	if (reg < 0x20)
+	{
+		switch(reg)
+		{
+		case 0x01:	// OPL2: waveform select enable
+			if (port == 0)
+				ri->type = RST_BARRIER;
+			break;
+		case 0x02: case 0x03: case 0x04:	// timers, OPL3: 4-op connection
+			ri->type = RST_STATE;
+			break;
+		case 0x05:	// OPL3: NEW (enables the second register set)
+			if (port == 1)
+				ri->type = RST_BARRIER;
+			break;
+		case 0x08:	// CSM/note select (used when the F-Number is written)
+			if (port == 0)
+				ri->type = RST_BARRIER;
+			break;
+		}
+		// Y8950 ADPCM/keyboard registers (0x07-0x1A) are sent directly.
+	}
+	else if (reg < 0xA0 || reg >= 0xE0)
+	{
+		if ((reg & 0x1F) < 0x16)
+			ri->type = RST_STATE;	// operator registers
+	}
+	else if (reg < 0xC0)
+	{
+		if ((reg & 0x0F) > 0x08 && reg != 0xBD)
+			return;
+		if (reg < 0xB0)
+		{
+			ri->type = RST_STATE;	// F-Number
+		}
+		else if (reg == 0xBD)
+		{
+			if (port != 0)
+				return;
+			// rhythm mode and rhythm instrument keys - switching the rhythm mode
+			// affects the keys of channels 6-8, so all writes are kept
+			ri->type = RST_BARRIER;
+		}
+		else
+		{
+			ri->type = RST_KEY;
+			ri->keyMask = 0x20;
+		}
+	}
+	else if (reg < 0xC9)
+	{
+		ri->type = RST_STATE;	// feedback/connection
+	}
+	return;
+}
+
+static void Classify_OPLL(UINT8 devType, UINT8 port, UINT8 reg, UINT8 data, RS_REGINFO* ri)
+{
+	ri->type = RST_PASS;
+	ri->slot = (port << 8) | reg;
+	if (reg < 0x08)
+	{
+		ri->type = RST_STATE;	// user instrument
+	}
+	else if (reg == 0x0E)
+	{
+		ri->type = RST_KEY;
+		ri->keyMask = 0x1F;	// rhythm instruments
+	}
+	else if (reg >= 0x10 && (reg & 0x0F) <= 0x08)
+	{
+		if (reg < 0x20 || reg >= 0x30)
+		{
+			if (reg < 0x40)
+				ri->type = RST_STATE;	// F-Number, instrument/volume
+		}
+		else
+		{
+			ri->type = RST_KEY;
+			ri->keyMask = 0x10;
+		}
+	}
+	return;
+}
+
+UINT8 RegShadow_IsSupported(UINT8 devType, UINT32 coreID)
+{
+	size_t curDev;
+	const UINT32* noCore;
+
+	for (curDev = 0; curDev < RS_DEVICE_COUNT; curDev ++)
+	{
+		if (RS_DEVICES[curDev].devType != devType)
+			continue;
+		noCore = RS_DEVICES[curDev].noCoreIDs;
+		if (noCore != NULL)
+		{
+			for (; *noCore != 0; noCore ++)
+			{
+				if (*noCore == coreID)
+					return 0x00;
+			}
+		}
+		return 0x01;
+	}
+	return 0x00;
+}
+
+UINT8 RegShadow_Init(REG_SHADOW** retShadow, UINT8 devType, const DEV_INFO* devInf, DEVFUNC_WRITE_A8D8 writeFunc)
+{
+	REG_SHADOW* rs;
+	size_t curDev;
+
+	if (writeFunc == NULL || ! RegShadow_IsSupported(devType, devInf->devDef->coreID))
+		return 0x80;
+
+	rs = (REG_SHADOW*)calloc(1, sizeof(REG_SHADOW));
+	if (rs == NULL)
+		return 0xFF;
+	for (curDev = 0; curDev < RS_DEVICE_COUNT; curDev ++)
+	{
+		if (RS_DEVICES[curDev].devType == devType)
+			break;
+	}
+	rs->dev = &RS_DEVICES[curDev];
+	rs->dataPtr = devInf->dataPtr;
+	rs->write = writeFunc;
+
+	*retShadow = rs;
+	return 0x00;
+}
+
+void RegShadow_Deinit(REG_SHADOW* shadow)
+{
+	free(shadow);
+
+	return;
+}
+
+INLINE void RS_WriteReg(REG_SHADOW* rs, UINT8 port, UINT8 reg, UINT8 data)
+{
+	rs->write(rs->dataPtr, (port << 1) | 0, reg);
+	rs->write(rs->dataPtr, (port << 1) | 1, data);
+	return;
+}
+
+void RegShadow_Write(REG_SHADOW* shadow, UINT8 port, UINT8 reg, UINT8 data)
+{
+	RS_REGINFO ri;
+	RS_SLOT* slot;
+
+	if (port >= shadow->dev->ports)
+	{
+		RS_WriteReg(shadow, port, reg, data);
+		return;
+	}
+	ri.keyMask = 0x00;
+	ri.latch = 0;
+	shadow->dev->classify(shadow->dev->devType, port, reg, data, &ri);
+	if (ri.type == RST_PASS)
+	{
+		RS_WriteReg(shadow, port, reg, data);
+		return;
+	}
+	else if (ri.type == RST_BARRIER)
+	{
+		RegShadow_Flush(shadow);
+		RS_WriteReg(shadow, port, reg, data);
+		return;
+	}
+
+	slot = &shadow->slots[ri.slot];
+	if (! slot->seq)
+	{
+		shadow->pending[shadow->pendCnt] = slot;
+		shadow->pendCnt ++;
+		slot->port = port;
+		slot->reg = reg;
+		slot->keyMask = ri.keyMask;
+		slot->keyOn = slot->keyOff = 0x00;
+		slot->latchValid = 0;
+	}
+	shadow->seq ++;
+	slot->seq = shadow->seq;
+	slot->data = data;
+	switch(ri.type)
+	{
+	case RST_KEY:
+		slot->keyOn |= data & ri.keyMask;
+		slot->keyOff |= ~data & ri.keyMask;
+		break;
+	case RST_LATCH:
+		shadow->latch[ri.latch] = data;
+		shadow->latchValid |= (1 << ri.latch);
+		break;
+	case RST_LATCHED:
+		// When nothing was latched during this batch, the chip's current latch value is used.
+		slot->latchValid = (shadow->latchValid >> ri.latch) & 0x01;
+		slot->latch = shadow->latch[ri.latch];
+		break;
+	}
+
+	return;
+}
+
+static void RS_SendSlot(REG_SHADOW* rs, const RS_SLOT* slot)
+{
+	if (slot->keyMask)
+	{
+		UINT8 retrig = slot->data & slot->keyOff;	// key on at the end, but key off in between
+		UINT8 pulse = slot->keyOn & ~slot->data;	// key off at the end, but key on in between
+
+		if (retrig || pulse)
+			RS_WriteReg(rs, slot->port, slot->reg, slot->data & ~retrig);
+		if (pulse)
+			RS_WriteReg(rs, slot->port, slot->reg, slot->data | pulse);
+	}
+	if (slot->latchValid)
+		RS_WriteReg(rs, slot->port, slot->reg | 0x04, slot->latch);
+	RS_WriteReg(rs, slot->port, slot->reg, slot->data);
+
+	return;
+}
+
+static int RS_SlotSeqCompare(const void* p1, const void* p2)
+{
+	const RS_SLOT* s1 = *(const RS_SLOT* const*)p1;
+	const RS_SLOT* s2 = *(const RS_SLOT* const*)p2;
+
+	if (s1->seq < s2->seq)
+		return -1;
+	else if (s1->seq > s2->seq)
+		return +1;
+	else
+		return 0;
+}
+
+void RegShadow_Flush(REG_SHADOW* shadow)
+{
+	UINT16 curSlot;
+
+	qsort(shadow->pending, shadow->pendCnt, sizeof(RS_SLOT*), RS_SlotSeqCompare);
+	for (curSlot = 0; curSlot < shadow->pendCnt; curSlot ++)
+	{
+		RS_SLOT* slot = shadow->pending[curSlot];
+		RS_SendSlot(shadow, slot);
+		slot->seq = 0;
+	}
+	shadow->pendCnt = 0;
+	shadow->seq = 0;
+	shadow->latchValid = 0x00;
+
+	return;
+}
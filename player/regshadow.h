@@ -0,0 +1,75 @@
+#ifndef __PLAYER_REGSHADOW_H__
+#define __PLAYER_REGSHADOW_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "../stdtype.h"
+#include "../emu/EmuStructs.h"
+
+// Register shadow for fast-forward seeking.
+// While seeking, no samples are rendered, so all register writes happen at the same point in time
+// and only the resulting register state matters. The shadow collects the writes to a sound chip
+// and sends only the last value of each register when the seek is finished.
+//
+// Registers are handled according to their function:
+//	- normal registers: only the last value is sent
+//	- key on/off registers: the last value is sent, preceded by a key off/on replay when the
+//	  key state changed during the seek (to restart/release the envelope like the full sequence would)
+//	- mode registers that change how other registers are interpreted (e.g. OPL3 "NEW" mode):
+//	  all pending writes are sent, then the register is written directly
+//	- registers with side effects (ADPCM control, memory access, test registers): written directly
+// The pending writes are sent in the order of their last write.
+//
+// Writes are expected in the format used by the players: (port << 1) | 0 = register, (port << 1) | 1 = data
+typedef struct _register_shadow REG_SHADOW;
+
+/**
+ * @brief Checks whether register shadowing can be used with a device.
+ *        This depends on the chip (the register layout must be known) and the emulation core
+ *        (cores that emulate the chip's internal write pipeline are excluded).
+ *
+ * @param devType device type (DEVID_ constant)
+ * @param coreID core ID (FCC_ constant) of the emulation core
+ * @return 0x01 if supported, 0x00 if not
+ */
+UINT8 RegShadow_IsSupported(UINT8 devType, UINT32 coreID);
+/**
+ * @brief Creates a register shadow for a device.
+ *
+ * @param retShadow buffer for the pointer to the new instance
+ * @param devType device type (DEVID_ constant)
+ * @param devInf device to be written to
+ * @param writeFunc register write function of the device
+ * @return 0x00 on success, 0x80 if the device is not supported, 0xFF if out of memory
+ */
+UINT8 RegShadow_Init(REG_SHADOW** retShadow, UINT8 devType, const DEV_INFO* devInf, DEVFUNC_WRITE_A8D8 writeFunc);
+/**
+ * @brief Frees a register shadow. Pending writes are discarded.
+ *
+ * @param shadow instance to be freed
+ */
+void RegShadow_Deinit(REG_SHADOW* shadow);
+/**
+ * @brief Processes a register write. The write is either stored or sent to the device directly.
+ *
+ * @param shadow shadow instance
+ * @param port register port
+ * @param reg register number
+ * @param data value to be written
+ */
+void RegShadow_Write(REG_SHADOW* shadow, UINT8 port, UINT8 reg, UINT8 data);
+/**
+ * @brief Sends all pending register writes to the device.
+ *
+ * @param shadow shadow instance
+ */
+void RegShadow_Flush(REG_SHADOW* shadow);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __PLAYER_REGSHADOW_H__
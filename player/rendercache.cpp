@@ -0,0 +1,707 @@
+// Render Cache: stores rendered songs in chunks on disk
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#ifdef _WIN32
+#include <process.h>	// for _getpid()
+#define getpid	_getpid
+#else
+#include <unistd.h>	// for getpid()
+#endif
+
+#define INLINE	static inline
+
+#include "../common_def.h"
+#include "rendercache.hpp"
+#include "playerbase.hpp"
+#include "../emu/EmuHelper.h"	// for EmuHash_Data
+#include "../utils/DataLoader.h"
+
+// cache file layout (all values are Little Endian):
+//	00..03	"LVRC" signature
+//	04..07	format version
+//	08..0B	sample rate
+//	0C..0F	total number of samples
+//	10..13	chunk size (in samples)
+//	14..17	number of chunks
+//	18..1B	key size (in bytes)
+//	1C..1F	flags (bit 0: compressed chunks)
+//	20..	key data, chunk table (8 bytes per chunk: file offset, data size), chunk data
+// Each sample is stored as 32-bit left + 32-bit right channel.
+#define RCF_SIGNATURE	"LVRC"
+#define RCF_VERSION		0x00000100
+#define RCF_HDR_SIZE	0x20
+#define RCF_FLAG_COMPR	0x01
+#define RCF_MAX_SIZE	0x7FFFFFFF	// limit for ftell/fseek with 32-bit long
+
+// Revision of the emulation code, part of the cache key.
+// Increase it when a change to the sound cores or players changes the rendered output.
+#define RC_EMU_REVISION	0x00000001
+#ifndef LIBVGM_VERSION_STR
+#define LIBVGM_VERSION_STR	""
+#endif
+
+#define SMPL_BYTES		8	// bytes per stereo sample in the cache file
+#define DEF_CHUNK_SIZE	0x8000
+#define CATCHUP_CHUNKS	4	// maximum distance (in chunks) to catch up by rendering after a Seek()
+
+
+INLINE UINT32 ReadLE32(const UINT8* data)
+{
+	return	(data[0x03] << 24) | (data[0x02] << 16) |
+			(data[0x01] <<  8) | (data[0x00] <<  0);
+}
+
+INLINE void WriteLE32(UINT8* buffer, UINT32 value)
+{
+	buffer[0x00] = (UINT8)(value >>  0);
+	buffer[0x01] = (UINT8)(value >>  8);
+	buffer[0x02] = (UINT8)(value >> 16);
+	buffer[0x03] = (UINT8)(value >> 24);
+	return;
+}
+
+INLINE void PushLE32(std::vector<UINT8>& data, UINT32 value)
+{
+	data.push_back((UINT8)(value >>  0));
+	data.push_back((UINT8)(value >>  8));
+	data.push_back((UINT8)(value >> 16));
+	data.push_back((UINT8)(value >> 24));
+	return;
+}
+
+RenderCache::RenderCache() :
+	_newChunkSize(DEF_CHUNK_SIZE),
+	_newCompress(1),
+	_player(NULL),
+	_keyHash(0),
+	_hFile(NULL),
+	_fileChanged(0),
+	_tableOfs(0),
+	_cachedChunks(0),
+	_smplRate(0),
+	_totalSmpls(0),
+	_chunkSmpls(DEF_CHUNK_SIZE),
+	_compress(0),
+	_curPos(0),
+	_bufChunk((UINT32)-1),
+	_liveStarted(0),
+	_liveExact(0),
+	_seekJump(0),
+	_livePos(0)
+{
+}
+
+RenderCache::~RenderCache()
+{
+	Close();
+}
+
+void RenderCache::SetCacheDir(const char* dirPath)
+{
+	_cacheDir = dirPath;
+	if (! _cacheDir.empty())
+	{
+		char lastChr = _cacheDir[_cacheDir.length() - 1];
+		if (lastChr != '/' && lastChr != '\\')
+			_cacheDir += '/';
+	}
+	return;
+}
+
+void RenderCache::SetChunkSize(UINT32 smplCnt)
+{
+	_newChunkSize = smplCnt ? smplCnt : DEF_CHUNK_SIZE;
+	return;
+}
+
+void RenderCache::SetCompression(UINT8 enable)
+{
+	_newCompress = enable;
+	return;
+}
+
+void RenderCache::SetUserKey(const void* data, size_t size)
+{
+	const UINT8* bytes = (const UINT8*)data;
+	_userKey.assign(bytes, bytes + size);
+	return;
+}
+
+UINT8 RenderCache::Open(PlayerBase* player, DATA_LOADER* dataLoader, UINT32 loopCount)
+{
+	char hashStr[0x20];
+	UINT8 retVal;
+
+	if (player == NULL || dataLoader == NULL)
+		return 0xFF;
+	Close();
+
+	if (! loopCount)
+		loopCount = 1;
+	_player = player;
+	_smplRate = _player->GetSampleRate();
+	// Tick2Sample() uses the sample rate from the last LoadFile()/Start(), which may be outdated here.
+	_totalSmpls = (UINT32)(_player->Tick2Second(_player->GetTotalPlayTicks(loopCount)) * _smplRate + 0.5);
+	BuildKey(dataLoader, loopCount);
+
+	_curPos = 0;
+	_bufChunk = (UINT32)-1;
+	_liveStarted = 0;
+	_chunks.clear();
+	_cachedChunks = 0;
+	_chunkSmpls = _newChunkSize;
+	_compress = _newCompress;
+
+	sprintf(hashStr, "%08X%08X.lvc", (UINT32)(_keyHash >> 32), (UINT32)(_keyHash >> 0));
+	_filePath = _cacheDir + hashStr;
+	retVal = OpenCacheFile();
+	if (retVal)
+		retVal = CreateCacheFile();	// on failure, the chunks are rendered without cache file
+	_chunkBuf.resize(_chunkSmpls);
+
+	return retVal;
+}
+
+UINT8 RenderCache::Close(void)
+{
+	if (_player == NULL)
+		return 0x00;
+
+	if (_liveStarted)
+	{
+		_player->Stop();
+		_liveStarted = 0;
+	}
+	CloseCacheFile();
+	_player = NULL;
+	std::vector<WAVE_32BS>().swap(_chunkBuf);
+	std::vector<UINT8>().swap(_fileBuf);
+	return 0x00;
+}
+
+// The key consists of the file data and all options that change the rendered samples.
+void RenderCache::BuildKey(DATA_LOADER* dataLoader, UINT32 loopCount)
+{
+	std::vector<PLR_DEV_INFO> devInfList;
+	PLR_DEV_OPTS devOpts;
+	UINT64 fileHash;
+	UINT32 fileSize;
+	size_t curDev;
+	UINT8 curChn;
+	UINT8 curLnk;
+
+	// The player already read the whole file. Reading again may move the buffer the player refers to.
+	fileSize = DataLoader_GetSize(dataLoader);
+	fileHash = EmuHash_Data(EMU_HASH_INIT, DataLoader_GetData(dataLoader), fileSize);
+
+	_key.clear();
+	PushLE32(_key, RC_EMU_REVISION);
+	PushLE32(_key, (UINT32)strlen(LIBVGM_VERSION_STR));
+	_key.insert(_key.end(), LIBVGM_VERSION_STR, LIBVGM_VERSION_STR + strlen(LIBVGM_VERSION_STR));
+	PushLE32(_key, _player->GetPlayerType());
+	PushLE32(_key, fileSize);
+	PushLE32(_key, (UINT32)(fileHash >> 0));
+	PushLE32(_key, (UINT32)(fileHash >> 32));
+	PushLE32(_key, _smplRate);
+	PushLE32(_key, loopCount);
+
+	_player->GetSongDeviceInfo(devInfList);
+	PushLE32(_key, (UINT32)devInfList.size());
+	for (curDev = 0; curDev < devInfList.size(); curDev ++)
+	{
+		const PLR_DEV_INFO& pdi = devInfList[curDev];
+		PushLE32(_key, pdi.id);
+		PushLE32(_key, pdi.volume);
+		if (_player->GetDeviceOptions(pdi.id, devOpts))
+			continue;
+		PushLE32(_key, devOpts.emuCore[0]);
+		PushLE32(_key, devOpts.emuCore[1]);
+		PushLE32(_key, (devOpts.srMode << 0) | (devOpts.resmplMode << 8) | (devOpts.muteOpts.disable << 16));
+		PushLE32(_key, devOpts.smplRate);
+		PushLE32(_key, devOpts.coreOpts);
+		PushLE32(_key, devOpts.muteOpts.chnMute[0]);
+		PushLE32(_key, devOpts.muteOpts.chnMute[1]);
+		for (curLnk = 0; curLnk < 2; curLnk ++)
+		{
+			for (curChn = 0; curChn < 32; curChn += 2)
+				PushLE32(_key, (UINT32)(UINT16)devOpts.panOpts.chnPan[curLnk][curChn + 0] |
+								((UINT32)(UINT16)devOpts.panOpts.chnPan[curLnk][curChn + 1] << 16));
+		}
+	}
+	PushLE32(_key, (UINT32)_userKey.size());
+	_key.insert(_key.end(), _userKey.begin(), _userKey.end());
+
+	_keyHash = EmuHash_Data(EMU_HASH_INIT, &_key[0], _key.size());
+	return;
+}
+
+UINT8 RenderCache::OpenCacheFile(void)
+{
+	UINT8 hdr[RCF_HDR_SIZE];
+	std::vector<UINT8> fileKey;
+	std::vector<UINT8> tblData;
+	UINT32 chunkCnt;
+	UINT32 keyLen;
+	UINT32 curChunk;
+
+	// The cache file is never modified, new chunks are stored in a copy. (see MakeFileWritable)
+	_hFile = fopen(_filePath.c_str(), "rb");
+	if (_hFile == NULL)
+		return 0xFF;
+	_tmpPath.clear();
+	_fileChanged = 0;
+
+	if (fread(hdr, 1, RCF_HDR_SIZE, _hFile) < RCF_HDR_SIZE)
+		goto invalid_file;
+	if (memcmp(&hdr[0x00], RCF_SIGNATURE, 4) || ReadLE32(&hdr[0x04]) != RCF_VERSION)
+		goto invalid_file;
+	if (ReadLE32(&hdr[0x08]) != _smplRate || ReadLE32(&hdr[0x0C]) != _totalSmpls)
+		goto invalid_file;
+	_chunkSmpls = ReadLE32(&hdr[0x10]);
+	chunkCnt = ReadLE32(&hdr[0x14]);
+	keyLen = ReadLE32(&hdr[0x18]);
+	_compress = (ReadLE32(&hdr[0x1C]) & RCF_FLAG_COMPR) ? 1 : 0;
+	if (! _chunkSmpls || chunkCnt != (_totalSmpls + _chunkSmpls - 1) / _chunkSmpls)
+		goto invalid_file;
+	if (keyLen != _key.size())
+		goto invalid_file;	// hash collision or different key format
+
+	fileKey.resize(keyLen);
+	if (fread(&fileKey[0], 1, keyLen, _hFile) < keyLen || memcmp(&fileKey[0], &_key[0], keyLen))
+		goto invalid_file;
+
+	_tableOfs = RCF_HDR_SIZE + keyLen;
+	tblData.resize(chunkCnt * 8);
+	if (chunkCnt > 0 && fread(&tblData[0], 1, tblData.size(), _hFile) < tblData.size())
+		goto invalid_file;
+	_chunks.resize(chunkCnt);
+	_cachedChunks = 0;
+	for (curChunk = 0; curChunk < chunkCnt; curChunk ++)
+	{
+		_chunks[curChunk].fileOfs = ReadLE32(&tblData[curChunk * 8 + 0x00]);
+		_chunks[curChunk].dataSize = ReadLE32(&tblData[curChunk * 8 + 0x04]);
+		if (_chunks[curChunk].fileOfs)
+			_cachedChunks ++;
+	}
+
+	return 0x00;
+
+invalid_file:
+	fclose(_hFile);
+	_hFile = NULL;
+	_chunkSmpls = _newChunkSize;
+	_compress = _newCompress;
+	return 0x80;
+}
+
+UINT8 RenderCache::CreateCacheFile(void)
+{
+	UINT8 hdr[RCF_HDR_SIZE];
+	std::vector<UINT8> tblData;
+	UINT32 chunkCnt;
+
+	_chunkSmpls = _newChunkSize;
+	_compress = _newCompress;
+	chunkCnt = (_totalSmpls + _chunkSmpls - 1) / _chunkSmpls;
+	_chunks.assign(chunkCnt, CHUNK_ENTRY());	// zero-initialized = not cached
+	_cachedChunks = 0;
+	_tableOfs = RCF_HDR_SIZE + (UINT32)_key.size();
+
+	_tmpPath = GetTempPath();
+	_fileChanged = 0;
+	_hFile = fopen(_tmpPath.c_str(), "w+b");
+	if (_hFile == NULL)
+	{
+		_tmpPath.clear();
+		return 0x80;
+	}
+
+	memcpy(&hdr[0x00], RCF_SIGNATURE, 4);
+	WriteLE32(&hdr[0x04], RCF_VERSION);
+	WriteLE32(&hdr[0x08], _smplRate);
+	WriteLE32(&hdr[0x0C], _totalSmpls);
+	WriteLE32(&hdr[0x10], _chunkSmpls);
+	WriteLE32(&hdr[0x14], chunkCnt);
+	WriteLE32(&hdr[0x18], (UINT32)_key.size());
+	WriteLE32(&hdr[0x1C], _compress ? RCF_FLAG_COMPR : 0x00);
+	tblData.assign(chunkCnt * 8, 0x00);
+
+	if (fwrite(hdr, 1, RCF_HDR_SIZE, _hFile) < RCF_HDR_SIZE ||
+		fwrite(&_key[0], 1, _key.size(), _hFile) < _key.size() ||
+		(chunkCnt > 0 && fwrite(&tblData[0], 1, tblData.size(), _hFile) < tblData.size()))
+	{
+		DiscardCacheFile();
+		return 0x80;
+	}
+
+	return 0x01;
+}
+
+// Returns a file name for a new cache file that is unique across processes.
+std::string RenderCache::GetTempPath(void) const
+{
+	static UINT32 tmpCounter = 0;
+	UINT32 idData[4];
+	UINT64 idHash;
+	char idStr[0x20];
+
+	idData[0] = (UINT32)getpid();
+	idData[1] = (UINT32)time(NULL);
+	idData[2] = (UINT32)clock();
+	idData[3] = tmpCounter ++;
+	idHash = EmuHash_Data(_keyHash, idData, sizeof(idData));
+	sprintf(idStr, ".%08X.tmp", (UINT32)(idHash >> 0));
+	return _filePath + idStr;
+}
+
+// copies the opened cache file into a new temporary file, which is renamed when closing
+UINT8 RenderCache::MakeFileWritable(void)
+{
+	std::vector<UINT8> copyBuf(0x10000);
+	FILE* hTmpFile;
+	size_t readBytes;
+
+	if (! _tmpPath.empty())
+		return 0x00;
+
+	_tmpPath = GetTempPath();
+	hTmpFile = fopen(_tmpPath.c_str(), "w+b");
+	if (hTmpFile == NULL)
+	{
+		_tmpPath.clear();
+		return 0x80;
+	}
+	if (fseek(_hFile, 0, SEEK_SET))
+		readBytes = 0;
+	else
+		readBytes = fread(&copyBuf[0], 1, copyBuf.size(), _hFile);
+	while(readBytes > 0)
+	{
+		if (fwrite(&copyBuf[0], 1, readBytes, hTmpFile) < readBytes)
+			break;
+		readBytes = fread(&copyBuf[0], 1, copyBuf.size(), _hFile);
+	}
+	if (ferror(_hFile) || ferror(hTmpFile))
+	{
+		fclose(hTmpFile);
+		remove(_tmpPath.c_str());
+		_tmpPath.clear();
+		return 0x80;
+	}
+
+	fclose(_hFile);
+	_hFile = hTmpFile;
+	return 0x00;
+}
+
+// closes the cache file and replaces the existing cache file with the temporary file
+void RenderCache::CloseCacheFile(void)
+{
+	if (_hFile == NULL)
+		return;
+
+	if (_tmpPath.empty() || ! _fileChanged)
+	{
+		DiscardCacheFile();
+		return;
+	}
+
+	fclose(_hFile);
+	_hFile = NULL;
+	// rename() is atomic on POSIX, so other processes see either the old or the new file.
+	// Windows doesn't replace existing files, so the old file has to be removed first.
+	if (rename(_tmpPath.c_str(), _filePath.c_str()))
+	{
+		remove(_filePath.c_str());
+		if (rename(_tmpPath.c_str(), _filePath.c_str()))
+			remove(_tmpPath.c_str());
+	}
+	_tmpPath.clear();
+	return;
+}
+
+// closes the cache file and removes the temporary file, if there is one
+void RenderCache::DiscardCacheFile(void)
+{
+	if (_hFile != NULL)
+	{
+		fclose(_hFile);
+		_hFile = NULL;
+	}
+	if (! _tmpPath.empty())
+	{
+		remove(_tmpPath.c_str());
+		_tmpPath.clear();
+	}
+	return;
+}
+
+UINT8 RenderCache::Start(void)
+{
+	if (_player == NULL)
+		return 0xFF;
+
+	// The player is only started when a chunk needs to be rendered.
+	_curPos = 0;
+	_seekJump = 0;
+	return 0x00;
+}
+
+UINT8 RenderCache::Stop(void)
+{
+	if (_player == NULL)
+		return 0xFF;
+
+	// The player keeps running until Close(), so that it can continue where it stopped.
+	_seekJump = 0;
+	return 0x00;
+}
+
+UINT8 RenderCache::Seek(UINT32 smplPos)
+{
+	if (_player == NULL)
+		return 0xFF;
+
+	_curPos = smplPos;
+	_seekJump = 1;
+	return 0x00;
+}
+
+UINT32 RenderCache::GetChunkLength(UINT32 chunkID) const
+{
+	UINT32 chunkStart = chunkID * _chunkSmpls;
+
+	return (_totalSmpls - chunkStart < _chunkSmpls) ? (_totalSmpls - chunkStart) : _chunkSmpls;
+}
+
+// moves the player to the specified position, either by rendering or by using Seek()
+void RenderCache::MoveLivePlayer(UINT32 smplPos)
+{
+	if (! _liveStarted)
+	{
+		_player->Start();
+		_liveStarted = 1;
+		_livePos = 0;
+		_liveExact = 1;
+	}
+	if (_livePos == smplPos)
+		return;
+
+	// Only samples that were rendered from the beginning of the song can be stored.
+	// Note: Neither Reset() nor Stop()/Start() of the player result in the exact same output,
+	//       so going back always uses Seek().
+	if (_livePos < smplPos && _liveExact &&
+		(! _seekJump || smplPos - _livePos <= _chunkSmpls * CATCHUP_CHUNKS))
+	{
+		// catch up by rendering, the samples are discarded
+		_bufChunk = (UINT32)-1;	// the chunk buffer is used as scratch buffer
+		while(_livePos < smplPos)
+		{
+			UINT32 smplCnt = smplPos - _livePos;
+			if (smplCnt > _chunkBuf.size())
+				smplCnt = (UINT32)_chunkBuf.size();
+			memset(&_chunkBuf[0], 0x00, smplCnt * sizeof(WAVE_32BS));
+			_player->Render(smplCnt, &_chunkBuf[0]);
+			_livePos += smplCnt;
+		}
+	}
+	else
+	{
+		// too far away or backwards - seek and don't fill the cache
+		_player->Seek(PLAYPOS_SAMPLE, smplPos);
+		_livePos = smplPos;
+		_liveExact = 0;
+	}
+	return;
+}
+
+UINT8 RenderCache::LoadChunk(UINT32 chunkID)
+{
+	const CHUNK_ENTRY& ce = _chunks[chunkID];
+	UINT32 chunkLen = GetChunkLength(chunkID);
+	uLongf rawSize = chunkLen * SMPL_BYTES;
+	const UINT8* rawData;
+	UINT32 curSmpl;
+
+	if (_hFile == NULL || ! ce.fileOfs)
+		return 0xFF;
+
+	_fileBuf.resize(ce.dataSize + rawSize);
+	if (fseek(_hFile, ce.fileOfs, SEEK_SET) || fread(&_fileBuf[0], 1, ce.dataSize, _hFile) < ce.dataSize)
+		return 0x80;
+	if (ce.dataSize == rawSize)
+	{
+		rawData = &_fileBuf[0];
+	}
+	else
+	{
+		if (uncompress(&_fileBuf[ce.dataSize], &rawSize, &_fileBuf[0], ce.dataSize) != Z_OK ||
+			rawSize != chunkLen * SMPL_BYTES)
+			return 0x80;
+		rawData = &_fileBuf[ce.dataSize];
+	}
+
+	for (curSmpl = 0; curSmpl < chunkLen; curSmpl ++, rawData += SMPL_BYTES)
+	{
+		_chunkBuf[curSmpl].L = (DEV_SMPL)ReadLE32(&rawData[0x00]);
+		_chunkBuf[curSmpl].R = (DEV_SMPL)ReadLE32(&rawData[0x04]);
+	}
+	_bufChunk = chunkID;
+	return 0x00;
+}
+
+void RenderCache::RenderChunk(UINT32 chunkID)
+{
+	UINT32 chunkStart = chunkID * _chunkSmpls;
+	UINT32 chunkLen = GetChunkLength(chunkID);
+
+	MoveLivePlayer(chunkStart);
+	memset(&_chunkBuf[0], 0x00, chunkLen * sizeof(WAVE_32BS));
+	_player->Render(chunkLen, &_chunkBuf[0]);
+	_livePos += chunkLen;
+	_bufChunk = chunkID;
+
+	if (_liveExact && _hFile != NULL && ! _chunks[chunkID].fileOfs)
+		StoreChunk(chunkID);
+	return;
+}
+
+void RenderCache::StoreChunk(UINT32 chunkID)
+{
+	CHUNK_ENTRY& ce = _chunks[chunkID];
+	UINT32 chunkLen = GetChunkLength(chunkID);
+	UINT32 rawSize = chunkLen * SMPL_BYTES;
+	uLongf dataSize;
+	const UINT8* data;
+	UINT8* rawData;
+	UINT8 tblEntry[8];
+	long fileOfs;
+	UINT32 curSmpl;
+
+	if (MakeFileWritable())
+		goto write_error;
+
+	_fileBuf.resize(rawSize + compressBound(rawSize));
+	rawData = &_fileBuf[0];
+	for (curSmpl = 0; curSmpl < chunkLen; curSmpl ++, rawData += SMPL_BYTES)
+	{
+		WriteLE32(&rawData[0x00], (UINT32)_chunkBuf[curSmpl].L);
+		WriteLE32(&rawData[0x04], (UINT32)_chunkBuf[curSmpl].R);
+	}
+
+	data = &_fileBuf[0];
+	dataSize = rawSize;
+	if (_compress)
+	{
+		uLongf comprSize = (uLongf)(_fileBuf.size() - rawSize);
+		// use the compressed data only if it is smaller, the size tells them apart
+		if (compress2(&_fileBuf[rawSize], &comprSize, &_fileBuf[0], rawSize, Z_BEST_SPEED) == Z_OK &&
+			comprSize < rawSize)
+		{
+			data = &_fileBuf[rawSize];
+			dataSize = comprSize;
+		}
+	}
+
+	if (fseek(_hFile, 0, SEEK_END))
+		goto write_error;
+	fileOfs = ftell(_hFile);
+	if (fileOfs < 0 || (UINT32)fileOfs > RCF_MAX_SIZE - dataSize)
+		return;	// the file is full - don't cache any more chunks
+	if (fwrite(data, 1, dataSize, _hFile) < dataSize)
+		goto write_error;
+
+	// update the table after the data was written, so that an interrupted write leaves no broken chunk
+	WriteLE32(&tblEntry[0x00], (UINT32)fileOfs);
+	WriteLE32(&tblEntry[0x04], (UINT32)dataSize);
+	if (fseek(_hFile, _tableOfs + chunkID * 8, SEEK_SET) || fwrite(tblEntry, 1, 8, _hFile) < 8)
+		goto write_error;
+	ce.fileOfs = (UINT32)fileOfs;
+	ce.dataSize = (UINT32)dataSize;
+	_cachedChunks ++;
+	_fileChanged = 1;
+	return;
+
+write_error:
+	// continue without cache file, the existing cache file stays as it is
+	DiscardCacheFile();
+	return;
+}
+
+UINT32 RenderCache::Render(UINT32 smplCnt, WAVE_32BS* data)
+{
+	UINT32 curSmpl;
+	UINT32 chunkID;
+	UINT32 chunkOfs;
+	UINT32 smplStep;
+	UINT32 i;
+
+	if (_player == NULL)
+		return 0;
+
+	curSmpl = 0;
+	while(curSmpl < smplCnt && _curPos < _totalSmpls)
+	{
+		chunkID = _curPos / _chunkSmpls;
+		if (_bufChunk != chunkID)
+		{
+			if (LoadChunk(chunkID))
+				RenderChunk(chunkID);
+			_seekJump = 0;	// the following chunks are reached by playing normally
+		}
+
+		chunkOfs = _curPos - chunkID * _chunkSmpls;
+		smplStep = GetChunkLength(chunkID) - chunkOfs;
+		if (smplStep > smplCnt - curSmpl)
+			smplStep = smplCnt - curSmpl;
+		for (i = 0; i < smplStep; i ++)
+		{
+			data[curSmpl + i].L += _chunkBuf[chunkOfs + i].L;
+			data[curSmpl + i].R += _chunkBuf[chunkOfs + i].R;
+		}
+		curSmpl += smplStep;
+		_curPos += smplStep;
+	}
+	if (curSmpl < smplCnt)
+	{
+		// after the end of the last loop: render directly
+		MoveLivePlayer(_curPos);
+		_seekJump = 0;
+		smplStep = _player->Render(smplCnt - curSmpl, &data[curSmpl]);
+		_livePos += smplStep;
+		_curPos += smplStep;
+		curSmpl += smplStep;
+	}
+
+	return curSmpl;
+}
+
+UINT32 RenderCache::GetCurPos(void) const
+{
+	return _curPos;
+}
+
+UINT32 RenderCache::GetTotalSamples(void) const
+{
+	return _totalSmpls;
+}
+
+UINT32 RenderCache::GetChunkCount(void) const
+{
+	return (UINT32)_chunks.size();
+}
+
+UINT32 RenderCache::GetCachedChunks(void) const
+{
+	return _cachedChunks;
+}
+
+std::string RenderCache::GetCacheFilePath(void) const
+{
+	return _filePath;
+}
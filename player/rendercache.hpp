@@ -0,0 +1,119 @@
+#ifndef __RENDERCACHE_HPP__
+#define __RENDERCACHE_HPP__
+
+#include "../stdtype.h"
+#include "../emu/Resampler.h"	// for WAVE_32BS
+#include "../utils/DataLoader.h"
+#include "playerbase.hpp"
+#include <stdio.h>	// for FILE
+#include <string>
+#include <vector>
+
+// Persistent render cache: stores the rendered output of a song on disk, so that repeated plays
+// don't need to emulate the sound chips again.
+// The output is split into fixed-size chunks that are stored (optionally zlib-compressed) in one cache file per song.
+// The file name is derived from a key that consists of the file contents and every option that affects
+// the output (sample rate, loop count, device cores/sample rate mode/resampler/core options, muting, panning)
+// as well as the library version and an emulation revision.
+// Player-specific options (e.g. VGM_PLAY_OPTIONS) must be added using SetUserKey().
+//
+// Chunks that are missing are rendered by the player and stored while playing.
+// Seeking within cached chunks doesn't touch the player at all.
+// Notes:
+//	- Chunks are only stored when the player reached them by rendering from the beginning of the song.
+//	  Seeking backwards or far ahead of the cached part uses the player's Seek() and doesn't fill the cache
+//	  until Close() is called.
+//	  When continuing a partially filled cache, the player renders the cached part once to catch up.
+//	- Player events (PLREVT_LOOP/PLREVT_END) are not sent while playing from the cache.
+//	  Use GetCurPos() and GetTotalSamples() to detect the end of the song.
+//	- The cache assumes a playback speed of 1.0.
+//	- Samples after the end of the last loop are rendered live and are not cached.
+//	- Cache files are never modified in place. New chunks are stored in a temporary copy that replaces
+//	  the cache file in Close(), so several processes can share a cache directory.
+//	  When two processes fill the same cache file, the one that closes last wins.
+class RenderCache
+{
+public:
+	RenderCache();
+	~RenderCache();
+
+	void SetCacheDir(const char* dirPath);	// directory for the cache files (must exist)
+	void SetChunkSize(UINT32 smplCnt);		// chunk size in samples, only used for new cache files (default: 0x8000)
+	void SetCompression(UINT8 enable);		// compress new chunks using zlib (default: on)
+	void SetUserKey(const void* data, size_t size);	// additional data for the cache key
+
+	// Attaches a player that has the file loaded. dataLoader must be the loader that was passed to LoadFile().
+	// All options must be set before calling Open().
+	// The player must not be used directly until Close() is called.
+	// Returns:
+	//	0x00 - opened existing cache file
+	//	0x01 - created new cache file
+	//	0x80 - cache file can't be used, all samples will be rendered by the player
+	//	0xFF - invalid parameters
+	UINT8 Open(PlayerBase* player, DATA_LOADER* dataLoader, UINT32 loopCount);
+	UINT8 Close(void);	// stops the player and closes the cache file
+
+	UINT8 Start(void);	// The player is started when the first chunk has to be rendered.
+	UINT8 Stop(void);	// The player keeps running until Close().
+	UINT8 Seek(UINT32 smplPos);	// seek to sample position, O(1) when the chunk is cached
+	UINT32 Render(UINT32 smplCnt, WAVE_32BS* data);	// adds the samples to data, like PlayerBase::Render()
+
+	UINT32 GetCurPos(void) const;		// current position in samples
+	UINT32 GetTotalSamples(void) const;	// length of the song (including loops) in samples
+	UINT32 GetChunkCount(void) const;
+	UINT32 GetCachedChunks(void) const;	// number of chunks that are stored in the cache file
+	std::string GetCacheFilePath(void) const;
+
+protected:
+	struct CHUNK_ENTRY
+	{
+		UINT32 fileOfs;		// 0 = not cached
+		UINT32 dataSize;	// stored size, equals the raw size for uncompressed chunks
+	};
+
+	void BuildKey(DATA_LOADER* dataLoader, UINT32 loopCount);
+	UINT8 OpenCacheFile(void);
+	UINT8 CreateCacheFile(void);
+	void CloseCacheFile(void);
+	void DiscardCacheFile(void);
+	UINT8 MakeFileWritable(void);
+	std::string GetTempPath(void) const;
+	UINT32 GetChunkLength(UINT32 chunkID) const;
+	UINT8 LoadChunk(UINT32 chunkID);
+	void RenderChunk(UINT32 chunkID);
+	void StoreChunk(UINT32 chunkID);
+	void MoveLivePlayer(UINT32 smplPos);
+
+	std::string _cacheDir;
+	UINT32 _newChunkSize;
+	UINT8 _newCompress;
+	std::vector<UINT8> _userKey;
+
+	PlayerBase* _player;
+	std::vector<UINT8> _key;
+	UINT64 _keyHash;
+	std::string _filePath;
+	FILE* _hFile;
+	std::string _tmpPath;	// temporary file that _hFile refers to, empty = _hFile is the read-only cache file
+	UINT8 _fileChanged;		// chunks were added to the temporary file
+	UINT32 _tableOfs;	// file offset of the chunk table
+	std::vector<CHUNK_ENTRY> _chunks;
+	UINT32 _cachedChunks;
+
+	UINT32 _smplRate;
+	UINT32 _totalSmpls;
+	UINT32 _chunkSmpls;
+	UINT8 _compress;
+
+	UINT32 _curPos;
+	UINT32 _bufChunk;	// chunk that is in _chunkBuf, (UINT32)-1 = none
+	std::vector<WAVE_32BS> _chunkBuf;
+	std::vector<UINT8> _fileBuf;
+
+	UINT8 _liveStarted;	// the player was started
+	UINT8 _liveExact;	// the player reached _livePos by rendering from the beginning
+	UINT8 _seekJump;	// the next live render was caused by Seek()
+	UINT32 _livePos;	// player position in samples
+};
+
+#endif	// __RENDERCACHE_HPP__
@@ -19,6 +19,9 @@
 #include "../utils/StrUtils.h"
 #include "helper.h"
 #include "logging.h"
+#ifdef PLAYER_PROFILING
+#include "../utils/OSTimer.h"
+#endif
 
 enum S98_DEVTYPES
 {
@@ -866,6 +869,7 @@ UINT8 S98Player::Start(void)
 		cDev->base.defInf.dataPtr = NULL;
 		cDev->base.defInf.devDef = NULL;
 		cDev->base.linkDev = NULL;
+		cDev->shadow = NULL;
 		deviceID = (devHdr->devType < S98DEV_END) ? S98_DEV_LIST[devHdr->devType] : 0xFF;
 		if (deviceID == 0xFF)
 			continue;
@@ -883,12 +887,14 @@ UINT8 S98Player::Start(void)
 		}
 		devCfg->emuCore = (devOpts != NULL) ? devOpts->emuCore[0] : 0x00;
 		devCfg->srMode = (devOpts != NULL) ? devOpts->srMode : DEVRI_SRMODE_NATIVE;
+		devCfg->memArena = _memArena;
 		if (devOpts != NULL && devOpts->smplRate)
 			devCfg->smplRate = devOpts->smplRate;
 		else
 			devCfg->smplRate = _outSmplRate;
 		
 		retVal = SndEmu_Start(deviceID, devCfg, &cDev->base.defInf);
+		devCfg->memArena = NULL;	// the stored configuration must not refer to the arena
 		if (retVal)
 		{
 			cDev->base.defInf.dataPtr = NULL;
@@ -917,6 +923,7 @@ UINT8 S98Player::Start(void)
 		for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev)
 		{
 			Resmpl_SetVals(&clDev->resmpl, 0xFF, 0x100, _outSmplRate);
+			clDev->resmpl.memArena = _memArena;
 			if (deviceID == DEVID_YM2203 || deviceID == DEVID_YM2608)
 			{
 				// set SSG volume
@@ -927,6 +934,7 @@ UINT8 S98Player::Start(void)
 			Resmpl_Init(&clDev->resmpl);
 		}
 	}
+	InitPlayStats(_devices.size(), 0x100);
 	
 	_playState |= PLAYSTATE_PLAY;
 	Reset();
@@ -945,9 +953,13 @@ UINT8 S98Player::Stop(void)
 	for (curDev = 0; curDev < _devices.size(); curDev ++)
 	{
 		S98_CHIPDEV* cDev = &_devices[curDev];
+		if (cDev->shadow != NULL)
+			RegShadow_Deinit(cDev->shadow);
 		FreeDeviceTree(&cDev->base, 0);
 	}
 	_devices.clear();
+	if (_memArena != NULL)
+		MemArena_Reset(_memArena);
 	if (_eventCbFunc != NULL)
 		_eventCbFunc(this, _eventCbParam, PLREVT_STOP, NULL);
 	
@@ -1008,21 +1020,28 @@ UINT8 S98Player::Seek(UINT8 unit, UINT32 pos)
 	{
 	case PLAYPOS_FILEOFS:
 		_playState |= PLAYSTATE_SEEK;
+		InitRegShadows();
 		if (pos < _filePos)
 			Reset();
-		return SeekToFilePos(pos);
+		SeekToFilePos(pos);
+		break;
 	case PLAYPOS_SAMPLE:
 		pos = Sample2Tick(pos);
 		// fall through
 	case PLAYPOS_TICK:
 		_playState |= PLAYSTATE_SEEK;
+		InitRegShadows();
 		if (pos < _playTick)
 			Reset();
-		return SeekToTick(pos);
+		SeekToTick(pos);
+		break;
 	case PLAYPOS_COMMAND:
 	default:
 		return 0xFF;
 	}
+	FlushRegShadows();
+	
+	return 0x00;
 }
 
 UINT8 S98Player::SeekToTick(UINT32 tick)
@@ -1047,6 +1066,43 @@ UINT8 S98Player::SeekToFilePos(UINT32 pos)
 	return 0x00;
 }
 
+void S98Player::InitRegShadows(void)
+{
+	size_t curDev;
+	
+	if (_seekMode != PLRSEEK_FAST)
+		return;
+	
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		S98_CHIPDEV* cDev = &_devices[curDev];
+		UINT8 deviceID;
+		if (cDev->base.defInf.dataPtr == NULL || cDev->shadow != NULL)
+			continue;
+		deviceID = (_devHdrs[curDev].devType < S98DEV_END) ? S98_DEV_LIST[_devHdrs[curDev].devType] : 0xFF;
+		RegShadow_Init(&cDev->shadow, deviceID, &cDev->base.defInf, cDev->write);
+	}
+	
+	return;
+}
+
+void S98Player::FlushRegShadows(void)
+{
+	size_t curDev;
+	
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		S98_CHIPDEV* cDev = &_devices[curDev];
+		if (cDev->shadow == NULL)
+			continue;
+		RegShadow_Flush(cDev->shadow);
+		RegShadow_Deinit(cDev->shadow);
+		cDev->shadow = NULL;
+	}
+	
+	return;
+}
+
 UINT32 S98Player::Render(UINT32 smplCnt, WAVE_32BS* data)
 {
 	UINT32 curSmpl;
@@ -1054,6 +1110,10 @@ UINT32 S98Player::Render(UINT32 smplCnt, WAVE_32BS* data)
 	UINT32 maxSmpl;
 	INT32 smplStep;	// might be negative due to rounding errors in Tick2Sample
 	size_t curDev;
+#ifdef PLAYER_PROFILING
+	UINT64 renderStart = OSTimer_GetTime();
+	UINT64 devStart;
+#endif
 	
 	// Note: use do {} while(), so that "smplCnt == 0" can be used to process until reaching the next sample.
 	curSmpl = 0;
@@ -1076,11 +1136,18 @@ UINT32 S98Player::Render(UINT32 smplCnt, WAVE_32BS* data)
 			UINT8 disable = (cDev->optID != (size_t)-1) ? _devOpts[cDev->optID].muteOpts.disable : 0x00;
 			VGM_BASEDEV* clDev;
 			
+#ifdef PLAYER_PROFILING
+			devStart = OSTimer_GetTime();
+#endif
 			for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev, disable >>= 1)
 			{
 				if (clDev->defInf.dataPtr != NULL && ! (disable & 0x01))
 					Resmpl_Execute(&clDev->resmpl, smplStep, &data[curSmpl]);
 			}
+#ifdef PLAYER_PROFILING
+			_playStats.devStats[curDev].renderTime += OSTimer_GetTime() - devStart;
+			_playStats.devStats[curDev].smplCount += smplStep;
+#endif
 		}
 		curSmpl += smplStep;
 		_playSmpl += smplStep;
@@ -1091,6 +1158,10 @@ UINT32 S98Player::Render(UINT32 smplCnt, WAVE_32BS* data)
 		}
 	} while(curSmpl < smplCnt);
 	
+#ifdef PLAYER_PROFILING
+	_playStats.renderTime += OSTimer_GetTime() - renderStart;
+	_playStats.smplCount += curSmpl;
+#endif
 	return curSmpl;
 }
 
@@ -1171,6 +1242,9 @@ void S98Player::DoCommand(void)
 	
 	curCmd = _fileData[_filePos];
 	_filePos ++;
+#ifdef PLAYER_PROFILING
+	_playStats.cmdCount[curCmd] ++;
+#endif
 	switch(curCmd)
 	{
 	case 0xFF:	// advance 1 tick
@@ -1200,6 +1274,9 @@ void S98Player::DoRegWrite(UINT8 deviceID, UINT8 port, UINT8 reg, UINT8 data)
 	DEV_DATA* dataPtr = cDev->base.defInf.dataPtr;
 	if (dataPtr == NULL || cDev->write == NULL)
 		return;
+#ifdef PLAYER_PROFILING
+	_playStats.devStats[deviceID].regWrites ++;
+#endif
 	
 	if (_devHdrs[deviceID].devType == S98DEV_DCSG)
 	{
@@ -1208,6 +1285,10 @@ void S98Player::DoRegWrite(UINT8 deviceID, UINT8 port, UINT8 reg, UINT8 data)
 		else
 			cDev->write(dataPtr, SN76496_W_REG, data);
 	}
+	else if (cDev->shadow != NULL)
+	{
+		RegShadow_Write(cDev->shadow, port, reg, data);
+	}
 	else
 	{
 		cDev->write(dataPtr, (port << 1) | 0, reg);
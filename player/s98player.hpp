@@ -6,6 +6,7 @@
 #include "../emu/Resampler.h"
 #include "../utils/StrUtils.h"
 #include "helper.h"
+#include "regshadow.h"
 #include "playerbase.hpp"
 #include "../utils/DataLoader.h"
 #include <vector>
@@ -40,6 +41,7 @@ struct _s98_chip_device
 	size_t optID;
 	std::vector<UINT8> cfg;
 	DEVFUNC_WRITE_A8D8 write;
+	REG_SHADOW* shadow;	// only used while seeking
 };
 
 class S98Player : public PlayerBase
@@ -115,6 +117,8 @@ private:
 	static void DeviceLinkCallback(void* userParam, VGM_BASEDEV* cDev, DEVLINK_INFO* dLink);
 	UINT8 SeekToTick(UINT32 tick);
 	UINT8 SeekToFilePos(UINT32 pos);
+	void InitRegShadows(void);
+	void FlushRegShadows(void);
 	void ParseFile(UINT32 ticks);
 	void HandleEOF(void);
 	void DoCommand(void);
@@ -0,0 +1,853 @@
+// VGM optimizer: rewrites VGM command data into a smaller form that is cheaper to play back
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define INLINE	static inline
+
+#include "../common_def.h"
+#include "vgmoptimizer.hpp"
+#include "vgmplayer.hpp"
+#include "dblk_compr.h"
+#include "../emu/RatioCntr.h"
+#include "../emu/dac_control.h"	// for DCTRL_LMODE_CMDS
+#include "../utils/DataLoader.h"
+#include "../utils/MemoryLoader.h"
+
+#define VGM_SMPL_RATE	44100
+#define PCMRUN_MIN_LEN	0x20	// minimum number of writes for converting a PCM write run into a DAC stream
+#define DBLK_MIN_LEN	0x20	// minimum size of data blocks that are compressed
+#define CMP_BUF_SMPLS	0x800	// buffer size for comparing rendered output
+
+// FM shadow registers for redundant write detection
+enum
+{
+	FMSHDW_YM2612_P0,
+	FMSHDW_YM2612_P1,
+	FMSHDW_YM2612_2_P0,
+	FMSHDW_YM2612_2_P1,
+	FMSHDW_YM2151,
+	FMSHDW_YM2151_2,
+	FMSHDW_COUNT
+};
+
+
+INLINE UINT16 ReadLE16(const UINT8* data)
+{
+	return (data[0x01] << 8) | (data[0x00] << 0);
+}
+
+INLINE UINT32 ReadLE32(const UINT8* data)
+{
+	return	(data[0x03] << 24) | (data[0x02] << 16) |
+			(data[0x01] <<  8) | (data[0x00] <<  0);
+}
+
+INLINE void WriteLE32(UINT8* buffer, UINT32 value)
+{
+	buffer[0x00] = (UINT8)(value >>  0);
+	buffer[0x01] = (UINT8)(value >>  8);
+	buffer[0x02] = (UINT8)(value >> 16);
+	buffer[0x03] = (UINT8)(value >> 24);
+	return;
+}
+
+INLINE void PushLE32(std::vector<UINT8>& data, UINT32 value)
+{
+	data.push_back((UINT8)(value >>  0));
+	data.push_back((UINT8)(value >>  8));
+	data.push_back((UINT8)(value >> 16));
+	data.push_back((UINT8)(value >> 24));
+	return;
+}
+
+// write a delay using the shortest commands, pcmCmdOfs is the offset of a preceding command 80
+// that can take the first 15 samples
+static void WriteDelay(std::vector<UINT8>& data, UINT32 delay, size_t& pcmCmdOfs)
+{
+	if (! delay)
+		return;
+	if (pcmCmdOfs != (size_t)-1)
+	{
+		UINT32 pcmDelay = (delay < 0x0F) ? delay : 0x0F;
+		data[pcmCmdOfs] |= (UINT8)pcmDelay;
+		delay -= pcmDelay;
+		pcmCmdOfs = (size_t)-1;
+	}
+
+	while(delay > 0)
+	{
+		if (delay <= 0x10)
+		{
+			data.push_back(0x70 | (UINT8)(delay - 1));
+			break;
+		}
+		else if (delay <= 0x20)
+		{
+			data.push_back(0x7F);
+			delay -= 0x10;
+		}
+		else if (delay == 735)
+		{
+			data.push_back(0x62);
+			break;
+		}
+		else if (delay == 882)
+		{
+			data.push_back(0x63);
+			break;
+		}
+		else
+		{
+			UINT32 curDelay = (delay < 0xFFFF) ? delay : 0xFFFF;
+			data.push_back(0x61);
+			data.push_back((UINT8)(curDelay >> 0));
+			data.push_back((UINT8)(curDelay >> 8));
+			delay -= curDelay;
+		}
+	}
+
+	return;
+}
+
+// make the YM2612 PCM position of the output file match the source file
+static void SyncPCMPos(std::vector<UINT8>& data, UINT32 srcPos, UINT32& outPos)
+{
+	if (srcPos == (UINT32)-1 || srcPos == outPos)
+		return;
+	data.push_back(0xE0);
+	PushLE32(data, srcPos);
+	outPos = srcPos;
+	return;
+}
+
+INLINE UINT8 IsBank0Block(UINT8 dblkType)
+{
+	return (dblkType & 0xBF) == 0x00;	// uncompressed (00) or compressed (40) YM2612 PCM data
+}
+
+INLINE UINT8 GetBitCount(UINT32 value)
+{
+	UINT8 bits;
+
+	for (bits = 0; value; bits ++)
+		value >>= 1;
+	return bits;
+}
+
+VGMOptimizer::VGMOptimizer() :
+	_fileData(NULL),
+	_fileSize(0),
+	_fileHdr(NULL),
+	_usedPasses(0x00),
+	_endTick(0),
+	_endPcmPos(0),
+	_hasEndCmd(false),
+	_hasYM2612(false),
+	_dacStrmID(0xFF)
+{
+}
+
+VGMOptimizer::~VGMOptimizer()
+{
+}
+
+UINT8 VGMOptimizer::Optimize(DATA_LOADER* dataLoader, UINT8 passes, std::vector<UINT8>& outData)
+{
+	UINT8 retVal;
+	UINT8 curPass;
+
+	_usedPasses = 0x00;
+	retVal = _player.LoadFile(dataLoader);
+	if (retVal)
+		return 0xF0;
+	_fileData = DataLoader_GetData(dataLoader);
+	_fileSize = DataLoader_GetSize(dataLoader);
+	_fileHdr = _player.GetFileHeader();
+	if (_fileHdr->fileVer < 0x160)
+		passes &= ~(VGMOPT_PCM_STREAMS | VGMOPT_COMPRESS);	// requires VGM 1.60 commands
+	_hasYM2612 = (_player.GetHeaderChipClock(0x02) != 0);
+
+	retVal = ParseCommands();
+	if (retVal)
+	{
+		_player.UnloadFile();
+		return retVal;
+	}
+	_pcmRuns.clear();
+	if (passes & VGMOPT_PCM_STREAMS)
+		FindPCMRuns();
+
+	if (! (passes & VGMOPT_VERIFY))
+	{
+		_usedPasses = passes & VGMOPT_ALL;
+		WriteCommands(_usedPasses, outData);
+		_player.UnloadFile();
+		return 0x00;
+	}
+
+	// The re-encoding itself has to be lossless, then every pass is added only if the output stays the same.
+	WriteCommands(0x00, outData);
+	if (VerifyOutput(outData))
+	{
+		outData.assign(_fileData, _fileData + _fileSize);
+		_player.UnloadFile();
+		return 0x80;
+	}
+	retVal = 0x00;
+	for (curPass = 0x01; curPass & VGMOPT_ALL; curPass <<= 1)
+	{
+		if (! (passes & curPass))
+			continue;
+		if (curPass == VGMOPT_PCM_STREAMS && _pcmRuns.empty())
+			continue;
+
+		std::vector<UINT8> passData;
+		WriteCommands(_usedPasses | curPass, passData);
+		if (VerifyOutput(passData))
+		{
+			retVal = 0x01;
+			continue;
+		}
+		_usedPasses |= curPass;
+		outData.swap(passData);
+	}
+
+	_player.UnloadFile();
+	return retVal;
+}
+
+UINT8 VGMOptimizer::GetAppliedPasses(void) const
+{
+	return _usedPasses;
+}
+
+UINT8 VGMOptimizer::ParseCommands(void)
+{
+	UINT32 filePos;
+	UINT32 curTick;
+	UINT32 pcmPos;
+	UINT32 pcmSize;
+	UINT8 strmUsed[0x100];
+	bool foundLoop;
+	OPT_EVENT evt;
+
+	_events.clear();
+	_hasEndCmd = false;
+	foundLoop = false;
+	memset(strmUsed, 0x00, sizeof(strmUsed));
+	curTick = 0;
+	pcmPos = 0;
+	pcmSize = 0;
+	evt.runID = (size_t)-1;
+
+	filePos = _fileHdr->dataOfs;
+	while(filePos < _fileHdr->dataEnd)
+	{
+		const UINT8* cmdData = &_fileData[filePos];
+		UINT8 curCmd = cmdData[0x00];
+		UINT32 cmdLen;
+
+		evt.tick = curTick;
+		evt.fileOfs = filePos;
+		evt.delay = 0;
+		evt.pcmPos = pcmPos;
+		evt.pcmSize = pcmSize;
+		if (filePos == _fileHdr->loopOfs)
+		{
+			evt.cmdLen = 0;
+			evt.type = _EVT_LOOP;
+			_events.push_back(evt);
+			foundLoop = true;
+			// From here on, the position depends on the state at the end of the previous loop.
+			pcmPos = (UINT32)-1;
+			evt.pcmPos = pcmPos;
+		}
+		if (curCmd == 0x66)
+		{
+			_hasEndCmd = true;
+			break;
+		}
+
+		evt.type = _EVT_CMD;
+		switch(curCmd)
+		{
+		case 0x61:
+		case 0x62:
+		case 0x63:
+			cmdLen = VGMPlayer::_CMD_INFO[curCmd].cmdLen;
+			if (filePos + cmdLen > _fileHdr->dataEnd)
+				break;
+			if (curCmd == 0x61)
+				evt.delay = ReadLE16(&cmdData[0x01]);
+			else
+				evt.delay = (curCmd == 0x62) ? 735 : 882;
+			evt.type = _EVT_DELAY;
+			evt.cmdLen = cmdLen;
+			_events.push_back(evt);
+			curTick += evt.delay;
+			break;
+		case 0x67:
+			cmdLen = 0x07;
+			if (filePos + cmdLen > _fileHdr->dataEnd)
+				break;
+			cmdLen += ReadLE32(&cmdData[0x03]) & 0x7FFFFFFF;
+			if (filePos + cmdLen > _fileHdr->dataEnd)
+				break;
+			evt.type = _EVT_DATABLK;
+			evt.cmdLen = cmdLen;
+			_events.push_back(evt);
+			if (cmdData[0x02] == 0x00)
+			{
+				pcmSize += cmdLen - 0x07;
+			}
+			else if (cmdData[0x02] == 0x40)
+			{
+				PCM_CDB_INF dbCI;
+				if (! ReadComprDataBlkHdr(cmdLen - 0x07, &cmdData[0x07], &dbCI))
+					pcmSize += dbCI.decmpLen;
+			}
+			break;
+		case 0xE0:
+			cmdLen = 0x05;
+			if (filePos + cmdLen <= _fileHdr->dataEnd)
+				pcmPos = ReadLE32(&cmdData[0x01]);
+			break;
+		default:
+			if (curCmd >= 0x70 && curCmd <= 0x7F)
+			{
+				cmdLen = 0x01;
+				evt.type = _EVT_DELAY;
+				evt.cmdLen = cmdLen;
+				evt.delay = (curCmd & 0x0F) + 1;
+				_events.push_back(evt);
+				curTick += evt.delay;
+			}
+			else if (curCmd >= 0x80 && curCmd <= 0x8F)
+			{
+				cmdLen = 0x01;
+				evt.type = _EVT_PCM;
+				evt.cmdLen = cmdLen;
+				evt.delay = (curCmd & 0x0F);
+				_events.push_back(evt);
+				// The player doesn't advance the position when there is no chip or the bank end was reached.
+				if (_hasYM2612 && pcmPos != (UINT32)-1 && pcmPos < pcmSize)
+					pcmPos ++;
+				curTick += evt.delay;
+			}
+			else
+			{
+				cmdLen = VGMPlayer::_CMD_INFO[curCmd].cmdLen;
+				if (! cmdLen)
+					return 0xF1;	// invalid command - would stop playback
+				if (filePos + cmdLen > _fileHdr->dataEnd)
+					break;
+				if (curCmd >= 0x90 && curCmd <= 0x95)
+					strmUsed[cmdData[0x01]] = 0x01;
+				evt.cmdLen = cmdLen;
+				_events.push_back(evt);
+			}
+			break;
+		}
+		filePos += cmdLen;
+	}
+	if (_fileHdr->loopOfs && ! foundLoop)
+		return 0xF1;	// loop offset doesn't point to a command
+
+	_endTick = curTick;
+	_endPcmPos = pcmPos;
+	for (_dacStrmID = 0x00; _dacStrmID < 0xFF; _dacStrmID ++)
+	{
+		if (! strmUsed[_dacStrmID])
+			break;
+	}
+
+	return 0x00;
+}
+
+void VGMOptimizer::FindPCMRuns(void)
+{
+	std::vector<size_t> runEvts;
+	UINT32 lastPcmTick;
+	size_t curEvt;
+
+	if (! _hasYM2612 || _dacStrmID == 0xFF)
+		return;
+
+	lastPcmTick = (UINT32)-1;
+	for (curEvt = 0; curEvt < _events.size(); curEvt ++)
+	{
+		OPT_EVENT& evt = _events[curEvt];
+
+		evt.runID = (size_t)-1;
+		if (evt.type == _EVT_LOOP || (evt.type == _EVT_DATABLK && IsBank0Block(_fileData[evt.fileOfs + 0x02])))
+		{
+			// A stream must not cross the loop point and a bank 0 data block invalidates its data pointer.
+			CheckPCMRun(runEvts);
+			runEvts.clear();
+			continue;
+		}
+		if (evt.type != _EVT_PCM)
+			continue;
+
+		if (! runEvts.empty())
+		{
+			const OPT_EVENT& lastEvt = _events[runEvts.back()];
+			UINT32 spacing = evt.tick - lastEvt.tick;
+			bool isContinuous = (evt.pcmPos != (UINT32)-1 && evt.pcmPos == lastEvt.pcmPos + 1);
+			bool isRegular = (runEvts.size() < 2 || spacing == lastEvt.tick - _events[runEvts[runEvts.size() - 2]].tick);
+			if (! isContinuous || ! isRegular || ! spacing)
+			{
+				CheckPCMRun(runEvts);
+				runEvts.clear();
+			}
+		}
+		// A run can't start at the same tick as a preceding write, as the stream's first write
+		// is done before all other commands of that tick.
+		if (runEvts.empty() && (evt.pcmPos == (UINT32)-1 || evt.tick == lastPcmTick))
+		{
+			lastPcmTick = evt.tick;
+			continue;
+		}
+		runEvts.push_back(curEvt);
+		lastPcmTick = evt.tick;
+	}
+	CheckPCMRun(runEvts);
+
+	return;
+}
+
+void VGMOptimizer::CheckPCMRun(const std::vector<size_t>& evtList)
+{
+	RATIO_CNTR stepCntr;
+	RC_TYPE smplInc;
+	RC_TYPE maxCount;
+	UINT32 spacing;
+	UINT32 freq;
+	UINT32 count;
+	size_t curPos;
+
+	if (evtList.size() < PCMRUN_MIN_LEN)
+		return;
+	spacing = _events[evtList[1]].tick - _events[evtList[0]].tick;
+
+	// The DAC stream sends its first write with the update following the start and then
+	// one write every time the ratio counter overflows. The frequency is an integer, so the counter
+	// increment is usually rounded. An increment that falls short would delay a write by one sample,
+	// so the lowest frequency that doesn't fall short is used.
+	freq = VGM_SMPL_RATE / spacing;
+	RC_SET_RATIO(&stepCntr, freq, VGM_SMPL_RATE);
+	if (stepCntr.inc * spacing < ((RC_TYPE)1 << RC_SHIFT))
+	{
+		freq ++;
+		RC_SET_RATIO(&stepCntr, freq, VGM_SMPL_RATE);
+	}
+	// The excess adds up over the run and may only make an overflow earlier by less than a sample.
+	// Longer runs are split into several streams.
+	smplInc = stepCntr.inc * spacing - ((RC_TYPE)1 << RC_SHIFT);
+	maxCount = smplInc ? ((stepCntr.inc - 1) / smplInc + 1) : (RC_TYPE)evtList.size();
+
+	for (curPos = 0; curPos < evtList.size(); curPos += count)
+	{
+		count = (UINT32)(evtList.size() - curPos);
+		if (count > maxCount)
+			count = (UINT32)maxCount;
+		if (count < PCMRUN_MIN_LEN)
+			break;
+		if (! AddPCMRun(evtList, curPos, count, freq))
+			break;
+	}
+
+	return;
+}
+
+UINT8 VGMOptimizer::AddPCMRun(const std::vector<size_t>& evtList, size_t firstEvt, UINT32 count, UINT32 freq)
+{
+	const OPT_EVENT& evtStart = _events[evtList[firstEvt]];
+	PCM_RUN run;
+	size_t curEvt;
+
+	if (! evtStart.tick)
+		return 0x00;	// the stream needs to be started 1 tick earlier
+	run.startTick = evtStart.tick;
+	run.pcmPos = evtStart.pcmPos;
+	run.count = count;
+	run.freq = freq;
+	if (run.pcmPos > evtStart.pcmSize || run.count > evtStart.pcmSize - run.pcmPos)
+		return 0x00;
+
+	// start the stream during the last delay before the first write, after all events of the previous tick
+	run.splitEvt = evtList[firstEvt];
+	do
+	{
+		run.splitEvt --;
+	} while(! _events[run.splitEvt].delay);
+	for (curEvt = run.splitEvt + 1; curEvt < evtList[firstEvt]; curEvt ++)
+	{
+		const OPT_EVENT& evt = _events[curEvt];
+		if (evt.type == _EVT_LOOP || (evt.type == _EVT_DATABLK && IsBank0Block(_fileData[evt.fileOfs + 0x02])))
+			return 0x00;
+	}
+
+	for (curEvt = firstEvt; curEvt < firstEvt + count; curEvt ++)
+		_events[evtList[curEvt]].runID = _pcmRuns.size();
+	_pcmRuns.push_back(run);
+
+	return 0x01;
+}
+
+UINT8 VGMOptimizer::IsNoOpCommand(const OPT_EVENT& evt, UINT8 fmRegs[][0x100], UINT8 fmValid[][0x100]) const
+{
+	const UINT8* cmdData = &_fileData[evt.fileOfs];
+	UINT8 curCmd = cmdData[0x00];
+	const VGMPlayer::COMMAND_INFO& cmdInf = VGMPlayer::_CMD_INFO[curCmd];
+	UINT32 chipClk;
+	UINT8 fmID;
+	UINT8 isStateReg;
+	UINT8 reg;
+
+	if (cmdInf.func == &VGMPlayer::Cmd_unknown)
+		return 0x01;
+	if (cmdInf.chipType >= VGMPlayer::_CHIP_COUNT)
+		return 0x00;
+
+	// writes to chips that aren't present in the header
+	chipClk = _player.GetHeaderChipClock(cmdInf.chipType);
+	if (! chipClk)
+		return 0x01;
+	if (curCmd == 0x30 || curCmd == 0x3F || (curCmd >= 0xA1 && curCmd <= 0xAF))
+	{
+		if (! (chipClk & 0x40000000))
+			return 0x01;	// 2nd chip not present
+	}
+
+	// repeated writes of the same value to FM registers that only hold parameters
+	reg = cmdData[0x01];
+	switch(curCmd)
+	{
+	case 0x52:	fmID = FMSHDW_YM2612_P0;	break;
+	case 0x53:	fmID = FMSHDW_YM2612_P1;	break;
+	case 0xA2:	fmID = FMSHDW_YM2612_2_P0;	break;
+	case 0xA3:	fmID = FMSHDW_YM2612_2_P1;	break;
+	case 0x54:	fmID = FMSHDW_YM2151;		break;
+	case 0xA4:	fmID = FMSHDW_YM2151_2;		break;
+	default:
+		return 0x00;
+	}
+	if (fmID < FMSHDW_YM2151)
+		// operator parameters (except SSG-EG, which resets the inversion state), algorithm/feedback, panning/LFO sensitivity
+		isStateReg = (reg >= 0x30 && reg < 0x90) || (reg >= 0xB0 && reg < 0xB8);
+	else
+		// RL/FB/CONNECT, PMS/AMS, operator parameters
+		isStateReg = (reg >= 0x20 && reg < 0x28) || (reg >= 0x38);
+	if (! isStateReg)
+		return 0x00;
+
+	if (fmValid[fmID][reg] && fmRegs[fmID][reg] == cmdData[0x02])
+		return 0x01;
+	fmRegs[fmID][reg] = cmdData[0x02];
+	fmValid[fmID][reg] = 0x01;
+	return 0x00;
+}
+
+void VGMOptimizer::WriteCommands(UINT8 passes, std::vector<UINT8>& outData) const
+{
+	UINT8 fmRegs[FMSHDW_COUNT][0x100];
+	UINT8 fmValid[FMSHDW_COUNT][0x100];
+	bool useRuns;
+	bool mergeWaits;
+	size_t nextRun;
+	size_t curEvt;
+	size_t pcmCmdOfs;	// offset of the last command 80 that may take a delay
+	UINT32 curTick;
+	UINT32 pcmPos;	// YM2612 PCM position during playback of the output file
+	UINT32 loopOfs;
+	UINT32 strmFreq;
+	bool strmSetup;
+	bool strmData;
+
+	useRuns = (passes & VGMOPT_PCM_STREAMS) && ! _pcmRuns.empty();
+	mergeWaits = (passes & VGMOPT_MERGE_WAITS) != 0;
+	memset(fmValid, 0x00, sizeof(fmValid));
+	outData.assign(_fileData, _fileData + _fileHdr->dataOfs);
+	nextRun = 0;
+	pcmCmdOfs = (size_t)-1;
+	curTick = 0;
+	pcmPos = 0;
+	loopOfs = 0;
+	strmFreq = 0;
+	strmSetup = false;
+	strmData = false;
+
+	// Without VGMOPT_MERGE_WAITS, the delays are written right after their command, so that curTick is
+	// always at the tick of the current event. Else they are written before the next command that is kept.
+	for (curEvt = 0; curEvt < _events.size(); curEvt ++)
+	{
+		const OPT_EVENT& evt = _events[curEvt];
+		const UINT8* cmdData = &_fileData[evt.fileOfs];
+		bool keepCmd;
+
+		switch(evt.type)
+		{
+		case _EVT_PCM:
+			keepCmd = true;
+			if (useRuns && evt.runID != (size_t)-1)
+				keepCmd = false;	// sent by the DAC stream
+			else if ((passes & VGMOPT_DROP_WRITES) && ! _hasYM2612)
+				keepCmd = false;
+			break;
+		case _EVT_CMD:
+			keepCmd = ! ((passes & VGMOPT_DROP_WRITES) && IsNoOpCommand(evt, fmRegs, fmValid));
+			break;
+		case _EVT_DELAY:
+			keepCmd = false;	// only the delay is written
+			break;
+		default:
+			keepCmd = true;
+			break;
+		}
+
+		if (keepCmd)
+		{
+			WriteDelay(outData, evt.tick - curTick, pcmCmdOfs);
+			curTick = evt.tick;
+			switch(evt.type)
+			{
+			case _EVT_LOOP:
+				SyncPCMPos(outData, evt.pcmPos, pcmPos);
+				loopOfs = (UINT32)outData.size();
+				pcmCmdOfs = (size_t)-1;
+				pcmPos = (UINT32)-1;
+				strmData = false;
+				strmFreq = 0;
+				memset(fmValid, 0x00, sizeof(fmValid));
+				break;
+			case _EVT_PCM:
+				SyncPCMPos(outData, evt.pcmPos, pcmPos);
+				pcmCmdOfs = outData.size();
+				outData.push_back(0x80);
+				if (_hasYM2612 && pcmPos != (UINT32)-1 && pcmPos < evt.pcmSize)
+					pcmPos ++;
+				break;
+			case _EVT_DATABLK:
+				if (! ((passes & VGMOPT_COMPRESS) && CompressBlock(evt, outData)))
+					outData.insert(outData.end(), cmdData, cmdData + evt.cmdLen);
+				if (IsBank0Block(cmdData[0x02]))
+					strmData = false;	// the bank gets reallocated
+				pcmCmdOfs = (size_t)-1;
+				break;
+			case _EVT_CMD:
+				outData.insert(outData.end(), cmdData, cmdData + evt.cmdLen);
+				pcmCmdOfs = (size_t)-1;
+				break;
+			}
+		}
+
+		if (useRuns && nextRun < _pcmRuns.size() && _pcmRuns[nextRun].splitEvt == curEvt)
+		{
+			// start the DAC stream 1 tick early, so that it sends its first write at the original tick
+			const PCM_RUN& run = _pcmRuns[nextRun];
+			nextRun ++;
+			WriteDelay(outData, run.startTick - 1 - curTick, pcmCmdOfs);
+			curTick = run.startTick - 1;
+			if (! strmSetup)
+			{
+				UINT8 cmdSetup[0x05] = {0x90, _dacStrmID, 0x02, 0x00, 0x2A};	// YM2612 chip 0, port 0, reg 2A
+				outData.insert(outData.end(), cmdSetup, cmdSetup + 0x05);
+				strmSetup = true;
+			}
+			if (! strmData)
+			{
+				UINT8 cmdSetData[0x05] = {0x91, _dacStrmID, 0x00, 0x01, 0x00};	// bank 0, step size 1, step base 0
+				outData.insert(outData.end(), cmdSetData, cmdSetData + 0x05);
+				strmData = true;
+			}
+			if (strmFreq != run.freq)
+			{
+				outData.push_back(0x92);
+				outData.push_back(_dacStrmID);
+				PushLE32(outData, run.freq);
+				strmFreq = run.freq;
+			}
+			outData.push_back(0x93);
+			outData.push_back(_dacStrmID);
+			PushLE32(outData, run.pcmPos);
+			outData.push_back(DCTRL_LMODE_CMDS);
+			PushLE32(outData, run.count);
+			pcmCmdOfs = (size_t)-1;
+		}
+		if (! mergeWaits && curTick < evt.tick + evt.delay)
+		{
+			if (evt.type == _EVT_DELAY && curTick == evt.tick)
+				outData.insert(outData.end(), cmdData, cmdData + evt.cmdLen);	// keep the original command
+			else
+				WriteDelay(outData, evt.tick + evt.delay - curTick, pcmCmdOfs);	// also restores 80..8F
+			curTick = evt.tick + evt.delay;
+			pcmCmdOfs = (size_t)-1;
+		}
+	}
+	WriteDelay(outData, _endTick - curTick, pcmCmdOfs);
+	if (_hasEndCmd)
+	{
+		SyncPCMPos(outData, _endPcmPos, pcmPos);
+		outData.push_back(0x66);
+	}
+
+	// fix header offsets
+	if (_fileHdr->loopOfs)
+		WriteLE32(&outData[0x1C], loopOfs - 0x1C);
+	if (_fileHdr->gd3Ofs >= _fileHdr->dataOfs && _fileHdr->gd3Ofs < _fileHdr->eofOfs)
+	{
+		UINT32 gd3Ofs = (UINT32)outData.size();
+		outData.insert(outData.end(), &_fileData[_fileHdr->gd3Ofs], &_fileData[_fileHdr->eofOfs]);
+		WriteLE32(&outData[0x14], gd3Ofs - 0x14);
+	}
+	WriteLE32(&outData[0x04], (UINT32)outData.size() - 0x04);
+
+	return;
+}
+
+UINT8 VGMOptimizer::CompressBlock(const OPT_EVENT& evt, std::vector<UINT8>& outData) const
+{
+	const UINT8* cmdData = &_fileData[evt.fileOfs];
+	const UINT8* dataPtr = &cmdData[0x07];
+	UINT8 dblkType = cmdData[0x02];
+	UINT32 dataLen = evt.cmdLen - 0x07;
+	UINT32 curPos;
+	UINT8 minVal;
+	UINT8 maxVal;
+	UINT8 usedBits;
+	UINT8 bitsCopy;
+	UINT8 bitsShift;
+	UINT32 cmpLen;
+	PCM_CDB_INF dbCI;
+	std::vector<UINT8> cmpData;
+	std::vector<UINT8> decData;
+
+	// only uncompressed PCM banks can be stored compressed, 7F is the compression table
+	if (dblkType >= 0x3F || dataLen < DBLK_MIN_LEN)
+		return 0x00;
+
+	minVal = maxVal = dataPtr[0x00];
+	for (curPos = 0x01; curPos < dataLen; curPos ++)
+	{
+		if (minVal > dataPtr[curPos])
+			minVal = dataPtr[curPos];
+		if (maxVal < dataPtr[curPos])
+			maxVal = dataPtr[curPos];
+	}
+	usedBits = 0x00;
+	for (curPos = 0x00; curPos < dataLen; curPos ++)
+		usedBits |= (UINT8)(dataPtr[curPos] - minVal);
+
+	// "copy" mode stores (value - base), "shift left" mode drops unused low bits
+	bitsCopy = GetBitCount(maxVal - minVal);
+	bitsShift = 8;
+	while(bitsShift > 0 && ! (usedBits & (0x100 >> bitsShift)))
+		bitsShift --;
+
+	dbCI.decmpLen = dataLen;
+	dbCI.cmprInfo.comprType = 0x00;	// bit packing
+	dbCI.cmprInfo.bitsDec = 8;
+	dbCI.cmprInfo.baseVal = minVal;
+	dbCI.cmprInfo.comprTbl = NULL;
+	if (bitsShift < bitsCopy)
+	{
+		dbCI.cmprInfo.subType = 0x01;
+		dbCI.cmprInfo.bitsCmp = bitsShift;
+	}
+	else
+	{
+		dbCI.cmprInfo.subType = 0x00;
+		dbCI.cmprInfo.bitsCmp = bitsCopy;
+	}
+	if (! dbCI.cmprInfo.bitsCmp)
+		dbCI.cmprInfo.bitsCmp = 1;
+	if (dbCI.cmprInfo.bitsCmp >= dbCI.cmprInfo.bitsDec)
+		return 0x00;
+
+	cmpLen = BPACK_SIZE_CMP(dataLen, dbCI.cmprInfo.bitsCmp, dbCI.cmprInfo.bitsDec);
+	cmpData.resize(0x10 + cmpLen + 0x01);	// CompressDataBlk may write 1 byte beyond the end
+	if (WriteComprDataBlkHdr((UINT32)cmpData.size(), &cmpData[0x00], &dbCI))
+		return 0x00;
+	if (dbCI.hdrSize + cmpLen >= dataLen)
+		return 0x00;	// no gain
+	if (CompressDataBlk(cmpLen + 0x01, &cmpData[dbCI.hdrSize], dataLen, dataPtr, &dbCI.cmprInfo))
+		return 0x00;
+	cmpLen += dbCI.hdrSize;
+
+	// make sure that the player decodes the exact same data
+	decData.resize(dataLen);
+	if (DecompressDataBlk(dataLen, &decData[0x00], cmpLen - dbCI.hdrSize, &cmpData[dbCI.hdrSize], &dbCI.cmprInfo))
+		return 0x00;
+	if (memcmp(&decData[0x00], dataPtr, dataLen))
+		return 0x00;
+
+	outData.push_back(0x67);
+	outData.push_back(0x66);
+	outData.push_back(0x40 | dblkType);
+	PushLE32(outData, cmpLen | (ReadLE32(&cmdData[0x03]) & 0x80000000));
+	outData.insert(outData.end(), cmpData.begin(), cmpData.begin() + cmpLen);
+
+	return 0x01;
+}
+
+UINT8 VGMOptimizer::VerifyOutput(const std::vector<UINT8>& outData) const
+{
+	UINT32 smplCnt;
+
+	// play the song once and the loop a second time, plus a second for release phases
+	smplCnt = _fileHdr->numTicks + VGM_SMPL_RATE;
+	if (_fileHdr->loopOfs)
+		smplCnt += _fileHdr->loopTicks;
+	return CompareOutput(_fileSize, _fileData, (UINT32)outData.size(), &outData[0], smplCnt);
+}
+
+/*static*/ UINT8 VGMOptimizer::CompareOutput(UINT32 lenA, const UINT8* dataA, UINT32 lenB, const UINT8* dataB, UINT32 smplCnt)
+{
+	DATA_LOADER* dLoad[2];
+	VGMPlayer player[2];
+	std::vector<WAVE_32BS> smplBuf[2];
+	UINT32 renderSmpls[2];
+	UINT32 curSmpl;
+	UINT8 curPlr;
+	UINT8 retVal;
+
+	dLoad[0] = MemoryLoader_Init(dataA, lenA);
+	dLoad[1] = MemoryLoader_Init(dataB, lenB);
+	retVal = 0x00;
+	for (curPlr = 0; curPlr < 2; curPlr ++)
+	{
+		if (dLoad[curPlr] == NULL || DataLoader_Load(dLoad[curPlr]) || player[curPlr].LoadFile(dLoad[curPlr]))
+		{
+			retVal = 0xF0;
+			continue;
+		}
+		player[curPlr].SetSampleRate(VGM_SMPL_RATE);
+		player[curPlr].Start();
+		smplBuf[curPlr].resize(CMP_BUF_SMPLS);
+	}
+
+	for (curSmpl = 0; curSmpl < smplCnt && ! retVal; curSmpl += CMP_BUF_SMPLS)
+	{
+		UINT32 smplStep = (smplCnt - curSmpl < CMP_BUF_SMPLS) ? (smplCnt - curSmpl) : CMP_BUF_SMPLS;
+		for (curPlr = 0; curPlr < 2; curPlr ++)
+		{
+			memset(&smplBuf[curPlr][0], 0x00, smplStep * sizeof(WAVE_32BS));
+			renderSmpls[curPlr] = player[curPlr].Render(smplStep, &smplBuf[curPlr][0]);
+		}
+		if (renderSmpls[0] != renderSmpls[1] ||
+			memcmp(&smplBuf[0][0], &smplBuf[1][0], renderSmpls[0] * sizeof(WAVE_32BS)))
+			retVal = 0x01;
+	}
+
+	for (curPlr = 0; curPlr < 2; curPlr ++)
+	{
+		if (player[curPlr].GetState() & PLAYSTATE_PLAY)
+			player[curPlr].Stop();
+		player[curPlr].UnloadFile();
+		if (dLoad[curPlr] != NULL)
+			DataLoader_Deinit(dLoad[curPlr]);
+	}
+	return retVal;
+}
@@ -0,0 +1,104 @@
+#ifndef __VGMOPTIMIZER_HPP__
+#define __VGMOPTIMIZER_HPP__
+
+#include "../stdtype.h"
+#include "../utils/DataLoader.h"
+#include "vgmplayer.hpp"
+#include <vector>
+
+// optimization passes
+// Without passes, the command data is re-encoded with the original wait commands.
+#define VGMOPT_DROP_WRITES	0x01	// drop commands without effect (unused chips, repeated FM parameter writes, unknown commands)
+#define VGMOPT_PCM_STREAMS	0x02	// convert runs of YM2612 PCM writes (80..8F) to DAC Stream Control commands
+#define VGMOPT_COMPRESS		0x04	// bit-pack uncompressed PCM data blocks
+#define VGMOPT_MERGE_WAITS	0x08	// merge waits and write them with the shortest commands (including 80..8F)
+#define VGMOPT_ALL			0x0F
+#define VGMOPT_VERIFY		0x80	// render every pass and reject it when the output differs from the original file
+
+// Rewrites VGM files into a form that is smaller and cheaper to play back.
+// The command table of VGMPlayer is used for parsing, so that the optimizer
+// sees the file exactly the way the player does.
+// DAC Stream Control and compressed data blocks require VGM 1.60, so these passes
+// are skipped for older files.
+// Notes:
+//	- PCM write runs are only converted when the DAC stream hits the exact same samples
+//	  at 44100 Hz. The output is compared at this rate, too.
+//	  As the stream frequency is an integer, the counter increment of most spacings has a small
+//	  rounding error. Long runs are split into several streams before the error adds up to a sample.
+//	- VGMPlayer renders the samples between two wait commands at once and some cores depend on
+//	  the block size. Merging waits or starting a stream in the middle of a wait can change
+//	  the output of those cores, so these should be used with VGMOPT_VERIFY.
+//	- The verification uses the default emulation cores.
+class VGMOptimizer
+{
+public:
+	VGMOptimizer();
+	~VGMOptimizer();
+
+	// Returns:
+	//	0x00 - OK
+	//	0x01 - OK, but verification rejected some of the requested passes
+	//	0x80 - verification of the re-encoded file failed, outData contains the original file
+	//	0xF0 - invalid file
+	//	0xF1 - invalid command in the command data
+	UINT8 Optimize(DATA_LOADER* dataLoader, UINT8 passes, std::vector<UINT8>& outData);
+	UINT8 GetAppliedPasses(void) const;	// passes that were used for the last output
+
+	// Renders both files using VGMPlayer and compares the output sample by sample.
+	// returns 0x00 if identical, 0x01 if different, 0xF0 if one of the files can't be played
+	static UINT8 CompareOutput(UINT32 lenA, const UINT8* dataA, UINT32 lenB, const UINT8* dataB, UINT32 smplCnt);
+
+protected:
+	enum
+	{
+		_EVT_CMD,		// command that is copied as it is
+		_EVT_PCM,		// YM2612 PCM write (80..8F)
+		_EVT_DATABLK,	// data block (67)
+		_EVT_DELAY,		// wait command (61..63, 70..7F)
+		_EVT_LOOP		// loop point
+	};
+	struct OPT_EVENT
+	{
+		UINT32 tick;
+		UINT32 fileOfs;
+		UINT32 cmdLen;
+		UINT32 delay;	// ticks the command waits after it was executed
+		UINT8 type;		// _EVT_ constant
+		UINT32 pcmPos;	// YM2612 PCM position before the event, (UINT32)-1 = unknown
+		UINT32 pcmSize;	// size of PCM bank 0 at the event
+		size_t runID;	// PCM write: PCM run that replaces it
+	};
+	struct PCM_RUN
+	{
+		size_t splitEvt;	// the stream is started during the delay of this event
+		UINT32 startTick;	// tick of the first write
+		UINT32 pcmPos;
+		UINT32 count;
+		UINT32 freq;
+	};
+
+	UINT8 ParseCommands(void);
+	void FindPCMRuns(void);
+	void CheckPCMRun(const std::vector<size_t>& evtList);
+	UINT8 AddPCMRun(const std::vector<size_t>& evtList, size_t firstEvt, UINT32 count, UINT32 freq);
+	UINT8 IsNoOpCommand(const OPT_EVENT& evt, UINT8 fmRegs[][0x100], UINT8 fmValid[][0x100]) const;
+	void WriteCommands(UINT8 passes, std::vector<UINT8>& outData) const;
+	UINT8 CompressBlock(const OPT_EVENT& evt, std::vector<UINT8>& outData) const;
+	UINT8 VerifyOutput(const std::vector<UINT8>& outData) const;
+
+	VGMPlayer _player;	// used for header parsing and the command table
+	const UINT8* _fileData;
+	UINT32 _fileSize;
+	const VGM_HEADER* _fileHdr;
+	UINT8 _usedPasses;
+
+	std::vector<OPT_EVENT> _events;
+	std::vector<PCM_RUN> _pcmRuns;
+	UINT32 _endTick;
+	UINT32 _endPcmPos;	// YM2612 PCM position at the end of the command data
+	bool _hasEndCmd;	// command data is terminated by command 66
+	bool _hasYM2612;
+	UINT8 _dacStrmID;	// DAC stream ID used for PCM runs, 0xFF = none available
+};
+
+#endif	// __VGMOPTIMIZER_HPP__
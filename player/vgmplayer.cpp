@@ -8,6 +8,7 @@
 #include "../common_def.h"
 #include "vgmplayer.hpp"
 #include "../emu/EmuStructs.h"
+#include "../emu/EmuHelper.h"	// for EmuHash_Data
 #include "../emu/SoundEmu.h"
 #include "../emu/Resampler.h"
 #include "../emu/SoundDevs.h"
@@ -26,6 +27,9 @@
 #include "../utils/StrUtils.h"
 #include "helper.h"
 #include "logging.h"
+#ifdef PLAYER_PROFILING
+#include "../utils/OSTimer.h"
+#endif
 
 /*static*/ const UINT8 VGMPlayer::_OPT_DEV_LIST[_OPT_DEV_COUNT] =
 {
@@ -129,13 +133,17 @@ INLINE void SaveDeviceConfig(std::vector<UINT8>& dst, const void* srcData, size_
 }
 
 VGMPlayer::VGMPlayer() :
+	_probeOnly(false),
 	_filePos(0),
 	_fileTick(0),
 	_playTick(0),
 	_playSmpl(0),
 	_curLoop(0),
 	_playState(0x00),
-	_psTrigger(0x00)
+	_psTrigger(0x00),
+	_lcMaxSmpls(0),
+	_lcState(_LCSTATE_OFF),
+	_lcCheck(0)
 {
 	UINT8 retVal;
 	UINT16 optChip;
@@ -170,6 +178,13 @@ VGMPlayer::VGMPlayer() :
 	if (retVal)
 		_cpcUTF16 = NULL;
 	memset(&_pcmComprTbl, 0x00, sizeof(PCM_COMPR_TBL));
+	for (size_t curBank = 0x00; curBank < _PCM_BANK_COUNT; curBank ++)
+	{
+		_pcmBank[curBank].ptr = NULL;
+		_pcmBank[curBank].size = 0;
+		_pcmBank[curBank].fileSize = 0;
+		_pcmBank[curBank].fileBlocks = 0;
+	}
 	_tagList[0] = NULL;
 	return;
 }
@@ -222,6 +237,7 @@ UINT8 VGMPlayer::LoadFile(DATA_LOADER *dataLoader)
 		return 0xF0;	// invalid file
 	
 	_dLoad = dataLoader;
+	_probeOnly = false;
 	DataLoader_ReadAll(_dLoad);
 	_fileData = DataLoader_GetData(_dLoad);
 	
@@ -231,17 +247,68 @@ UINT8 VGMPlayer::LoadFile(DATA_LOADER *dataLoader)
 	// parse extra headers
 	ParseXHdr_Data32(_fileHdr.xhChpClkOfs, _xHdrChipClk);
 	ParseXHdr_Data16(_fileHdr.xhChpVolOfs, _xHdrChipVol);
+	ScanDataBlocks();
 	
 	GenerateDeviceConfig();
 	
 	// parse tags
-	LoadTags();
+	if (_fileHdr.gd3Ofs && _fileHdr.gd3Ofs < _fileHdr.eofOfs)
+		LoadTags(&_fileData[_fileHdr.gd3Ofs], _fileHdr.eofOfs - _fileHdr.gd3Ofs);
+	else
+		LoadTags(NULL, 0);
 	
 	RefreshTSRates();	// make Tick2Sample etc. work
 	
 	return 0x00;
 }
 
+UINT8 VGMPlayer::ProbeFile(DATA_LOADER *dataLoader)
+{
+	_dLoad = NULL;
+	DataLoader_ReadUntil(dataLoader,0x38);
+	_fileData = DataLoader_GetData(dataLoader);
+	if (DataLoader_GetSize(dataLoader) < 0x38 || memcmp(&_fileData[0x00], "Vgm ", 4))
+		return 0xF0;	// invalid file
+	
+	// load only the main and extra headers, they end where the command data begins
+	UINT32 hdrEnd = (ReadLE32(&_fileData[0x08]) >= 0x150) ? ReadRelOfs(_fileData, 0x34) : 0x00;
+	if (hdrEnd < 0x40)
+		hdrEnd = 0x40;
+	
+	_dLoad = dataLoader;
+	_probeOnly = true;
+	DataLoader_ReadUntil(_dLoad, hdrEnd);
+	_fileData = DataLoader_GetData(_dLoad);
+	
+	ParseHeader();
+	ParseXHdr_Data32(_fileHdr.xhChpClkOfs, _xHdrChipClk);
+	ParseXHdr_Data16(_fileHdr.xhChpVolOfs, _xHdrChipVol);
+	
+	GenerateDeviceConfig();
+	
+	// fetch the GD3 tag directly from its offset
+	LoadTags(NULL, 0);
+	if (_fileHdr.gd3Ofs && _fileHdr.gd3Ofs < _fileHdr.eofOfs)
+	{
+		UINT8 gd3Hdr[0x0C];
+		UINT32 tagSize;
+		
+		if (DataLoader_ReadAt(_dLoad, _fileHdr.gd3Ofs, gd3Hdr, 0x0C) == 0x0C)
+		{
+			tagSize = 0x0C + ReadLE32(&gd3Hdr[0x08]);
+			if (tagSize < 0x0C || tagSize > _fileHdr.eofOfs - _fileHdr.gd3Ofs)
+				tagSize = _fileHdr.eofOfs - _fileHdr.gd3Ofs;
+			std::vector<UINT8> tagData(tagSize);
+			tagSize = DataLoader_ReadAt(_dLoad, _fileHdr.gd3Ofs, &tagData[0], tagSize);
+			LoadTags(&tagData[0], tagSize);
+		}
+	}
+	
+	RefreshTSRates();
+	
+	return 0x00;
+}
+
 UINT8 VGMPlayer::ParseHeader(void)
 {
 	memset(&_fileHdr, 0x00, sizeof(VGM_HEADER));
@@ -264,6 +331,8 @@ UINT8 VGMPlayer::ParseHeader(void)
 	
 	if (_hdrLenFile > _HDR_BUF_SIZE)
 		_hdrLenFile = _HDR_BUF_SIZE;
+	if (_hdrLenFile > DataLoader_GetSize(_dLoad))
+		_hdrLenFile = DataLoader_GetSize(_dLoad);
 	memset(_hdrBuffer, 0x00, _HDR_BUF_SIZE);
 	memcpy(_hdrBuffer, _fileData, _hdrLenFile);
 	
@@ -284,22 +353,26 @@ UINT8 VGMPlayer::ParseHeader(void)
 		_fileHdr.volumeGain = _hdrBuffer[0x7C] - 0x100;
 	_fileHdr.volumeGain <<= 3;	// 3.5 fixed point -> 8.8 fixed point
 	
-	if (_fileHdr.extraHdrOfs)
+	if (_fileHdr.extraHdrOfs && _fileHdr.extraHdrOfs + 0x04 <= DataLoader_GetSize(_dLoad))
 	{
 		UINT32 xhLen;
 		
 		xhLen = ReadLE32(&_fileData[_fileHdr.extraHdrOfs]);
+		if (xhLen > DataLoader_GetSize(_dLoad) - _fileHdr.extraHdrOfs)
+			xhLen = DataLoader_GetSize(_dLoad) - _fileHdr.extraHdrOfs;
 		if (xhLen >= 0x08)
 			_fileHdr.xhChpClkOfs = ReadRelOfs(_fileData, _fileHdr.extraHdrOfs + 0x04);
 		if (xhLen >= 0x0C)
 			_fileHdr.xhChpVolOfs = ReadRelOfs(_fileData, _fileHdr.extraHdrOfs + 0x08);
 	}
 	
-	if (! _fileHdr.eofOfs || _fileHdr.eofOfs > DataLoader_GetSize(_dLoad))
+	// when probing, only the header is loaded
+	UINT32 fileSize = _probeOnly ? DataLoader_GetTotalSize(_dLoad) : DataLoader_GetSize(_dLoad);
+	if (! _fileHdr.eofOfs || _fileHdr.eofOfs > fileSize)
 	{
 		fprintf(stderr, "Warning! Invalid EOF Offset 0x%06X! (should be: 0x%06X)\n",
-				_fileHdr.eofOfs, DataLoader_GetSize(_dLoad));
-		_fileHdr.eofOfs = DataLoader_GetSize(_dLoad);	// catch invalid EOF values
+				_fileHdr.eofOfs, fileSize);
+		_fileHdr.eofOfs = fileSize;	// catch invalid EOF values
 	}
 	_fileHdr.dataEnd = _fileHdr.eofOfs;
 	// command data ends at the GD3 offset if:
@@ -378,29 +451,87 @@ void VGMPlayer::ParseXHdr_Data16(UINT32 fileOfs, std::vector<XHDR_DATA16>& xData
 	return;
 }
 
-UINT8 VGMPlayer::LoadTags(void)
+void VGMPlayer::ScanDataBlocks(void)
+{
+	UINT32 filePos;
+	size_t curBank;
+	
+	// sum up the size of all PCM data blocks, so that each bank can be allocated only once
+	for (curBank = 0x00; curBank < _PCM_BANK_COUNT; curBank ++)
+	{
+		_pcmBank[curBank].fileSize = 0;
+		_pcmBank[curBank].fileBlocks = 0;
+	}
+	
+	filePos = _fileHdr.dataOfs;
+	while(filePos < _fileHdr.dataEnd)
+	{
+		const UINT8* cmdData = &_fileData[filePos];
+		UINT8 curCmd = cmdData[0x00];
+		UINT32 cmdLen;
+		
+		if (curCmd == 0x66)
+			break;
+		if (curCmd == 0x67)
+		{
+			if (filePos + 0x07 > _fileHdr.dataEnd)
+				break;
+			UINT8 dblkType = cmdData[0x02];
+			UINT32 dblkLen = ReadLE32(&cmdData[0x03]) & 0x7FFFFFFF;
+			cmdLen = 0x07 + dblkLen;
+			if (filePos + cmdLen > _fileHdr.dataEnd)
+				break;
+			if (dblkType < 0x80 && dblkType != 0x7F)
+			{
+				PCM_BANK* pcmBnk = &_pcmBank[dblkType & 0x3F];
+				UINT32 dataLen = dblkLen;
+				if (dblkType & 0x40)
+				{
+					PCM_CDB_INF dbCI;
+					if (ReadComprDataBlkHdr(dblkLen, &cmdData[0x07], &dbCI))
+						dataLen = 0;
+					else
+						dataLen = dbCI.decmpLen;
+				}
+				pcmBnk->fileSize += dataLen;
+				pcmBnk->fileBlocks ++;
+			}
+		}
+		else
+		{
+			cmdLen = _CMD_INFO[curCmd].cmdLen;
+			if (! cmdLen)
+				break;	// unknown command - playback stops here
+		}
+		filePos += cmdLen;
+	}
+	
+	return;
+}
+
+UINT8 VGMPlayer::LoadTags(const UINT8* tagData, UINT32 tagSize)
 {
 	for (size_t curTag = 0; curTag < _TAG_COUNT; curTag ++)
 		_tagData[curTag].clear();
 	_tagList[0] = NULL;
-	if (! _fileHdr.gd3Ofs)
+	if (tagData == NULL)
 		return 0x00;
 	
 	UINT32 curPos;
 	UINT32 eotPos;
 	
-	if (memcmp(&_fileData[_fileHdr.gd3Ofs + 0x00], "Gd3 ", 4))
+	if (tagSize < 0x0C || memcmp(&tagData[0x00], "Gd3 ", 4))
 		return 0xF0;	// bad tag
 	
-	_tagVer = ReadLE32(&_fileData[_fileHdr.gd3Ofs + 0x04]);
+	_tagVer = ReadLE32(&tagData[0x04]);
 	if (_tagVer < 0x100 || _tagVer >= 0x200)
 		return 0xF1;	// unsupported tag version
 	
-	eotPos = ReadLE32(&_fileData[_fileHdr.gd3Ofs + 0x08]);
-	curPos = _fileHdr.gd3Ofs + 0x0C;
+	eotPos = ReadLE32(&tagData[0x08]);
+	curPos = 0x0C;
 	eotPos += curPos;
-	if (eotPos > _fileHdr.eofOfs)
-		eotPos = _fileHdr.eofOfs;
+	if (eotPos > tagSize || eotPos < curPos)
+		eotPos = tagSize;
 	
 	const char **tagListEnd = _tagList;
 	for (size_t curTag = 0; curTag < _TAG_COUNT; curTag ++)
@@ -410,9 +541,11 @@ UINT8 VGMPlayer::LoadTags(void)
 			break;
 		
 		// search for UTF-16 L'\0' character
-		while(curPos < eotPos && ReadLE16(&_fileData[curPos]) != L'\0')
+		while(curPos + 0x01 < eotPos && ReadLE16(&tagData[curPos]) != L'\0')
 			curPos += 0x02;
-		_tagData[curTag] = GetUTF8String(&_fileData[startPos], &_fileData[curPos]);
+		if (curPos + 0x01 >= eotPos)
+			curPos = eotPos;	// unterminated string at the end of the tag
+		_tagData[curTag] = GetUTF8String(&tagData[startPos], &tagData[curPos]);
 		curPos += 0x02;	// skip '\0'
 		
 		*(tagListEnd++) = _TAG_TYPE_LIST[curTag];
@@ -448,6 +581,7 @@ UINT8 VGMPlayer::UnloadFile(void)
 	
 	_playState = 0x00;
 	_dLoad = NULL;
+	_probeOnly = false;
 	_fileData = NULL;
 	_fileHdr.fileVer = 0xFFFFFFFF;
 	_fileHdr.dataOfs = 0x00;
@@ -601,6 +735,7 @@ UINT8 VGMPlayer::SetDeviceOptions(UINT32 id, const PLR_DEV_OPTS& devOpts)
 	if (optID == (size_t)-1)
 		return 0x80;	// bad device ID
 	
+	LoopCache_Leave();
 	_devOpts[optID] = devOpts;
 	
 	size_t devID = _optDevMap[optID];
@@ -632,6 +767,7 @@ UINT8 VGMPlayer::SetDeviceMuting(UINT32 id, const PLR_MUTE_OPTS& muteOpts)
 	if (optID == (size_t)-1)
 		return 0x80;	// bad device ID
 	
+	LoopCache_Leave();
 	_devOpts[optID].muteOpts = muteOpts;
 	
 	size_t devID = _optDevMap[optID];
@@ -751,7 +887,11 @@ UINT32 VGMPlayer::GetLoopTicks(void) const
 
 UINT8 VGMPlayer::Start(void)
 {
+	if (_probeOnly)
+		return 0xFF;	// command data not loaded - LoadFile() is required
+	
 	InitDevices();
+	InitPlayStats(_devices.size(), 0x100);
 	
 	_playState |= PLAYSTATE_PLAY;
 	Reset();
@@ -767,6 +907,8 @@ UINT8 VGMPlayer::Stop(void)
 	size_t curBank;
 	
 	_playState &= ~PLAYSTATE_PLAY;
+	LoopCache_Clear();
+	std::vector<WAVE_32BS>().swap(_lcData);	// free the memory
 	
 	for (curDev = 0; curDev < _dacStreams.size(); curDev ++)
 	{
@@ -781,13 +923,21 @@ UINT8 VGMPlayer::Stop(void)
 		pcmBnk->bankOfs.clear();
 		pcmBnk->bankSize.clear();
 		pcmBnk->data.clear();
+		pcmBnk->ptr = NULL;
+		pcmBnk->size = 0;
 	}
 	free(_pcmComprTbl.values.d8);	_pcmComprTbl.values.d8 = NULL;
 	
 	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		if (_devices[curDev].shadow != NULL)
+			RegShadow_Deinit(_devices[curDev].shadow);
 		FreeDeviceTree(&_devices[curDev].base, 0);
+	}
 	_devices.clear();
 	_devCfgs.clear();
+	if (_memArena != NULL)
+		MemArena_Reset(_memArena);
 	if (_eventCbFunc != NULL)
 		_eventCbFunc(this, _eventCbParam, PLREVT_STOP, NULL);
 	
@@ -809,6 +959,7 @@ UINT8 VGMPlayer::Reset(void)
 	_psTrigger = 0x00;
 	_curLoop = 0;
 	_lastLoopTick = 0;
+	LoopCache_Clear();
 	
 	RefreshTSRates();
 	
@@ -829,6 +980,8 @@ UINT8 VGMPlayer::Reset(void)
 		pcmBnk->bankOfs.clear();
 		pcmBnk->bankSize.clear();
 		pcmBnk->data.clear();
+		pcmBnk->ptr = NULL;
+		pcmBnk->size = 0;
 	}
 	free(_pcmComprTbl.values.d8);	_pcmComprTbl.values.d8 = NULL;
 	memset(&_pcmComprTbl, 0x00, sizeof(PCM_COMPR_TBL));
@@ -1124,7 +1277,7 @@ void VGMPlayer::GenerateDeviceConfig(void)
 				SaveDeviceConfig(sdCfg.cfgData, &devCfg, sizeof(DEV_GEN_CFG));
 				break;
 			case DEVID_ES5506:
-				devCfg.flags = _hdrBuffer[0xD5];	// output channels
+				devCfg.flags |= _hdrBuffer[0xD5] << 1;	// chip type (from clock bit 31) + output channels
 				SaveDeviceConfig(sdCfg.cfgData, &devCfg, sizeof(DEV_GEN_CFG));
 				break;
 			case DEVID_SCSP:
@@ -1190,6 +1343,7 @@ void VGMPlayer::InitDevices(void)
 		devOpts = (chipDev.optID != (size_t)-1) ? &_devOpts[chipDev.optID] : NULL;
 		devCfg->emuCore = (devOpts != NULL) ? devOpts->emuCore[0] : 0x00;
 		devCfg->srMode = (devOpts != NULL) ? devOpts->srMode : DEVRI_SRMODE_NATIVE;
+		devCfg->memArena = _memArena;
 		if (devOpts != NULL && devOpts->smplRate)
 			devCfg->smplRate = devOpts->smplRate;
 		else
@@ -1314,6 +1468,7 @@ void VGMPlayer::InitDevices(void)
 				break;
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, (void**)&chipDev.write8);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D16, 0, (void**)&chipDev.writeD16);
+			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, (void**)&chipDev.romSize);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, (void**)&chipDev.romWrite);
 			break;
 		case DEVID_SCSP:
@@ -1337,6 +1492,7 @@ void VGMPlayer::InitDevices(void)
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, (void**)&chipDev.romWrite);
 			break;
 		}
+		devCfg->memArena = NULL;	// the stored configuration must not refer to the arena
 		if (retVal)
 		{
 			devInf->dataPtr = NULL;
@@ -1388,6 +1544,7 @@ void VGMPlayer::InitDevices(void)
 			UINT16 chipVol = GetChipVolume(chipDev.vgmChipType, chipDev.chipID, linkCntr);
 			
 			Resmpl_SetVals(&clDev->resmpl, 0xFF, chipVol, _outSmplRate);
+			clDev->resmpl.memArena = _memArena;
 			Resmpl_DevConnect(&clDev->resmpl, &clDev->defInf);
 			Resmpl_Init(&clDev->resmpl);
 		}
@@ -1497,25 +1654,34 @@ void VGMPlayer::LoadOPL4ROM(CHIP_DEVICE* chipDev)
 
 UINT8 VGMPlayer::Seek(UINT8 unit, UINT32 pos)
 {
+	LoopCache_Leave();
 	switch(unit)
 	{
 	case PLAYPOS_FILEOFS:
 		_playState |= PLAYSTATE_SEEK;
+		InitRegShadows();
 		if (pos < _filePos)
 			Reset();
-		return SeekToFilePos(pos);
+		SeekToFilePos(pos);
+		break;
 	case PLAYPOS_SAMPLE:
 		pos = Sample2Tick(pos);
 		// fall through
 	case PLAYPOS_TICK:
 		_playState |= PLAYSTATE_SEEK;
+		InitRegShadows();
 		if (pos < _playTick)
 			Reset();
-		return SeekToTick(pos);
+		SeekToTick(pos);
+		break;
 	case PLAYPOS_COMMAND:
 	default:
 		return 0xFF;
 	}
+	FlushRegShadows();
+	LoopCache_Clear();	// the cache requires continuous playback
+	
+	return 0x00;
 }
 
 UINT8 VGMPlayer::SeekToTick(UINT32 tick)
@@ -1535,6 +1701,9 @@ UINT8 VGMPlayer::SeekToFilePos(UINT32 pos)
 	{
 		UINT8 curCmd = _fileData[_filePos];
 		COMMAND_FUNC func = _CMD_INFO[curCmd].func;
+#ifdef PLAYER_PROFILING
+		_playStats.cmdCount[curCmd] ++;
+#endif
 		(this->*func)();
 		_filePos += _CMD_INFO[curCmd].cmdLen;
 	}
@@ -1554,6 +1723,41 @@ UINT8 VGMPlayer::SeekToFilePos(UINT32 pos)
 	return 0x00;
 }
 
+void VGMPlayer::InitRegShadows(void)
+{
+	size_t curDev;
+	
+	if (_seekMode != PLRSEEK_FAST)
+		return;
+	
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		CHIP_DEVICE* cDev = &_devices[curDev];
+		if (cDev->base.defInf.dataPtr == NULL || cDev->shadow != NULL)
+			continue;
+		RegShadow_Init(&cDev->shadow, cDev->chipType, &cDev->base.defInf, cDev->write8);
+	}
+	
+	return;
+}
+
+void VGMPlayer::FlushRegShadows(void)
+{
+	size_t curDev;
+	
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		CHIP_DEVICE* cDev = &_devices[curDev];
+		if (cDev->shadow == NULL)
+			continue;
+		RegShadow_Flush(cDev->shadow);
+		RegShadow_Deinit(cDev->shadow);
+		cDev->shadow = NULL;
+	}
+	
+	return;
+}
+
 UINT32 VGMPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 {
 	UINT32 curSmpl;
@@ -1561,13 +1765,36 @@ UINT32 VGMPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 	UINT32 maxSmpl;
 	INT32 smplStep;	// might be negative due to rounding errors in Tick2Sample
 	size_t curDev;
+	size_t cacheOfs = 0;
+#ifdef PLAYER_PROFILING
+	UINT64 renderStart = OSTimer_GetTime();
+	UINT64 devStart;
+#endif
 	
 	// Note: use do {} while(), so that "smplCnt == 0" can be used to process until reaching the next sample.
 	curSmpl = 0;
 	do
 	{
+		if (_lcState == _LCSTATE_REPLAY)
+		{
+			curSmpl += LoopCache_Render(smplCnt - curSmpl, &data[curSmpl]);
+			if (_lcState == _LCSTATE_REPLAY)
+				break;
+			// The cache was left (playback stopped at a loop point), so the remaining samples are emulated.
+		}
+		
 		smplFileTick = Sample2Tick(_playSmpl);
 		ParseFile(smplFileTick - _playTick);
+		while(_lcCheck)
+		{
+			// ParseFile stopped at the loop point
+			LoopCache_Check();
+			if (_lcState == _LCSTATE_REPLAY)
+				break;
+			ParseFile(0);
+		}
+		if (_lcState == _LCSTATE_REPLAY)
+			continue;	// the state was seen before, replay the samples from the cache
 		
 		// render as many samples at once as possible (for better performance)
 		maxSmpl = Tick2Sample(_fileTick);
@@ -1578,23 +1805,56 @@ UINT32 VGMPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 		if ((UINT32)smplStep > smplCnt - curSmpl)
 			smplStep = smplCnt - curSmpl;
 		
+		if (_lcState == _LCSTATE_RECORD && ! _lcPoints.empty())
+		{
+			if (_lcData.size() + smplStep > _lcMaxSmpls)
+			{
+				// The repeated section is too long. Give up until the next Reset/Seek.
+				LoopCache_Clear();
+				_lcState = _LCSTATE_OFF;
+			}
+			else
+			{
+				// keep the current buffer contents, so that only the rendered samples are stored
+				cacheOfs = _lcData.size();
+				_lcData.insert(_lcData.end(), &data[curSmpl], &data[curSmpl + smplStep]);
+			}
+		}
 		for (curDev = 0; curDev < _devices.size(); curDev ++)
 		{
 			CHIP_DEVICE* cDev = &_devices[curDev];
 			UINT8 disable = (cDev->optID != (size_t)-1) ? _devOpts[cDev->optID].muteOpts.disable : 0x00;
 			VGM_BASEDEV* clDev;
 			
+#ifdef PLAYER_PROFILING
+			devStart = OSTimer_GetTime();
+#endif
 			for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev, disable >>= 1)
 			{
 				if (clDev->defInf.dataPtr != NULL && ! (disable & 0x01))
 					Resmpl_Execute(&clDev->resmpl, smplStep, &data[curSmpl]);
 			}
+#ifdef PLAYER_PROFILING
+			_playStats.devStats[curDev].renderTime += OSTimer_GetTime() - devStart;
+			_playStats.devStats[curDev].smplCount += smplStep;
+#endif
 		}
 		for (curDev = 0; curDev < _dacStreams.size(); curDev ++)
 		{
 			DEV_INFO* dacDInf = &_dacStreams[curDev].defInf;
 			dacDInf->devDef->Update(dacDInf->dataPtr, smplStep, NULL);
 		}
+		if (_lcState == _LCSTATE_RECORD && ! _lcPoints.empty())
+		{
+			WAVE_32BS* cacheSmpl = &_lcData[cacheOfs];
+			INT32 curCSmpl;
+			
+			for (curCSmpl = 0; curCSmpl < smplStep; curCSmpl ++)
+			{
+				cacheSmpl[curCSmpl].L = data[curSmpl + curCSmpl].L - cacheSmpl[curCSmpl].L;
+				cacheSmpl[curCSmpl].R = data[curSmpl + curCSmpl].R - cacheSmpl[curCSmpl].R;
+			}
+		}
 		
 		curSmpl += smplStep;
 		_playSmpl += smplStep;
@@ -1605,6 +1865,10 @@ UINT32 VGMPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 		}
 	} while(curSmpl < smplCnt);
 	
+#ifdef PLAYER_PROFILING
+	_playStats.renderTime += OSTimer_GetTime() - renderStart;
+	_playStats.smplCount += curSmpl;
+#endif
 	return curSmpl;
 }
 
@@ -1614,10 +1878,13 @@ void VGMPlayer::ParseFile(UINT32 ticks)
 	if (_playState & PLAYSTATE_END)
 		return;
 	
-	while(_filePos < _fileHdr.dataEnd && _fileTick <= _playTick && ! (_playState & PLAYSTATE_END))
+	while(_filePos < _fileHdr.dataEnd && _fileTick <= _playTick && ! (_playState & PLAYSTATE_END) && ! _lcCheck)
 	{
 		UINT8 curCmd = _fileData[_filePos];
 		COMMAND_FUNC func = _CMD_INFO[curCmd].func;
+#ifdef PLAYER_PROFILING
+		_playStats.cmdCount[curCmd] ++;
+#endif
 		(this->*func)();
 		_filePos += _CMD_INFO[curCmd].cmdLen;
 	}
@@ -1635,3 +1902,248 @@ void VGMPlayer::ParseFile(UINT32 ticks)
 	
 	return;
 }
+
+UINT8 VGMPlayer::SetLoopCache(UINT32 maxSmpls)
+{
+	LoopCache_Leave();
+	_lcMaxSmpls = maxSmpls;
+	if (_playState & PLAYSTATE_PLAY)
+		LoopCache_Clear();	// else done by Start()
+	
+	return 0x00;
+}
+
+UINT8 VGMPlayer::HashPlayState(UINT64* hash) const
+{
+	UINT64 h = EMU_HASH_INIT;
+	UINT64 smplFrac;
+	UINT32 tickOfs;
+	size_t curDev;
+	size_t curBank;
+	UINT8 chipID;
+	
+	// The positions are hashed relative to the current sample, so only the file offset has to match.
+	smplFrac = _playSmpl * _tsDiv % _tsMult;	// fraction of the tick at the current sample
+	tickOfs = _playTick - _fileTick;
+	h = EmuHash_Data(h, &_filePos, sizeof(_filePos));
+	h = EmuHash_Data(h, &smplFrac, sizeof(smplFrac));
+	h = EmuHash_Data(h, &tickOfs, sizeof(tickOfs));
+	
+	for (curBank = 0x00; curBank < _PCM_BANK_COUNT; curBank ++)
+	{
+		UINT32 bankSize = _pcmBank[curBank].size;
+		h = EmuHash_Data(h, &bankSize, sizeof(bankSize));
+	}
+	h = EmuHash_Data(h, &_ym2612pcm_bnkPos, sizeof(_ym2612pcm_bnkPos));
+	h = EmuHash_Data(h, _rf5cBank, sizeof(_rf5cBank));
+	for (chipID = 0; chipID < 2; chipID ++)
+	{
+		h = EmuHash_Data(h, _qsWork[chipID].startAddrCache, sizeof(_qsWork[0].startAddrCache));
+		h = EmuHash_Data(h, _qsWork[chipID].pitchCache, sizeof(_qsWork[0].pitchCache));
+	}
+	
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		const CHIP_DEVICE* cDev = &_devices[curDev];
+		UINT8 disable = (cDev->optID != (size_t)-1) ? _devOpts[cDev->optID].muteOpts.disable : 0x00;
+		const VGM_BASEDEV* clDev;
+		
+		h = EmuHash_Data(h, &disable, sizeof(disable));
+		for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev)
+		{
+			DEVFUNC_READ_STATEHASH funcHash = NULL;
+			UINT8 retVal;
+			
+			if (clDev->defInf.dataPtr == NULL)
+				continue;
+			retVal = SndEmu_GetDeviceFunc(clDev->defInf.devDef, RWF_STATE | RWF_READ, DEVRW_ALL, 0, (void**)&funcHash);
+			if (retVal == EERR_NOT_FOUND || funcHash == NULL)
+				return 0x80;
+			retVal = funcHash(clDev->defInf.dataPtr, &h);
+			if (retVal)
+				return 0x80;
+			Resmpl_HashState(&clDev->resmpl, &h);
+		}
+	}
+	
+	for (curDev = 0; curDev < _dacStreams.size(); curDev ++)
+	{
+		const DACSTRM_DEV* dacStrm = &_dacStreams[curDev];
+		h = EmuHash_Data(h, &dacStrm->streamID, sizeof(dacStrm->streamID));
+		h = EmuHash_Data(h, &dacStrm->bankID, sizeof(dacStrm->bankID));
+		daccontrol_hash_state(dacStrm->defInf.dataPtr, &h);
+	}
+	
+	*hash = h;
+	return 0x00;
+}
+
+void VGMPlayer::LoopCache_Clear(void)
+{
+	_lcData.clear();
+	_lcPoints.clear();
+	_lcCheck = 0;
+	_lcState = _lcMaxSmpls ? _LCSTATE_RECORD : _LCSTATE_OFF;
+	
+	return;
+}
+
+void VGMPlayer::LoopCache_Check(void)
+{
+	LOOPCACHE_POINT lcPt;
+	size_t curPt;
+	
+	_lcCheck = 0;
+	if (_lcState != _LCSTATE_RECORD)
+		return;
+	
+	if (HashPlayState(&lcPt.hash))
+	{
+		// not all devices support state hashing
+		LoopCache_Clear();
+		_lcState = _LCSTATE_OFF;
+		return;
+	}
+	lcPt.cacheOfs = (UINT32)_lcData.size();
+	lcPt.filePos = _filePos;
+	lcPt.fileTick = _fileTick;
+	lcPt.playTick = _playTick;
+	lcPt.playSmpl = _playSmpl;
+	lcPt.curLoop = _curLoop;
+	lcPt.lastLoopTick = _lastLoopTick;
+	
+	for (curPt = 0; curPt < _lcPoints.size(); curPt ++)
+	{
+		if (_lcPoints[curPt].hash == lcPt.hash && _lcPoints[curPt].cacheOfs < lcPt.cacheOfs)
+			break;
+	}
+	if (curPt >= _lcPoints.size())
+	{
+		_lcPoints.push_back(lcPt);
+		return;
+	}
+	
+	// The state equals the one at an earlier loop point, so everything from there on repeats.
+	// The emulation stays at this point while the section is replayed.
+	_lcEmuPt = lcPt;
+	_lcLoopPt = curPt;
+	_lcNextPt = curPt + 1;
+	_lcEndOfs = lcPt.cacheOfs;
+	_lcPos = _lcPoints[curPt].cacheOfs;
+	_lcState = _LCSTATE_REPLAY;
+	
+	return;
+}
+
+void VGMPlayer::LoopCache_Leave(void)
+{
+	const LOOPCACHE_POINT* lpStart;
+	UINT32 perSmpls;
+	UINT32 perTicks;
+	UINT32 perLoops;
+	UINT32 periods;
+	UINT32 dstSmpl;
+	
+	if (_lcState != _LCSTATE_REPLAY)
+		return;
+	
+	// The emulation state is the same at the end of each repetition, so move the emulation to
+	// the last repetition before the current position and emulate the rest.
+	lpStart = &_lcPoints[_lcLoopPt];
+	perSmpls = _lcEmuPt.playSmpl - lpStart->playSmpl;
+	perTicks = _lcEmuPt.playTick - lpStart->playTick;
+	perLoops = _lcEmuPt.curLoop - lpStart->curLoop;
+	periods = (_playSmpl - _lcEmuPt.playSmpl) / perSmpls;
+	dstSmpl = _playSmpl;
+	
+	_filePos = _lcEmuPt.filePos;
+	_fileTick = _lcEmuPt.fileTick + periods * perTicks;
+	_playTick = _lcEmuPt.playTick + periods * perTicks;
+	_playSmpl = _lcEmuPt.playSmpl + periods * perSmpls;
+	_curLoop = _lcEmuPt.curLoop + periods * perLoops;
+	_lastLoopTick = _lcEmuPt.lastLoopTick + periods * perTicks;
+	LoopCache_Clear();
+	
+	if (_playSmpl < dstSmpl)
+	{
+		std::vector<WAVE_32BS> smplBuf(0x400);
+		PLAYER_EVENT_CB cbFunc = _eventCbFunc;
+		
+		// the loop events were already sent while replaying
+		_eventCbFunc = NULL;
+		_lcState = _LCSTATE_OFF;
+		while(_playSmpl < dstSmpl)
+		{
+			UINT32 smplCnt = dstSmpl - _playSmpl;
+			if (smplCnt > smplBuf.size())
+				smplCnt = (UINT32)smplBuf.size();
+			Render(smplCnt, &smplBuf[0]);
+		}
+		_eventCbFunc = cbFunc;
+		LoopCache_Clear();
+	}
+	
+	return;
+}
+
+UINT32 VGMPlayer::LoopCache_Render(UINT32 smplCnt, WAVE_32BS* data)
+{
+	UINT32 curSmpl;
+	UINT32 evtOfs;
+	UINT32 smplStep;
+	UINT32 curCSmpl;
+	const WAVE_32BS* cacheSmpl;
+	
+	curSmpl = 0;
+	while(curSmpl < smplCnt)
+	{
+		evtOfs = (_lcNextPt < _lcPoints.size()) ? _lcPoints[_lcNextPt].cacheOfs : _lcEndOfs;
+		if (_lcPos == evtOfs)
+		{
+			// reached the next loop point
+			if (_lcNextPt < _lcPoints.size())
+			{
+				_lcNextPt ++;
+			}
+			else
+			{
+				_lcPos = _lcPoints[_lcLoopPt].cacheOfs;
+				_lcNextPt = _lcLoopPt + 1;
+			}
+			_curLoop ++;
+			if (_eventCbFunc != NULL)
+			{
+				UINT8 retVal = _eventCbFunc(this, _eventCbParam, PLREVT_LOOP, &_curLoop);
+				if (retVal == 0x01)	// "stop" signal?
+				{
+					// the sound chips keep playing after the end, so continue with emulation
+					UINT32 curLoop = _curLoop;
+					LoopCache_Leave();
+					_curLoop = curLoop;
+					_playState |= PLAYSTATE_END;
+					_psTrigger |= PLAYSTATE_END;
+					if (_eventCbFunc != NULL)
+						_eventCbFunc(this, _eventCbParam, PLREVT_END, NULL);
+					break;
+				}
+			}
+			continue;
+		}
+		
+		smplStep = evtOfs - _lcPos;
+		if (smplStep > smplCnt - curSmpl)
+			smplStep = smplCnt - curSmpl;
+		cacheSmpl = &_lcData[_lcPos];
+		for (curCSmpl = 0; curCSmpl < smplStep; curCSmpl ++)
+		{
+			data[curSmpl + curCSmpl].L += cacheSmpl[curCSmpl].L;
+			data[curSmpl + curCSmpl].R += cacheSmpl[curCSmpl].R;
+		}
+		_lcPos += smplStep;
+		curSmpl += smplStep;
+		_playSmpl += smplStep;
+	}
+	_playTick = Sample2Tick(_playSmpl);	// Note: The file offset isn't updated while replaying.
+	
+	return curSmpl;
+}
@@ -6,6 +6,7 @@
 #include "../emu/Resampler.h"
 #include "../utils/StrUtils.h"
 #include "helper.h"
+#include "regshadow.h"
 #include "playerbase.hpp"
 #include "../utils/DataLoader.h"
 #include "dblk_compr.h"
@@ -49,6 +50,7 @@ struct VGM_PLAY_OPTIONS
 
 class VGMPlayer : public PlayerBase
 {
+	friend class VGMOptimizer;	// uses the command table and header information
 public:
 	struct CHIP_DEVICE	// Note: has to be a POD, because I use memset() on it.
 	{
@@ -66,6 +68,7 @@ public:
 		DEVFUNC_WRITE_BLOCK romWrite;
 		DEVFUNC_WRITE_MEMSIZE romSizeB;
 		DEVFUNC_WRITE_BLOCK romWriteB;
+		REG_SHADOW* shadow;	// only used while seeking
 	};
 	
 protected:
@@ -105,6 +108,10 @@ protected:
 	struct PCM_BANK
 	{
 		std::vector<UINT8> data;
+		const UINT8* ptr;	// bank data, points to "data" or directly into the file data
+		UINT32 size;
+		UINT32 fileSize;	// total size of all data blocks for this bank (set by ScanDataBlocks)
+		UINT32 fileBlocks;	// number of data blocks for this bank
 		std::vector<UINT32> bankOfs;
 		std::vector<UINT32> bankSize;
 	};
@@ -130,6 +137,18 @@ protected:
 		UINT16 pitchCache[16];		// QSound register 0x02
 	};
 	
+	struct LOOPCACHE_POINT	// playback state at the start of a loop
+	{
+		UINT64 hash;		// hash of player and device state
+		UINT32 cacheOfs;	// offset into cached samples
+		UINT32 filePos;
+		UINT32 fileTick;
+		UINT32 playTick;
+		UINT32 playSmpl;
+		UINT32 curLoop;
+		UINT32 lastLoopTick;
+	};
+	
 public:
 	VGMPlayer();
 	~VGMPlayer();
@@ -139,6 +158,7 @@ public:
 	static UINT8 PlayerCanLoadFile(DATA_LOADER *dataLoader);
 	UINT8 CanLoadFile(DATA_LOADER *dataLoader) const;
 	UINT8 LoadFile(DATA_LOADER *dataLoader);
+	UINT8 ProbeFile(DATA_LOADER *dataLoader);
 	UINT8 UnloadFile(void);
 	const VGM_HEADER* GetFileHeader(void) const;
 	
@@ -176,12 +196,15 @@ public:
 	UINT8 Seek(UINT8 unit, UINT32 pos);
 	UINT32 Render(UINT32 smplCnt, WAVE_32BS* data);
 	
+	UINT8 SetLoopCache(UINT32 maxSmpls);
+	
 protected:
 	UINT8 ParseHeader(void);
 	void ParseXHdr_Data32(UINT32 fileOfs, std::vector<XHDR_DATA32>& xData);
 	void ParseXHdr_Data16(UINT32 fileOfs, std::vector<XHDR_DATA16>& xData);
+	void ScanDataBlocks(void);
 	
-	UINT8 LoadTags(void);
+	UINT8 LoadTags(const UINT8* tagData, UINT32 tagSize);
 	std::string GetUTF8String(const UINT8* startPtr, const UINT8* endPtr);
 	
 	size_t DeviceID2OptionID(UINT32 id) const;
@@ -205,8 +228,16 @@ protected:
 	
 	UINT8 SeekToTick(UINT32 tick);
 	UINT8 SeekToFilePos(UINT32 pos);
+	void InitRegShadows(void);
+	void FlushRegShadows(void);
 	void ParseFile(UINT32 ticks);
 	
+	UINT8 HashPlayState(UINT64* hash) const;	// returns 0x80 if a device doesn't support state hashing
+	void LoopCache_Clear(void);
+	void LoopCache_Check(void);
+	void LoopCache_Leave(void);
+	UINT32 LoopCache_Render(UINT32 smplCnt, WAVE_32BS* data);
+	
 	// --- VGM command functions ---
 	void Cmd_invalid(void);
 	void Cmd_unknown(void);
@@ -255,8 +286,15 @@ protected:
 	CPCONV* _cpcUTF16;	// UTF-16 LE -> UTF-8 codepage conversion
 	DATA_LOADER *_dLoad;
 	const UINT8* _fileData;	// data pointer for quick access, equals _dLoad->GetFileData().data()
+	bool _probeOnly;	// only header and tags were loaded by ProbeFile()
 	std::vector<UINT8> _yrwRom;	// cache for OPL4 sample ROM (yrw801.rom)
 	
+	enum
+	{
+		_LCSTATE_OFF = 0x00,	// loop cache disabled/not possible for the current playback
+		_LCSTATE_RECORD = 0x01,	// storing rendered samples and loop points
+		_LCSTATE_REPLAY = 0x02	// playing the repeated section from the cache
+	};
 	enum
 	{
 		_HDR_BUF_SIZE = 0x100,
@@ -308,6 +346,18 @@ protected:
 	
 	UINT8 _playState;
 	UINT8 _psTrigger;	// used to temporarily trigger special commands
+	
+	// loop output cache
+	UINT32 _lcMaxSmpls;	// maximum number of cached samples, 0 = disabled
+	UINT8 _lcState;		// _LCSTATE_ constant
+	UINT8 _lcCheck;		// set at the loop point, makes ParseFile stop so that the state can be checked
+	std::vector<WAVE_32BS> _lcData;	// rendered samples, starting at the first loop point
+	std::vector<LOOPCACHE_POINT> _lcPoints;
+	size_t _lcLoopPt;	// replay: first point of the repeated section
+	size_t _lcNextPt;	// replay: next point to be passed
+	UINT32 _lcEndOfs;	// replay: end of the repeated section in _lcData
+	UINT32 _lcPos;		// replay: current offset into _lcData
+	LOOPCACHE_POINT _lcEmuPt;	// replay: state of the emulation (frozen at the end of the repeated section)
 	//PLAYER_EVENT_CB _eventCbFunc;
 	//void* _eventCbParam;
 	//PLAYER_FILEREQ_CB _fileReqCbFunc;
@@ -15,6 +15,11 @@
 #include "helper.h"
 
 #define fData	(&_fileData[_filePos])	// used by command handlers for better readability
+#ifdef PLAYER_PROFILING
+#define COUNT_REG_WRITE(cDev)	_playStats.devStats[(cDev) - &_devices[0]].regWrites ++
+#else
+#define COUNT_REG_WRITE(cDev)
+#endif
 
 /*static*/ const VGMPlayer::COMMAND_INFO VGMPlayer::_CMD_INFO[0x100] =
 {
@@ -579,6 +584,8 @@ void VGMPlayer::Cmd_EndOfData(void)
 			}
 		}
 		_filePos = _fileHdr.loopOfs;
+		if (_lcState == _LCSTATE_RECORD && ! (_playState & PLAYSTATE_SEEK))
+			_lcCheck = 1;	// stop parsing, so that the loop cache can check the state
 		return;
 	}
 	
@@ -631,6 +638,11 @@ void VGMPlayer::Cmd_DelaySamplesN1(void)
 
 INLINE void SendYMCommand(VGMPlayer::CHIP_DEVICE* cDev, UINT8 port, UINT8 reg, UINT8 data)
 {
+	if (cDev->shadow != NULL)
+	{
+		RegShadow_Write(cDev->shadow, port, reg, data);
+		return;
+	}
 	cDev->write8(cDev->base.defInf.dataPtr, (port << 1) | 0, reg);
 	cDev->write8(cDev->base.defInf.dataPtr, (port << 1) | 1, data);
 	return;
@@ -703,9 +715,10 @@ void VGMPlayer::Cmd_DataBlock(void)
 		}
 		else
 		{
-			PCM_BANK* pcmBnk = &_pcmBank[dblkType & 0x3F];
+			UINT8 bankID = dblkType & 0x3F;
+			PCM_BANK* pcmBnk = &_pcmBank[bankID];
 			PCM_CDB_INF dbCI;
-			UINT32 oldLen = (UINT32)pcmBnk->data.size();
+			UINT32 oldLen = pcmBnk->size;
 			dataLen = dblkLen;
 			dataPtr = &fData[0x00];
 			
@@ -719,18 +732,41 @@ void VGMPlayer::Cmd_DataBlock(void)
 			pcmBnk->bankOfs.push_back(oldLen);
 			pcmBnk->bankSize.push_back(dataLen);
 			
-			pcmBnk->data.resize(oldLen + dataLen);
-			if (dblkType & 0x40)
+			if (! (dblkType & 0x40) && ! oldLen && pcmBnk->fileBlocks == 1)
 			{
-				DecompressDataBlk(dataLen, &pcmBnk->data[oldLen],
-									dblkLen - dbCI.hdrSize, &dataPtr[dbCI.hdrSize], &dbCI.cmprInfo);
+				// The bank consists of this block only, so the data can be used directly from the file.
+				pcmBnk->ptr = dataPtr;
+				pcmBnk->size = dataLen;
 			}
 			else
 			{
-				memcpy(&pcmBnk->data[oldLen], dataPtr, dataLen);
+				if (pcmBnk->data.size() != oldLen)
+					pcmBnk->data.assign(pcmBnk->ptr, pcmBnk->ptr + oldLen);	// was referencing the file data
+				pcmBnk->data.reserve(pcmBnk->fileSize);	// allocate the whole bank at once
+				pcmBnk->data.resize(oldLen + dataLen);
+				if (dblkType & 0x40)
+				{
+					DecompressDataBlk(dataLen, &pcmBnk->data[oldLen],
+										dblkLen - dbCI.hdrSize, &dataPtr[dbCI.hdrSize], &dbCI.cmprInfo);
+				}
+				else
+				{
+					memcpy(&pcmBnk->data[oldLen], dataPtr, dataLen);
+				}
+				pcmBnk->ptr = pcmBnk->data.empty() ? NULL : &pcmBnk->data[0];
+				pcmBnk->size = (UINT32)pcmBnk->data.size();
 			}
 			
-			// TODO: refresh DAC Stream pointers (call daccontrol_refresh_data)
+			// the data may have moved and the size has changed
+			for (size_t curStrm = 0; curStrm < _dacStreams.size(); curStrm ++)
+			{
+				DACSTRM_DEV* dacStrm = &_dacStreams[curStrm];
+				if (dacStrm->bankID == bankID)
+					daccontrol_refresh_data(dacStrm->defInf.dataPtr, (UINT8*)pcmBnk->ptr, pcmBnk->size);
+			}
+#ifdef PLAYER_PROFILING
+			_playStats.dataBlkBytes += dataLen;
+#endif
 		}
 		break;
 	case 0x80:	// ROM/RAM write
@@ -759,6 +795,9 @@ void VGMPlayer::Cmd_DataBlock(void)
 		{
 			WriteChipROM(cDev, _VGM_ROM_CHIPS[dblkType & 0x3F][1], memSize, dataOfs, dataLen, dataPtr);
 		}
+#ifdef PLAYER_PROFILING
+		_playStats.devStats[cDev - &_devices[0]].dataBytes += dataLen;
+#endif
 		break;
 	case 0xC0:	// RAM Write
 		chipType = _VGM_RAM_CHIPS[dblkType & 0x3F];
@@ -782,6 +821,9 @@ void VGMPlayer::Cmd_DataBlock(void)
 		}
 		DoRAMOfsPatches(chipType, chipID, dataOfs, dataLen);
 		cDev->romWrite(cDev->base.defInf.dataPtr, dataOfs, dataLen, dataPtr);
+#ifdef PLAYER_PROFILING
+		_playStats.devStats[cDev - &_devices[0]].dataBytes += dataLen;
+#endif
 		break;
 	}
 	
@@ -804,20 +846,23 @@ void VGMPlayer::Cmd_PcmRamWrite(void)
 	UINT32 dbPos = ReadLE24(&fData[0x03]);
 	UINT32 wrtAddr = ReadLE24(&fData[0x06]);
 	UINT32 dataLen = ReadLE24(&fData[0x09]);
-	if (dbPos >= _pcmBank[dbType].data.size())
+	if (dbPos >= _pcmBank[dbType].size)
 		return;
-	const UINT8* ROMData = &_pcmBank[dbType].data[dbPos];
+	const UINT8* ROMData = &_pcmBank[dbType].ptr[dbPos];
 	if (! dataLen)
 		dataLen += 0x01000000;
 	
 	if (chipType == 0x14)	// NES APU
 	{
 		//Last95Drum = dbPos / dataLen - 1;
-		//Last95Max = _pcmBank[dbType].data.size() / dataLen;
+		//Last95Max = _pcmBank[dbType].size / dataLen;
 	}
 	
 	DoRAMOfsPatches(chipType, chipID, wrtAddr, dataLen);
 	cDev->romWrite(cDev->base.defInf.dataPtr, wrtAddr, dataLen, ROMData);
+#ifdef PLAYER_PROFILING
+	_playStats.devStats[cDev - &_devices[0]].dataBytes += dataLen;
+#endif
 	
 	return;
 }
@@ -829,10 +874,11 @@ void VGMPlayer::Cmd_YM2612PCM_Delay(void)
 	
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
-	if (_ym2612pcm_bnkPos >= _pcmBank[0].data.size())
+	if (_ym2612pcm_bnkPos >= _pcmBank[0].size)
 		return;
 	
-	UINT8 data = _pcmBank[0].data[_ym2612pcm_bnkPos];
+	UINT8 data = _pcmBank[0].ptr[_ym2612pcm_bnkPos];
+	COUNT_REG_WRITE(cDev);
 	SendYMCommand(cDev, 0x00, 0x2A, data);
 	_ym2612pcm_bnkPos ++;
 	// TODO: clip when exceeding pcmBank size
@@ -862,6 +908,7 @@ void VGMPlayer::Cmd_DACCtrl_Setup(void)	// DAC Stream Control: Setup Chip
 		devCfg.srMode = DEVRI_SRMODE_NATIVE;
 		devCfg.flags = 0x00;
 		devCfg.clock = 0;
+		devCfg.memArena = NULL;	// streams are recreated on every Reset(), keep them on the heap
 		devCfg.smplRate = _outSmplRate;
 		retVal = device_start_daccontrol(&devCfg, &dacStrm.defInf);
 		if (retVal)
@@ -900,7 +947,7 @@ void VGMPlayer::Cmd_DACCtrl_SetData(void)	// DAC Stream Control: Set Data Bank
 		return;
 	PCM_BANK* pcmBnk = &_pcmBank[dacStrm->bankID];
 	
-	daccontrol_set_data(dacStrm->defInf.dataPtr, &pcmBnk->data[0], (UINT32)pcmBnk->data.size(), fData[0x03], fData[0x04]);
+	daccontrol_set_data(dacStrm->defInf.dataPtr, (UINT8*)pcmBnk->ptr, pcmBnk->size, fData[0x03], fData[0x04]);
 	return;
 }
 
@@ -974,6 +1021,7 @@ void VGMPlayer::Cmd_GGStereo(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	cDev->write8(cDev->base.defInf.dataPtr, SN76496_W_GGST, fData[0x01]);
 	return;
@@ -986,6 +1034,7 @@ void VGMPlayer::Cmd_SN76489(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	cDev->write8(cDev->base.defInf.dataPtr, SN76496_W_REG, fData[0x01]);
 	return;
@@ -998,6 +1047,7 @@ void VGMPlayer::Cmd_Reg8_Data8(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	SendYMCommand(cDev, 0, fData[0x01], fData[0x02]);
 	return;
@@ -1010,6 +1060,7 @@ void VGMPlayer::Cmd_CPort_Reg8_Data8(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	SendYMCommand(cDev, fData[0x00] & 0x01, fData[0x01], fData[0x02]);
 	return;
@@ -1022,6 +1073,7 @@ void VGMPlayer::Cmd_Port_Reg8_Data8(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	SendYMCommand(cDev, fData[0x01] & 0x7F, fData[0x02], fData[0x03]);
 	return;
@@ -1034,6 +1086,7 @@ void VGMPlayer::Cmd_Ofs8_Data8(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	cDev->write8(cDev->base.defInf.dataPtr, fData[0x01] & 0x7F, fData[0x02]);
 	return;
@@ -1046,6 +1099,7 @@ void VGMPlayer::Cmd_Ofs16_Data8(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->writeM8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	UINT16 ofs = ReadBE16(&fData[0x01]) & 0x7FFF;
 	cDev->writeM8(cDev->base.defInf.dataPtr, ofs, fData[0x03]);
@@ -1059,6 +1113,7 @@ void VGMPlayer::Cmd_Ofs8_Data16(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->writeD16 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	UINT16 value = ReadLE16(&fData[0x02]);
 	cDev->writeD16(cDev->base.defInf.dataPtr, fData[0x01] & 0x7F, value);
@@ -1072,6 +1127,7 @@ void VGMPlayer::Cmd_Ofs16_Data16(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->writeM16 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	UINT16 ofs = ReadBE16(&fData[0x01]) & 0x7FFF;
 	UINT16 value = ReadBE16(&fData[0x03]);
@@ -1086,6 +1142,7 @@ void VGMPlayer::Cmd_Port_Ofs8_Data8(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	cDev->write8(cDev->base.defInf.dataPtr, fData[0x02], fData[0x03]);
 	return;
@@ -1098,6 +1155,7 @@ void VGMPlayer::Cmd_DReg8_Data8(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	SendYMCommand(cDev, 0, fData[0x01] & 0x7F, fData[0x02]);
 	return;
@@ -1110,6 +1168,7 @@ void VGMPlayer::Cmd_SegaPCM_Mem(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->writeM8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	UINT16 memOfs = ReadLE16(&fData[0x01]) & 0x7FFF;
 	cDev->writeM8(cDev->base.defInf.dataPtr, memOfs, fData[0x03]);
@@ -1123,6 +1182,7 @@ void VGMPlayer::Cmd_RF5C_Mem(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->writeM8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	UINT16 memOfs = ReadLE16(&fData[0x01]);
 	if (memOfs & 0xF000)
@@ -1138,6 +1198,7 @@ void VGMPlayer::Cmd_RF5C_Reg(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	UINT8 ofs = fData[0x01] & 0x7F;
 	cDev->write8(cDev->base.defInf.dataPtr, ofs, fData[0x02]);
@@ -1159,6 +1220,7 @@ void VGMPlayer::Cmd_PWM_Reg(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->writeD16 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	UINT8 ofs = (fData[0x01] >> 4) & 0x0F;
 	UINT16 value = ReadBE16(&fData[0x01]) & 0x0FFF;
@@ -1174,6 +1236,7 @@ void VGMPlayer::Cmd_QSound_Reg(void)
 	QSOUND_WORK* qsWork = &_qsWork[chipID];
 	if (cDev == NULL || qsWork->write == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	if (cDev->flags & 0x01)	// enable hacks for proper playback of old VGMs with a good QSound core
 	{
@@ -1231,6 +1294,7 @@ void VGMPlayer::Cmd_WSwan_Reg(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	cDev->write8(cDev->base.defInf.dataPtr, 0x80 + (fData[0x01] & 0x7F), fData[0x02]);
 	return;
@@ -1243,6 +1307,7 @@ void VGMPlayer::Cmd_NES_Reg(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	UINT8 ofs = fData[0x01] & 0x7F;
 	
@@ -1263,6 +1328,7 @@ void VGMPlayer::Cmd_YMW_Bank(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	UINT8 bankmask = fData[0x01] & 0x03;
 	// fData[0x03] is ignored as we don't support YMW258 ROMs > 16 MB
@@ -1290,6 +1356,7 @@ void VGMPlayer::Cmd_SAA_Reg(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	cDev->write8(cDev->base.defInf.dataPtr, 0x01, fData[0x01] & 0x7F);	// SAA commands are at offset 1, not 0
 	cDev->write8(cDev->base.defInf.dataPtr, 0x00, fData[0x02]);
@@ -1303,6 +1370,7 @@ void VGMPlayer::Cmd_OKIM6295_Reg(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	COUNT_REG_WRITE(cDev);
 	
 	UINT8 ofs = fData[0x01] & 0x7F;
 	UINT8 data = fData[0x02];
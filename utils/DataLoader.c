@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>	// for SEEK_SET
 
 #include "../stdtype.h"
 #include "DataLoader.h"
@@ -102,6 +103,25 @@ UINT32 DataLoader_Read(DATA_LOADER *loader, UINT32 numBytes)
 	if (endOfs > loader->_bytesTotal)
 		endOfs = loader->_bytesTotal;
 
+	if (endOfs == loader->_bytesTotal && endOfs > loader->_bytesLoaded && loader->_callbacks->dtakedata != NULL)
+	{
+		// everything that's left is requested - take over the loader's buffer if possible
+		UINT32 dataSize;
+		UINT8 *data = loader->_callbacks->dtakedata(loader->_context, &dataSize);
+		if (data != NULL)
+		{
+			if (dataSize > loader->_bytesTotal)
+				dataSize = loader->_bytesTotal;
+			readBytes = (dataSize > loader->_bytesLoaded) ? (dataSize - loader->_bytesLoaded) : 0;
+			free(loader->_data);
+			loader->_data = data;
+			loader->_bytesLoaded = dataSize;
+			DataLoader_CancelLoading(loader);
+			loader->_status = DLSTAT_LOADED;
+			return readBytes;
+		}
+	}
+
 	loader->_data = (UINT8 *)realloc(loader->_data,endOfs);
 	if(loader->_data == NULL) {
 		return 0;
@@ -121,6 +141,35 @@ UINT32 DataLoader_Read(DATA_LOADER *loader, UINT32 numBytes)
 	return readBytes;
 }
 
+UINT32 DataLoader_ReadAt(DATA_LOADER *loader, UINT32 fileOffset, UINT8 *buffer, UINT32 numBytes)
+{
+	UINT32 readBytes;
+
+	if (fileOffset >= loader->_bytesTotal)
+		return 0;
+	if (numBytes > loader->_bytesTotal - fileOffset)
+		numBytes = loader->_bytesTotal - fileOffset;
+
+	if (fileOffset + numBytes <= loader->_bytesLoaded || loader->_status != DLSTAT_LOADING)
+	{
+		// copy from the buffer (if not loading anymore, that's all we can get)
+		if (fileOffset >= loader->_bytesLoaded)
+			return 0;
+		if (numBytes > loader->_bytesLoaded - fileOffset)
+			numBytes = loader->_bytesLoaded - fileOffset;
+		memcpy(buffer, &loader->_data[fileOffset], numBytes);
+		return numBytes;
+	}
+
+	// read directly from the source, then return to the end of the loaded data
+	if (loader->_callbacks->dseek(loader->_context, fileOffset, SEEK_SET))
+		return 0;
+	readBytes = loader->_callbacks->dread(loader->_context, buffer, numBytes);
+	if (loader->_callbacks->dseek(loader->_context, loader->_bytesLoaded, SEEK_SET))
+		DataLoader_CancelLoading(loader);	// can't continue sequential loading
+	return readBytes;
+}
+
 void DataLoader_Deinit(DATA_LOADER *dLoader)
 {
 	if(dLoader == NULL) return;
@@ -12,6 +12,7 @@ typedef UINT32 (*DLOADCB_READ)(void *context, UINT8 *buffer, UINT32 numBytes);
 typedef UINT8 (*DLOADCB_SEEK)(void *context, UINT32 offset, UINT8 whence);
 typedef INT32 (*DLOADCB_TELL)(void *context);
 typedef UINT32 (*DLOADCB_LENGTH)(void *context);
+typedef UINT8 *(*DLOADCB_TAKEDATA)(void *context, UINT32 *retSize);
 
 typedef struct _data_loader_callbacks
 {
@@ -19,11 +20,14 @@ typedef struct _data_loader_callbacks
 	const char *name;       /* human-readable name of the file loader */
 	DLOADCB_GENERIC dopen;  /* open a file, URL, piece of memory, return 0 on success */
 	DLOADCB_READ dread;     /* read bytes into buffer */
-	DLOADCB_SEEK dseek;     /* seek to byte offset */
+	DLOADCB_SEEK dseek;     /* seek to byte offset, return 0 on success, like fseek the offset is
+	                         * signed (INT32) for SEEK_CUR/SEEK_END, SEEK_END may fail for compressed data */
 	DLOADCB_GENERIC dclose; /* closes out file, return 0 on success */
 	DLOADCB_TELL dtell;     /* returns the current position of the data */
 	DLOADCB_LENGTH dlength; /* returns the length of the data, in bytes */
 	DLOADCB_GENERIC deof;   /* determines if we've seen eof or not (return 1 for eof) */
+	DLOADCB_TAKEDATA dtakedata; /* optional: hands over a buffer with all data (allocated with malloc)
+	                             * instead of copying it, called when reading until the end, return NULL to use dread */
 } DATA_LOADER_CALLBACKS;
 
 enum
@@ -82,6 +86,10 @@ void DataLoader_ReadUntil(DATA_LOADER *loader, UINT32 fileOffset);
 /* read all data */
 void DataLoader_ReadAll(DATA_LOADER *loader);
 
+/* reads numBytes from fileOffset into buffer without loading the data in-between,
+ * uses dseek when the range wasn't loaded yet, returns the number of bytes read */
+UINT32 DataLoader_ReadAt(DATA_LOADER *loader, UINT32 fileOffset, UINT8 *buffer, UINT32 numBytes);
+
 /* convenience function for MemoryLoader,FileLoader, etc */
 void DataLoader_Setup(DATA_LOADER *loader, const DATA_LOADER_CALLBACKS *callbacks, void *context);
 
@@ -5,12 +5,14 @@
 
 #include "../common_def.h"
 #include "FileLoader.h"
+#include "InflateThread.h"
 
 enum
 {
 	// mode: compression
 	FLMODE_CMP_RAW = 0x00,
-	FLMODE_CMP_GZ = 0x10
+	FLMODE_CMP_GZ = 0x10,
+	FLMODE_CMP_GZ_BG = 0x11	// gzip, decompressed by a helper thread
 };
 
 typedef struct _file_loader FILE_LOADER;
@@ -25,6 +27,7 @@ typedef union _loader_handles
 {
 	FILE *hFileRaw;
 	gzFile hFileGZ;
+	INFLATE_THREAD *hInflate;
 } LOADER_HANDLES;
 
 struct _file_loader
@@ -33,6 +36,8 @@ struct _file_loader
 	UINT32 bytesTotal;
 	LOADER_HANDLES hLoad;
 	const char *fileName;
+	UINT8 bgInflate;	// background decompression mode for gzip files (INFL_MODE_ constant)
+	UINT32 bgPos;		// read position for background decompression
 
 	FLOAD_READ Read;
 	FLOAD_SEEK Seek;
@@ -49,6 +54,7 @@ static UINT8 FileLoader_dclose(void *context);
 static INT32 FileLoader_dtell(void *context);
 static UINT32 FileLoader_dlength(void *context);
 static UINT8 FileLoader_deof(void *context);
+static UINT8 *FileLoader_dtakedata(void *context, UINT32 *retSize);
 
 static UINT32 FileLoader_ReadRaw(FILE_LOADER *loader, UINT8 *buffer, UINT32 numBytes);
 static UINT8 FileLoader_SeekRaw(FILE_LOADER *loader, UINT32 offset, UINT8 whence);
@@ -62,6 +68,12 @@ static UINT8 FileLoader_CloseGZ(FILE_LOADER *loader);
 static INT32 FileLoader_TellGZ(FILE_LOADER *loader);
 static UINT8 FileLoader_EofGZ(FILE_LOADER *loader);
 
+static UINT32 FileLoader_ReadBG(FILE_LOADER *loader, UINT8 *buffer, UINT32 numBytes);
+static UINT8 FileLoader_SeekBG(FILE_LOADER *loader, UINT32 offset, UINT8 whence);
+static UINT8 FileLoader_CloseBG(FILE_LOADER *loader);
+static INT32 FileLoader_TellBG(FILE_LOADER *loader);
+static UINT8 FileLoader_EofBG(FILE_LOADER *loader);
+
 //DATA_LOADER *FileLoader_Init(const char *fileName);
 
 
@@ -92,6 +104,24 @@ static UINT8 FileLoader_dopen(void *context)
 		loader->bytesTotal = ReadLE32(sizeBuffer);
 		if (loader->bytesTotal < (UINT32)ftell(loader->hLoad.hFileRaw) / 2)
 			loader->bytesTotal = 0;
+
+		if (loader->bgInflate)
+		{
+			FILE *hFile = loader->hLoad.hFileRaw;
+			rewind(hFile);
+			if (! InflThread_Init(&loader->hLoad.hInflate, hFile, NULL, 0, loader->bytesTotal, loader->bgInflate))
+			{
+				loader->bgPos = 0;
+				loader->modeCompr = FLMODE_CMP_GZ_BG;
+				loader->Read = &FileLoader_ReadBG;
+				loader->Seek = &FileLoader_SeekBG;
+				loader->Close = &FileLoader_CloseBG;
+				loader->Tell = &FileLoader_TellBG;
+				loader->Eof = &FileLoader_EofBG;
+				return 0x00;
+			}
+			loader->hLoad.hFileRaw = hFile;	// fall back to gzread
+		}
 		fclose(loader->hLoad.hFileRaw);
 		loader->hLoad.hFileRaw = NULL;
 
@@ -157,6 +187,14 @@ static UINT8 FileLoader_deof(void *context)
 	return loader->Eof(loader);
 }
 
+static UINT8 *FileLoader_dtakedata(void *context, UINT32 *retSize)
+{
+	FILE_LOADER *loader = (FILE_LOADER *)context;
+	if (loader->modeCompr != FLMODE_CMP_GZ_BG)
+		return NULL;
+	return InflThread_TakeData(loader->hLoad.hInflate, retSize);
+}
+
 
 static UINT32 FileLoader_ReadRaw(FILE_LOADER *loader, UINT8 *buffer, UINT32 numBytes)
 {
@@ -165,7 +203,8 @@ static UINT32 FileLoader_ReadRaw(FILE_LOADER *loader, UINT8 *buffer, UINT32 numB
 
 static UINT8 FileLoader_SeekRaw(FILE_LOADER *loader, UINT32 offset, UINT8 whence)
 {
-	return (UINT8)fseek(loader->hLoad.hFileRaw, offset, whence);
+	long ofs = (whence == SEEK_SET) ? (long)offset : (long)(INT32)offset;	// relative offsets are signed
+	return fseek(loader->hLoad.hFileRaw, ofs, whence) ? 0x01 : 0x00;
 }
 
 static UINT8 FileLoader_CloseRaw(FILE_LOADER *loader)
@@ -193,8 +232,9 @@ static UINT32 FileLoader_ReadGZ(FILE_LOADER *loader, UINT8 *buffer, UINT32 numBy
 
 static UINT8 FileLoader_SeekGZ(FILE_LOADER *loader, UINT32 offset, UINT8 whence)
 {
-	if(whence == SEEK_END) return 0;
-	return (gzseek(loader->hLoad.hFileGZ, offset, whence) == -1) ? 0x01 : 0x00;
+	z_off_t ofs = (whence == SEEK_SET) ? (z_off_t)offset : (z_off_t)(INT32)offset;
+	if(whence == SEEK_END) return 0x01;	// not supported by zlib
+	return (gzseek(loader->hLoad.hFileGZ, ofs, whence) == -1) ? 0x01 : 0x00;
 }
 
 static UINT8 FileLoader_CloseGZ(FILE_LOADER *loader)
@@ -215,6 +255,42 @@ static UINT8 FileLoader_EofGZ(FILE_LOADER *loader)
 }
 
 
+static UINT32 FileLoader_ReadBG(FILE_LOADER *loader, UINT8 *buffer, UINT32 numBytes)
+{
+	UINT32 readBytes = InflThread_Read(loader->hLoad.hInflate, loader->bgPos, buffer, numBytes);
+	loader->bgPos += readBytes;
+	return readBytes;
+}
+
+static UINT8 FileLoader_SeekBG(FILE_LOADER *loader, UINT32 offset, UINT8 whence)
+{
+	if(whence == SEEK_END) return 0x01;	// decompressed size is not known until inflating is done
+	if(whence == SEEK_CUR)
+		offset += loader->bgPos;
+	loader->bgPos = offset;
+	return 0x00;
+}
+
+static UINT8 FileLoader_CloseBG(FILE_LOADER *loader)
+{
+	InflThread_Deinit(loader->hLoad.hInflate);
+	loader->hLoad.hInflate = NULL;
+	return 0x00;
+}
+
+static INT32 FileLoader_TellBG(FILE_LOADER *loader)
+{
+	return loader->bgPos;
+}
+
+static UINT8 FileLoader_EofBG(FILE_LOADER *loader)
+{
+	INFLATE_THREAD *inf = loader->hLoad.hInflate;
+	// check "done" first, so that no data can be published in-between
+	return InflThread_IsDone(inf) && loader->bgPos >= InflThread_GetSize(inf);
+}
+
+
 DATA_LOADER *FileLoader_Init(const char *fileName)
 {
 	DATA_LOADER *dLoader;
@@ -237,6 +313,16 @@ DATA_LOADER *FileLoader_Init(const char *fileName)
 	return dLoader;
 }
 
+void FileLoader_SetBackgroundInflate(DATA_LOADER *loader, UINT8 mode)
+{
+	FILE_LOADER *fLoader;
+
+	if(loader->_callbacks != &fileLoader) return;
+	fLoader = (FILE_LOADER *)loader->_context;
+	fLoader->bgInflate = mode;
+	return;
+}
+
 const DATA_LOADER_CALLBACKS fileLoader = {
 	0x46494C45,		// "FILE"
 	"File Loader",
@@ -247,4 +333,5 @@ const DATA_LOADER_CALLBACKS fileLoader = {
 	FileLoader_dtell,
 	FileLoader_dlength,
 	FileLoader_deof,
+	FileLoader_dtakedata,
 };
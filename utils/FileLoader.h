@@ -6,8 +6,13 @@ extern "C" {
 #endif
 
 #include "DataLoader.h"
+#include "InflateThread.h"	// for INFL_MODE_ constants
 
 DATA_LOADER *FileLoader_Init(const char *fileName);
+/* enables decompression of gzip files on a helper thread, must be set before loading
+ * mode: INFL_MODE_STREAM - ReadUntil etc. return as soon as the requested data is available
+ *       INFL_MODE_WHOLE - for reading all data at once (can use libdeflate) */
+void FileLoader_SetBackgroundInflate(DATA_LOADER *loader, UINT8 mode);
 #define FileLoader_Load				DataLoader_Load
 #define FileLoader_Reset			DataLoader_Reset
 #define FileLoader_GetData			DataLoader_GetData
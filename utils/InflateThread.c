@@ -0,0 +1,350 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#ifdef UTIL_LOADER_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
+#include "../stdtype.h"
+#include "OSThread.h"
+#include "OSMutex.h"
+#include "OSSignal.h"
+#include "InflateThread.h"
+
+#define INF_CHUNK	0x4000	// amount of data that is decompressed/published at once
+#define INF_INBUF	0x10000	// size of the buffer for compressed file data
+
+struct _inflate_thread
+{
+	FILE *hFile;
+	const UINT8 *srcData;
+	UINT32 srcSize;
+	UINT8 *fileBuf;		// compressed file data, when the whole file had to be read
+	UINT32 decSize;		// expected size, 0 = unknown
+	UINT8 mode;
+
+	UINT8 *data;
+	UINT32 dataAlloc;
+	UINT32 dataSize;	// number of published bytes, protected by hMutex
+	UINT8 done;			// protected by hMutex
+	volatile UINT8 stop;
+
+	OS_THREAD *hThread;
+	OS_MUTEX *hMutex;
+	OS_SIGNAL *hSignal;	// signalled after publishing data
+};
+
+
+static void InflThread_Main(void *args);
+static UINT8 InflThread_Reserve(INFLATE_THREAD *inf);
+static void InflThread_Publish(INFLATE_THREAD *inf, UINT32 numBytes);
+static void InflThread_RunZlib(INFLATE_THREAD *inf);
+#ifdef UTIL_LOADER_LIBDEFLATE
+static UINT8 InflThread_ReadFile(INFLATE_THREAD *inf);
+static UINT8 InflThread_RunLibDeflate(INFLATE_THREAD *inf);
+#endif
+
+
+UINT8 InflThread_Init(INFLATE_THREAD **retInf, FILE *srcFile, const UINT8 *srcData, UINT32 srcSize, UINT32 decSize, UINT8 mode)
+{
+	INFLATE_THREAD *inf;
+	UINT8 retVal;
+
+	inf = (INFLATE_THREAD *)calloc(1, sizeof(INFLATE_THREAD));
+	if(inf == NULL) return 0xFF;
+
+	inf->hFile = srcFile;
+	inf->srcData = (srcFile == NULL) ? srcData : NULL;
+	inf->srcSize = (srcFile == NULL) ? srcSize : 0;
+	inf->decSize = decSize;
+	inf->mode = mode;
+	if(decSize)
+	{
+		inf->data = (UINT8 *)malloc(decSize);
+		inf->dataAlloc = (inf->data != NULL) ? decSize : 0;
+	}
+
+	retVal  = OSMutex_Init(&inf->hMutex, 0);
+	retVal |= OSSignal_Init(&inf->hSignal, 0);
+	if(! retVal)
+		retVal = OSThread_Init(&inf->hThread, &InflThread_Main, inf);
+	if(retVal)
+	{
+		inf->hFile = NULL;	// the caller keeps ownership on failure
+		InflThread_Deinit(inf);
+		return 0x80;
+	}
+
+	*retInf = inf;
+	return 0x00;
+}
+
+void InflThread_Deinit(INFLATE_THREAD *inf)
+{
+	if(inf->hThread != NULL)
+	{
+		inf->stop = 1;
+		OSThread_Join(inf->hThread);
+		OSThread_Deinit(inf->hThread);
+	}
+	if(inf->hSignal != NULL)
+		OSSignal_Deinit(inf->hSignal);
+	if(inf->hMutex != NULL)
+		OSMutex_Deinit(inf->hMutex);
+	if(inf->hFile != NULL)
+		fclose(inf->hFile);
+	free(inf->fileBuf);
+	free(inf->data);
+	free(inf);
+}
+
+UINT32 InflThread_Read(INFLATE_THREAD *inf, UINT32 offset, UINT8 *buffer, UINT32 numBytes)
+{
+	UINT32 endOfs;
+
+	endOfs = offset + numBytes;
+	if(endOfs < offset)
+		endOfs = (UINT32)-1;
+
+	OSMutex_Lock(inf->hMutex);
+	while(inf->dataSize < endOfs && ! inf->done)
+	{
+		OSMutex_Unlock(inf->hMutex);
+		OSSignal_Wait(inf->hSignal);
+		OSMutex_Lock(inf->hMutex);
+	}
+	if(offset >= inf->dataSize)
+		numBytes = 0;
+	else if(numBytes > inf->dataSize - offset)
+		numBytes = inf->dataSize - offset;
+	if(numBytes)
+		memcpy(buffer, &inf->data[offset], numBytes);
+	OSMutex_Unlock(inf->hMutex);
+
+	return numBytes;
+}
+
+UINT32 InflThread_GetSize(INFLATE_THREAD *inf)
+{
+	UINT32 size;
+
+	OSMutex_Lock(inf->hMutex);
+	size = inf->dataSize;
+	OSMutex_Unlock(inf->hMutex);
+	return size;
+}
+
+UINT8 InflThread_IsDone(INFLATE_THREAD *inf)
+{
+	UINT8 done;
+
+	OSMutex_Lock(inf->hMutex);
+	done = inf->done;
+	OSMutex_Unlock(inf->hMutex);
+	return done;
+}
+
+UINT8 *InflThread_TakeData(INFLATE_THREAD *inf, UINT32 *retSize)
+{
+	UINT8 *data;
+
+	OSMutex_Lock(inf->hMutex);
+	while(! inf->done)
+	{
+		OSMutex_Unlock(inf->hMutex);
+		OSSignal_Wait(inf->hSignal);
+		OSMutex_Lock(inf->hMutex);
+	}
+	data = inf->dataSize ? inf->data : NULL;
+	*retSize = inf->dataSize;
+	if(data != NULL)
+	{
+		inf->data = NULL;
+		inf->dataAlloc = 0;
+		inf->dataSize = 0;
+	}
+	OSMutex_Unlock(inf->hMutex);
+
+	return data;
+}
+
+
+static void InflThread_Main(void *args)
+{
+	INFLATE_THREAD *inf = (INFLATE_THREAD *)args;
+
+#ifdef UTIL_LOADER_LIBDEFLATE
+	// libdeflate can only publish the data after decompressing everything
+	if(inf->mode != INFL_MODE_WHOLE || InflThread_RunLibDeflate(inf))
+		InflThread_RunZlib(inf);	// fall back to zlib (e.g. unknown size, multiple gzip members)
+#else
+	InflThread_RunZlib(inf);
+#endif
+
+	OSMutex_Lock(inf->hMutex);
+	inf->done = 1;
+	OSMutex_Unlock(inf->hMutex);
+	OSSignal_Signal(inf->hSignal);
+	return;
+}
+
+static UINT8 InflThread_Reserve(INFLATE_THREAD *inf)
+{
+	UINT32 newAlloc;
+	UINT8 *newData;
+
+	if(inf->dataSize < inf->dataAlloc)
+		return 0x00;
+
+	// The expected size was wrong/unknown. Grow the buffer.
+	if(inf->decSize)
+		newAlloc = inf->dataAlloc + INF_CHUNK;
+	else
+		newAlloc = inf->dataAlloc ? (inf->dataAlloc * 2) : (INF_CHUNK * 4);
+	if(newAlloc < inf->dataAlloc)
+		return 0xFF;	// overflow
+
+	OSMutex_Lock(inf->hMutex);	// readers may copy from the buffer
+	newData = (UINT8 *)realloc(inf->data, newAlloc);
+	if(newData != NULL)
+	{
+		inf->data = newData;
+		inf->dataAlloc = newAlloc;
+	}
+	OSMutex_Unlock(inf->hMutex);
+	return (newData != NULL) ? 0x00 : 0xFF;
+}
+
+static void InflThread_Publish(INFLATE_THREAD *inf, UINT32 numBytes)
+{
+	if(! numBytes)
+		return;
+	OSMutex_Lock(inf->hMutex);
+	inf->dataSize += numBytes;
+	OSMutex_Unlock(inf->hMutex);
+	OSSignal_Signal(inf->hSignal);
+	return;
+}
+
+static void InflThread_RunZlib(INFLATE_THREAD *inf)
+{
+	z_stream zStream;
+	UINT8 *inBuf;
+	UINT32 outLen;
+	UINT32 produced;
+	int ret;
+
+	inBuf = NULL;
+	memset(&zStream, 0x00, sizeof(z_stream));
+	if(inf->srcData != NULL)
+	{
+		zStream.next_in = (z_const Bytef *)inf->srcData;
+		zStream.avail_in = inf->srcSize;
+	}
+	else
+	{
+		inBuf = (UINT8 *)malloc(INF_INBUF);
+		if(inBuf == NULL) return;
+	}
+	if(inflateInit2(&zStream, 0x20 | 15) != Z_OK)
+	{
+		free(inBuf);
+		return;
+	}
+
+	while(! inf->stop)
+	{
+		if(zStream.avail_in == 0 && inBuf != NULL)
+		{
+			zStream.avail_in = (uInt)fread(inBuf, 0x01, INF_INBUF, inf->hFile);
+			zStream.next_in = inBuf;
+			if(zStream.avail_in == 0)
+				break;	// end of file
+		}
+		if(InflThread_Reserve(inf))
+			break;
+
+		outLen = inf->dataAlloc - inf->dataSize;
+		if(outLen > INF_CHUNK)
+			outLen = INF_CHUNK;
+		zStream.next_out = &inf->data[inf->dataSize];	// only this thread changes dataSize
+		zStream.avail_out = outLen;
+		ret = inflate(&zStream, Z_NO_FLUSH);
+		produced = outLen - zStream.avail_out;
+		InflThread_Publish(inf, produced);
+
+		if(ret == Z_STREAM_END)
+		{
+			// continue with the next gzip member, like gzread() does
+			if(zStream.avail_in == 0 && inBuf != NULL)
+			{
+				zStream.avail_in = (uInt)fread(inBuf, 0x01, INF_INBUF, inf->hFile);
+				zStream.next_in = inBuf;
+			}
+			if(zStream.avail_in < 2 || zStream.next_in[0] != 31 || zStream.next_in[1] != 139)
+				break;
+			if(inflateReset(&zStream) != Z_OK)
+				break;
+		}
+		else if(ret != Z_OK && ret != Z_BUF_ERROR)
+		{
+			break;	// data error - keep what was decompressed so far
+		}
+		else if(! produced && zStream.avail_in == 0 && inBuf == NULL)
+		{
+			break;	// truncated data
+		}
+	}
+
+	inflateEnd(&zStream);
+	free(inBuf);
+	return;
+}
+
+#ifdef UTIL_LOADER_LIBDEFLATE
+static UINT8 InflThread_ReadFile(INFLATE_THREAD *inf)
+{
+	UINT32 bufSize;
+	UINT32 readBytes;
+	UINT8 *newBuf;
+
+	bufSize = INF_INBUF / 2;
+	do
+	{
+		bufSize *= 2;
+		newBuf = (UINT8 *)realloc(inf->fileBuf, bufSize);
+		if(newBuf == NULL)
+			return 0xFF;
+		inf->fileBuf = newBuf;
+		readBytes = (UINT32)fread(&inf->fileBuf[inf->srcSize], 0x01, bufSize - inf->srcSize, inf->hFile);
+		inf->srcSize += readBytes;
+	} while(inf->srcSize == bufSize && ! inf->stop);
+
+	inf->srcData = inf->fileBuf;
+	return 0x00;
+}
+
+static UINT8 InflThread_RunLibDeflate(INFLATE_THREAD *inf)
+{
+	struct libdeflate_decompressor *decomp;
+	enum libdeflate_result res;
+	size_t outSize;
+
+	if(! inf->decSize || inf->dataAlloc < inf->decSize)
+		return 0x01;	// libdeflate needs to know the size in advance
+	if(inf->srcData == NULL && InflThread_ReadFile(inf))
+		return 0x01;
+
+	decomp = libdeflate_alloc_decompressor();
+	if(decomp == NULL)
+		return 0x01;
+	res = libdeflate_gzip_decompress(decomp, inf->srcData, inf->srcSize, inf->data, inf->decSize, &outSize);
+	libdeflate_free_decompressor(decomp);
+	if(res != LIBDEFLATE_SUCCESS || outSize != inf->decSize)
+		return 0x01;
+
+	InflThread_Publish(inf, (UINT32)outSize);
+	return 0x00;
+}
+#endif
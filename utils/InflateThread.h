@@ -0,0 +1,54 @@
+#ifndef __INFLATETHREAD_H__
+#define __INFLATETHREAD_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include "../stdtype.h"
+
+/* Background decompression of gzip data.
+ * A helper thread inflates the whole stream into an internal buffer and
+ * publishes the decompressed bytes incrementally, readers only block until
+ * the range they ask for is available.
+ * When compiled with UTIL_LOADER_LIBDEFLATE, libdeflate can be used for data of known size
+ * that is only needed as a whole. It publishes everything at once, so zlib is used otherwise. */
+typedef struct _inflate_thread INFLATE_THREAD;
+
+/* decompression modes */
+#define INFL_MODE_OFF		0x00	/* no background decompression (for the loaders) */
+#define INFL_MODE_STREAM	0x01	/* publish the data while decompressing, so that the beginning can be read early */
+#define INFL_MODE_WHOLE		0x02	/* the data is only needed as a whole, allows using libdeflate */
+
+/* starts decompression
+ *   srcFile: compressed file, read from the current position (the inflater takes ownership and closes it)
+ *   srcData, srcSize: compressed data in memory, used when srcFile is NULL (must stay valid until InflThread_Deinit)
+ *   decSize: decompressed size from the gzip trailer, 0 = unknown
+ *   mode: INFL_MODE_STREAM or INFL_MODE_WHOLE
+ * returns 0 on success */
+UINT8 InflThread_Init(INFLATE_THREAD **retInf, FILE *srcFile, const UINT8 *srcData, UINT32 srcSize, UINT32 decSize, UINT8 mode);
+
+/* cancels decompression and frees all data */
+void InflThread_Deinit(INFLATE_THREAD *inf);
+
+/* copies decompressed data, waits until the range is available or decompression finished
+ * returns the number of bytes read (less than numBytes only at the end of the data) */
+UINT32 InflThread_Read(INFLATE_THREAD *inf, UINT32 offset, UINT8 *buffer, UINT32 numBytes);
+
+/* returns the number of bytes decompressed so far */
+UINT32 InflThread_GetSize(INFLATE_THREAD *inf);
+
+/* returns 1 when decompression has finished (successfully or not) */
+UINT8 InflThread_IsDone(INFLATE_THREAD *inf);
+
+/* waits until decompression has finished and hands over the buffer with all decompressed data
+ * The buffer has to be freed by the caller using free(). Reading returns no data afterwards.
+ * returns NULL if there is no data */
+UINT8 *InflThread_TakeData(INFLATE_THREAD *inf, UINT32 *retSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* __INFLATETHREAD_H__ */
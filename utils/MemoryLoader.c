@@ -1,16 +1,19 @@
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>	// for SEEK_SET/SEEK_CUR/SEEK_END
 #include <zlib.h>
 
 #include "../common_def.h"
 #include "DataLoader.h"
 #include "MemoryLoader.h"
+#include "InflateThread.h"
 
 enum
 {
 	// mode: compression
 	MLMODE_CMP_RAW = 0x00,
-	MLMODE_CMP_GZ = 0x10
+	MLMODE_CMP_GZ = 0x10,
+	MLMODE_CMP_GZ_BG = 0x11	// gzip, decompressed by a helper thread
 };
 
 typedef struct _memory_loader MEMORY_LOADER;
@@ -25,6 +28,8 @@ struct _memory_loader
 	UINT32 decSize;	// decompressed size
 	UINT32 pos;
 	z_stream zStream;
+	UINT8 bgInflate;	// background decompression mode for gzip data (INFL_MODE_ constant)
+	INFLATE_THREAD *hInflate;
 
 	MLOAD_READ ReadData;
 };
@@ -34,11 +39,13 @@ static UINT8 MemoryLoader_dopen(void *context);
 static UINT32 MemoryLoader_dread(void *context, UINT8 *buffer, UINT32 numBytes);
 static UINT32 MemoryLoader_ReadDataRaw(MEMORY_LOADER *loader, UINT8 *buffer, UINT32 numBytes);
 static UINT32 MemoryLoader_ReadDataGZ(MEMORY_LOADER *loader, UINT8 *buffer, UINT32 numBytes);
+static UINT32 MemoryLoader_ReadDataBG(MEMORY_LOADER *loader, UINT8 *buffer, UINT32 numBytes);
 static UINT32 MemoryLoader_dlength(void *context);
 static INT32 MemoryLoader_dtell(void *context);
 static UINT8 MemoryLoader_dseek(void *context, UINT32 offset, UINT8 whence);
 static UINT8 MemoryLoader_dclose(void *context);
 static UINT8 MemoryLoader_deof(void *context);
+static UINT8 *MemoryLoader_dtakedata(void *context, UINT32 *retSize);
 //DATA_LOADER *MemoryLoader_Init(const UINT8 *buffer, UINT32 length);
 
 
@@ -63,6 +70,12 @@ static UINT8 MemoryLoader_dopen(void *context)
 		loader->zStream.avail_in = loader->srcSize;
 		loader->zStream.next_in = (z_const Bytef *)loader->srcData;
 		loader->decSize = ReadLE32(&loader->srcData[loader->srcSize - 4]);
+		if(loader->bgInflate && ! InflThread_Init(&loader->hInflate, NULL, loader->srcData, loader->srcSize, loader->decSize, loader->bgInflate))
+		{
+			loader->modeCompr = MLMODE_CMP_GZ_BG;
+			loader->ReadData = &MemoryLoader_ReadDataBG;
+			return 0x00;
+		}
 		if(inflateInit2(&loader->zStream, 0x20 | 15) != Z_OK)
 			return 0x01;
 		loader->ReadData = &MemoryLoader_ReadDataGZ;
@@ -112,6 +125,13 @@ static UINT32 MemoryLoader_ReadDataGZ(MEMORY_LOADER *loader, UINT8 *buffer, UINT
 	return bytesWritten;
 }
 
+static UINT32 MemoryLoader_ReadDataBG(MEMORY_LOADER *loader, UINT8 *buffer, UINT32 numBytes)
+{
+	UINT32 bytesRead = InflThread_Read(loader->hInflate, loader->pos, buffer, numBytes);
+	loader->pos += bytesRead;
+	return bytesRead;
+}
+
 static UINT32 MemoryLoader_dlength(void *context)
 {
 	MEMORY_LOADER *loader = (MEMORY_LOADER *)context;
@@ -126,10 +146,45 @@ static INT32 MemoryLoader_dtell(void *context)
 
 static UINT8 MemoryLoader_dseek(void *context, UINT32 offset, UINT8 whence)
 {
-	(void)context;
-	(void)offset;
-	(void)whence;
-	return 0; /* TODO */
+	MEMORY_LOADER *loader = (MEMORY_LOADER *)context;
+	UINT8 skipBuf[0x400];
+	UINT32 skipBytes;
+
+	if(whence == SEEK_CUR)
+		offset += loader->pos;
+	else if(whence == SEEK_END)
+	{
+		if(loader->modeCompr != MLMODE_CMP_RAW)
+			return 0x01;	// decompressed size is not reliable
+		offset = loader->decSize + offset;	// (INT32)offset <= 0, like fseek
+	}
+	if(offset > loader->decSize)
+		return 0x01;
+
+	if(loader->modeCompr != MLMODE_CMP_GZ)
+	{
+		loader->pos = offset;	// raw data or random access to the decompressed data
+		return 0x00;
+	}
+
+	// compressed data: restart decompression when going backwards, then skip forward
+	if(offset < loader->pos)
+	{
+		if(inflateReset(&loader->zStream) != Z_OK)
+			return 0x01;
+		loader->zStream.avail_in = loader->srcSize;
+		loader->zStream.next_in = (z_const Bytef *)loader->srcData;
+		loader->pos = 0;
+	}
+	while(loader->pos < offset)
+	{
+		skipBytes = offset - loader->pos;
+		if(skipBytes > sizeof(skipBuf))
+			skipBytes = sizeof(skipBuf);
+		if(! MemoryLoader_ReadDataGZ(loader, skipBuf, skipBytes))
+			return 0x01;
+	}
+	return 0x00;
 }
 
 static UINT8 MemoryLoader_dclose(void *context)
@@ -137,15 +192,30 @@ static UINT8 MemoryLoader_dclose(void *context)
 	MEMORY_LOADER *loader = (MEMORY_LOADER *)context;
 	if(loader->modeCompr == MLMODE_CMP_GZ)
 		inflateEnd(&loader->zStream);
+	else if(loader->modeCompr == MLMODE_CMP_GZ_BG)
+	{
+		InflThread_Deinit(loader->hInflate);
+		loader->hInflate = NULL;
+	}
 	return 0x00;
 }
 
 static UINT8 MemoryLoader_deof(void *context)
 {
 	MEMORY_LOADER *loader = (MEMORY_LOADER *)context;
+	if(loader->modeCompr == MLMODE_CMP_GZ_BG && InflThread_IsDone(loader->hInflate))
+		return loader->pos >= InflThread_GetSize(loader->hInflate);
 	return loader->pos >= loader->decSize;
 }
 
+static UINT8 *MemoryLoader_dtakedata(void *context, UINT32 *retSize)
+{
+	MEMORY_LOADER *loader = (MEMORY_LOADER *)context;
+	if(loader->modeCompr != MLMODE_CMP_GZ_BG)
+		return NULL;
+	return InflThread_TakeData(loader->hInflate, retSize);
+}
+
 DATA_LOADER *MemoryLoader_Init(const UINT8 *buffer, UINT32 length)
 {
 	DATA_LOADER *dLoader;
@@ -170,6 +240,16 @@ DATA_LOADER *MemoryLoader_Init(const UINT8 *buffer, UINT32 length)
 	return dLoader;
 }
 
+void MemoryLoader_SetBackgroundInflate(DATA_LOADER *loader, UINT8 mode)
+{
+	MEMORY_LOADER *mLoader;
+
+	if(loader->_callbacks != &memoryLoader) return;
+	mLoader = (MEMORY_LOADER *)loader->_context;
+	mLoader->bgInflate = mode;
+	return;
+}
+
 const DATA_LOADER_CALLBACKS memoryLoader = {
 	0x4D454D20,		// "MEM "
 	"Memory Loader",
@@ -180,4 +260,5 @@ const DATA_LOADER_CALLBACKS memoryLoader = {
 	MemoryLoader_dtell,
 	MemoryLoader_dlength,
 	MemoryLoader_deof,
+	MemoryLoader_dtakedata,
 };
@@ -7,8 +7,13 @@ extern "C" {
 
 #include "../stdtype.h"
 #include "DataLoader.h"
+#include "InflateThread.h"	// for INFL_MODE_ constants
 
 DATA_LOADER *MemoryLoader_Init(const UINT8 *buffer, UINT32 length);
+/* enables decompression of gzip data on a helper thread, must be set before loading
+ * mode: INFL_MODE_STREAM - ReadUntil etc. return as soon as the requested data is available
+ *       INFL_MODE_WHOLE - for reading all data at once (can use libdeflate) */
+void MemoryLoader_SetBackgroundInflate(DATA_LOADER *loader, UINT8 mode);
 #define MemoryLoader_Load				DataLoader_Load
 #define MemoryLoader_Reset				DataLoader_Reset
 #define MemoryLoader_GetData			DataLoader_GetData
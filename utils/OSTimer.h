@@ -0,0 +1,18 @@
+#ifndef __OSTIMER_H__
+#define __OSTIMER_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "../stdtype.h"
+
+UINT64 OSTimer_GetFreq(void);	// returns timer ticks per second
+UINT64 OSTimer_GetTime(void);	// returns current value of the high-resolution monotonic timer
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __OSTIMER_H__
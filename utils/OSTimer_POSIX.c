@@ -0,0 +1,20 @@
+// POSIX Timer
+// -----------
+
+#include <time.h>
+
+#include "../stdtype.h"
+#include "OSTimer.h"
+
+UINT64 OSTimer_GetFreq(void)
+{
+	return 1000000000;	// clock_gettime() has nanosecond resolution
+}
+
+UINT64 OSTimer_GetTime(void)
+{
+	struct timespec tpSys;
+	
+	clock_gettime(CLOCK_MONOTONIC, &tpSys);
+	return (UINT64)tpSys.tv_sec * 1000000000 + tpSys.tv_nsec;
+}
@@ -0,0 +1,23 @@
+// Windows Timer
+// -------------
+
+#include <Windows.h>
+
+#include "../stdtype.h"
+#include "OSTimer.h"
+
+UINT64 OSTimer_GetFreq(void)
+{
+	LARGE_INTEGER freq;
+	
+	QueryPerformanceFrequency(&freq);
+	return (UINT64)freq.QuadPart;
+}
+
+UINT64 OSTimer_GetTime(void)
+{
+	LARGE_INTEGER count;
+	
+	QueryPerformanceCounter(&count);
+	return (UINT64)count.QuadPart;
+}
@@ -6,6 +6,7 @@
  * vgm-util
  * iconv (depending on system)
  * z
+ * pthread (depending on system)
  */
 
 #include <stdio.h>
@@ -16,11 +17,18 @@
 #include "player/vgmplayer.hpp"
 #include "player/s98player.hpp"
 #include "player/droplayer.hpp"
+#include "player/coreselect.hpp"
+#include "player/rendercache.hpp"
 #include "utils/DataLoader.h"
 #include "utils/FileLoader.h"
 #include "emu/SoundDevs.h"
 #include "emu/EmuCores.h"
 #include "emu/SoundEmu.h"
+#include "utils/OSThread.h"
+#include "utils/OSMutex.h"
+
+#include <vector>
+#include <string>
 
 #ifdef _MSC_VER
 #define strncasecmp	_strnicmp
@@ -45,6 +53,19 @@ bit_depth = 16;
 static unsigned int
 loops = 2;
 
+/* maximum length of the loop output cache, in seconds (0 = off) */
+static unsigned int
+loop_cache = 0;
+
+/* minimum rendering speed (times realtime) for picking
+ * sound cores by their measured cost (0 = default cores) */
+static unsigned int
+min_speed = 0;
+
+/* directory for cached renders (NULL = render everything) */
+static const char *
+cache_dir = NULL;
+
 /* vgm-specific functions */
 static void
 FCC2STR(char *str, UINT32 fcc);
@@ -58,6 +79,9 @@ set_core(PlayerBase *player, UINT8 devId, UINT32 coreId);
 static void
 dump_info(PlayerBase *player);
 
+static void
+dump_core_choices(const CoreSelector *coreSel);
+
 /* generic utility/wave functions */
 static void
 pack_int16le(UINT8 *d, INT16 n);
@@ -92,29 +116,70 @@ fmt_time(double ts);
 static const char *
 extensible_guid_trailer= "\x00\x00\x00\x00\x10\x00\x80\x00\x00\xAA\x00\x38\x9B\x71";
 
-int main(int argc, const char *argv[]) {
-    PlayerBase *player;
+/* per-worker state, reused across all files rendered by that worker */
+struct render_state {
+    WAVE_32BS *buffer;
+    UINT8 *packed;
+    MEM_ARENA *arena;
+    VGMPlayer *vgmPlayer;
+    S98Player *s98Player;
+    DROPlayer *droPlayer;
+    CoreSelector *coreSel;
+    RenderCache *cache;
+    OS_MUTEX *outMutex;   /* serializes stderr output of parallel workers, NULL = single file */
+};
+
+/* shared state for batch conversion */
+struct batch_state {
+    std::vector<std::string> inputs;
+    std::vector<std::string> outputs;
+    size_t nextJob;
+    unsigned int failed;
+    OS_MUTEX *jobMutex;   /* protects nextJob, failed and stderr output */
+};
+
+struct batch_worker {
+    batch_state *batch;
+    render_state rs;
+    OS_THREAD *thread;
+};
 
-    unsigned int i;
-    unsigned int totalFrames;
-    unsigned int fadeFrames;
-    unsigned int curFrames;
-    const char *const *tags;
-    const char *f_input;
-    const char *f_output;
+static int
+init_render_state(render_state *rs);
+
+static void
+deinit_render_state(render_state *rs);
+
+static void
+render_error(const render_state *rs, const char *f_input, const char *msg);
+
+static int
+render_file(render_state *rs, const char *f_input, const char *f_output, int verbose);
+
+static int
+read_manifest(const char *fileName, batch_state *batch);
+
+static std::string
+make_output_name(const char *f_input);
+
+static void
+batch_worker_thread(void *args);
+
+static int
+run_batch(batch_state *batch, unsigned int jobs);
+
+int main(int argc, const char *argv[]) {
+    render_state rs;
+    batch_state batch;
+    unsigned int jobs;
+    int batchMode;
+    int ret;
     const char *self;
     const char *c;
     const char *s;
-    FILE *f;
-    DATA_LOADER *loader;
-    WAVE_32BS *buffer;
-    UINT8 *packed;
-    double complete;
-    double inc;
 
-    fadeFrames = 0;
-    complete = 0.0;
-    inc = 0.0;
+    jobs = 1;
+    batchMode = 0;
 
     self = *argv++;
     argc--;
@@ -177,6 +242,80 @@ int main(int argc, const char *argv[]) {
             argv++;
             argc--;
         }
+        else if(str_istarts(*argv,"--loopcache")) {
+            c = strchr(*argv,'=');
+            if(c != NULL) {
+                s = &c[1];
+            } else {
+                argv++;
+                argc--;
+                s = *argv;
+            }
+            loop_cache = scan_uint(s);
+            argv++;
+            argc--;
+        }
+        else if(str_istarts(*argv,"--jobs")) {
+            c = strchr(*argv,'=');
+            if(c != NULL) {
+                s = &c[1];
+            } else {
+                argv++;
+                argc--;
+                s = *argv;
+            }
+            jobs = scan_uint(s);
+            argv++;
+            argc--;
+        }
+        else if(str_istarts(*argv,"--speed")) {
+            c = strchr(*argv,'=');
+            if(c != NULL) {
+                s = &c[1];
+            } else {
+                argv++;
+                argc--;
+                s = *argv;
+            }
+            min_speed = scan_uint(s);
+            argv++;
+            argc--;
+        }
+        else if(str_istarts(*argv,"--cache")) {
+            c = strchr(*argv,'=');
+            if(c != NULL) {
+                s = &c[1];
+            } else {
+                argv++;
+                argc--;
+                s = *argv;
+            }
+            cache_dir = s;
+            argv++;
+            argc--;
+        }
+        else if(str_istarts(*argv,"--list")) {
+            c = strchr(*argv,'=');
+            if(c != NULL) {
+                s = &c[1];
+            } else {
+                argv++;
+                argc--;
+                s = *argv;
+            }
+            if(read_manifest(s,&batch)) {
+                fprintf(stderr,"unable to read file list %s\n",s);
+                return 1;
+            }
+            batchMode = 1;
+            argv++;
+            argc--;
+        }
+        else if(str_equals(*argv,"--batch")) {
+            batchMode = 1;
+            argv++;
+            argc--;
+        }
         else {
             break;
         }
@@ -196,13 +335,41 @@ int main(int argc, const char *argv[]) {
         default: bit_depth = 16;
     }
 
+    if(jobs == 0) {
+        jobs = 1;
+    }
+
+    if(batchMode) {
+        /* all remaining arguments are input files, the output
+         * file is named after the input (with a .wav extension) */
+        while(argc > 0) {
+            batch.inputs.push_back(*argv);
+            batch.outputs.push_back(make_output_name(*argv));
+            argv++;
+            argc--;
+        }
+        if(batch.inputs.empty()) {
+            fprintf(stderr,"no input files\n");
+            return 1;
+        }
+        return run_batch(&batch,jobs);
+    }
+
     if(argc < 2) {
         fprintf(stderr,"Usage: %s [options] /path/to/vgm-file /path/to/out.wav\n",self);
+        fprintf(stderr,"       %s [options] --batch [--jobs N] file1.vgm file2.vgm ...\n",self);
+        fprintf(stderr,"       %s [options] --list files.txt [--jobs N]\n",self);
         fprintf(stderr,"Available options:\n");
         fprintf(stderr,"    --samplerate\n");
         fprintf(stderr,"    --bps\n");
         fprintf(stderr,"    --fade\n");
         fprintf(stderr,"    --loops\n");
+        fprintf(stderr,"    --loopcache replay repeated loops from a cache of up to N seconds\n");
+        fprintf(stderr,"    --jobs      number of files to render in parallel (batch mode)\n");
+        fprintf(stderr,"    --speed     use the most accurate cores that render at least N times realtime\n");
+        fprintf(stderr,"    --cache     reuse renders stored in directory DIR (must exist)\n");
+        fprintf(stderr,"    --list      read input files from a list, one \"input[<TAB>output]\" per line\n");
+        fprintf(stderr,"    --batch     treat all file arguments as inputs, write <input>.wav\n");
         return 1;
     }
 
@@ -212,40 +379,112 @@ int main(int argc, const char *argv[]) {
      * Since this is just a CLI app, we can just quit and let
      * the OS handle everything. */
 
-    /* libvgm renders sames to a WAVE_32BS object - a struct
-     * representing left and right samples (in that order) of
-     * a single PCM frame */
-    buffer = (WAVE_32BS *)malloc(sizeof(WAVE_32BS) * BUFFER_LEN);
-    if(buffer == NULL) {
+    if(init_render_state(&rs)) {
         fprintf(stderr,"out of memory\n");
         return 1;
     }
 
+    ret = render_file(&rs,argv[0],argv[1],1);
+
+    deinit_render_state(&rs);
+    return ret;
+}
+
+static int init_render_state(render_state *rs) {
+    /* libvgm renders sames to a WAVE_32BS object - a struct
+     * representing left and right samples (in that order) of
+     * a single PCM frame */
+    rs->buffer = (WAVE_32BS *)malloc(sizeof(WAVE_32BS) * BUFFER_LEN);
+
     /* we'll want to make sure to pack our audio samples
      * into little-endian, interleaved format.
      * If we only supported 16-bit samples this could be
      * malloc(sizeof(INT16) * 2 * BUFFER_LEN) - but in
      * this case we're using INT32 to ensure we can pack
      * 16 and 24-bit frames */
-    packed = (UINT8 *)malloc(sizeof(INT32) * 2 * BUFFER_LEN);
-    if(packed == NULL) {
-        fprintf(stderr,"out of memory\n");
-        return 1;
+    rs->packed = (UINT8 *)malloc(sizeof(INT32) * 2 * BUFFER_LEN);
+
+    /* per-file device buffers come from an arena that is
+     * recycled by Stop(), so consecutive files don't need
+     * to go through malloc/free again */
+    rs->arena = NULL;
+    MemArena_Init(&rs->arena, 0);
+
+    /* players are created on first use and then reused for
+     * every file of the same format */
+    rs->vgmPlayer = NULL;
+    rs->s98Player = NULL;
+    rs->droPlayer = NULL;
+
+    /* core costs are measured once per worker and
+     * then reused for all files */
+    rs->coreSel = NULL;
+    if(min_speed) rs->coreSel = new CoreSelector();
+
+    /* the render cache is reused as well, each worker
+     * keeps its own cache file open */
+    rs->cache = NULL;
+    if(cache_dir != NULL) {
+        rs->cache = new RenderCache();
+        rs->cache->SetCacheDir(cache_dir);
     }
+    rs->outMutex = NULL;
 
-    f = fopen(argv[1],"wb");
-    if(f == NULL) {
-        fprintf(stderr,"unable to open output file\n");
+    if(rs->buffer == NULL || rs->packed == NULL || rs->arena == NULL) {
+        deinit_render_state(rs);
         return 1;
     }
+    return 0;
+}
+
+static void deinit_render_state(render_state *rs) {
+    free(rs->buffer);   rs->buffer = NULL;
+    free(rs->packed);   rs->packed = NULL;
+    delete rs->vgmPlayer;   rs->vgmPlayer = NULL;
+    delete rs->s98Player;   rs->s98Player = NULL;
+    delete rs->droPlayer;   rs->droPlayer = NULL;
+    delete rs->coreSel;     rs->coreSel = NULL;
+    delete rs->cache;       rs->cache = NULL;
+    if(rs->arena != NULL) MemArena_Deinit(rs->arena);
+    rs->arena = NULL;
+}
+
+/* prints an error message for an input file */
+static void render_error(const render_state *rs, const char *f_input, const char *msg) {
+    if(rs->outMutex != NULL) OSMutex_Lock(rs->outMutex);
+    fprintf(stderr,"%s: %s\n",f_input,msg);
+    if(rs->outMutex != NULL) OSMutex_Unlock(rs->outMutex);
+}
+
+/* renders one file, returns 0 on success
+ * verbose - print tags, device info and a progress bar */
+static int render_file(render_state *rs, const char *f_input, const char *f_output, int verbose) {
+    PlayerBase *player;
+
+    unsigned int totalFrames;
+    unsigned int fadeFrames;
+    unsigned int curFrames;
+    const char *const *tags;
+    FILE *f;
+    DATA_LOADER *loader;
+    WAVE_32BS *buffer;
+    UINT8 *packed;
+    double complete;
+    double inc;
+
+    fadeFrames = 0;
+    complete = 0.0;
+    inc = 0.0;
+    buffer = rs->buffer;
+    packed = rs->packed;
 
     /* past all the boilerplate now!
      * create a FileLoader object - able to read gzip'd
      * files on-the-fly */
 
-    loader = FileLoader_Init(argv[0]);
+    loader = FileLoader_Init(f_input);
     if(loader == NULL) {
-        fprintf(stderr,"failed to create FileLoader\n");
+        render_error(rs,f_input,"failed to create FileLoader");
         return 1;
     }
 
@@ -253,30 +492,43 @@ int main(int argc, const char *argv[]) {
     DataLoader_SetPreloadBytes(loader,0x100);
     if(DataLoader_Load(loader)) {
         DataLoader_CancelLoading(loader);
-        fprintf(stderr,"failed to load DataLoader\n");
+        render_error(rs,f_input,"failed to load DataLoader");
         DataLoader_Deinit(loader);
         return 1;
     }
 
     /* figure out a player */
     if(VGMPlayer::PlayerCanLoadFile(loader) == 0) {
-        player = new VGMPlayer();
+        if(rs->vgmPlayer == NULL) rs->vgmPlayer = new VGMPlayer();
+        player = rs->vgmPlayer;
     }
     else if(S98Player::PlayerCanLoadFile(loader) == 0) {
-        player = new S98Player();
+        if(rs->s98Player == NULL) rs->s98Player = new S98Player();
+        player = rs->s98Player;
     }
     else if(DROPlayer::PlayerCanLoadFile(loader) == 0) {
-        player = new DROPlayer();
+        if(rs->droPlayer == NULL) rs->droPlayer = new DROPlayer();
+        player = rs->droPlayer;
     }
     else {
-        fprintf(stderr,"Unsupported file\n");
+        render_error(rs,f_input,"Unsupported file");
+        DataLoader_Deinit(loader);
         return 1;
     }
 
     /* associate the fileloader to the player -
      * automatically reads the rest of the file */
     if(player->LoadFile(loader)) {
-        fprintf(stderr,"failed to load file\n");
+        render_error(rs,f_input,"failed to load file");
+        DataLoader_Deinit(loader);
+        return 1;
+    }
+
+    f = fopen(f_output,"wb");
+    if(f == NULL) {
+        render_error(rs,f_input,"unable to open output file");
+        player->UnloadFile();
+        DataLoader_Deinit(loader);
         return 1;
     }
 
@@ -290,32 +542,65 @@ int main(int argc, const char *argv[]) {
     /* commented-out since NUKE uses a lot of CPU */
     // set_core(player,DEVID_YM2612,FCC_NUKE);
 
+    /* alternatively, measure all cores on this machine and pick
+     * the most accurate ones that are still fast enough */
+    if(rs->coreSel != NULL) {
+        if(rs->coreSel->ApplyToPlayer(player,min_speed) == 0x01 && verbose) {
+            fprintf(stderr,"Warning: unable to render at %ux realtime, using the fastest cores\n",min_speed);
+        }
+        if(verbose) {
+            dump_core_choices(rs->coreSel);
+        }
+    }
+
     /* let's get some tags! just printing for now.
      * if we wanted to get *really* fancy we could add
      * an "id3 " chunk or "LIST" "INFO" chunk to the
      * wave file. */
-    tags = player->GetTags();
-    while(*tags) {
-        fprintf(stderr,"%s: %s\n",tags[0],tags[1]);
-        tags += 2;
+    if(verbose) {
+        tags = player->GetTags();
+        while(*tags) {
+            fprintf(stderr,"%s: %s\n",tags[0],tags[1]);
+            tags += 2;
+        }
     }
 
     /* set our desired sample rate */
     player->SetSampleRate(sample_rate);
-
-    /* need to call Start before calls like Tick2Sample or
-     * checking any kind of timing info, because
-     * Start updates the sample rate multiplier/divisors */
-    player->Start();
-
-    dump_info(player);
+    player->SetMemArena(rs->arena);
+    player->SetLoopCache(loop_cache * sample_rate);
 
     /* libvgm uses the term "Sample" but its' really a PCM frame! */
     /* In a mono configuration, 1 frame = 1 sample, in a stereo
      * configuration, 1 frame = (left sample + right sample) */
 
-    /* figure out how many total frames we're going to render */
-    totalFrames = player->Tick2Sample(player->GetTotalPlayTicks(loops));
+    if(rs->cache != NULL) {
+        /* the cache starts the player only when a part of the
+         * song isn't cached yet, and the player must not be
+         * used directly until the cache is closed */
+        if(rs->cache->Open(player,loader,loops) & 0x80) {
+            render_error(rs,f_input,"unable to use the render cache");
+        }
+        rs->cache->Start();
+
+        if(verbose) {
+            dump_info(player);
+        }
+
+        totalFrames = rs->cache->GetTotalSamples();
+    } else {
+        /* need to call Start before calls like Tick2Sample or
+         * checking any kind of timing info, because
+         * Start updates the sample rate multiplier/divisors */
+        player->Start();
+
+        if(verbose) {
+            dump_info(player);
+        }
+
+        /* figure out how many total frames we're going to render */
+        totalFrames = player->Tick2Sample(player->GetTotalPlayTicks(loops));
+    }
 
     /* we only want to fade if there's a looping section. Assumption is
      * if the VGM doesn't specify a loop, it's a song with an actual ending */
@@ -324,12 +609,14 @@ int main(int argc, const char *argv[]) {
         totalFrames += fadeFrames;
     }
 
-    /* Let's tell the user what we're doing */
-    fprintf(stderr,"Rendering %s to %s\n",argv[0],argv[1]);
-    fprintf(stderr,"Samplerate: %u\n",sample_rate);
-    fprintf(stderr,"BPS: %u\n",bit_depth);
-    fprintf(stderr,"Channels: 2\n");
-    fprintf(stderr,"Length: %s\n",fmt_time(player->Sample2Second(totalFrames)));
+    if(verbose) {
+        /* Let's tell the user what we're doing */
+        fprintf(stderr,"Rendering %s to %s\n",f_input,f_output);
+        fprintf(stderr,"Samplerate: %u\n",sample_rate);
+        fprintf(stderr,"BPS: %u\n",bit_depth);
+        fprintf(stderr,"Channels: 2\n");
+        fprintf(stderr,"Length: %s\n",fmt_time((double)totalFrames / sample_rate));
+    }
 
     write_wav_header(f,totalFrames);
 
@@ -338,8 +625,10 @@ int main(int argc, const char *argv[]) {
 
     /* we'll just print a '-' character each time we've hit the
      * next 10% of the file */
-    fprintf(stderr,"[");
-    fflush(stderr);
+    if(verbose) {
+        fprintf(stderr,"[");
+        fflush(stderr);
+    }
 
     while(totalFrames) {
 
@@ -349,7 +638,11 @@ int main(int argc, const char *argv[]) {
         /* default to BUFFER_LEN PCM frames unless we have under BUFFER_LEN remaining */
         curFrames = (BUFFER_LEN > totalFrames ? totalFrames : BUFFER_LEN);
 
-        player->Render(curFrames,buffer);
+        if(rs->cache != NULL) {
+            rs->cache->Render(curFrames,buffer);
+        } else {
+            player->Render(curFrames,buffer);
+        }
 
         /* apply a fade if we've entered the fade section, nothing otherwise */
         fade_frames(totalFrames, fadeFrames, curFrames, buffer);
@@ -372,21 +665,168 @@ int main(int argc, const char *argv[]) {
         complete += inc;
         if(complete >= 0.10) {
             complete -= 0.10;
-            fprintf(stderr,"-");
-            fflush(stderr);
+            if(verbose) {
+                fprintf(stderr,"-");
+                fflush(stderr);
+            }
         }
     }
-    fprintf(stderr,"]\n");
+    if(verbose) {
+        fprintf(stderr,"]\n");
+    }
 
-    free(buffer);
-    free(packed);
+    /* the player is kept for the next file, only the song data is released */
+    if(rs->cache != NULL) {
+        rs->cache->Close();
+    } else {
+        player->Stop();
+    }
+    player->UnloadFile();
     DataLoader_Deinit(loader);
     fclose(f);
 
-    delete player;
     return 0;
 }
 
+/* reads a list of files to convert
+ * each line is either "input" or "input<TAB>output",
+ * empty lines and lines starting with '#' are ignored */
+static int read_manifest(const char *fileName, batch_state *batch) {
+    FILE *f;
+    char line[0x1000];
+    char *tab;
+    size_t len;
+
+    f = fopen(fileName,"rt");
+    if(f == NULL) return 1;
+
+    while(fgets(line,sizeof(line),f) != NULL) {
+        len = strlen(line);
+        while(len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+            line[--len] = '\0';
+        }
+        if(len == 0 || line[0] == '#') continue;
+
+        tab = strchr(line,'\t');
+        if(tab != NULL) {
+            *tab = '\0';
+            batch->inputs.push_back(line);
+            batch->outputs.push_back(&tab[1]);
+        } else {
+            batch->inputs.push_back(line);
+            batch->outputs.push_back(make_output_name(line));
+        }
+    }
+
+    fclose(f);
+    return 0;
+}
+
+/* replace the file extension of the input file with .wav */
+static std::string make_output_name(const char *f_input) {
+    std::string name(f_input);
+    size_t extPos;
+    size_t dirPos;
+
+    extPos = name.rfind('.');
+    dirPos = name.find_last_of("/\\");
+    if(extPos != std::string::npos && (dirPos == std::string::npos || extPos > dirPos)) {
+        name.erase(extPos);
+    }
+    name += ".wav";
+    return name;
+}
+
+static void batch_worker_thread(void *args) {
+    batch_worker *worker = (batch_worker *)args;
+    batch_state *batch = worker->batch;
+    size_t job;
+    int ret;
+
+    while(1) {
+        OSMutex_Lock(batch->jobMutex);
+        job = batch->nextJob;
+        if(job < batch->inputs.size()) {
+            batch->nextJob++;
+        }
+        OSMutex_Unlock(batch->jobMutex);
+        if(job >= batch->inputs.size()) break;
+
+        ret = render_file(&worker->rs,batch->inputs[job].c_str(),batch->outputs[job].c_str(),0);
+
+        OSMutex_Lock(batch->jobMutex);
+        if(ret) {
+            batch->failed++;
+            fprintf(stderr,"[%u/%u] FAILED %s\n",(unsigned int)job + 1,(unsigned int)batch->inputs.size(),
+              batch->inputs[job].c_str());
+        } else {
+            fprintf(stderr,"[%u/%u] %s -> %s\n",(unsigned int)job + 1,(unsigned int)batch->inputs.size(),
+              batch->inputs[job].c_str(),batch->outputs[job].c_str());
+        }
+        OSMutex_Unlock(batch->jobMutex);
+    }
+}
+
+/* renders all files of the batch using a pool of worker threads,
+ * each with its own player instances and buffers */
+static int run_batch(batch_state *batch, unsigned int jobs) {
+    std::vector<batch_worker> workers;
+    unsigned int i;
+
+    if(jobs > batch->inputs.size()) {
+        jobs = (unsigned int)batch->inputs.size();
+    }
+
+    batch->nextJob = 0;
+    batch->failed = 0;
+    if(OSMutex_Init(&batch->jobMutex,0)) {
+        fprintf(stderr,"failed to create mutex\n");
+        return 1;
+    }
+
+    fprintf(stderr,"Rendering %u files using %u thread(s)\n",(unsigned int)batch->inputs.size(),jobs);
+
+    workers.resize(jobs);
+    for(i=0;i<jobs;i++) {
+        workers[i].batch = batch;
+        workers[i].thread = NULL;
+        if(init_render_state(&workers[i].rs)) {
+            fprintf(stderr,"out of memory\n");
+            jobs = i;
+            break;
+        }
+        workers[i].rs.outMutex = batch->jobMutex;
+    }
+
+    if(jobs == 1) {
+        /* no need for an extra thread */
+        batch_worker_thread(&workers[0]);
+    } else {
+        for(i=0;i<jobs;i++) {
+            if(OSThread_Init(&workers[i].thread,batch_worker_thread,&workers[i])) {
+                fprintf(stderr,"failed to create worker thread %u\n",i);
+                workers[i].thread = NULL;
+            }
+        }
+        for(i=0;i<jobs;i++) {
+            if(workers[i].thread == NULL) continue;
+            OSThread_Join(workers[i].thread);
+            OSThread_Deinit(workers[i].thread);
+        }
+    }
+
+    for(i=0;i<jobs;i++) {
+        deinit_render_state(&workers[i].rs);
+    }
+    OSMutex_Deinit(batch->jobMutex);
+
+    /* jobs that were never picked up (i.e. all threads failed) count as failed */
+    batch->failed += (unsigned int)(batch->inputs.size() - batch->nextJob);
+    fprintf(stderr,"Done: %u of %u files converted\n",
+      (unsigned int)batch->inputs.size() - batch->failed,(unsigned int)batch->inputs.size());
+    return batch->failed ? 1 : 0;
+}
+
 static void set_core(PlayerBase *player, UINT8 devId, UINT32 coreId) {
     PLR_DEV_OPTS devOpts;
     UINT32 id;
@@ -445,6 +885,34 @@ static void dump_info(PlayerBase *player) {
     fprintf(stderr,"\n");
 }
 
+static void dump_core_choices(const CoreSelector *coreSel) {
+    const std::vector<CORE_CHOICE>& choices = coreSel->GetChoices();
+    const std::vector<CORE_COST>& costs = coreSel->GetCosts();
+    UINT32 i;
+    UINT32 j;
+    char str[5];
+
+    fprintf(stderr,"Core selection: %.1fx realtime\n",coreSel->GetTotalSpeed());
+    for(i=0;i<choices.size();i++) {
+        FCC2STR(str,choices[i].coreID);
+        fprintf(stderr,"  Dev 0x%02X: Core %s, Accuracy %u, Speed %.1fx\n",
+          choices[i].devType,
+          choices[i].coreID ? str : "----",
+          choices[i].accuracy,
+          choices[i].speed);
+        for(j=0;j<costs.size();j++) {
+            if(costs[j].devType != choices[i].devType) continue;
+            FCC2STR(str,costs[j].coreID);
+            fprintf(stderr,"    %s @ %u Hz: Accuracy %u, Speed %.1fx\n",
+              str,
+              costs[j].clock,
+              costs[j].accuracy,
+              costs[j].speed);
+        }
+    }
+    fprintf(stderr,"\n");
+}
+
 static const char *
 fmt_time(double sec) {
     static char ts[256];
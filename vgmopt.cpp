@@ -0,0 +1,112 @@
+// VGM optimizer test
+// Optimizes a VGM file using VGMOptimizer, renders the result against the original file
+// and reports the applied passes and whether the output is identical.
+//
+// Usage: vgmopt [-p passes] [-n] input.vgm [output.vgm]
+//	-p	optimization passes (VGMOPT_ constants, default: 0x0F = all)
+//	-n	don't verify the passes while optimizing (the final comparison is still done)
+// Returns 0 when the optimized file renders exactly like the original, 1 otherwise.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "stdtype.h"
+#include "player/vgmoptimizer.hpp"
+#include "player/vgmplayer.hpp"
+#include "utils/DataLoader.h"
+#include "utils/FileLoader.h"
+
+#define CMP_SMPLRATE	44100
+
+static UINT32 GetCompareSamples(UINT32 fileSize, const UINT8* fileData)
+{
+	UINT32 numTicks;
+	UINT32 loopTicks;
+
+	// song length + 1 loop + 1 second, like VGMOptimizer::VerifyOutput()
+	if (fileSize < 0x24)
+		return CMP_SMPLRATE;
+	numTicks = fileData[0x18] | (fileData[0x19] << 8) | (fileData[0x1A] << 16) | (fileData[0x1B] << 24);
+	loopTicks = fileData[0x20] | (fileData[0x21] << 8) | (fileData[0x22] << 16) | (fileData[0x23] << 24);
+	return numTicks + loopTicks + CMP_SMPLRATE;
+}
+
+int main(int argc, char* argv[])
+{
+	DATA_LOADER* dLoad;
+	VGMOptimizer vgmOpt;
+	std::vector<UINT8> srcData;
+	std::vector<UINT8> outData;
+	UINT8 passes;
+	UINT8 retVal;
+	UINT8 cmpVal;
+	int argbase;
+
+	passes = VGMOPT_ALL | VGMOPT_VERIFY;
+	argbase = 1;
+	while (argbase < argc && argv[argbase][0] == '-')
+	{
+		if (! strcmp(argv[argbase], "-p") && argbase + 1 < argc)
+		{
+			passes = (passes & VGMOPT_VERIFY) | ((UINT8)strtoul(argv[argbase + 1], NULL, 0) & VGMOPT_ALL);
+			argbase += 2;
+		}
+		else if (! strcmp(argv[argbase], "-n"))
+		{
+			passes &= ~VGMOPT_VERIFY;
+			argbase ++;
+		}
+		else
+		{
+			break;
+		}
+	}
+	if (argbase >= argc)
+	{
+		printf("Usage: %s [-p passes] [-n] input.vgm [output.vgm]\n", argv[0]);
+		printf("Passes: 0x01 drop writes, 0x02 PCM streams, 0x04 compress, 0x08 merge waits\n");
+		return 0;
+	}
+
+	dLoad = FileLoader_Init(argv[argbase]);
+	if (dLoad == NULL)
+		return 1;
+	DataLoader_SetPreloadBytes(dLoad, 0x100);
+	retVal = DataLoader_Load(dLoad);
+	if (retVal)
+	{
+		DataLoader_CancelLoading(dLoad);
+		DataLoader_Deinit(dLoad);
+		printf("Error loading %s!\n", argv[argbase]);
+		return 1;
+	}
+	DataLoader_ReadAll(dLoad);
+	srcData.assign(DataLoader_GetData(dLoad), DataLoader_GetData(dLoad) + DataLoader_GetSize(dLoad));
+
+	retVal = vgmOpt.Optimize(dLoad, passes, outData);
+	DataLoader_Deinit(dLoad);
+	printf("Optimize: result 0x%02X, applied passes 0x%02X, size %u -> %u bytes\n",
+		retVal, vgmOpt.GetAppliedPasses(), (UINT32)srcData.size(), (UINT32)outData.size());
+	if (retVal >= 0xF0)
+		return 1;
+
+	cmpVal = VGMOptimizer::CompareOutput((UINT32)srcData.size(), &srcData[0], (UINT32)outData.size(), &outData[0],
+		GetCompareSamples((UINT32)srcData.size(), &srcData[0]));
+	printf("Output: %s\n", cmpVal ? "differs" : "identical");
+
+	if (argbase + 1 < argc)
+	{
+		FILE* hFile = fopen(argv[argbase + 1], "wb");
+		if (hFile == NULL)
+		{
+			printf("Error writing %s!\n", argv[argbase + 1]);
+			return 1;
+		}
+		fwrite(&outData[0], 1, outData.size(), hFile);
+		fclose(hFile);
+	}
+
+	return cmpVal ? 1 : 0;
+}
@@ -500,6 +500,7 @@ static void InitVGMChips(void)
 		devCfg.srMode = DEVRI_SRMODE_NATIVE;
 		devCfg.flags = (chpClk & 0x80000000) >> 31;
 		devCfg.clock = chpClk & ~0xC0000000;
+		devCfg.memArena = NULL;
 		devCfg.smplRate = sampleRate;
 		switch(curChip)
 		{
@@ -749,13 +750,14 @@ static void InitVGMChips(void)
 			break;
 		case DEVID_ES5506:
 			{
-				devCfg.flags = VGMHdr.bytES5506Chns;	// output channels
+				devCfg.flags |= VGMHdr.bytES5506Chns << 1;	// chip type (from clock bit 31) + output channels
 				
 				retVal = SndEmu_Start(curChip, &devCfg, &cDev->defInf);
 				if (retVal)
 					break;
 				SndEmu_GetDeviceFunc(cDev->defInf.devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, (void**)&cDev->write8);
 				SndEmu_GetDeviceFunc(cDev->defInf.devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D16, 0, (void**)&cDev->writeD16);
+				SndEmu_GetDeviceFunc(cDev->defInf.devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, (void**)&cDev->romSize);
 				SndEmu_GetDeviceFunc(cDev->defInf.devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, (void**)&cDev->romWrite);
 			}
 			break;
@@ -865,6 +867,7 @@ static void InitVGMChips(void)
 	devCfg.srMode = DEVRI_SRMODE_NATIVE;
 	devCfg.flags = 0x00;
 	devCfg.clock = 0x00;
+	devCfg.memArena = NULL;
 	devCfg.smplRate = sampleRate;
 	for (curChip = 0x00; curChip < DACSTRM_COUNT; curChip ++)
 	{